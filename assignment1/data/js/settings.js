@@ -25,6 +25,32 @@ document.addEventListener('DOMContentLoaded', async () => {
   });
 });
 
+// Fill the timezone list from the device's tz table, keeping the current choice
+async function loadTimezones(token, current) {
+  const select = document.getElementById('timezone');
+  try {
+    const response = await fetch('/api/timezones', {
+      headers: { 'Authorization': `Bearer ${token}` }
+    });
+
+    if (!response.ok) {
+      throw new Error('Failed to fetch timezones');
+    }
+
+    const zones = await response.json();
+    select.innerHTML = '';
+    for (const zone of zones) {
+      select.add(new Option(zone, zone));
+    }
+  } catch (error) {
+    console.error(error);
+  }
+  if (current && !Array.from(select.options).some(option => option.value === current)) {
+    select.add(new Option(current, current));
+  }
+  select.value = current || 'UTC';
+}
+
 async function loadConfigData(token) {
   try {
     const response = await fetch('/api/config', {
@@ -46,7 +72,7 @@ async function loadConfigData(token) {
     document.getElementById('login-user').value = config.login.user || '';
     document.getElementById('login-password').value = config.login.password || '';
     document.getElementById('jwt-secret').value = config.jwtSecret || '';
-    document.getElementById('timezone').value = config.timezone || '';
+    await loadTimezones(token, config.timezone);
   } catch (error) {
     console.error(error);
     alert("Failed to load settings. Please try again.");
@@ -0,0 +1,43 @@
+// Arduino.h - host stand-in for the ESP32 Arduino core
+// Provides just enough of the core (String, Serial, timing, GPIO no-ops)
+// for the SmartAC sources to compile and run on Linux. Time is driven by
+// HostClock so tools can run the firmware logic against a virtual clock.
+#ifndef ARDUINO_HOST_ARDUINO_H
+#define ARDUINO_HOST_ARDUINO_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "HostClock.h"
+#include "IPAddress.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+using std::isnan;
+using std::isinf;
+
+typedef uint8_t byte;
+
+inline unsigned long millis() { return hostClockMillis(); }
+inline unsigned long micros() { return hostClockMicros(); }
+inline void delay(unsigned long ms) { hostClockDelay(ms); }
+inline void delayMicroseconds(unsigned int us) { (void)us; }
+inline void yield() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { (void)pin; (void)value; }
+inline int digitalRead(uint8_t pin) { (void)pin; return LOW; }
+
+#endif
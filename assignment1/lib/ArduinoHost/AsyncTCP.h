@@ -0,0 +1,5 @@
+// AsyncTCP.h - host stand-in; the socket work is in ESPAsyncWebServer.cpp
+#ifndef ARDUINO_HOST_ASYNC_TCP_H
+#define ARDUINO_HOST_ASYNC_TCP_H
+
+#endif
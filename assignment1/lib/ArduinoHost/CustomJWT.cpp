@@ -0,0 +1,202 @@
+// CustomJWT.cpp - HS256 tokens for the host CustomJWT stand-in
+#include "CustomJWT.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// ---- SHA-256 (FIPS 180-4) ----
+
+const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+class Sha256 {
+public:
+  void update(const uint8_t* data, size_t length) {
+    total += length;
+    while (length--) {
+      block[used++] = *data++;
+      if (used == 64) compress();
+    }
+  }
+
+  void finish(uint8_t digest[32]) {
+    uint64_t bits = total * 8;
+    uint8_t pad = 0x80;
+    update(&pad, 1);
+    pad = 0;
+    while (used != 56) update(&pad, 1);
+    for (int i = 7; i >= 0; --i) {
+      uint8_t b = (uint8_t)(bits >> (i * 8));
+      update(&b, 1);
+    }
+    for (int i = 0; i < 8; ++i) {
+      for (int j = 0; j < 4; ++j) digest[i * 4 + j] = (uint8_t)(h[i] >> (24 - j * 8));
+    }
+  }
+
+private:
+  uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  uint8_t block[64];
+  size_t used = 0;
+  uint64_t total = 0;
+
+  void compress() {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+      w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 | (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; ++i) {
+      uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t t1 = k + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+      uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+      k = g; g = f; f = e; e = d + t1;
+      d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+    used = 0;
+  }
+};
+
+void hmacSha256(const char* key, const std::string& message, uint8_t mac[32]) {
+  uint8_t keyBlock[64] = {0};
+  size_t keyLength = strlen(key);
+  if (keyLength > 64) {
+    Sha256 hash;
+    hash.update((const uint8_t*)key, keyLength);
+    hash.finish(keyBlock);
+  } else {
+    memcpy(keyBlock, key, keyLength);
+  }
+  uint8_t pad[64];
+  for (int i = 0; i < 64; ++i) pad[i] = keyBlock[i] ^ 0x36;
+  Sha256 inner;
+  inner.update(pad, 64);
+  inner.update((const uint8_t*)message.data(), message.size());
+  uint8_t innerDigest[32];
+  inner.finish(innerDigest);
+  for (int i = 0; i < 64; ++i) pad[i] = keyBlock[i] ^ 0x5c;
+  Sha256 outer;
+  outer.update(pad, 64);
+  outer.update(innerDigest, 32);
+  outer.finish(mac);
+}
+
+// ---- base64url, no padding ----
+
+const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+std::string encode(const uint8_t* data, size_t length) {
+  std::string out;
+  uint32_t bits = 0;
+  int count = 0;
+  for (size_t i = 0; i < length; ++i) {
+    bits = bits << 8 | data[i];
+    count += 8;
+    while (count >= 6) out += ALPHABET[(bits >> (count -= 6)) & 63];
+  }
+  if (count) out += ALPHABET[(bits << (6 - count)) & 63];
+  return out;
+}
+
+bool decode(const std::string& text, std::string& out) {
+  out.clear();
+  uint32_t bits = 0;
+  int count = 0;
+  for (char c : text) {
+    const char* at = strchr(ALPHABET, c);
+    if (!c || !at) return false;
+    bits = bits << 6 | (uint32_t)(at - ALPHABET);
+    count += 6;
+    if (count >= 8) out += (char)((bits >> (count -= 8)) & 0xff);
+  }
+  return true;
+}
+
+char* copyString(const std::string& s, size_t limit) {
+  if (s.size() > limit) return nullptr;
+  char* out = (char*)malloc(s.size() + 1);
+  memcpy(out, s.c_str(), s.size() + 1);
+  return out;
+}
+
+} // namespace
+
+CustomJWT::CustomJWT(char* secret, size_t maxPayloadLen, size_t maxHeadLen, size_t maxSigLen, const char* alg, const char* typ)
+    : secret(secret), maxPayloadLen(maxPayloadLen), maxHeadLen(maxHeadLen), maxSigLen(maxSigLen), alg(alg), typ(typ) {}
+
+bool CustomJWT::allocateJWTMemory() {
+  clear();
+  return true;    // Buffers are sized per token here
+}
+
+bool CustomJWT::encodeJWT(char* string) {
+  clear();
+  std::string head = std::string("{\"alg\":\"") + alg + "\",\"typ\":\"" + typ + "\"}";
+  std::string body = string;
+  if (head.size() > maxHeadLen || body.size() > maxPayloadLen) return false;
+  std::string token = encode((const uint8_t*)head.data(), head.size()) + "." + encode((const uint8_t*)body.data(), body.size());
+  uint8_t mac[32];
+  hmacSha256(secret, token, mac);
+  std::string sig = encode(mac, sizeof(mac));
+  token += "." + sig;
+
+  header = copyString(head, maxHeadLen);
+  payload = copyString(body, maxPayloadLen);
+  signature = copyString(sig, 64);
+  out = copyString(token, token.size());
+  headerLength = head.size();
+  payloadLength = body.size();
+  signatureLength = sig.size();
+  outputLength = token.size();
+  return true;
+}
+
+int CustomJWT::decodeJWT(char* string) {
+  clear();
+  std::string token = string ? string : "";
+  size_t first = token.find('.');
+  size_t second = first == std::string::npos ? first : token.find('.', first + 1);
+  if (second == std::string::npos || token.find('.', second + 1) != std::string::npos) return 2;
+
+  std::string head, body, sig;
+  if (!decode(token.substr(0, first), head) || !decode(token.substr(first + 1, second - first - 1), body) ||
+      !decode(token.substr(second + 1), sig) || head.size() > maxHeadLen || body.size() > maxPayloadLen) {
+    return 2;
+  }
+  uint8_t mac[32];
+  hmacSha256(secret, token.substr(0, second), mac);
+  if (sig.size() != sizeof(mac) || memcmp(sig.data(), mac, sizeof(mac)) != 0) return 3;
+
+  header = copyString(head, maxHeadLen);
+  payload = copyString(body, maxPayloadLen);
+  headerLength = head.size();
+  payloadLength = body.size();
+  return 0;
+}
+
+void CustomJWT::clear() {
+  free(header);
+  free(payload);
+  free(signature);
+  free(out);
+  header = payload = signature = out = nullptr;
+  headerLength = payloadLength = signatureLength = outputLength = 0;
+}
@@ -0,0 +1,39 @@
+// CustomJWT.h - host stand-in for the CustomJWT library (ant2000/CustomJWT)
+// Same interface and token format: HS256, base64url without padding,
+// header {"alg":"HS256","typ":"JWT"}. SHA-256 and HMAC are built in.
+#ifndef ARDUINO_HOST_CUSTOM_JWT_H
+#define ARDUINO_HOST_CUSTOM_JWT_H
+
+#include <cstddef>
+#include <cstdint>
+
+class CustomJWT {
+public:
+  char* header = nullptr;
+  char* payload = nullptr;
+  char* signature = nullptr;
+  char* out = nullptr;
+  size_t headerLength = 0;
+  size_t payloadLength = 0;
+  size_t signatureLength = 0;
+  size_t outputLength = 0;
+
+  CustomJWT(char* secret, size_t maxPayloadLen, size_t maxHeadLen = 40, size_t maxSigLen = 32,
+            const char* alg = "HS256", const char* typ = "JWT");
+  ~CustomJWT() { clear(); }
+
+  bool allocateJWTMemory();
+  bool encodeJWT(char* string);
+  int decodeJWT(char* string);   // 0 valid, 1 out of memory, 2 malformed, 3 bad signature
+  void clear();
+
+private:
+  const char* secret;
+  size_t maxPayloadLen;
+  size_t maxHeadLen;
+  size_t maxSigLen;
+  const char* alg;
+  const char* typ;
+};
+
+#endif
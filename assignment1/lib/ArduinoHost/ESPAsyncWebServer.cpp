@@ -0,0 +1,397 @@
+// ESPAsyncWebServer.cpp - POSIX socket server behind the host AsyncWebServer
+#include "ESPAsyncWebServer.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+
+static int portOverride = -1;
+static uint16_t boundPort = 0;
+static std::function<void(AsyncWebServerRequest&)> beforeHook;
+static std::function<void(AsyncWebServerRequest&, AsyncWebServerResponse&)> afterHook;
+
+const size_t MAX_REQUEST_HEAD = 16384;
+const size_t MAX_REQUEST_BODY = 65536;
+
+void setWebServerPort(uint16_t port) { portOverride = port; }
+uint16_t webServerPort() { return boundPort; }
+
+void setWebRequestHooks(std::function<void(AsyncWebServerRequest&)> before,
+                        std::function<void(AsyncWebServerRequest&, AsyncWebServerResponse&)> after) {
+  beforeHook = before;
+  afterHook = after;
+}
+
+// ---- Request ----
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const {
+  for (const auto& h : _headers) {
+    if (h.first.equalsIgnoreCase(name)) return true;
+  }
+  return false;
+}
+
+String AsyncWebServerRequest::header(const char* name) const {
+  for (const auto& h : _headers) {
+    if (h.first.equalsIgnoreCase(name)) return h.second;
+  }
+  return String();
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+  return getParam(name, post, file) != nullptr;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+  for (const auto& p : _params) {
+    if (p->name() == name && p->isPost() == post && p->isFile() == file) return p.get();
+  }
+  return nullptr;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+  if (_response) {
+    delete response;   // Already answered
+    return;
+  }
+  _response.reset(response);
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+  send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send(FS& fs, const String& path, const String& contentType, bool download) {
+  send(beginResponse(fs, path, contentType, download));
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+  AsyncWebServerResponse* response = beginResponse(302);
+  response->addHeader("Location", url);
+  send(response);
+}
+
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+  AsyncWebServerResponse* response = new AsyncWebServerResponse(code, contentType);
+  response->body() = content.str();
+  return response;
+}
+
+static String contentTypeFor(const String& path) {
+  static const char* const types[][2] = {
+    {".html", "text/html"}, {".htm", "text/html"}, {".css", "text/css"}, {".json", "application/json"},
+    {".js", "application/javascript"}, {".png", "image/png"}, {".ico", "image/x-icon"}, {".svg", "image/svg+xml"},
+    {".woff2", "font/woff2"}, {".ttf", "font/ttf"}, {".gz", "application/x-gzip"},
+  };
+  for (const auto& type : types) {
+    if (path.endsWith(type[0])) return type[1];
+  }
+  return "text/plain";
+}
+
+static bool readWholeFile(FS& fs, const String& path, std::string& out) {
+  File file = fs.open(path.c_str(), FILE_READ);
+  if (!file || file.isDirectory()) return false;
+  out.resize(file.size());
+  size_t n = out.empty() ? 0 : file.read((uint8_t*)&out[0], out.size());
+  file.close();
+  return n == out.size();
+}
+
+// Missing files get a 404 here; the library returns NULL and drops the connection
+AsyncWebServerResponse* AsyncWebServerRequest::beginResponse(FS& fs, const String& path, const String& contentType, bool download) {
+  AsyncWebServerResponse* response = new AsyncWebServerResponse(200, contentType);
+  if (readWholeFile(fs, path, response->body())) {
+    // As is
+  } else if (!download && readWholeFile(fs, path + ".gz", response->body())) {
+    response->addHeader("Content-Encoding", "gzip");
+  } else {
+    delete response;
+    return beginResponse(404, "text/plain", "Not found");
+  }
+  if (download) {
+    int slash = path.lastIndexOf('/');
+    response->addHeader("Content-Disposition", "attachment; filename=\"" + path.substring(slash + 1) + "\"");
+  }
+  return response;
+}
+
+AsyncResponseStream* AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+  return new AsyncResponseStream(contentType, bufferSize);
+}
+
+// ---- Handlers ----
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest* request) {
+  if (!(_method & request->method())) return false;
+  if (_uri.length() && _uri.endsWith("*")) return request->url().startsWith(_uri.substring(0, _uri.length() - 1));
+  return !_uri.length() || _uri == request->url() || request->url().startsWith(_uri + "/");
+}
+
+bool AsyncStaticWebHandler::canHandle(AsyncWebServerRequest* request) {
+  if (request->method() != HTTP_GET || !request->url().startsWith(_uri)) return false;
+  String path = _path + request->url().substring(_uri.length());
+  return (_fs.exists(path.c_str()) || _fs.exists((path + ".gz").c_str())) && !_fs.open(path.c_str()).isDirectory();
+}
+
+void AsyncStaticWebHandler::handleRequest(AsyncWebServerRequest* request) {
+  String path = _path + request->url().substring(_uri.length());
+  String type = contentTypeFor(path);
+  AsyncWebServerResponse* response = request->beginResponse(_fs, path, type);
+  if (_cacheControl.length()) response->addHeader("Cache-Control", _cacheControl);
+  request->send(response);
+}
+
+// ---- Server ----
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+  AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler(uri, method, onRequest);
+  _handlers.emplace_back(handler);
+  return *handler;
+}
+
+AsyncStaticWebHandler& AsyncWebServer::serveStatic(const char* uri, FS& fs, const char* path, const char* cacheControl) {
+  AsyncStaticWebHandler* handler = new AsyncStaticWebHandler(uri, fs, path, cacheControl);
+  _handlers.emplace_back(handler);
+  return *handler;
+}
+
+void AsyncWebServer::handle(AsyncWebServerRequest& request) {
+  if (beforeHook) beforeHook(request);
+  AsyncWebHandler* handler = nullptr;
+  for (auto& h : _handlers) {
+    if (h->canHandle(&request)) {
+      handler = h.get();
+      break;
+    }
+  }
+  if (handler) handler->handleRequest(&request);
+  else if (_notFound) _notFound(&request);
+  else request.send(404);
+  if (!request.response()) request.send(500, "text/plain", "Handler sent no response");
+  if (afterHook) afterHook(request, *request.response());
+}
+
+void AsyncWebServer::begin() {
+  if (_running) return;
+  _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(portOverride >= 0 ? portOverride : _port);
+  socklen_t length = sizeof(address);
+  if (bind(_listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(_listenFd, 128) != 0 ||
+      getsockname(_listenFd, (sockaddr*)&address, &length) != 0) {
+    Serial.printf("Web server: cannot listen on port %u: %s\n", ntohs(address.sin_port), strerror(errno));
+    close(_listenFd);
+    _listenFd = -1;
+    return;
+  }
+  boundPort = ntohs(address.sin_port);
+  fcntl(_listenFd, F_SETFL, O_NONBLOCK);
+  _running = true;
+  _thread = std::thread(&AsyncWebServer::serve, this);
+}
+
+void AsyncWebServer::end() {
+  if (!_running) return;
+  _running = false;
+  _thread.join();
+  close(_listenFd);
+  _listenFd = -1;
+}
+
+static String urlDecode(const std::string& text, size_t from, size_t to) {
+  std::string out;
+  for (size_t i = from; i < to; ++i) {
+    if (text[i] == '+') {
+      out += ' ';
+    } else if (text[i] == '%' && i + 2 < to && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+      out += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += text[i];
+    }
+  }
+  return out;
+}
+
+static void parseParams(const std::string& text, size_t from, size_t to, bool form,
+                        std::vector<std::unique_ptr<AsyncWebParameter>>& params) {
+  while (from < to) {
+    size_t end = text.find('&', from);
+    if (end == std::string::npos || end > to) end = to;
+    size_t equals = text.find('=', from);
+    if (equals == std::string::npos || equals > end) equals = end;
+    if (equals > from) {
+      params.emplace_back(new AsyncWebParameter(urlDecode(text, from, equals),
+                                                equals < end ? urlDecode(text, equals + 1, end) : String(), form));
+    }
+    from = end + 1;
+  }
+}
+
+int AsyncWebServer::parseRequest(std::string& input, AsyncWebServerRequest& request, bool& keepAlive) {
+  size_t headEnd = input.find("\r\n\r\n");
+  if (headEnd == std::string::npos) return input.size() > MAX_REQUEST_HEAD ? -1 : 0;
+
+  size_t lineEnd = input.find("\r\n");
+  size_t space1 = input.find(' ');
+  size_t space2 = space1 == std::string::npos ? space1 : input.find(' ', space1 + 1);
+  if (space2 == std::string::npos || space2 > lineEnd) return -1;
+  std::string verb = input.substr(0, space1);
+  std::string version = input.substr(space2 + 1, lineEnd - space2 - 1);
+
+  size_t contentLength = 0;
+  bool form = false;
+  keepAlive = version == "HTTP/1.1";
+  std::vector<std::pair<String, String>>& headers = request._headers;
+  for (size_t at = lineEnd + 2; at < headEnd;) {
+    size_t end = input.find("\r\n", at);
+    size_t colon = input.find(':', at);
+    if (colon != std::string::npos && colon < end) {
+      size_t value = input.find_first_not_of(' ', colon + 1);
+      headers.push_back({String(input.substr(at, colon - at)), String(input.substr(value, end - value))});
+      const String& name = headers.back().first;
+      const String& text = headers.back().second;
+      if (name.equalsIgnoreCase("Content-Length")) contentLength = strtoul(text.c_str(), nullptr, 10);
+      if (name.equalsIgnoreCase("Content-Type")) form = text.startsWith("application/x-www-form-urlencoded");
+      if (name.equalsIgnoreCase("Connection")) keepAlive = text.equalsIgnoreCase("keep-alive") || (keepAlive && !text.equalsIgnoreCase("close"));
+    }
+    at = end + 2;
+  }
+  if (contentLength > MAX_REQUEST_BODY) return -1;
+  size_t bodyStart = headEnd + 4;
+  if (input.size() < bodyStart + contentLength) return 0;
+
+  static const struct { const char* name; WebRequestMethod method; } verbs[] = {
+    {"GET", HTTP_GET}, {"POST", HTTP_POST}, {"DELETE", HTTP_DELETE}, {"PUT", HTTP_PUT},
+    {"PATCH", HTTP_PATCH}, {"HEAD", HTTP_HEAD}, {"OPTIONS", HTTP_OPTIONS},
+  };
+  request._method = 0;
+  for (const auto& v : verbs) {
+    if (verb == v.name) request._method = v.method;
+  }
+  if (!request._method) return -1;
+
+  size_t query = input.find('?', space1 + 1);
+  size_t pathEnd = query < space2 ? query : space2;
+  request._url = urlDecode(input, space1 + 1, pathEnd);
+  if (query < space2) parseParams(input, query + 1, space2, false, request._params);
+  if (form) parseParams(input, bodyStart, bodyStart + contentLength, true, request._params);
+  input.erase(0, bodyStart + contentLength);
+  return 1;
+}
+
+static const char* reasonPhrase(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 302: return "Found";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 500: return "Internal Server Error";
+    default: return "";
+  }
+}
+
+static void appendResponse(std::string& out, AsyncWebServerResponse& response, bool keepAlive) {
+  char line[64];
+  snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", response.code(), reasonPhrase(response.code()));
+  out += line;
+  if (response.contentType().length()) out += std::string("Content-Type: ") + response.contentType().c_str() + "\r\n";
+  for (const auto& h : response.headers()) out += std::string(h.first.c_str()) + ": " + h.second.c_str() + "\r\n";
+  snprintf(line, sizeof(line), "Content-Length: %zu\r\n", response.body().size());
+  out += line;
+  out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+  out += response.body();
+}
+
+struct Connection {
+  int fd;
+  std::string input;
+  std::string output;
+  size_t sent = 0;
+  bool closing = false;     // Close once the output is out
+};
+
+void AsyncWebServer::serve() {
+  std::vector<Connection> connections;
+  std::vector<pollfd> fds;
+  char buffer[16384];
+
+  while (_running) {
+    fds.clear();
+    fds.push_back({_listenFd, POLLIN, 0});
+    for (const Connection& c : connections) {
+      fds.push_back({c.fd, (short)(c.sent < c.output.size() ? POLLOUT : POLLIN), 0});
+    }
+    if (poll(fds.data(), fds.size(), 100) <= 0) continue;
+
+    for (size_t i = 0; i < connections.size(); ++i) {
+      Connection& c = connections[i];
+      short events = fds[i + 1].revents;
+      bool drop = events & (POLLERR | POLLNVAL);
+
+      if (!drop && (events & (POLLIN | POLLHUP)) && c.sent == c.output.size()) {
+        ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) c.input.append(buffer, n);
+        else if (n == 0 || (errno != EAGAIN && errno != EINTR)) drop = true;
+
+        // Every whole request in the buffer, in order
+        while (!drop && !c.closing) {
+          AsyncWebServerRequest request;
+          bool keepAlive = false;
+          int result = parseRequest(c.input, request, keepAlive);
+          if (result == 0) break;
+          if (result < 0) {
+            request.send(400, "text/plain", "Bad request");
+            keepAlive = false;
+          } else {
+            handle(request);
+          }
+          appendResponse(c.output, *request.response(), keepAlive);
+          c.closing = !keepAlive;
+        }
+      }
+
+      // Straight away for a new response; the socket buffer usually takes it
+      if (!drop && c.sent < c.output.size()) {
+        ssize_t n = ::send(c.fd, c.output.data() + c.sent, c.output.size() - c.sent, MSG_NOSIGNAL);
+        if (n > 0) c.sent += n;
+        else if (errno != EAGAIN && errno != EINTR) drop = true;
+      }
+      if (c.sent == c.output.size()) {
+        c.output.clear();
+        c.sent = 0;
+        if (c.closing) drop = true;
+      }
+
+      if (drop) {
+        close(c.fd);
+        connections.erase(connections.begin() + i);
+        fds.erase(fds.begin() + i + 1);
+        --i;
+      }
+    }
+
+    // After the loop above, which only knows the connections polled
+    if (fds[0].revents & POLLIN) {
+      int fd;
+      while ((fd = accept(_listenFd, nullptr, nullptr)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        connections.push_back({fd});
+      }
+    }
+  }
+  for (Connection& c : connections) close(c.fd);
+}
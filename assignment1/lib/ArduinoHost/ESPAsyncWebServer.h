@@ -0,0 +1,190 @@
+// ESPAsyncWebServer.h - host stand-in for ESPAsyncWebServer over POSIX sockets
+// The route handlers in web.cpp run unchanged: AsyncWebServer keeps the
+// handlers in registration order and the first that matches a request
+// handles it (exact URL or URL + "/...", "*" suffix for a prefix; static
+// handlers match a prefix and try "<file>.gz" too), as the library does.
+//
+// One server thread owns every connection and runs every handler, like the
+// AsyncTCP task on the device. Requests are HTTP/1.1 with keep-alive;
+// parameters come from the query string and from url-encoded POST bodies.
+// A response is built in memory and sent with a Content-Length.
+#ifndef ARDUINO_HOST_ESP_ASYNC_WEB_SERVER_H
+#define ARDUINO_HOST_ESP_ASYNC_WEB_SERVER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "Arduino.h"
+#include "FS.h"
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000,
+  HTTP_PATCH = 0b00010000,
+  HTTP_HEAD = 0b00100000,
+  HTTP_OPTIONS = 0b01000000,
+  HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+
+class AsyncWebParameter {
+public:
+  AsyncWebParameter(const String& name, const String& value, bool form = false)
+      : _name(name), _value(value), _isForm(form) {}
+  const String& name() const { return _name; }
+  const String& value() const { return _value; }
+  bool isPost() const { return _isForm; }
+  bool isFile() const { return false; }
+
+private:
+  String _name;
+  String _value;
+  bool _isForm;
+};
+
+class AsyncWebServerResponse {
+public:
+  AsyncWebServerResponse(int code = 200, const String& contentType = String())
+      : _code(code), _contentType(contentType) {}
+  virtual ~AsyncWebServerResponse() {}
+  void addHeader(const String& name, const String& value) { _headers.push_back({name, value}); }
+  void setCode(int code) { _code = code; }
+
+  // Host side
+  int code() const { return _code; }
+  const String& contentType() const { return _contentType; }
+  const std::vector<std::pair<String, String>>& headers() const { return _headers; }
+  std::string& body() { return _body; }
+
+protected:
+  int _code;
+  String _contentType;
+  std::vector<std::pair<String, String>> _headers;
+  std::string _body;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+  AsyncResponseStream(const String& contentType, size_t bufferSize) : AsyncWebServerResponse(200, contentType) {
+    _body.reserve(bufferSize);
+  }
+  size_t write(uint8_t c) override { _body += (char)c; return 1; }
+  size_t write(const uint8_t* data, size_t length) override { _body.append((const char*)data, length); return length; }
+  using Print::write;
+};
+
+class AsyncWebServerRequest {
+public:
+  WebRequestMethodComposite method() const { return _method; }
+  const String& url() const { return _url; }
+
+  bool hasHeader(const String& name) const;
+  String header(const char* name) const;
+
+  bool hasParam(const String& name, bool post = false, bool file = false) const;
+  AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+  size_t params() const { return _params.size(); }
+  AsyncWebParameter* getParam(size_t index) const { return index < _params.size() ? _params[index].get() : nullptr; }
+
+  void send(AsyncWebServerResponse* response);
+  void send(int code, const String& contentType = String(), const String& content = String());
+  void send(FS& fs, const String& path, const String& contentType = String(), bool download = false);
+  void redirect(const String& url);
+
+  AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String());
+  AsyncWebServerResponse* beginResponse(FS& fs, const String& path, const String& contentType = String(), bool download = false);
+  AsyncResponseStream* beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+
+  // Host side
+  AsyncWebServerResponse* response() const { return _response.get(); }
+
+private:
+  friend class AsyncWebServer;
+  WebRequestMethodComposite _method = HTTP_GET;
+  String _url;
+  std::vector<std::pair<String, String>> _headers;
+  std::vector<std::unique_ptr<AsyncWebParameter>> _params;
+  std::unique_ptr<AsyncWebServerResponse> _response;
+};
+
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() {}
+  virtual bool canHandle(AsyncWebServerRequest* request) = 0;
+  virtual void handleRequest(AsyncWebServerRequest* request) = 0;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+public:
+  AsyncCallbackWebHandler(const String& uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest)
+      : _uri(uri), _method(method), _onRequest(onRequest) {}
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override { _onRequest(request); }
+
+private:
+  String _uri;
+  WebRequestMethodComposite _method;
+  ArRequestHandlerFunction _onRequest;
+};
+
+class AsyncStaticWebHandler : public AsyncWebHandler {
+public:
+  AsyncStaticWebHandler(const String& uri, FS& fs, const String& path, const char* cacheControl)
+      : _uri(uri), _fs(fs), _path(path), _cacheControl(cacheControl ? cacheControl : "") {}
+  bool canHandle(AsyncWebServerRequest* request) override;
+  void handleRequest(AsyncWebServerRequest* request) override;
+  AsyncStaticWebHandler& setCacheControl(const char* cacheControl) { _cacheControl = cacheControl; return *this; }
+
+private:
+  String _uri;
+  FS& _fs;
+  String _path;
+  String _cacheControl;
+};
+
+class AsyncWebServer {
+public:
+  explicit AsyncWebServer(uint16_t port) : _port(port) {}
+  ~AsyncWebServer() { end(); }
+
+  AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+  AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest) { return on(uri, HTTP_ANY, onRequest); }
+  AsyncStaticWebHandler& serveStatic(const char* uri, FS& fs, const char* path, const char* cacheControl = nullptr);
+  void onNotFound(ArRequestHandlerFunction fn) { _notFound = fn; }
+  void begin();
+  void end();
+
+  // Host side: run a request without a socket
+  void handle(AsyncWebServerRequest& request);
+
+private:
+  uint16_t _port;
+  std::vector<std::unique_ptr<AsyncWebHandler>> _handlers;
+  ArRequestHandlerFunction _notFound;
+  int _listenFd = -1;
+  std::atomic<bool> _running{false};
+  std::thread _thread;
+
+  void serve();
+  int parseRequest(std::string& input, AsyncWebServerRequest& request, bool& keepAlive);   // 1 taken, 0 incomplete, -1 malformed
+};
+
+// Host only. The firmware binds port 80; host tools pick another here,
+// before begin(). 0 means any free port, see webServerPort().
+void setWebServerPort(uint16_t port);
+uint16_t webServerPort();          // The port the last begin() bound
+
+// Host only: called on the server thread around every handler, e.g. to
+// measure what a request costs. `after` may add headers to the response.
+void setWebRequestHooks(std::function<void(AsyncWebServerRequest&)> before,
+                        std::function<void(AsyncWebServerRequest&, AsyncWebServerResponse&)> after);
+
+#endif
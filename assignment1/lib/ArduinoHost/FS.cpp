@@ -0,0 +1,189 @@
+// FS.cpp - stdio-backed implementation of the host fs::FS / fs::File shims
+#include "FS.h"
+#include "SPIFFS.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+fs::SPIFFSFS SPIFFS;
+
+namespace fs {
+
+class FileImpl {
+public:
+  FILE* fp = nullptr;
+  String path;       // Path as seen by the firmware ("/data_5min.bin")
+  String hostPath;   // Path on the host filesystem
+  bool directory = false;
+  std::vector<String> entries; // Directory listing for openNextFile()
+  size_t nextEntry = 0;
+  String root;
+
+  ~FileImpl() { if (fp) fclose(fp); }
+};
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t* buf, size_t size) {
+  if (!_impl || !_impl->fp) return 0;
+  return fwrite(buf, 1, size, _impl->fp);
+}
+
+int File::available() {
+  if (!_impl || !_impl->fp) return 0;
+  long remaining = (long)size() - (long)position();
+  return remaining > 0 ? (int)remaining : 0;
+}
+
+int File::read() {
+  if (!_impl || !_impl->fp) return -1;
+  return fgetc(_impl->fp);
+}
+
+int File::peek() {
+  if (!_impl || !_impl->fp) return -1;
+  int c = fgetc(_impl->fp);
+  if (c != EOF) ungetc(c, _impl->fp);
+  return c;
+}
+
+void File::flush() {
+  if (_impl && _impl->fp) fflush(_impl->fp);
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+  if (!_impl || !_impl->fp) return 0;
+  return fread(buf, 1, size, _impl->fp);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!_impl || !_impl->fp) return false;
+  return fseek(_impl->fp, pos, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+}
+
+size_t File::position() const {
+  if (!_impl || !_impl->fp) return 0;
+  long pos = ftell(_impl->fp);
+  return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+  if (!_impl) return 0;
+  if (_impl->fp) fflush(_impl->fp);
+  struct stat st;
+  if (stat(_impl->hostPath.c_str(), &st) != 0) return 0;
+  return (size_t)st.st_size;
+}
+
+void File::close() {
+  _impl.reset();
+}
+
+File::operator bool() const {
+  return _impl && (_impl->fp || _impl->directory);
+}
+
+const char* File::path() const { return _impl ? _impl->path.c_str() : nullptr; }
+
+const char* File::name() const {
+  if (!_impl) return nullptr;
+  int slash = _impl->path.lastIndexOf('/');
+  return _impl->path.c_str() + (slash < 0 ? 0 : slash + 1);
+}
+
+bool File::isDirectory() const { return _impl && _impl->directory; }
+
+File File::openNextFile(const char* mode) {
+  if (!_impl || !_impl->directory || _impl->nextEntry >= _impl->entries.size()) return File();
+  String child = _impl->path;
+  if (!child.endsWith("/")) child += "/";
+  child += _impl->entries[_impl->nextEntry++];
+  FS fs;
+  fs.setHostRoot(_impl->root);
+  return fs.open(child.c_str(), mode);
+}
+
+void File::rewindDirectory() {
+  if (_impl) _impl->nextEntry = 0;
+}
+
+String FS::hostPath(const char* path) const {
+  String result = _root;
+  if (path[0] != '/') result += "/";
+  result += path;
+  return result;
+}
+
+File FS::open(const char* path, const char* mode, const bool create) {
+  (void)create;
+  auto impl = std::make_shared<FileImpl>();
+  impl->path = path;
+  impl->hostPath = hostPath(path);
+  impl->root = _root;
+
+  struct stat st;
+  if (stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    DIR* dir = opendir(impl->hostPath.c_str());
+    if (!dir) return File();
+    while (struct dirent* entry = readdir(dir)) {
+      String name = entry->d_name;
+      if (name != "." && name != "..") impl->entries.push_back(name);
+    }
+    closedir(dir);
+    impl->directory = true;
+    return File(impl);
+  }
+
+  // Binary modes keep the host behaviour identical to SPIFFS
+  String hostMode = String(mode) + "b";
+  impl->fp = fopen(impl->hostPath.c_str(), hostMode.c_str());
+  if (!impl->fp) return File();
+  return File(impl);
+}
+
+bool FS::exists(const char* path) {
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+  return ::unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+  return ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+  return ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+bool FS::rmdir(const char* path) {
+  return ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+bool SPIFFSFS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles, const char* partitionLabel) {
+  (void)formatOnFail; (void)basePath; (void)maxOpenFiles; (void)partitionLabel;
+  struct stat st;
+  return stat(_root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool SPIFFSFS::format() {
+  return false;
+}
+
+size_t SPIFFSFS::totalBytes() {
+  return 0xE0000; // huge_app.csv SPIFFS partition size
+}
+
+size_t SPIFFSFS::usedBytes() {
+  size_t used = 0;
+  File root = open("/");
+  for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+    used += file.size();
+  }
+  return used;
+}
+
+} // namespace fs
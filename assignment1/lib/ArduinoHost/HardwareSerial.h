@@ -0,0 +1,38 @@
+// HardwareSerial.h - host stand-in for the ESP32 Serial port
+// Writes go to stdout. Host tools can mute the firmware's chatter with
+// Serial.setQuiet(true) when measuring throughput.
+#ifndef ARDUINO_HOST_HARDWARESERIAL_H
+#define ARDUINO_HOST_HARDWARESERIAL_H
+
+#include "Stream.h"
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  void setQuiet(bool quiet) { _quiet = quiet; }
+  bool isQuiet() const { return _quiet; }
+
+  size_t write(uint8_t c) override {
+    if (_quiet) return 1;
+    return fputc(c, stdout) == EOF ? 0 : 1;
+  }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (_quiet) return size;
+    return fwrite(buffer, 1, size, stdout);
+  }
+  using Print::write;
+  void flush() override { fflush(stdout); }
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  operator bool() const { return true; }
+
+private:
+  bool _quiet = false;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,60 @@
+// HostClock.cpp - real or virtual time source for host builds
+#include "HostClock.h"
+#include "HardwareSerial.h"
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+
+extern "C" time_t __real_time(time_t* tloc);
+
+static bool virtualClock = false;
+static uint64_t virtualMicros = 0;   // Monotonic time since "boot"
+static uint64_t virtualEpochMs = 0;  // Wall-clock time in milliseconds
+
+static uint64_t realMicros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long hostClockMillis() {
+  return (unsigned long)((virtualClock ? virtualMicros : realMicros()) / 1000);
+}
+
+unsigned long hostClockMicros() {
+  return (unsigned long)(virtualClock ? virtualMicros : realMicros());
+}
+
+void hostClockDelay(unsigned long ms) {
+  if (virtualClock) {
+    hostClockAdvanceMillis(ms);
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+void hostClockSetEpoch(uint32_t epoch) {
+  virtualClock = true;
+  virtualEpochMs = (uint64_t)epoch * 1000;
+}
+
+void hostClockAdvanceMillis(unsigned long ms) {
+  virtualClock = true;
+  virtualMicros += (uint64_t)ms * 1000;
+  virtualEpochMs += ms;
+}
+
+void hostClockUseRealTime() {
+  virtualClock = false;
+}
+
+bool hostClockIsVirtual() {
+  return virtualClock;
+}
+
+extern "C" time_t __wrap_time(time_t* tloc) {
+  if (!virtualClock) return __real_time(tloc);
+  time_t now = (time_t)(virtualEpochMs / 1000);
+  if (tloc) *tloc = now;
+  return now;
+}
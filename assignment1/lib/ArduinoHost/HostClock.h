@@ -0,0 +1,27 @@
+// HostClock.h - real or virtual time source for host builds
+// By default millis()/micros() follow the monotonic clock and time() the
+// wall clock. Once a tool sets a virtual epoch, all of them are driven by
+// hostClockSetEpoch()/hostClockAdvanceMillis() instead, so the firmware's
+// time-based logic can be replayed far faster than real time.
+//
+// time() is intercepted at link time: host environments link with
+// -Wl,--wrap=time so firmware calls land in __wrap_time().
+#ifndef ARDUINO_HOST_HOSTCLOCK_H
+#define ARDUINO_HOST_HOSTCLOCK_H
+
+#include <cstdint>
+#include <ctime>
+
+unsigned long hostClockMillis();
+unsigned long hostClockMicros();
+void hostClockDelay(unsigned long ms);
+
+// Switch to the virtual clock and set the wall-clock epoch (seconds)
+void hostClockSetEpoch(uint32_t epoch);
+// Advance the virtual clock (both millis() and time())
+void hostClockAdvanceMillis(unsigned long ms);
+// Return to the real clocks
+void hostClockUseRealTime();
+bool hostClockIsVirtual();
+
+#endif
@@ -0,0 +1,28 @@
+// IPAddress.h - host stand-in for the Arduino IPAddress class
+#ifndef ARDUINO_HOST_IPADDRESS_H
+#define ARDUINO_HOST_IPADDRESS_H
+
+#include <cstdint>
+#include "WString.h"
+
+class IPAddress {
+public:
+  IPAddress() : _bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+
+  uint8_t operator[](int index) const { return _bytes[index]; }
+  bool operator==(const IPAddress& other) const {
+    return _bytes[0] == other._bytes[0] && _bytes[1] == other._bytes[1] &&
+           _bytes[2] == other._bytes[2] && _bytes[3] == other._bytes[3];
+  }
+  String toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(buffer);
+  }
+
+private:
+  uint8_t _bytes[4];
+};
+
+#endif
@@ -0,0 +1,39 @@
+// Stream.h - host stand-in for the Arduino Stream base class
+#ifndef ARDUINO_HOST_STREAM_H
+#define ARDUINO_HOST_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout() const { return _timeout; }
+
+  // Host streams never block, so reads simply stop at end of data
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+      int c = read();
+      if (c < 0) break;
+      buffer[count++] = (char)c;
+    }
+    return count;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+
+  String readString() {
+    String result;
+    int c;
+    while ((c = read()) >= 0) result.concat((char)c);
+    return result;
+  }
+
+protected:
+  unsigned long _timeout = 1000;
+};
+
+#endif
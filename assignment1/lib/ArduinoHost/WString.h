@@ -0,0 +1,157 @@
+// WString.h - host stand-in for the Arduino String class
+// Backed by std::string. Only the parts of the API used by the SmartAC
+// sources (and by ArduinoJson's String adapter) are provided.
+#ifndef ARDUINO_HOST_WSTRING_H
+#define ARDUINO_HOST_WSTRING_H
+
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+class StringSumHelper;
+
+class String {
+public:
+  String() {}
+  String(const char* str) : _s(str ? str : "") {}
+  String(const std::string& str) : _s(str) {}
+  String(const String& other) = default;
+  String(String&& other) = default;
+  explicit String(char c) : _s(1, c) {}
+  String(int value, unsigned char base = 10) { fromLong(value, base); }
+  String(unsigned int value, unsigned char base = 10) { fromULong(value, base); }
+  String(long value, unsigned char base = 10) { fromLong(value, base); }
+  String(unsigned long value, unsigned char base = 10) { fromULong(value, base); }
+  String(float value, unsigned char decimals = 2) { fromDouble(value, decimals); }
+  String(double value, unsigned char decimals = 2) { fromDouble(value, decimals); }
+
+  String& operator=(const String& other) = default;
+  String& operator=(String&& other) = default;
+  String& operator=(const char* str) { _s = str ? str : ""; return *this; }
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return (unsigned int)_s.length(); }
+  bool isEmpty() const { return _s.empty(); }
+  bool reserve(unsigned int size) { _s.reserve(size); return true; }
+  const std::string& str() const { return _s; }
+
+  bool concat(const String& other) { _s += other._s; return true; }
+  bool concat(const char* str) { if (str) _s += str; return true; }
+  bool concat(const char* str, unsigned int len) { if (str) _s.append(str, len); return true; }
+  bool concat(char c) { _s += c; return true; }
+  bool concat(int value) { return concat(String(value)); }
+  bool concat(unsigned int value) { return concat(String(value)); }
+  bool concat(long value) { return concat(String(value)); }
+  bool concat(unsigned long value) { return concat(String(value)); }
+  bool concat(float value) { return concat(String(value)); }
+  bool concat(double value) { return concat(String(value)); }
+
+  template <typename T>
+  String& operator+=(const T& value) { concat(value); return *this; }
+
+  char operator[](unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+  char& operator[](unsigned int index) { return _s[index]; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+
+  bool equals(const String& other) const { return _s == other._s; }
+  bool equalsIgnoreCase(const String& other) const {
+    if (_s.size() != other._s.size()) return false;
+    for (size_t i = 0; i < _s.size(); ++i) {
+      if (std::tolower((unsigned char)_s[i]) != std::tolower((unsigned char)other._s[i])) return false;
+    }
+    return true;
+  }
+  int compareTo(const String& other) const { return _s.compare(other._s); }
+
+  bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+  bool endsWith(const String& suffix) const {
+    return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+  }
+
+  int indexOf(char c, unsigned int from = 0) const { return toIndex(_s.find(c, from)); }
+  int indexOf(const String& str, unsigned int from = 0) const { return toIndex(_s.find(str._s, from)); }
+  int lastIndexOf(char c) const { return toIndex(_s.rfind(c)); }
+
+  String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    return String(_s.substr(from, to - from));
+  }
+
+  void replace(const String& find, const String& replacement) {
+    if (find._s.empty()) return;
+    size_t pos = 0;
+    while ((pos = _s.find(find._s, pos)) != std::string::npos) {
+      _s.replace(pos, find._s.size(), replacement._s);
+      pos += replacement._s.size();
+    }
+  }
+  void toLowerCase() { for (char& c : _s) c = (char)std::tolower((unsigned char)c); }
+  void toUpperCase() { for (char& c : _s) c = (char)std::toupper((unsigned char)c); }
+  void trim() {
+    size_t start = _s.find_first_not_of(" \t\r\n");
+    size_t end = _s.find_last_not_of(" \t\r\n");
+    _s = (start == std::string::npos) ? std::string() : _s.substr(start, end - start + 1);
+  }
+
+  long toInt() const { return std::strtol(_s.c_str(), nullptr, 10); }
+  float toFloat() const { return std::strtof(_s.c_str(), nullptr); }
+  double toDouble() const { return std::strtod(_s.c_str(), nullptr); }
+
+  friend bool operator==(const String& a, const String& b) { return a._s == b._s; }
+  friend bool operator==(const String& a, const char* b) { return a._s == (b ? b : ""); }
+  friend bool operator!=(const String& a, const String& b) { return a._s != b._s; }
+  friend bool operator!=(const String& a, const char* b) { return !(a == b); }
+  friend bool operator<(const String& a, const String& b) { return a._s < b._s; }
+  friend bool operator<=(const String& a, const String& b) { return a._s <= b._s; }
+  friend bool operator>(const String& a, const String& b) { return a._s > b._s; }
+  friend bool operator>=(const String& a, const String& b) { return a._s >= b._s; }
+
+  friend StringSumHelper operator+(const String& a, const String& b);
+  friend StringSumHelper operator+(const String& a, const char* b);
+  friend StringSumHelper operator+(const char* a, const String& b);
+
+private:
+  static int toIndex(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+  void fromLong(long value, unsigned char base) {
+    if (base == 10) { _s = std::to_string(value); return; }
+    if (value < 0) { fromULong((unsigned long)-value, base); _s.insert(0, "-"); return; }
+    fromULong((unsigned long)value, base);
+  }
+  void fromULong(unsigned long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char buf[sizeof(unsigned long) * 8 + 1];
+    char* p = buf + sizeof(buf);
+    *--p = 0;
+    do {
+      unsigned digit = (unsigned)(value % base);
+      *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+      value /= base;
+    } while (value);
+    _s = p;
+  }
+  void fromDouble(double value, unsigned char decimals) {
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    _s = buf;
+  }
+
+  std::string _s;
+};
+
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& s) : String(s) {}
+  StringSumHelper(const char* s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String& a, const String& b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String& a, const char* b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const char* a, const String& b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String& a, char b) { StringSumHelper r(a); r.concat(b); return r; }
+
+#endif
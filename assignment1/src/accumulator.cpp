@@ -0,0 +1,107 @@
+#include <accumulator.h>
+#include <math.h>
+
+SampleChannel::SampleChannel(float limit) : limit(limit), windowCount(0), windowNext(0), rejectStreak(0) {
+    reset();
+}
+
+void SampleChannel::reset() {
+    count = 0;
+    offset = 0;
+    sum = 0;
+    sumSquares = 0;
+    min = 0;
+    max = 0;
+}
+
+bool SampleChannel::isOutlier(float value) const {
+    if (windowCount < ACCUMULATOR_WINDOW) return false;
+
+    // Median of the window by insertion sort; it is only a handful of values
+    float sorted[ACCUMULATOR_WINDOW];
+    for (size_t i = 0; i < ACCUMULATOR_WINDOW; ++i) {
+        float v = window[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            --j;
+        }
+        sorted[j] = v;
+    }
+    return fabsf(value - sorted[ACCUMULATOR_WINDOW / 2]) > limit;
+}
+
+void SampleChannel::reject() {
+    // A run of rejections means the level really changed; follow it
+    if (++rejectStreak >= ACCUMULATOR_WINDOW) {
+        windowCount = 0;
+        windowNext = 0;
+        rejectStreak = 0;
+    }
+}
+
+void SampleChannel::add(float value) {
+    window[windowNext] = value;
+    windowNext = (windowNext + 1) % ACCUMULATOR_WINDOW;
+    if (windowCount < ACCUMULATOR_WINDOW) windowCount++;
+    rejectStreak = 0;
+
+    if (count == 0) {
+        offset = value;
+        min = value;
+        max = value;
+    } else {
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    double delta = value - offset;
+    sum += delta;
+    sumSquares += delta * delta;
+    count++;
+}
+
+ChannelStats SampleChannel::stats() const {
+    ChannelStats stats = {NAN, NAN, NAN, NAN};
+    if (count == 0) return stats;
+
+    double mean = sum / count;
+    double variance = sumSquares / count - mean * mean;
+    stats.mean = offset + mean;
+    stats.min = min;
+    stats.max = max;
+    stats.stddev = variance > 0 ? sqrt(variance) : 0;
+    return stats;
+}
+
+SampleAccumulator::SampleAccumulator()
+    : temperature(ACCUMULATOR_TEMP_LIMIT), humidity(ACCUMULATOR_HUM_LIMIT), rejected(0) {}
+
+bool SampleAccumulator::add(float temp, float hum) {
+    bool tempOutlier = temperature.isOutlier(temp);
+    bool humOutlier = humidity.isOutlier(hum);
+    if (tempOutlier || humOutlier) {
+        if (tempOutlier) temperature.reject();
+        if (humOutlier) humidity.reject();
+        rejected++;
+        return false;
+    }
+
+    temperature.add(temp);
+    humidity.add(hum);
+    return true;
+}
+
+SampleRollup SampleAccumulator::rollup() const {
+    SampleRollup result;
+    result.count = temperature.size();
+    result.rejected = rejected;
+    result.temperature = temperature.stats();
+    result.humidity = humidity.stats();
+    return result;
+}
+
+void SampleAccumulator::reset() {
+    temperature.reset();
+    humidity.reset();
+    rejected = 0;
+}
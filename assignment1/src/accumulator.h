@@ -0,0 +1,78 @@
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+#include <Arduino.h>
+
+// Fixed-size accumulator for the 15-second samples between 5-minute
+// averages. Keeps running count, sum, sum of squares, min and max per
+// channel, so memory stays constant however long the average is delayed
+// and the average is O(1). No heap allocation.
+//
+// A DHT read occasionally returns garbage that still passes the isnan()
+// check. Each channel keeps the last few accepted samples; once that window
+// is full a sample further than the channel's limit from the window median
+// is rejected, and the pair is dropped. If the window rejects
+// ACCUMULATOR_WINDOW samples in a row the reading really has moved, so the
+// window restarts from the new level.
+
+const size_t ACCUMULATOR_WINDOW = 5;
+const float ACCUMULATOR_TEMP_LIMIT = 3.0;     // °C from the window median
+const float ACCUMULATOR_HUM_LIMIT = 15.0;     // % RH from the window median
+
+struct ChannelStats {
+    float mean;
+    float min;
+    float max;
+    float stddev;                   // Population standard deviation
+};
+
+struct SampleRollup {
+    uint32_t count;                 // Samples accepted
+    uint32_t rejected;              // Samples dropped as outliers
+    ChannelStats temperature;
+    ChannelStats humidity;
+};
+
+class SampleChannel {
+public:
+    explicit SampleChannel(float limit);
+
+    bool isOutlier(float value) const;
+    void reject();                  // Counts an outlier; a run of them restarts the window
+    void add(float value);
+    void reset();                   // Starts a new period; keeps the outlier window
+    ChannelStats stats() const;
+    uint32_t size() const { return count; }
+
+private:
+    float limit;
+    float window[ACCUMULATOR_WINDOW];
+    size_t windowCount;
+    size_t windowNext;
+    size_t rejectStreak;
+
+    uint32_t count;
+    float offset;                   // First value of the period; sums are taken relative to it
+    double sum;
+    double sumSquares;
+    float min;
+    float max;
+};
+
+class SampleAccumulator {
+public:
+    SampleAccumulator();
+
+    bool add(float temp, float hum); // False if the pair was rejected
+    bool empty() const { return temperature.size() == 0; }
+    uint32_t count() const { return temperature.size(); }
+    SampleRollup rollup() const;
+    void reset();
+
+private:
+    SampleChannel temperature;
+    SampleChannel humidity;
+    uint32_t rejected;
+};
+
+#endif
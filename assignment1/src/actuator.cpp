@@ -0,0 +1,79 @@
+// actuator.cpp
+#include <actuator.h>
+#include <ir_frame.h>
+
+static ACTransmitter acTransmitter = nullptr;
+static unsigned long minSendIntervalMs = ACTUATOR_MIN_SEND_INTERVAL;
+static unsigned long resyncIntervalMs = ACTUATOR_RESYNC_INTERVAL;
+
+// Until we have sent a frame we assume the AC matches our boot default (set in
+// setupActuator), so a fresh boot never blasts a frame at the AC before the
+// rules ask for one.
+static ACState acknowledgedState;
+static bool hasSent = false;
+static unsigned long lastSendTime = 0;
+static unsigned long lastChangeTime = 0;
+static ActuatorStats stats = {0, 0, 0, 0};
+
+void setupActuator(ACTransmitter transmitter, unsigned long minSendInterval, unsigned long resyncInterval) {
+    acTransmitter = transmitter;
+    minSendIntervalMs = minSendInterval;
+    resyncIntervalMs = resyncInterval;
+    acknowledgedState = ac_state;
+}
+
+// Set points that round to the same frame are the same state to the AC
+bool isSameACState(const ACState& a, const ACState& b) {
+    return a.is_on == b.is_on && irTemperature(a.current_temp) == irTemperature(b.current_temp) &&
+           a.mode == b.mode && a.fan_on == b.fan_on;
+}
+
+bool actuatorService(const ACState& desired, unsigned long now) {
+    if (!acTransmitter) return false;
+
+    bool changed = !isSameACState(desired, acknowledgedState);
+    bool resyncDue = hasSent && (now - lastSendTime) >= resyncIntervalMs;
+    if (!changed && !resyncDue) return false;
+
+    // Hold changes back until the minimum interval has passed; the latest
+    // desired state is picked up on a later call, so bursts collapse to one frame.
+    if (hasSent && (now - lastSendTime) < minSendIntervalMs) {
+        stats.rateLimited++;
+        return false;
+    }
+
+    lastSendTime = now;
+    hasSent = true;
+    if (!acTransmitter(desired)) {
+        Serial.println("Failed to transmit AC state");
+        stats.failures++;
+        return false;
+    }
+
+    if (changed) {
+        stats.framesSent++;
+        lastChangeTime = now;
+        Serial.printf("AC state sent - Power: %s, Mode: %s, Temp: %.1f, Fan: %s\n",
+                      desired.is_on ? "on" : "off", desired.mode.c_str(), desired.current_temp, desired.fan_on ? "on" : "off");
+    } else {
+        stats.resyncs++;
+    }
+    acknowledgedState = desired;
+    return true;
+}
+
+const ACState& getAcknowledgedACState() {
+    return acknowledgedState;
+}
+
+bool hasACChanged() {
+    return stats.framesSent > 0;
+}
+
+unsigned long getLastACChangeTime() {
+    return lastChangeTime;
+}
+
+const ActuatorStats& getActuatorStats() {
+    return stats;
+}
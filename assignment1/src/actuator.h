@@ -0,0 +1,37 @@
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include <Arduino.h>
+#include <rules.h>
+
+// The actuator sits between rule evaluation and the IR transmitter. Each
+// evaluation pass reduces its actions to one desired ACState; the actuator
+// diffs that against the last state the AC acknowledged (i.e. the last frame
+// we sent) and only transmits when something changed. Sends are rate limited
+// and the acknowledged state is re-sent periodically in case a frame was
+// missed or someone used the physical remote.
+
+// Encodes and sends one full frame for the given state. Returns false on failure.
+typedef bool (*ACTransmitter)(const ACState& state);
+
+struct ActuatorStats {
+  uint32_t framesSent;     // Frames sent because the desired state changed
+  uint32_t resyncs;        // Frames re-sent by the resync timer
+  uint32_t rateLimited;    // Service calls that had a change pending but were held back
+  uint32_t failures;       // Transmit failures
+};
+
+const unsigned long ACTUATOR_MIN_SEND_INTERVAL = 2000;     // 2 seconds between frames
+const unsigned long ACTUATOR_RESYNC_INTERVAL = 900000;     // Re-send every 15 minutes
+
+void setupActuator(ACTransmitter transmitter,
+                   unsigned long minSendInterval = ACTUATOR_MIN_SEND_INTERVAL,
+                   unsigned long resyncInterval = ACTUATOR_RESYNC_INTERVAL);
+bool actuatorService(const ACState& desired, unsigned long now); // Returns true if a frame was sent
+bool isSameACState(const ACState& a, const ACState& b);
+const ACState& getAcknowledgedACState();
+bool hasACChanged();                  // A frame has changed the AC state since boot
+unsigned long getLastACChangeTime();  // millis() of the last frame that changed the AC state
+const ActuatorStats& getActuatorStats();
+
+#endif
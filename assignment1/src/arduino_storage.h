@@ -0,0 +1,177 @@
+#ifndef ARDUINO_STORAGE_H
+#define ARDUINO_STORAGE_H
+
+#include <storage.h>
+#include <FS.h>
+#include <utility>
+
+// Storage over an fs::FS-style filesystem: SPIFFS and LittleFS on the device,
+// and the fault-injecting flash model in tools/crash_harness on the host, so
+// the replace protocol checked there is the one the firmware runs. The
+// filesystem only needs open/exists/remove/rename/begin/totalBytes/usedBytes
+// and files with the fs::File calls used below.
+//
+// replace() when rename cannot overwrite (SPIFFS):
+//   1. write <path>.tmp            a cut here leaves <path> untouched
+//   2. rename .tmp -> <path>.new   the commit point: a .new is always complete
+//   3. remove <path>
+//   4. rename .new -> <path>
+// Until step 4 is done a read of <path> falls back to <path>.new, and begin()
+// finishes any replace a power cut interrupted and deletes stale .tmp files.
+// So there is never a moment with no complete copy on flash. A .new found at
+// step 2 is left by a replace whose step 4 failed and may be the only copy,
+// so that replace is finished first. With an atomic rename (LittleFS) step 1
+// is followed by a rename straight over <path>.
+template <class Filesystem>
+class ArduinoStorage : public Storage {
+public:
+    ArduinoStorage(Filesystem& fs, const char* label, bool atomicRename)
+        : fs(fs), label(label), atomicRename(atomicRename) {}
+
+    const char* name() const override { return label; }
+
+    bool begin(bool formatOnFail) override {
+        if (!fs.begin(formatOnFail)) return false;
+        recoverReplaces("/");
+        return true;
+    }
+
+    bool exists(const char* path) override {
+        return fs.exists(path) || (!atomicRename && fs.exists(committedPath(path).c_str()));
+    }
+
+    bool stat(const char* path, StorageStat& info) override {
+        auto file = openForRead(path);
+        if (!file) return false;
+        info.size = file.size();
+        info.isDirectory = file.isDirectory();
+        file.close();
+        return true;
+    }
+
+    bool read(const char* path, std::vector<uint8_t>& contents) override {
+        auto file = openForRead(path);
+        if (!file || file.isDirectory()) return false;
+        contents.resize(file.size());
+        size_t n = contents.empty() ? 0 : file.read(contents.data(), contents.size());
+        file.close();
+        return n == contents.size();
+    }
+
+    size_t readAt(const char* path, size_t offset, uint8_t* buffer, size_t length) override {
+        auto file = openForRead(path);
+        if (!file) return 0;
+        size_t n = file.seek(offset) ? file.read(buffer, length) : 0;
+        file.close();
+        return n;
+    }
+
+    bool append(const char* path, const uint8_t* data, size_t length) override {
+        auto file = fs.open(path, FILE_APPEND);
+        if (!file) return false;
+        size_t written = file.write(data, length);
+        file.close();
+        return written == length;
+    }
+
+    bool replace(const char* path, const uint8_t* data, size_t length) override {
+        String newPath = committedPath(path);
+        if (!atomicRename && fs.exists(newPath.c_str()) && !finishReplace(path, newPath)) {
+            Serial.printf("Failed to finish the previous write of %s\n", path);
+            return false;
+        }
+
+        String tempPath = String(path) + ".tmp";
+        auto file = fs.open(tempPath.c_str(), FILE_WRITE);
+        if (!file) {
+            Serial.printf("Failed to open %s for writing\n", tempPath.c_str());
+            return false;
+        }
+        size_t written = file.write(data, length);
+        file.close();
+        if (written != length) {
+            Serial.printf("Short write to %s (%u of %u bytes)\n", tempPath.c_str(), written, length);
+            fs.remove(tempPath.c_str());
+            return false;
+        }
+        if (atomicRename) return fs.rename(tempPath.c_str(), path);
+
+        if (!fs.rename(tempPath.c_str(), newPath.c_str())) {
+            Serial.printf("Failed to commit %s\n", newPath.c_str());
+            fs.remove(tempPath.c_str());
+            return false;
+        }
+        return finishReplace(path, newPath);
+    }
+
+    bool remove(const char* path) override {
+        bool removed = fs.remove(path);
+        String newPath = committedPath(path);    // And a copy waiting to replace it
+        if (!atomicRename && fs.exists(newPath.c_str())) removed = fs.remove(newPath.c_str()) || removed;
+        return removed;
+    }
+
+    bool list(const char* directory, std::vector<StorageEntry>& entries) override {
+        entries.clear();
+        auto dir = fs.open(directory);
+        if (!dir || !dir.isDirectory()) return false;
+        String prefix = directory;
+        if (!prefix.endsWith("/")) prefix += "/";
+        for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+            // SPIFFS reports the full path, LittleFS just the name
+            String path = file.name();
+            if (!path.startsWith("/")) path = prefix + path;
+            entries.push_back({path, file.isDirectory() ? 0 : file.size(), file.isDirectory()});
+            file.close();
+        }
+        dir.close();
+        return true;
+    }
+
+    size_t totalBytes() override { return fs.totalBytes(); }
+    size_t usedBytes() override { return fs.usedBytes(); }
+    fs::FS& filesystem() override { return fs; }
+
+private:
+    typedef decltype(std::declval<Filesystem&>().open("/")) FileHandle;   // fs::File on the device
+
+    Filesystem& fs;
+    const char* label;
+    bool atomicRename;
+
+    static String committedPath(const char* path) { return String(path) + ".new"; }
+
+    // Steps 3 and 4: the committed copy takes the place of <path>
+    bool finishReplace(const char* path, const String& newPath) {
+        fs.remove(path);
+        return fs.rename(newPath.c_str(), path);
+    }
+
+    // <path>, or the committed copy a replace is about to rename onto it
+    FileHandle openForRead(const char* path) {
+        auto file = fs.open(path, FILE_READ);
+        if (!file && !atomicRename) file = fs.open(committedPath(path).c_str(), FILE_READ);
+        return file;
+    }
+
+    // Finish what a power cut interrupted. SPIFFS lists every file under "/";
+    // on LittleFS only the top level is swept (no files are replaced deeper)
+    void recoverReplaces(const char* directory) {
+        std::vector<StorageEntry> entries;
+        if (!list(directory, entries)) return;
+        for (const StorageEntry& entry : entries) {
+            if (entry.isDirectory) continue;
+            String target = entry.path.substring(0, entry.path.length() - 4);
+            if (entry.path.endsWith(".tmp")) {
+                Serial.printf("Removing partial %s\n", entry.path.c_str());
+                fs.remove(entry.path.c_str());
+            } else if (entry.path.endsWith(".new")) {
+                Serial.printf("Completing interrupted write of %s\n", target.c_str());
+                if (atomicRename) fs.rename(entry.path.c_str(), target.c_str());
+                else finishReplace(target.c_str(), entry.path);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include <boot_profile.h>
+#include <atomic>
+#ifdef ESP32
+#include <esp_attr.h>
+#include <esp_system.h>
+#endif
+
+static const uint32_t BOOT_PROFILE_MAGIC = 0x424f4f54;  // "BOOT"
+
+// Both records start out as garbage after a power cycle; the magic tells
+#ifdef ESP32
+RTC_NOINIT_ATTR static BootProfile currentBoot;
+RTC_NOINIT_ATTR static BootProfile previousBoot;
+#else
+static BootProfile currentBoot;
+static BootProfile previousBoot;
+#endif
+
+static void readHeap(uint32_t& freeHeap, uint32_t& minFreeHeap) {
+#ifdef ESP32
+    freeHeap = ESP.getFreeHeap();
+    minFreeHeap = ESP.getMinFreeHeap();
+#else
+    freeHeap = 0;
+    minFreeHeap = 0;
+#endif
+}
+
+void beginBootProfile() {
+    uint32_t bootCount = 1;
+    if (currentBoot.magic == BOOT_PROFILE_MAGIC && currentBoot.phaseCount <= BOOT_PROFILE_MAX_PHASES) {
+        previousBoot = currentBoot;
+        bootCount = currentBoot.bootCount + 1;
+    } else {
+        previousBoot.magic = 0;
+    }
+
+    memset(&currentBoot, 0, sizeof(currentBoot));
+    currentBoot.magic = BOOT_PROFILE_MAGIC;
+    currentBoot.bootCount = bootCount;
+#ifdef ESP32
+    currentBoot.resetReason = esp_reset_reason();
+#else
+    (void)micros(); // The host clock counts from its first reading; make that "boot"
+#endif
+    strncpy(currentBoot.firmware, FIRMWARE_VERSION, sizeof(currentBoot.firmware) - 1);
+}
+
+void markBootPhase(const char* name) {
+    uint32_t count = currentBoot.phaseCount;
+    if (currentBoot.magic != BOOT_PROFILE_MAGIC || count >= BOOT_PROFILE_MAX_PHASES) return;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (strncmp(currentBoot.phases[i].name, name, BOOT_PHASE_NAME_LENGTH - 1) == 0) return;
+    }
+
+    BootPhase& phase = currentBoot.phases[count];
+    phase.endMicros = micros();
+    readHeap(phase.freeHeap, phase.minFreeHeap);
+    strncpy(phase.name, name, sizeof(phase.name) - 1);
+    phase.name[sizeof(phase.name) - 1] = 0;
+    // Publish the entry before the count; web handlers read from the other core
+    std::atomic_thread_fence(std::memory_order_release);
+    currentBoot.phaseCount = count + 1;
+
+    uint32_t start = count ? currentBoot.phases[count - 1].endMicros : 0;
+    Serial.printf("[boot] %-14s %8lu us  (+%lu us)  heap %u\n", phase.name,
+                  (unsigned long)phase.endMicros, (unsigned long)(phase.endMicros - start), phase.freeHeap);
+}
+
+void getBootProfile(BootProfile& current) {
+    uint32_t count = currentBoot.phaseCount;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    current = currentBoot;
+    current.phaseCount = count;
+}
+
+bool getPreviousBootProfile(BootProfile& previous) {
+    if (previousBoot.magic != BOOT_PROFILE_MAGIC) return false;
+    previous = previousBoot;
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <Arduino.h>
+
+// Boot phase profiler. setup() marks the end of each phase with
+// markBootPhase(); the mark stores micros() since boot and the free heap.
+// Milestones reached after setup() (WiFi, NTP, first sample) use the same
+// call. Each name is recorded once per boot.
+//
+// On the ESP32 the record lives in RTC memory that survives a software
+// reset, so after a reboot the previous boot's profile is still there next
+// to the current one (a power cycle clears both). /api/boot-profile serves
+// them. On the host build the record is plain static memory and the heap
+// readings are 0.
+
+const size_t BOOT_PROFILE_MAX_PHASES = 24;
+const size_t BOOT_PHASE_NAME_LENGTH = 14;
+const size_t BOOT_FIRMWARE_LENGTH = 24;
+
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION __DATE__ " " __TIME__
+#endif
+
+struct BootPhase {
+    char name[BOOT_PHASE_NAME_LENGTH];
+    uint16_t reserved;
+    uint32_t endMicros;              // Since boot
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;            // Low-water mark since boot
+};
+
+struct BootProfile {
+    uint32_t magic;
+    uint32_t bootCount;              // Boots since the RTC record was created
+    uint32_t resetReason;            // esp_reset_reason() on the ESP32
+    char firmware[BOOT_FIRMWARE_LENGTH];
+    uint32_t phaseCount;
+    BootPhase phases[BOOT_PROFILE_MAX_PHASES];
+};
+
+void beginBootProfile();             // First thing in setup()
+void markBootPhase(const char* name);
+
+// Copies of the current and previous boot; false if there is no previous one
+void getBootProfile(BootProfile& current);
+bool getPreviousBootProfile(BootProfile& previous);
+
+#endif
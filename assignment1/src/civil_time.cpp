@@ -0,0 +1,371 @@
+#include "civil_time.h"
+#include "seqlock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static Seqlock<TimeZone> localZone;     // Version 0 until the zone is first set
+
+// ---- Calendar ----
+
+int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yearOfEra = (uint32_t)(year - era * 400);                          // [0, 399]
+    const uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+    const uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;   // [0, 146096]
+    return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+void civilFromDays(int32_t days, int32_t& year, uint32_t& month, uint32_t& day) {
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t dayOfEra = (uint32_t)(days - era * 146097);
+    const uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const uint32_t mp = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = (int32_t)yearOfEra + era * 400 + (month <= 2);
+}
+
+bool isLeapYear(int32_t year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+uint8_t daysInMonth(int32_t year, uint32_t month) {
+    static const uint8_t lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : lengths[month - 1];
+}
+
+bool parseDate(const char* text, int32_t& days) {
+    int32_t fields[3] = {0, 0, 0};
+    const uint8_t widths[3] = {4, 2, 2};
+    for (int i = 0; i < 3; ++i) {
+        for (uint8_t j = 0; j < widths[i]; ++j, ++text) {
+            if (*text < '0' || *text > '9') return false;
+            fields[i] = fields[i] * 10 + (*text - '0');
+        }
+        if (*text++ != (i < 2 ? '-' : '\0')) return false;
+    }
+    if (fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > daysInMonth(fields[0], fields[1])) return false;
+    days = daysFromCivil(fields[0], fields[1], fields[2]);
+    return true;
+}
+
+static int32_t floorDiv(int64_t value, int32_t divisor) {
+    int64_t quotient = value / divisor;
+    if (value % divisor < 0) quotient--;
+    return (int32_t)quotient;
+}
+
+static void fillCivil(int32_t days, int32_t seconds, int32_t year, uint32_t month, uint32_t day, CivilTime& out) {
+    out.year = (int16_t)year;
+    out.month = (uint8_t)month;
+    out.day = (uint8_t)day;
+    out.hour = seconds / 3600;
+    out.minute = seconds / 60 % 60;
+    out.second = seconds % 60;
+    out.weekday = (uint8_t)((days % 7 + 11) % 7);     // 1970-01-01 was a Thursday
+}
+
+void utcToCivil(int64_t epoch, CivilTime& out) {
+    int32_t days = floorDiv(epoch, 86400);
+    int32_t year;
+    uint32_t month, day;
+    civilFromDays(days, year, month, day);
+    fillCivil(days, (int32_t)(epoch - (int64_t)days * 86400), year, month, day, out);
+    out.dst = false;
+    out.utcOffset = 0;
+}
+
+// ---- POSIX TZ ----
+
+// std offset [dst [offset] [,start[/time],end[/time]]]
+static bool parseName(const char*& p, char* name, size_t size) {
+    size_t length = 0;
+    if (*p == '<') {
+        // Quoted form, e.g. <+10>
+        ++p;
+        while (*p && *p != '>') {
+            if (length + 1 < size) name[length++] = *p;
+            ++p;
+        }
+        if (*p != '>') return false;
+        ++p;
+    } else {
+        while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+            if (length + 1 < size) name[length++] = *p;
+            ++p;
+        }
+    }
+    name[length] = '\0';
+    return length > 0;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static bool parseTime(const char*& p, int32_t& seconds) {
+    int sign = 1;
+    if (*p == '+' || *p == '-') sign = *p++ == '-' ? -1 : 1;
+    if (*p < '0' || *p > '9') return false;
+    int32_t parts[3] = {0, 0, 0};
+    for (int i = 0; i < 3; ++i) {
+        if (i > 0) {
+            if (*p != ':') break;
+            ++p;
+        }
+        if (*p < '0' || *p > '9') return false;
+        while (*p >= '0' && *p <= '9') parts[i] = parts[i] * 10 + (*p++ - '0');
+    }
+    seconds = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+    return true;
+}
+
+static bool parseNumber(const char*& p, uint32_t& value) {
+    if (*p < '0' || *p > '9') return false;
+    value = 0;
+    while (*p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+    return true;
+}
+
+static bool parseRule(const char*& p, TzTransitionRule& rule) {
+    uint32_t a, b, c;
+    if (*p == 'M') {
+        ++p;
+        if (!parseNumber(p, a) || *p++ != '.' || !parseNumber(p, b) || *p++ != '.' || !parseNumber(p, c)) return false;
+        if (a < 1 || a > 12 || b < 1 || b > 5 || c > 6) return false;
+        rule.kind = TzTransitionRule::MONTH_WEEK_DAY;
+        rule.month = a;
+        rule.week = b;
+        rule.weekday = c;
+    } else if (*p == 'J') {
+        ++p;
+        if (!parseNumber(p, a) || a < 1 || a > 365) return false;
+        rule.kind = TzTransitionRule::JULIAN_NO_LEAP;
+        rule.day = a;
+    } else {
+        if (!parseNumber(p, a) || a > 365) return false;
+        rule.kind = TzTransitionRule::JULIAN;
+        rule.day = a;
+    }
+    rule.time = 7200;            // 02:00 unless given
+    if (*p == '/') {
+        ++p;
+        if (!parseTime(p, rule.time)) return false;
+    }
+    return true;
+}
+
+// Local midnight of the transition day, as days since 1970-01-01
+static int32_t transitionDay(const TzTransitionRule& rule, int32_t year) {
+    int32_t jan1 = daysFromCivil(year, 1, 1);
+    switch (rule.kind) {
+        case TzTransitionRule::JULIAN_NO_LEAP:
+            // Feb 29 is never counted
+            return jan1 + rule.day - 1 + (isLeapYear(year) && rule.day >= 60 ? 1 : 0);
+        case TzTransitionRule::JULIAN:
+            return jan1 + rule.day;
+        default: {
+            int32_t first = daysFromCivil(year, rule.month, 1);
+            int32_t firstWeekday = ((first % 7) + 11) % 7;
+            int32_t day = (rule.weekday - firstWeekday + 7) % 7 + (rule.week - 1) * 7;
+            while (day >= daysInMonth(year, rule.month)) day -= 7;   // Week 5 = last
+            return first + day;
+        }
+    }
+}
+
+static void transitionsForYear(const TimeZone& zone, int32_t year, int64_t& start, int64_t& end) {
+    // Start is given in standard time, end in daylight time
+    start = (int64_t)transitionDay(zone.start, year) * 86400 + zone.start.time - zone.stdOffset;
+    end = (int64_t)transitionDay(zone.end, year) * 86400 + zone.end.time - zone.dstOffset;
+}
+
+bool parsePosixTz(const char* posix, TimeZone& zone) {
+    memset(&zone, 0, sizeof(zone));
+    strcpy(zone.stdName, "UTC");
+    if (posix == nullptr) return false;
+
+    const char* p = posix;
+    int32_t offset;
+    if (!parseName(p, zone.stdName, sizeof(zone.stdName)) || !parseTime(p, offset)) {
+        strcpy(zone.stdName, "UTC");
+        return false;
+    }
+    zone.stdOffset = -offset;    // POSIX offsets are west of UTC
+    zone.dstOffset = zone.stdOffset;
+    if (*p == '\0') return true;
+
+    TimeZone parsed = zone;
+    if (!parseName(p, parsed.dstName, sizeof(parsed.dstName))) return false;
+    parsed.dstOffset = parsed.stdOffset + 3600;
+    if (*p && *p != ',') {
+        if (!parseTime(p, offset)) return false;
+        parsed.dstOffset = -offset;
+    }
+    if (*p == ',') {
+        ++p;
+        if (!parseRule(p, parsed.start) || *p++ != ',' || !parseRule(p, parsed.end) || *p != '\0') return false;
+    } else if (*p == '\0') {
+        // No rule: the US rules, as glibc and newlib assume
+        const char* us = "M3.2.0,M11.1.0";
+        parseRule(us, parsed.start);
+        ++us;
+        parseRule(us, parsed.end);
+    } else {
+        return false;
+    }
+    parsed.hasDst = true;
+    for (size_t i = 0; i < TZ_TABLE_YEARS; ++i) {
+        transitionsForYear(parsed, TZ_TABLE_FIRST_YEAR + i, parsed.dstStart[i], parsed.dstEnd[i]);
+    }
+    zone = parsed;
+    return true;
+}
+
+// DST for an instant, given the civil year it falls in by standard time.
+// That year is close enough at new year since no zone changes over then.
+static bool inDstForYear(const TimeZone& zone, int64_t epoch, int32_t year) {
+    int64_t start, end;
+    size_t index = (size_t)(year - TZ_TABLE_FIRST_YEAR);
+    if (year >= TZ_TABLE_FIRST_YEAR && index < TZ_TABLE_YEARS) {
+        start = zone.dstStart[index];
+        end = zone.dstEnd[index];
+    } else {
+        transitionsForYear(zone, year, start, end);
+    }
+    // Southern zones start DST late in the year and end it early in the next
+    return start < end ? epoch >= start && epoch < end : epoch >= start || epoch < end;
+}
+
+int32_t utcOffsetAt(const TimeZone& zone, int64_t epoch, bool* dst) {
+    bool inDst = false;
+    if (zone.hasDst) {
+        int32_t year;
+        uint32_t month, day;
+        civilFromDays(floorDiv(epoch + zone.stdOffset, 86400), year, month, day);
+        inDst = inDstForYear(zone, epoch, year);
+    }
+    if (dst) *dst = inDst;
+    return inDst ? zone.dstOffset : zone.stdOffset;
+}
+
+void toLocalTime(const TimeZone& zone, int64_t epoch, CivilTime& out) {
+    // Standard time first; its date also picks the DST table entry, and is
+    // only recomputed when DST moves the time past midnight
+    int64_t local = epoch + zone.stdOffset;
+    int32_t days = floorDiv(local, 86400);
+    int32_t year;
+    uint32_t month, day;
+    civilFromDays(days, year, month, day);
+
+    bool dst = zone.hasDst && inDstForYear(zone, epoch, year);
+    if (dst) {
+        local = epoch + zone.dstOffset;
+        int32_t dstDays = floorDiv(local, 86400);
+        if (dstDays != days) {
+            days = dstDays;
+            civilFromDays(days, year, month, day);
+        }
+    }
+    fillCivil(days, (int32_t)(local - (int64_t)days * 86400), year, month, day, out);
+    out.dst = dst;
+    out.utcOffset = dst ? zone.dstOffset : zone.stdOffset;
+}
+
+bool isSouthernDst(const TimeZone& zone) {
+    return zone.hasDst && zone.dstStart[0] > zone.dstEnd[0];
+}
+
+// ---- Formatting ----
+
+static inline char* put2(char* p, uint32_t value) {
+    p[0] = '0' + value / 10 % 10;
+    p[1] = '0' + value % 10;
+    return p + 2;
+}
+
+static inline char* putDate(char* p, const CivilTime& time) {
+    uint32_t year = time.year < 0 ? 0 : time.year;
+    p = put2(p, year / 100);
+    p = put2(p, year % 100);
+    *p++ = '-';
+    p = put2(p, time.month);
+    *p++ = '-';
+    return put2(p, time.day);
+}
+
+size_t formatDateTime(char* out, const CivilTime& time) {
+    char* p = putDate(out, time);
+    *p++ = ' ';
+    p = put2(p, time.hour);
+    *p++ = ':';
+    p = put2(p, time.minute);
+    *p++ = ':';
+    p = put2(p, time.second);
+    *p = '\0';
+    return p - out;
+}
+
+size_t formatDateMinute(char* out, const CivilTime& time) {
+    char* p = putDate(out, time);
+    *p++ = ' ';
+    p = put2(p, time.hour);
+    *p++ = ':';
+    p = put2(p, time.minute);
+    *p = '\0';
+    return p - out;
+}
+
+size_t formatHourMinute(char* out, const CivilTime& time) {
+    char* p = put2(out, time.hour);
+    *p++ = ':';
+    p = put2(p, time.minute);
+    *p = '\0';
+    return p - out;
+}
+
+const char* weekdayName(uint8_t weekday) {
+    static const char* const names[7] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    return weekday < 7 ? names[weekday] : "";
+}
+
+// ---- The device's zone ----
+
+void setLocalTimeZone(const char* posix) {
+    TimeZone zone;
+    parsePosixTz(posix, zone);
+    localZone.write(zone);
+
+    // Keep libc in step for anything still using localtime()
+    setenv("TZ", posix, 1);
+    tzset();
+}
+
+void getLocalTimeZone(TimeZone& zone) {
+    if (localZone.version() == 0) {
+        parsePosixTz("UTC0", zone);
+        return;
+    }
+    zone = localZone.read();
+}
+
+uint32_t localTimeZoneVersion() {
+    return localZone.version();
+}
+
+void LocalClock::now(CivilTime& out) {
+    int64_t epoch = (int64_t)time(nullptr);
+    int64_t currentMinute = floorDiv(epoch, 60);
+    uint32_t currentVersion = localTimeZoneVersion();
+    if (currentMinute != minute || currentVersion != version) {
+        // Zone changes and DST transitions both land on minute boundaries
+        TimeZone zone;
+        getLocalTimeZone(zone);
+        toLocalTime(zone, currentMinute * 60, snapshot);
+        minute = currentMinute;
+        version = currentVersion;
+    }
+    out = snapshot;
+    out.second = (uint8_t)(epoch - currentMinute * 60);
+}
@@ -0,0 +1,93 @@
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Local time without localtime()/strftime(). The POSIX TZ string (see
+// timezones.h) is parsed once into a TimeZone: the standard and DST offsets
+// plus a table of DST start/end instants for TZ_TABLE_YEARS years, so turning
+// an epoch into local time is a table lookup and integer arithmetic
+// (days <-> civil dates after Howard Hinnant's algorithms, valid for any
+// proleptic Gregorian date). Formatting writes fixed-width fields into a
+// caller's buffer and never allocates.
+//
+// setLocalTimeZone() replaces setenv("TZ")/tzset() and keeps libc in step,
+// so code that still calls localtime() sees the same zone.
+
+const int32_t TZ_TABLE_FIRST_YEAR = 2020;
+const size_t TZ_TABLE_YEARS = 32;          // Years outside the table are computed on the fly
+
+struct CivilTime {
+    int16_t year;
+    uint8_t month;               // 1-12
+    uint8_t day;                 // 1-31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;             // 0 = Sunday
+    bool dst;
+    int32_t utcOffset;           // Seconds east of UTC
+};
+
+// One end of the DST period, as written in the TZ string
+struct TzTransitionRule {
+    enum Kind : uint8_t { JULIAN_NO_LEAP, JULIAN, MONTH_WEEK_DAY };   // Jn, n, Mm.w.d
+    Kind kind;
+    uint8_t month;               // Mm.w.d
+    uint8_t week;                // 1-5, 5 = last
+    uint8_t weekday;             // 0 = Sunday
+    uint16_t day;                // Jn (1-365) or n (0-365)
+    int32_t time;                // Local seconds after midnight (may be negative or past 24h)
+};
+
+struct TimeZone {
+    int32_t stdOffset;           // Seconds east of UTC
+    int32_t dstOffset;
+    bool hasDst;
+    TzTransitionRule start;
+    TzTransitionRule end;
+    char stdName[8];
+    char dstName[8];
+    int64_t dstStart[TZ_TABLE_YEARS];   // UTC instants, per year from TZ_TABLE_FIRST_YEAR
+    int64_t dstEnd[TZ_TABLE_YEARS];
+};
+
+// Days since 1970-01-01 and back
+int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day);
+void civilFromDays(int32_t days, int32_t& year, uint32_t& month, uint32_t& day);
+bool isLeapYear(int32_t year);
+uint8_t daysInMonth(int32_t year, uint32_t month);
+bool parseDate(const char* text, int32_t& days);     // "YYYY-MM-DD"; false if malformed or no such date
+
+void utcToCivil(int64_t epoch, CivilTime& out);      // UTC, offset 0
+bool parsePosixTz(const char* posix, TimeZone& zone); // false if malformed; keeps what parsed, else UTC
+int32_t utcOffsetAt(const TimeZone& zone, int64_t epoch, bool* dst = nullptr);
+void toLocalTime(const TimeZone& zone, int64_t epoch, CivilTime& out);
+bool isSouthernDst(const TimeZone& zone);             // DST runs over new year
+
+// Fixed width, NUL terminated; return the length written
+size_t formatDateTime(char* out, const CivilTime& time);     // "YYYY-MM-DD HH:MM:SS", 20 bytes
+size_t formatDateMinute(char* out, const CivilTime& time);   // "YYYY-MM-DD HH:MM", 17 bytes
+size_t formatHourMinute(char* out, const CivilTime& time);   // "HH:MM", 6 bytes
+const char* weekdayName(uint8_t weekday);                    // "Sunday"...
+
+// The device's zone. Written by whoever sets the timezone, read from any task.
+void setLocalTimeZone(const char* posix);
+void getLocalTimeZone(TimeZone& zone);
+uint32_t localTimeZoneVersion();     // Changes with every setLocalTimeZone()
+
+// Local time now, recomputed once a minute (or when the zone changes). Not
+// shared between tasks: each task that needs the time keeps its own.
+class LocalClock {
+public:
+    LocalClock() : minute(-1), version(0) {}
+    void now(CivilTime& out);
+
+private:
+    int64_t minute;              // Epoch minute of `snapshot`
+    uint32_t version;            // Zone version `snapshot` was made with
+    CivilTime snapshot;
+};
+
+#endif
@@ -1,7 +1,10 @@
 #include "config.h"
 #include <ArduinoJson.h>
-#include <SPIFFS.h>
+#include <storage.h>
 #include "data.h"
+#include "flash_writer.h"
+#include "timezones.h"
+#include "config_store.h"
 
 // Define the config struct with initial values
 Config config = {
@@ -11,7 +14,10 @@ Config config = {
   .web_userpass = "admin123",
   .jwt_secret = "your_secret",
   .timezone = "UTC",
-  .posix_tz = "UTC0"
+  .posix_tz = "UTC0",
+  .durability_window = PERSIST_DEFAULT_WINDOW,
+  .comfort_high = COMFORT_DEFAULT_HIGH,
+  .comfort_low = COMFORT_DEFAULT_LOW
 };
 
 // Define local WiFi SSID and password
@@ -23,7 +29,24 @@ IPAddress ap_local_IP(172, 23, 23, 1);
 IPAddress ap_gateway(172, 23, 23, 1);
 IPAddress ap_subnet(255, 255, 255, 0);
 
-void applyJsonToConfig(const DynamicJsonDocument& doc) {
+bool applyJsonToConfig(const DynamicJsonDocument& doc, String& error) {
+  // Sensors are optional; a settings update without them keeps the current list.
+  // Checked before anything changes: setupSensors() would drop a bad entry at boot
+  bool hasSensors = doc.containsKey("sensors");
+  std::vector<SensorConfig> sensors;
+  if (hasSensors) {
+    for (JsonObjectConst entry : doc["sensors"].as<JsonArrayConst>()) {
+      SensorConfig sensor = defaultSensorConfig();
+      sensor.id = entry["id"] | sensor.id.c_str();
+      sensor.driver = entry["driver"] | sensor.driver.c_str();
+      sensor.pin = entry["pin"] | sensor.pin;
+      sensor.temperature_offset = entry["temperature_offset"] | 0.0f;
+      sensor.humidity_offset = entry["humidity_offset"] | 0.0f;
+      sensors.push_back(sensor);
+    }
+    if (!validateSensorConfigs(sensors, error)) return false;
+  }
+
   // Apply JSON values to the in-memory config structure
   config.web_username = doc["login"]["user"].as<String>();
   config.web_userpass = doc["login"]["password"].as<String>();
@@ -35,40 +58,67 @@ void applyJsonToConfig(const DynamicJsonDocument& doc) {
   config.jwt_secret = doc["jwt_secret"].as<String>();
   config.timezone = doc["timezone"].as<String>();
   config.posix_tz = getPosixTzFromTimezone(config.timezone);
+
+  if (hasSensors) config.sensors = sensors;
+
+  // Longer windows save flash wear, shorter ones lose fewer points on a power cut
+  if (doc.containsKey("durability_window")) {
+    uint32_t window = doc["durability_window"];
+    config.durability_window = window > PERSIST_MAX_WINDOW ? PERSIST_MAX_WINDOW : window;
+  }
+
+  // Comfort band for the daily statistics; a change applies from the next day
+  if (doc.containsKey("comfort_high")) config.comfort_high = doc["comfort_high"];
+  if (doc.containsKey("comfort_low")) config.comfort_low = doc["comfort_low"];
+  return true;
 }
 
 
+// Older firmware kept the config as JSON; read it once and convert
+static bool migrateJsonConfig() {
+  std::vector<uint8_t> contents;
+  if (!storage().read(LEGACY_CONFIG_PATH, contents)) return false;
+
+  DynamicJsonDocument doc(contents.size() * 2 + 1024);
+  DeserializationError error = deserializeJson(doc, (const char*)contents.data(), contents.size());
+  if (error) {
+    Serial.printf("Failed to parse %s: %s\n", LEGACY_CONFIG_PATH, error.c_str());
+    return false;
+  }
+  String reason;
+  if (!applyJsonToConfig(doc, reason)) {
+    Serial.printf("Not migrating %s: %s\n", LEGACY_CONFIG_PATH, reason.c_str());
+    return false;
+  }
+  Serial.printf("Migrating %s to %s\n", LEGACY_CONFIG_PATH, CONFIG_PATH);
+  saveConfig();
+  return true;
+}
+
 void loadConfig() {
-  
   Serial.println("Loading configuration...");
-  File configFile = SPIFFS.open("/config.json", "r");
-  if (!configFile) {
-    Serial.println("Failed to open config file");
+  std::vector<uint8_t> record;
+  StorageStat info;
+  if (!storage().stat(CONFIG_PATH, info)) {
+    if (!migrateJsonConfig()) Serial.println("No config file, using defaults");
     return;
   }
-
-  size_t size = configFile.size();
-  if (size > 1024) {
-    Serial.println("Config file size is too large");
+  if (info.size > CONFIG_RECORD_MAX_SIZE || !storage().read(CONFIG_PATH, record)) {
+    Serial.println("Failed to read config file, using defaults");
     return;
   }
 
-  std::unique_ptr<char[]> buf(new char[size]);
-  configFile.readBytes(buf.get(), size);
-
-  DynamicJsonDocument doc(1024);
-  DeserializationError error = deserializeJson(doc, buf.get());
-  if (error) {
-    Serial.println("Failed to parse config file");
+  ConfigRecordResult result = decodeConfig(record.data(), record.size(), config);
+  if (result != CONFIG_RECORD_OK) {
+    Serial.printf("Config file %s, using defaults\n", configRecordResultName(result));
     return;
   }
-  applyJsonToConfig(doc);
-  configFile.close();
+  config.posix_tz = getPosixTzFromTimezone(config.timezone);
   Serial.println("Configuration loaded");
 }
 
-DynamicJsonDocument getConfigJson() {
-  DynamicJsonDocument doc(1024);
+// JSON form for the web interface (GET /api/config)
+void writeConfigJson(JsonDocument& doc) {
   doc["login"]["user"] = config.web_username;
   doc["login"]["password"] = config.web_userpass;
   doc["wifi"]["ssid"] = config.wifi_ssid;
@@ -78,45 +128,59 @@ DynamicJsonDocument getConfigJson() {
   doc["wifi"]["security"] = config.wifi_security;
   doc["jwt_secret"] = config.jwt_secret;
   doc["timezone"] = config.timezone;
-
-  return doc;
+  JsonArray sensors = doc.createNestedArray("sensors");
+  for (const SensorConfig& sensor : config.sensors) {
+    JsonObject entry = sensors.createNestedObject();
+    entry["id"] = sensor.id;
+    entry["driver"] = sensor.driver;
+    entry["pin"] = sensor.pin;
+    entry["temperature_offset"] = sensor.temperature_offset;
+    entry["humidity_offset"] = sensor.humidity_offset;
+  }
+  doc["durability_window"] = config.durability_window;
+  doc["comfort_high"] = config.comfort_high;
+  doc["comfort_low"] = config.comfort_low;
 }
 
-void updateConfig(const String& json) {
+bool updateConfig(const String& json, String& error) {
   Serial.println("Updating configuration...");
-  DynamicJsonDocument doc(1024);
-  DeserializationError error = deserializeJson(doc, json);
-  if (error) {
+  DynamicJsonDocument doc(json.length() * 2 + 1024);
+  DeserializationError parseError = deserializeJson(doc, json);
+  if (parseError) {
     Serial.println("Failed to parse JSON");
-    return;
+    error = String("Invalid JSON: ") + parseError.c_str();
+    return false;
+  }
+  if (!applyJsonToConfig(doc, error)) {
+    Serial.printf("Config rejected: %s\n", error.c_str());
+    return false;
   }
-  applyJsonToConfig(doc);
   saveConfig();
+  return true;
 }
 
-// Save configuration to JSON file in SPIFFS
-void saveConfig() {
-
-  File configFile = SPIFFS.open("/config.json", "w");
-  if (!configFile) {
-    Serial.println("Failed to open config file for writing");
-    return;
+// The JSON file is only removed once the record that replaces it is on flash
+static void onConfigWritten(const char* path, FlashWriteResult result, void* context) {
+  if (result == FLASH_WRITE_OK && storage().exists(LEGACY_CONFIG_PATH)) {
+    storage().remove(LEGACY_CONFIG_PATH);
   }
+}
+
+// Save the configuration record to flash
+// (queued on the flash writer, so HTTP handlers never wait on flash)
+void saveConfig() {
   Serial.println("Saving configuration...");
-  DynamicJsonDocument doc = getConfigJson();
-  serializeJson(doc, configFile);
-  configFile.close();
+  if (!queueFileWrite(CONFIG_PATH, encodeConfig(config), onConfigWritten)) {
+    Serial.println("Failed to queue config file for writing");
+  }
 }
 
 String getPosixTzFromTimezone(String timezone) {
-    //TODO: Is there a better way?
-    // Convert timezone to POSIX format
-    // From https://github.com/nayarsystems/posix_tz_db/blob/master/zones.csv
-    if (timezone == "Australia/Sydney") return "AEST-10AEDT,M10.1.0,M4.1.0";
-    if (timezone == "America/New_York") return "EST5EDT,M3.2.0,M11.1.0";
-    if (timezone == "Europe/London") return "GMT0BST,M3.5.0,M10.5.0";
-    if (timezone == "Asia/Tokyo") return "JST-9";
-    if (timezone == "Europe/Berlin") return "CET-1CEST,M3.5.0,M10.5.0";
-    if (timezone == "America/Los_Angeles") return "PST8PDT,M3.2.0,M11.1.0";
-    return "UTC0";
+    // Full tz database, see tools/tz/zones.csv
+    const char* rule = findPosixTz(timezone.c_str());
+    if (rule == nullptr) {
+        Serial.printf("Unknown timezone %s, using UTC\n", timezone.c_str());
+        return "UTC0";
+    }
+    return rule;
 }
@@ -3,15 +3,25 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <vector>
+#include <sensors.h>
+#include <persistence.h>
+#include <daily_stats.h>
+
+// The config lives in /config.bin, a binary record (see config_store.h).
+// JSON is only used by the web interface.
+const char* const CONFIG_PATH = "/config.bin";
+const char* const LEGACY_CONFIG_PATH = "/config.json";   // Converted on first boot
 
 void loadConfig();
 void saveConfig();
-void updateConfig(const String& json);
-void applyJsonToConfig(const DynamicJsonDocument& doc);
+// Both leave the config untouched and return false, with a reason in `error`,
+// if the JSON can't be parsed or a value would be refused at boot
+bool updateConfig(const String& json, String& error);
+bool applyJsonToConfig(const DynamicJsonDocument& doc, String& error);
+void writeConfigJson(JsonDocument& doc);
 String getPosixTzFromTimezone(String timezone);
 
-DynamicJsonDocument getConfigJson();
-
 struct Config {
   String wifi_ssid;
   String wifi_password; //Wifi Password
@@ -22,9 +32,13 @@ struct Config {
   String web_userpass; //Web password
   String jwt_secret; //JWT Secret
   String timezone; //Timezone
-  String posix_tz; //Timezone as per https://github.com/nayarsystems/posix_tz_db/blob/master/zones.csv
+  String posix_tz; //Timezone as a POSIX TZ string, looked up in tools/tz/zones.csv (see timezones.h)
   bool is_dst; //Daylight Saving Time
   int utc_offset; //UTC Offset
+  std::vector<SensorConfig> sensors; //Sensor registry, see sensors.h (applied on reboot)
+  uint32_t durability_window; //Minutes data points may wait in RTC memory before the files are rewritten, see persistence.h
+  float comfort_high; //°C; time and degree-hours above this are counted per day, see daily_stats.h
+  float comfort_low; //°C; likewise below
 };
 
 // Extern declarations
@@ -0,0 +1,243 @@
+#include "config_store.h"
+#include "config.h"
+#include "data.h"
+#include <string.h>
+
+namespace {
+
+struct StringField {
+    ConfigTag tag;
+    String Config::*member;
+};
+
+const StringField STRING_FIELDS[] = {
+    {CFG_WIFI_SSID, &Config::wifi_ssid},
+    {CFG_WIFI_PASSWORD, &Config::wifi_password},
+    {CFG_WIFI_USERNAME, &Config::wifi_username},
+    {CFG_WIFI_IDENTITY, &Config::wifi_identity},
+    {CFG_WIFI_SECURITY, &Config::wifi_security},
+    {CFG_WEB_USERNAME, &Config::web_username},
+    {CFG_WEB_USERPASS, &Config::web_userpass},
+    {CFG_JWT_SECRET, &Config::jwt_secret},
+    {CFG_TIMEZONE, &Config::timezone},
+};
+
+// Little-endian field writer
+class RecordWriter {
+public:
+    explicit RecordWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void bytes(uint16_t tag, const void* data, size_t length) {
+        if (length > 0xFFFF) length = 0xFFFF;
+        put16(tag);
+        put16((uint16_t)length);
+        const uint8_t* p = (const uint8_t*)data;
+        out.insert(out.end(), p, p + length);
+    }
+    void string(uint16_t tag, const String& value) { bytes(tag, value.c_str(), value.length()); }
+    void u8(uint16_t tag, uint8_t value) { bytes(tag, &value, 1); }
+    void u32(uint16_t tag, uint32_t value) {
+        uint8_t b[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+        bytes(tag, b, 4);
+    }
+    void f32(uint16_t tag, float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, 4);
+        u32(tag, bits);
+    }
+
+    // Nested list: write the fields into `nested`, then close it
+    size_t open(uint16_t tag) {
+        put16(tag);
+        put16(0);
+        return out.size();
+    }
+    void close(size_t start) {
+        size_t length = out.size() - start;
+        out[start - 2] = (uint8_t)length;
+        out[start - 1] = (uint8_t)(length >> 8);
+    }
+
+private:
+    void put16(uint16_t value) {
+        out.push_back((uint8_t)value);
+        out.push_back((uint8_t)(value >> 8));
+    }
+    std::vector<uint8_t>& out;
+};
+
+struct Field {
+    uint16_t tag;
+    const uint8_t* value;
+    uint16_t length;
+};
+
+// Walks a field list; false on a field running past the end
+class RecordReader {
+public:
+    RecordReader(const uint8_t* data, size_t length) : p(data), end(data + length) {}
+
+    bool next(Field& field, bool& ok) {
+        if (p == end) return false;
+        if (end - p < 4) { ok = false; return false; }
+        field.tag = p[0] | (p[1] << 8);
+        field.length = p[2] | (p[3] << 8);
+        if ((size_t)(end - p - 4) < field.length) { ok = false; return false; }
+        field.value = p + 4;
+        p += 4 + field.length;
+        return true;
+    }
+
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+};
+
+uint32_t readU32(const Field& field) {
+    return field.value[0] | (field.value[1] << 8) | (field.value[2] << 16) | ((uint32_t)field.value[3] << 24);
+}
+
+float readF32(const Field& field) {
+    uint32_t bits = readU32(field);
+    float value;
+    memcpy(&value, &bits, 4);
+    return value;
+}
+
+String readString(const Field& field) {
+    String value;
+    value.reserve(field.length);
+    for (uint16_t i = 0; i < field.length; ++i) value += (char)field.value[i];
+    return value;
+}
+
+bool decodeSensor(const Field& group, SensorConfig& sensor) {
+    RecordReader reader(group.value, group.length);
+    Field field;
+    bool ok = true;
+    while (reader.next(field, ok)) {
+        switch (field.tag) {
+            case CFG_SENSOR_ID: sensor.id = readString(field); break;
+            case CFG_SENSOR_DRIVER: sensor.driver = readString(field); break;
+            case CFG_SENSOR_PIN: if (field.length == 1) sensor.pin = field.value[0]; else ok = false; break;
+            case CFG_SENSOR_TEMPERATURE_OFFSET: if (field.length == 4) sensor.temperature_offset = readF32(field); else ok = false; break;
+            case CFG_SENSOR_HUMIDITY_OFFSET: if (field.length == 4) sensor.humidity_offset = readF32(field); else ok = false; break;
+            default: break;        // Newer field, skip
+        }
+    }
+    return ok;
+}
+
+// Fields retired from older schemas are converted here. Nothing is retired
+// yet (schema 2 only added fields); returns true if the field was handled.
+bool migrateConfigField(uint16_t version, const Field& field, Config& config) {
+    (void)version;
+    (void)field;
+    (void)config;
+    return false;
+}
+
+} // namespace
+
+std::vector<uint8_t> encodeConfig(const Config& config) {
+    std::vector<uint8_t> record(sizeof(ConfigRecordHeader));
+    record.reserve(512);
+    RecordWriter writer(record);
+
+    for (const StringField& field : STRING_FIELDS) {
+        writer.string(field.tag, config.*field.member);
+    }
+    writer.u32(CFG_DURABILITY_WINDOW, config.durability_window);
+    writer.f32(CFG_COMFORT_HIGH, config.comfort_high);
+    writer.f32(CFG_COMFORT_LOW, config.comfort_low);
+    for (const SensorConfig& sensor : config.sensors) {
+        size_t group = writer.open(CFG_SENSOR);
+        writer.string(CFG_SENSOR_ID, sensor.id);
+        writer.string(CFG_SENSOR_DRIVER, sensor.driver);
+        writer.u8(CFG_SENSOR_PIN, sensor.pin);
+        writer.f32(CFG_SENSOR_TEMPERATURE_OFFSET, sensor.temperature_offset);
+        writer.f32(CFG_SENSOR_HUMIDITY_OFFSET, sensor.humidity_offset);
+        writer.close(group);
+    }
+
+    ConfigRecordHeader header;
+    header.magic = CONFIG_RECORD_MAGIC;
+    header.version = CONFIG_SCHEMA_VERSION;
+    header.headerSize = sizeof(ConfigRecordHeader);
+    header.length = record.size() - sizeof(ConfigRecordHeader);
+    header.checksum = calculateCRC32(record.data() + sizeof(header), header.length);
+    memcpy(record.data(), &header, sizeof(header));
+    return record;
+}
+
+ConfigRecordResult decodeConfig(const uint8_t* data, size_t length, Config& config) {
+    ConfigRecordHeader header;
+    if (length < sizeof(header)) return CONFIG_RECORD_BAD_HEADER;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != CONFIG_RECORD_MAGIC) return CONFIG_RECORD_BAD_HEADER;
+    // Later schemas may only grow the header; the payload still follows it
+    if (header.headerSize < sizeof(header)) return CONFIG_RECORD_BAD_HEADER;
+    if (header.headerSize > length || length - header.headerSize != header.length) return CONFIG_RECORD_BAD_HEADER;
+
+    const uint8_t* payload = data + header.headerSize;
+    if (calculateCRC32(payload, header.length) != header.checksum) return CONFIG_RECORD_CORRUPT;
+
+    // Decode into a copy so a bad field leaves the current config alone
+    Config decoded = config;
+    bool sensorsSeen = false;
+    RecordReader reader(payload, header.length);
+    Field field;
+    bool ok = true;
+    while (ok && reader.next(field, ok)) {
+        bool known = false;
+        for (const StringField& entry : STRING_FIELDS) {
+            if (entry.tag == field.tag) {
+                decoded.*entry.member = readString(field);
+                known = true;
+                break;
+            }
+        }
+        if (known) continue;
+
+        switch (field.tag) {
+            case CFG_DURABILITY_WINDOW:
+                if (field.length != 4) { ok = false; break; }
+                decoded.durability_window = readU32(field);
+                if (decoded.durability_window > PERSIST_MAX_WINDOW) decoded.durability_window = PERSIST_MAX_WINDOW;
+                break;
+            case CFG_COMFORT_HIGH:
+                if (field.length != 4) { ok = false; break; }
+                decoded.comfort_high = readF32(field);
+                break;
+            case CFG_COMFORT_LOW:
+                if (field.length != 4) { ok = false; break; }
+                decoded.comfort_low = readF32(field);
+                break;
+            case CFG_SENSOR: {
+                // The record holds the whole list; drop the defaults on the first one
+                if (!sensorsSeen) decoded.sensors.clear();
+                sensorsSeen = true;
+                SensorConfig sensor = defaultSensorConfig();
+                if (!decodeSensor(field, sensor)) { ok = false; break; }
+                decoded.sensors.push_back(sensor);
+                break;
+            }
+            default:
+                migrateConfigField(header.version, field, decoded);   // Unknown fields are skipped
+                break;
+        }
+    }
+    if (!ok) return CONFIG_RECORD_CORRUPT;
+
+    config = decoded;
+    return CONFIG_RECORD_OK;
+}
+
+const char* configRecordResultName(ConfigRecordResult result) {
+    switch (result) {
+        case CONFIG_RECORD_OK: return "ok";
+        case CONFIG_RECORD_BAD_HEADER: return "bad header";
+        case CONFIG_RECORD_CORRUPT: return "corrupt";
+    }
+    return "unknown";
+}
@@ -0,0 +1,74 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <vector>
+
+struct Config;
+
+// Binary config record (/config.bin). JSON is only used at the HTTP edge
+// (GET/POST /api/config); on flash the config is a typed record that loads
+// with one read and no parser:
+//   - ConfigRecordHeader, little-endian, with a CRC32 of the payload
+//   - payload: fields as <tag u16><length u16><value>, in any order
+// Values are raw bytes for strings, little-endian u32/float and a single
+// byte for u8. A sensor is a CFG_SENSOR field whose value is itself a list
+// of sensor fields.
+//
+// Schema changes are per field: a field missing from an older record keeps
+// its default, unknown tags (written by newer firmware) are skipped, and a
+// field whose meaning changes gets a new tag, with the old one converted in
+// migrateConfigField(). Never reuse a tag number. Bump CONFIG_SCHEMA_VERSION
+// when the set of tags changes. A record from newer firmware still loads
+// (after a downgrade), minus the fields this firmware doesn't know.
+//
+// The file is replaced atomically by the flash writer (Storage::replace()),
+// so a power cut leaves either the old record or the new one.
+
+const uint32_t CONFIG_RECORD_MAGIC = 0x46434153;   // "SACF"
+const uint16_t CONFIG_SCHEMA_VERSION = 2;
+const size_t CONFIG_RECORD_MAX_SIZE = 16384;       // Sanity limit when loading
+
+struct ConfigRecordHeader {
+    uint32_t magic;
+    uint16_t version;            // Schema version that wrote the record
+    uint16_t headerSize;         // sizeof(ConfigRecordHeader) at that version
+    uint32_t length;             // Payload bytes after the header
+    uint32_t checksum;           // CRC32 of the payload
+};
+
+enum ConfigTag : uint16_t {
+    CFG_WIFI_SSID = 1,
+    CFG_WIFI_PASSWORD = 2,
+    CFG_WIFI_USERNAME = 3,
+    CFG_WIFI_IDENTITY = 4,
+    CFG_WIFI_SECURITY = 5,
+    CFG_WEB_USERNAME = 6,
+    CFG_WEB_USERPASS = 7,
+    CFG_JWT_SECRET = 8,
+    CFG_TIMEZONE = 9,
+    CFG_DURABILITY_WINDOW = 10,  // u32, minutes
+    CFG_SENSOR = 11,             // Repeated, value is a list of CFG_SENSOR_* fields
+    CFG_COMFORT_HIGH = 12,       // float, °C (schema 2)
+    CFG_COMFORT_LOW = 13,        // float, °C (schema 2)
+
+    CFG_SENSOR_ID = 100,
+    CFG_SENSOR_DRIVER = 101,
+    CFG_SENSOR_PIN = 102,        // u8
+    CFG_SENSOR_TEMPERATURE_OFFSET = 103,   // float
+    CFG_SENSOR_HUMIDITY_OFFSET = 104       // float
+};
+
+enum ConfigRecordResult {
+    CONFIG_RECORD_OK,
+    CONFIG_RECORD_BAD_HEADER,    // Not a config record, or truncated
+    CONFIG_RECORD_CORRUPT        // Checksum or field layout wrong
+};
+
+std::vector<uint8_t> encodeConfig(const Config& config);
+// Fields found in the record replace those in `config`; others keep their value.
+// `config` is left untouched unless the whole record checks out.
+ConfigRecordResult decodeConfig(const uint8_t* data, size_t length, Config& config);
+const char* configRecordResultName(ConfigRecordResult result);
+
+#endif
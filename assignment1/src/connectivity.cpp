@@ -0,0 +1,154 @@
+#include <connectivity.h>
+#include <WiFi.h>
+#include "esp_wpa2.h" //For WPA Enterprise
+#include <time.h>
+#include <config.h>
+#include <data.h>
+#include <boot_profile.h>
+#include <civil_time.h>
+#include <seqlock.h>
+
+// Copied out of config by updateWifiCredentials(); sizes are the 802.11 and
+// WPA limits, longer values are cut short (and would not connect anyway)
+struct WifiCredentials {
+  char ssid[33];
+  char password[65];
+  char username[129];   // WPA2-Enterprise
+  char identity[129];
+  char posixTz[64];     // configTime() resets TZ, see below
+  bool enterprise;
+};
+
+static Seqlock<WifiCredentials> credentials;
+static uint32_t credentialsSeen = 0;   // credentials.version() when last checked
+static ConnectivityState state = CONNECTIVITY_NO_CREDENTIALS;
+static TimeSyncCallback timeSynced = nullptr;
+static unsigned long stateSince = 0;
+static unsigned long retryDelay = CONNECT_RETRY_MIN;
+static bool sntpStarted = false;
+static bool synced = false;
+
+static void enterState(ConnectivityState next) {
+  if (next != state) {
+    Serial.printf("Connectivity: %s -> %s\n", connectivityStateName(state), connectivityStateName(next));
+  }
+  state = next;
+  stateSince = millis();
+}
+
+void updateWifiCredentials() {
+  WifiCredentials next;
+  snprintf(next.ssid, sizeof(next.ssid), "%s", config.wifi_ssid.c_str());
+  snprintf(next.password, sizeof(next.password), "%s", config.wifi_password.c_str());
+  snprintf(next.username, sizeof(next.username), "%s", config.wifi_username.c_str());
+  snprintf(next.identity, sizeof(next.identity), "%s", config.wifi_identity.c_str());
+  snprintf(next.posixTz, sizeof(next.posixTz), "%s", config.posix_tz.c_str());
+  next.enterprise = config.wifi_security == "WPA2-Enterprise";
+  credentials.write(next);
+}
+
+static void beginConnect() {
+  WifiCredentials wifi = credentials.read();
+  credentialsSeen = credentials.version();
+  if (wifi.enterprise) {
+    WiFi.disconnect(true);
+    Serial.println("Connecting to WPA2-Enterprise WiFi...");
+    esp_wifi_sta_wpa2_ent_set_identity((uint8_t *)wifi.identity, strlen(wifi.identity));
+    esp_wifi_sta_wpa2_ent_set_username((uint8_t *)wifi.username, strlen(wifi.username));
+    esp_wifi_sta_wpa2_ent_set_password((uint8_t *)wifi.password, strlen(wifi.password));
+    esp_wifi_sta_wpa2_ent_enable();
+  }
+  Serial.printf("Connecting to WiFi: %s\n", wifi.ssid);
+  WiFi.begin(wifi.ssid, wifi.password);
+  enterState(CONNECTIVITY_CONNECTING);
+}
+
+void startConnectivity(TimeSyncCallback onTimeSynced) {
+  timeSynced = onTimeSynced;
+  updateWifiCredentials();
+  credentialsSeen = credentials.version();
+  if (config.wifi_ssid.length() == 0) {
+    Serial.println("No saved WiFi credentials, running as access point only");
+    enterState(CONNECTIVITY_NO_CREDENTIALS);
+    return;
+  }
+  Serial.println("Found saved WiFi credentials for: " + config.wifi_ssid);
+  beginConnect();
+}
+
+void serviceConnectivity() {
+  unsigned long elapsed = millis() - stateSince;
+
+  switch (state) {
+    case CONNECTIVITY_NO_CREDENTIALS:
+      if (credentials.version() != credentialsSeen) {
+        credentialsSeen = credentials.version();
+        if (credentials.read().ssid[0]) {
+          Serial.println("WiFi credentials saved, connecting");
+          beginConnect();
+        }
+      }
+      return;
+
+    case CONNECTIVITY_CONNECTING:
+      if (WiFi.status() == WL_CONNECTED) {
+        Serial.println("Connected to WiFi with IP: " + WiFi.localIP().toString());
+        markBootPhase("wifi");
+        retryDelay = CONNECT_RETRY_MIN;
+        if (!sntpStarted) {
+          // SNTP keeps itself running (and resyncing) once started
+          configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+          setLocalTimeZone(credentials.read().posixTz); // configTime() resets TZ
+          sntpStarted = true;
+        }
+        enterState(synced ? CONNECTIVITY_ONLINE : CONNECTIVITY_WAITING_FOR_TIME);
+      } else if (elapsed >= CONNECT_TIMEOUT) {
+        Serial.printf("WiFi connection timed out, retrying in %lu s\n", retryDelay / 1000);
+        WiFi.disconnect();
+        enterState(CONNECTIVITY_BACKOFF);
+      }
+      return;
+
+    case CONNECTIVITY_BACKOFF:
+      if (elapsed >= retryDelay) {
+        retryDelay = min(retryDelay * 2, CONNECT_RETRY_MAX);
+        beginConnect();
+      }
+      return;
+
+    case CONNECTIVITY_WAITING_FOR_TIME:
+    case CONNECTIVITY_ONLINE:
+      if (!synced && time(nullptr) >= MIN_VALID_EPOCH) {
+        synced = true;
+        uint32_t bootOffset = (uint32_t)time(nullptr) - millis() / 1000;
+        Serial.println("Time initialized with NTP");
+        markBootPhase("ntp");
+        if (timeSynced) timeSynced(bootOffset);
+        enterState(CONNECTIVITY_ONLINE);
+      }
+      if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("WiFi connection lost");
+        enterState(CONNECTIVITY_BACKOFF);
+      }
+      return;
+  }
+}
+
+ConnectivityState getConnectivityState() {
+  return state;
+}
+
+const char* connectivityStateName(ConnectivityState state) {
+  switch (state) {
+    case CONNECTIVITY_NO_CREDENTIALS: return "no_credentials";
+    case CONNECTIVITY_CONNECTING: return "connecting";
+    case CONNECTIVITY_BACKOFF: return "backoff";
+    case CONNECTIVITY_WAITING_FOR_TIME: return "waiting_for_time";
+    case CONNECTIVITY_ONLINE: return "online";
+  }
+  return "unknown";
+}
+
+bool isTimeSynced() {
+  return synced;
+}
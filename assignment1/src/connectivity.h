@@ -0,0 +1,45 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <Arduino.h>
+
+// Station WiFi and NTP, brought up in the background so boot never waits on
+// the network. serviceConnectivity() is a scheduler task: it starts a
+// connection attempt, checks on it, and backs off after failures (doubling
+// from CONNECT_RETRY_MIN up to CONNECT_RETRY_MAX). Once connected it starts
+// SNTP and polls for the clock to be set, then reports the sync once. A
+// dropped connection is retried the same way.
+//
+// Until the clock is set getCurrentEpoch() returns seconds since boot, which
+// are far below MIN_VALID_EPOCH. The sync callback gets the offset that turns
+// those boot stamps into epochs so anything stamped early can be rebased.
+//
+// The state machine runs on the control task while POST /api/config rewrites
+// the config Strings on the AsyncTCP task, so it never reads them: the
+// credentials are copied into fixed buffers behind a seqlock when the config
+// changes, and the next attempt uses the latest copy. New credentials also
+// start the first attempt if there were none.
+
+enum ConnectivityState {
+  CONNECTIVITY_NO_CREDENTIALS,   // AP only
+  CONNECTIVITY_CONNECTING,
+  CONNECTIVITY_BACKOFF,          // Waiting to retry after a failed attempt
+  CONNECTIVITY_WAITING_FOR_TIME, // Connected, SNTP not answered yet
+  CONNECTIVITY_ONLINE            // Connected and clock set
+};
+
+const unsigned long CONNECT_TIMEOUT = 20000;      // ms per connection attempt
+const unsigned long CONNECT_RETRY_MIN = 2000;
+const unsigned long CONNECT_RETRY_MAX = 300000;
+const unsigned long CONNECTIVITY_POLL = 250;      // Task period while anything is pending
+
+typedef void (*TimeSyncCallback)(uint32_t bootOffset);
+
+void startConnectivity(TimeSyncCallback onTimeSynced);  // Starts WiFi if configured; schedule serviceConnectivity after
+void updateWifiCredentials();                           // Whenever config changes, on the task that changed it
+void serviceConnectivity();
+ConnectivityState getConnectivityState();
+const char* connectivityStateName(ConnectivityState state);
+bool isTimeSynced();
+
+#endif
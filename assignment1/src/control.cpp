@@ -0,0 +1,209 @@
+// control.cpp
+#include <control.h>
+#include <data.h>
+#include <config.h>
+#include <rules.h>
+#include <actuator.h>
+#include <signals.h>
+#include <scheduler.h>
+#include <telemetry.h>
+#include <sensors.h>
+#include <connectivity.h>
+#include <boot_profile.h>
+#include <persistence.h>
+#include <daily_stats.h>
+
+unsigned long lastAverageTime = 0;   // Last time data was aggregated to 5min data point
+unsigned long lastHourlyAggregation = 0; // Last time data was aggregated to hourly data point
+unsigned long last6HourAggregation = 0; // Last time data was aggregated to 6-hour data point
+
+unsigned long collectionInterval = 15000;    // 15 seconds
+unsigned long averageInterval = 300000;      // 5 minutes
+unsigned long hourlyInterval = 3600000;      // 1 hour
+unsigned long sixHourInterval = 21600000;    // 6 hours
+unsigned long serviceInterval = 1000;        // Actuator housekeeping
+unsigned long persistenceInterval = 60000;   // Durability window checks
+unsigned long sensorRetryInterval = 1000;    // Until the first good reading after boot
+
+int actuatorTask = -1;
+int collectTask = -1;
+int finishTask = -1;
+bool firstSampleTaken = false;
+
+void resumeAggregation() {
+  if (!temperatureData5Min.empty()) {
+      lastAverageTime = millis() - (millis() - calculateNextInterval(temperatureData5Min.back().timestamp, averageInterval));
+      Serial.printf("Setting last 5-minute aggregation: %lu\n", lastAverageTime);
+  }
+  if (!temperatureDataHourly.empty()) {
+      lastHourlyAggregation = millis() - (millis() - calculateNextInterval(temperatureDataHourly.back().timestamp, hourlyInterval));
+      Serial.printf("Setting last hourly aggregation: %lu\n", lastHourlyAggregation);
+  }
+  if (!temperatureData6Hour.empty()) {
+      last6HourAggregation = millis() - (millis() - calculateNextInterval(temperatureData6Hour.back().timestamp, sixHourInterval));
+      Serial.printf("Setting last 6-hour aggregation: %lu\n", last6HourAggregation);
+  }
+}
+
+// Start a read of every sensor every 15 seconds; finishSample() picks them up
+void collectSample() {
+    startSensorReads();
+    rescheduleTask(finishTask, SENSOR_CAPTURE_TIME);
+}
+
+// Collect the sensor reads and evaluate the rules against the samples
+void finishSample() {
+    unsigned long now = millis();
+
+    // One pass over all sensors; each feeds its own 5-minute accumulator
+    unsigned long retryIn = readSensors(getCurrentEpoch());
+    if (retryIn) {
+        rescheduleTask(finishTask, retryIn); // Some sensors are being read again
+        return;
+    }
+
+    // The primary sensor drives temperature_data and the derived signals
+    const SensorReading& reading = getSensor(PRIMARY_SENSOR).latest;
+    if (reading.result == SENSOR_READ_OK) {
+      if (!firstSampleTaken) {
+        firstSampleTaken = true;
+        markBootPhase("first_sample");
+        Serial.printf("First sample %lu ms after boot\n", now);
+      }
+      temperature_data.temperature = reading.temperature; // Update global temperature
+      temperature_data.humidity = reading.humidity; // Update global humidity
+      temperature_data.feels_like = reading.feels_like; // Update global feels like temperature
+      updateSampleSignals(reading.temperature, reading.feels_like, now, hasACChanged(), getLastACChangeTime());
+      publishSample(getCurrentEpoch(), reading.temperature, reading.humidity, reading.feels_like);
+      Serial.printf("Collected data - Temp: %.2f, Humidity: %.2f\n", reading.temperature, reading.humidity);
+    } else if (reading.result == SENSOR_READ_REJECTED) {
+      Serial.println("Rejected outlier reading from the primary sensor");
+    } else {
+      Serial.println("Failed to read from DHT sensor.");
+      // The DHT needs a moment after power-up; retry soon rather than a full interval later
+      if (!firstSampleTaken) rescheduleTask(collectTask, sensorRetryInterval);
+    }
+
+    bool anyRead = false;
+    for (size_t i = 0; i < getSensorCount(); ++i) {
+      if (getSensor(i).latest.result == SENSOR_READ_OK) anyRead = true;
+    }
+
+    // One rule pass per sampling pass; all of its actions collapse into ac_state.
+    // Rules depend on the time of day and season, so wait for the clock
+    if (anyRead) {
+      if (isTimeSynced()) {
+        evaluateRules();
+        rescheduleTask(actuatorTask, 0); // Transmit any change now rather than on the next service tick
+      }
+      publishLiveState(getCurrentEpoch(), temperature_data, ac_state);
+    }
+}
+
+// Average data every 5 minutes
+void averageFiveMinutes() {
+    for (size_t i = 0; i < getSensorCount(); ++i) {
+        Sensor& sensor = getSensor(i);
+        if (sensor.accumulator.empty()) continue;
+
+        // Calculate and store 5-minute average
+        SampleRollup rollup = sensor.accumulator.rollup();
+        float avgTemp = rollup.temperature.mean;
+        float avgHum = rollup.humidity.mean;
+        sensor.series5Min->push_back({avgTemp, avgHum, getCurrentEpoch()});
+        Serial.printf("5-Minute Average [%s] - Temp: %.2f (%.2f..%.2f, sd %.2f), Humidity: %.2f (%.2f..%.2f, sd %.2f), %u samples, %u rejected\n",
+                      sensor.config.id.c_str(), avgTemp, rollup.temperature.min, rollup.temperature.max, rollup.temperature.stddev,
+                      avgHum, rollup.humidity.min, rollup.humidity.max, rollup.humidity.stddev,
+                      rollup.count, rollup.rejected);
+
+        if (i == PRIMARY_SENSOR) {
+            publishRollup(getCurrentEpoch(), rollup);
+            temperature_data.temperature_5min = avgTemp; // Update global temperature
+            temperature_data.humidity_5min = avgHum; // Update global humidity
+            temperature_data.feels_like_5min = getFeelsLikeTemperature(avgTemp, avgHum); // Update global feels like temperature
+            updateTrendSignals(avgTemp);
+            publishLiveState(getCurrentEpoch(), temperature_data, ac_state);
+            updateDailyStats(sensor.series5Min->back(), temperature_data.feels_like_5min, getAcknowledgedACState().is_on);
+        }
+
+        // Stage the point; the file is rewritten once per durability window (see persistence.h)
+        persistLatest(*sensor.series5Min);
+
+        // Start the next 5-minute period
+        sensor.accumulator.reset();
+    }
+}
+
+// Average the newest `count` points of one tier into a point of the next
+bool aggregateSeries(const DataSeries& from, size_t count, DataSeries& to, float& avgTemp, float& avgHum) {
+    if (from.size() < count) return false;
+    float tempSum = 0.0;
+    float humSum = 0.0;
+    for (size_t i = from.size() - count; i < from.size(); ++i) {
+        tempSum += from[i].temperature;
+        humSum += from[i].humidity;
+    }
+    avgTemp = tempSum / count;
+    avgHum = humSum / count;
+    to.push_back({avgTemp, avgHum, getCurrentEpoch()});
+    return true;
+}
+
+// Aggregate to hourly data every hour
+void aggregateHourly() {
+    for (size_t i = 0; i < getSensorCount(); ++i) {
+        Sensor& sensor = getSensor(i);
+        float avgTemp, avgHum;
+        // Aggregate the last 12 5-minute points into an hourly average
+        if (aggregateSeries(*sensor.series5Min, 12, *sensor.seriesHourly, avgTemp, avgHum)) {
+            Serial.printf("Hourly Average [%s] - Temp: %.2f, Humidity: %.2f\n", sensor.config.id.c_str(), avgTemp, avgHum);
+            persistLatest(*sensor.seriesHourly);
+        }
+    }
+}
+
+// Aggregate to 6-hour data every 6 hours
+void aggregateSixHourly() {
+    for (size_t i = 0; i < getSensorCount(); ++i) {
+        Sensor& sensor = getSensor(i);
+        float avgTemp, avgHum;
+        // Aggregate the last 6 hourly points into a 6-hour average
+        if (aggregateSeries(*sensor.seriesHourly, 6, *sensor.series6Hour, avgTemp, avgHum)) {
+            Serial.printf("6-Hour Average [%s] - Temp: %.2f, Humidity: %.2f\n", sensor.config.id.c_str(), avgTemp, avgHum);
+            persistLatest(*sensor.series6Hour);
+        }
+    }
+}
+
+// Transmit the desired AC state only when it changed (rate limited, with periodic resync)
+void serviceActuator() {
+    uint32_t framesSent = getActuatorStats().framesSent;
+    actuatorService(ac_state, millis());
+    if (getActuatorStats().framesSent != framesSent) {
+        publishACState(getCurrentEpoch(), getAcknowledgedACState());
+    }
+}
+
+// Rewrite the data files once the durability window has passed
+void flushStagedData() {
+    setDurabilityWindow(config.durability_window);   // Settings changes apply without a reboot
+    servicePersistence(millis());
+}
+
+// Delay until one interval after `last`, measured from now
+unsigned long firstRunDelay(unsigned long last, unsigned long interval) {
+    unsigned long due = last + interval;
+    return (long)(due - millis()) > 0 ? due - millis() : 0;
+}
+
+void setupTasks() {
+  collectTask = scheduleTask("collect", collectSample, collectionInterval, 0, 100);
+  finishTask = scheduleTask("collect-finish", finishSample, 0, SENSOR_CAPTURE_TIME, 5000);
+  scheduleTask("average-5min", averageFiveMinutes, averageInterval, firstRunDelay(lastAverageTime, averageInterval), 2000);
+  scheduleTask("aggregate-hourly", aggregateHourly, hourlyInterval, firstRunDelay(lastHourlyAggregation, hourlyInterval), 2000);
+  scheduleTask("aggregate-6hour", aggregateSixHourly, sixHourInterval, firstRunDelay(last6HourAggregation, sixHourInterval), 2000);
+  actuatorTask = scheduleTask("actuator", serviceActuator, serviceInterval, 0, 200);
+  scheduleTask("persistence", flushStagedData, persistenceInterval, persistenceInterval, 500);
+  scheduleTask("connectivity", serviceConnectivity, CONNECTIVITY_POLL, 0, 100);
+}
+
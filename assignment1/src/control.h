@@ -0,0 +1,19 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <Arduino.h>
+
+// What the control task runs (see tasks.h), as scheduler tasks: a sampling
+// pass over every sensor each 15 s followed by a rule pass, the actuator,
+// the 5-minute, hourly and 6-hour rollups, and the durability window flush.
+// Nothing here touches the hardware directly (sensors, IR and the network
+// sit behind sensors.h, actuator.h and connectivity.h), so host tools can
+// drive it with a virtual clock.
+
+// After loadHistoricalData(): line the rollups up with the newest stored points
+void resumeAggregation();
+
+// Once the sensors, rules, actuator and connectivity are set up
+void setupTasks();
+
+#endif
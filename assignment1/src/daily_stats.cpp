@@ -0,0 +1,294 @@
+#include <daily_stats.h>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include <civil_time.h>
+#include <config.h>
+#include <flash_writer.h>
+#include <rules.h>
+#include <seqlock.h>
+#include <storage.h>
+
+// Today's record with the stamp of the newest point in it, as saved
+struct TodayRecord {
+    DailyStats stats;
+    uint32_t lastTimestamp;
+};
+
+// Finished days, oldest dropped when full. Same reader scheme as DataSeries
+// (see data.h): the control task writes, web handlers copy a record and
+// check that it wasn't reused underneath them.
+static DailyStats finishedDays[DAILY_STATS_DAYS];
+static std::atomic<uint32_t> claimed(0);
+static std::atomic<uint32_t> published(0);
+
+static TodayRecord today;                    // Control task's working copy
+static Seqlock<TodayRecord> sharedToday;     // What readers see
+static DailyStatsStatus status;              // Control task's working copy
+static Seqlock<DailyStatsStatus> sharedStatus;
+static bool replaying = false;               // Boot replay: save once at the end
+
+static int32_t toTenths(float value) {
+    return (int32_t)lroundf(value * 10.0f);
+}
+
+static int16_t clampTenths(int32_t value) {
+    return (int16_t)(value < INT16_MIN ? INT16_MIN : value > INT16_MAX ? INT16_MAX : value);
+}
+
+uint16_t getLocalDay(uint32_t epoch) {
+    TimeZone zone;
+    getLocalTimeZone(zone);
+    CivilTime local;
+    toLocalTime(zone, epoch, local);
+    return (uint16_t)daysFromCivil(local.year, local.month, local.day);
+}
+
+static bool lastFinishedDay(uint16_t& day) {
+    uint32_t end = published.load(std::memory_order_relaxed);
+    if (end == 0) return false;
+    day = finishedDays[(end - 1) % DAILY_STATS_DAYS].day;
+    return true;
+}
+
+static std::vector<uint8_t> serializeStats(const void* records, size_t recordSize, size_t count) {
+    DailyStatsFileHeader header;
+    header.magic = DAILY_STATS_MAGIC;
+    header.version = DAILY_STATS_VERSION;
+    header.recordSize = recordSize;
+    header.count = count;
+    header.checksum = calculateCRC32((const uint8_t*)records, recordSize * count);
+    std::vector<uint8_t> contents(sizeof(header) + recordSize * count);
+    memcpy(contents.data(), &header, sizeof(header));
+    memcpy(contents.data() + sizeof(header), records, recordSize * count);
+    return contents;
+}
+
+// Records of a stats file, or false if it is missing, from another layout or damaged
+static bool loadStatsFile(const char* path, size_t recordSize, std::vector<uint8_t>& records, uint32_t& count) {
+    std::vector<uint8_t> contents;
+    if (!storage().read(path, contents)) return false;
+    DailyStatsFileHeader header;
+    if (contents.size() < sizeof(header)) return false;
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != DAILY_STATS_MAGIC || header.version != DAILY_STATS_VERSION ||
+        header.recordSize != recordSize || contents.size() - sizeof(header) != (size_t)header.count * recordSize) {
+        Serial.printf("Ignoring %s: bad header\n", path);
+        return false;
+    }
+    if (calculateCRC32(contents.data() + sizeof(header), header.count * recordSize) != header.checksum) {
+        Serial.printf("Ignoring %s: checksum mismatch\n", path);
+        return false;
+    }
+    records.assign(contents.begin() + sizeof(header), contents.end());
+    count = header.count;
+    return true;
+}
+
+// Rewrite /stats.bin with every finished day; ~15 KB once a day
+static void saveFinishedDays() {
+    uint32_t end = published.load(std::memory_order_relaxed);
+    uint32_t first = end > DAILY_STATS_DAYS ? end - DAILY_STATS_DAYS : 0;
+    std::vector<DailyStats> records;
+    records.reserve(end - first);
+    for (uint32_t sequence = first; sequence != end; ++sequence) {
+        records.push_back(finishedDays[sequence % DAILY_STATS_DAYS]);
+    }
+    if (queueFileWrite(DAILY_STATS_PATH, serializeStats(records.data(), sizeof(DailyStats), records.size()))) {
+        status.saves++;
+    } else {
+        Serial.println("Failed to queue daily statistics, write queue full");
+    }
+}
+
+static void saveToday() {
+    if (queueFileWrite(DAILY_STATS_TODAY_PATH, serializeStats(&today, sizeof(today), 1))) status.saves++;
+}
+
+static void pushFinishedDay(const DailyStats& stats) {
+    uint32_t sequence = published.load(std::memory_order_relaxed);
+    // Claim first, so a reader that copied the slot being overwritten sees that it is stale
+    claimed.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    finishedDays[sequence % DAILY_STATS_DAYS] = stats;
+    published.store(sequence + 1, std::memory_order_release);
+    status.finishedDays = sequence + 1 < DAILY_STATS_DAYS ? sequence + 1 : DAILY_STATS_DAYS;
+}
+
+static void finishDay() {
+    pushFinishedDay(today.stats);
+    Serial.printf("Day %u finished: %u points, %.1f..%.1f C\n", today.stats.day, today.stats.points,
+                  today.stats.minTemperature / 10.0f, today.stats.maxTemperature / 10.0f);
+    if (!replaying) saveFinishedDays();
+    memset(&today, 0, sizeof(today));
+}
+
+// Returns false if the point was skipped
+static bool foldPoint(const DataPoint& point, float feelsLike, bool acOn) {
+    // Boot-time stamps have no local date; restamped points are too old to fold in later
+    if (point.timestamp < MIN_VALID_EPOCH || isnan(point.temperature) || isnan(point.humidity)) return false;
+
+    uint16_t day = getLocalDay(point.timestamp);
+    uint16_t finished;
+    if ((lastFinishedDay(finished) && day <= finished) ||
+        (today.stats.points && (day < today.stats.day || point.timestamp <= today.lastTimestamp))) {
+        status.outOfOrder++;
+        return false;
+    }
+    if (today.stats.points && day != today.stats.day) finishDay();
+
+    DailyStats& stats = today.stats;
+    int16_t temperature = clampTenths(toTenths(point.temperature));
+    if (stats.points == 0) {
+        stats.day = day;
+        stats.minTemperature = temperature;
+        stats.maxTemperature = temperature;
+        stats.high = clampTenths(toTenths(config.comfort_high));
+        stats.low = clampTenths(toTenths(config.comfort_low));
+    }
+    stats.temperatureSum += temperature;
+    stats.feelsLikeSum += toTenths(feelsLike);
+    stats.humiditySum += toTenths(point.humidity);
+    if (temperature < stats.minTemperature) stats.minTemperature = temperature;
+    if (temperature > stats.maxTemperature) stats.maxTemperature = temperature;
+    if (temperature > stats.high) {
+        stats.degreesAbove += temperature - stats.high;
+        stats.pointsAbove++;
+    }
+    if (temperature < stats.low) {
+        stats.degreesBelow += stats.low - temperature;
+        stats.pointsBelow++;
+    }
+    if (acOn) stats.acOnPoints++;
+    stats.points++;
+    today.lastTimestamp = point.timestamp;
+    status.lastTimestamp = point.timestamp;
+    sharedToday.write(today);
+    return true;
+}
+
+void updateDailyStats(const DataPoint& point, float feelsLike, bool acOn) {
+    // Hourly, so a reset loses little of today
+    if (foldPoint(point, feelsLike, acOn) && today.stats.points % 12 == 0) saveToday();
+    sharedStatus.write(status);
+}
+
+void loadDailyStats(const DataSeries& series5Min) {
+    std::vector<uint8_t> records;
+    uint32_t count = 0;
+    if (loadStatsFile(DAILY_STATS_PATH, sizeof(DailyStats), records, count)) {
+        uint32_t first = count > DAILY_STATS_DAYS ? count - DAILY_STATS_DAYS : 0;
+        for (uint32_t i = first; i < count; ++i) {
+            DailyStats record;
+            memcpy(&record, records.data() + i * sizeof(DailyStats), sizeof(record));
+            uint16_t finished;
+            if (lastFinishedDay(finished) && record.day <= finished) continue;
+            pushFinishedDay(record);
+        }
+    }
+
+    uint16_t finished;
+    bool haveFinished = lastFinishedDay(finished);
+    if (loadStatsFile(DAILY_STATS_TODAY_PATH, sizeof(TodayRecord), records, count) && count == 1) {
+        TodayRecord saved;
+        memcpy(&saved, records.data(), sizeof(saved));
+        if (!haveFinished || saved.stats.day > finished) today = saved;
+    }
+    sharedToday.write(today);
+
+    // Points newer than the last save (all of them on first boot); the AC
+    // state at the time is unknown, so they count as off
+    replaying = true;
+    uint32_t days = published.load(std::memory_order_relaxed);
+    size_t replayed = 0;
+    for (size_t i = 0; i < series5Min.size(); ++i) {
+        const DataPoint& point = series5Min[i];
+        if (point.timestamp <= today.lastTimestamp) continue;
+        if (foldPoint(point, getFeelsLikeTemperature(point.temperature, point.humidity), false)) replayed++;
+    }
+    replaying = false;
+    if (published.load(std::memory_order_relaxed) != days) saveFinishedDays();
+    if (replayed) saveToday();
+    sharedStatus.write(status);
+    Serial.printf("Loaded %u days of statistics, %u points replayed\n", status.finishedDays, (unsigned)replayed);
+}
+
+size_t readDailyStats(uint16_t from, uint16_t to, std::vector<DailyStats>& out) {
+    size_t added = 0;
+    uint32_t end = published.load(std::memory_order_acquire);
+    uint32_t first = end > DAILY_STATS_DAYS ? end - DAILY_STATS_DAYS : 0;
+    for (uint32_t sequence = first; sequence != end; ++sequence) {
+        DailyStats record = finishedDays[sequence % DAILY_STATS_DAYS];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Slot `sequence` is reused by day number sequence + capacity
+        if (claimed.load(std::memory_order_relaxed) > sequence + DAILY_STATS_DAYS) continue;
+        if (record.day < from || record.day > to) continue;
+        out.push_back(record);
+        added++;
+    }
+
+    // Today's record may still be the day just finished above
+    TodayRecord current = sharedToday.read();
+    if (current.stats.points && current.stats.day >= from && current.stats.day <= to &&
+        (added == 0 || out.back().day < current.stats.day)) {
+        out.push_back(current.stats);
+        added++;
+    }
+    return added;
+}
+
+bool getTodayStats(DailyStats& stats) {
+    TodayRecord current = sharedToday.read();
+    stats = current.stats;
+    return current.stats.points != 0;
+}
+
+DailyStatsStatus getDailyStatsStatus() {
+    return sharedStatus.read();
+}
+
+void writeDailyStatsJson(Print& out, const std::vector<DailyStats>& days) {
+    const float pointHours = DAILY_STATS_POINT_MINUTES / 60.0f;
+    int64_t temperatureSum = 0;
+    uint32_t points = 0, pointsAbove = 0, pointsBelow = 0, acOnPoints = 0;
+    uint64_t degreesAbove = 0, degreesBelow = 0;
+    int16_t minTemperature = INT16_MAX, maxTemperature = INT16_MIN;
+
+    out.print("{\"days\":[");
+    for (size_t i = 0; i < days.size(); ++i) {
+        const DailyStats& day = days[i];
+        int32_t year;
+        uint32_t month, date;
+        civilFromDays(day.day, year, month, date);
+        out.printf("%s{\"date\":\"%04d-%02u-%02u\",\"points\":%u,\"min\":%.1f,\"max\":%.1f,\"mean\":%.2f,"
+                   "\"humidity\":%.1f,\"feels_like\":%.2f,\"high\":%.1f,\"low\":%.1f,\"hours_above\":%.2f,"
+                   "\"hours_below\":%.2f,\"degree_hours_above\":%.2f,\"degree_hours_below\":%.2f,\"ac_on_hours\":%.2f}",
+                   i ? "," : "", (int)year, (unsigned)month, (unsigned)date, day.points,
+                   day.minTemperature / 10.0f, day.maxTemperature / 10.0f,
+                   day.temperatureSum / 10.0f / day.points, day.humiditySum / 10.0f / day.points,
+                   day.feelsLikeSum / 10.0f / day.points, day.high / 10.0f, day.low / 10.0f,
+                   day.pointsAbove * pointHours, day.pointsBelow * pointHours,
+                   day.degreesAbove / 10.0f * pointHours, day.degreesBelow / 10.0f * pointHours,
+                   day.acOnPoints * pointHours);
+
+        temperatureSum += day.temperatureSum;
+        points += day.points;
+        pointsAbove += day.pointsAbove;
+        pointsBelow += day.pointsBelow;
+        acOnPoints += day.acOnPoints;
+        degreesAbove += day.degreesAbove;
+        degreesBelow += day.degreesBelow;
+        if (day.minTemperature < minTemperature) minTemperature = day.minTemperature;
+        if (day.maxTemperature > maxTemperature) maxTemperature = day.maxTemperature;
+    }
+    out.print("],\"total\":{");
+    out.printf("\"days\":%u,\"points\":%u", (unsigned)days.size(), (unsigned)points);
+    if (points) {
+        out.printf(",\"min\":%.1f,\"max\":%.1f,\"mean\":%.2f", minTemperature / 10.0f, maxTemperature / 10.0f,
+                   temperatureSum / 10.0 / points);
+    }
+    out.printf(",\"hours_above\":%.2f,\"hours_below\":%.2f,\"degree_hours_above\":%.2f,\"degree_hours_below\":%.2f,"
+               "\"ac_on_hours\":%.2f}}",
+               pointsAbove * pointHours, pointsBelow * pointHours, degreesAbove / 10.0f * pointHours,
+               degreesBelow / 10.0f * pointHours, acOnPoints * pointHours);
+}
@@ -0,0 +1,80 @@
+#ifndef DAILY_STATS_H
+#define DAILY_STATS_H
+
+#include <Arduino.h>
+#include <vector>
+#include <data.h>
+
+// Per-day summary of the primary sensor, so "yesterday's min/max" or "hours
+// above 26 °C this week" don't need the raw tiers (GET /api/stats). Each new
+// 5-minute point is folded into today's record in O(1); when a point lands on
+// a new local day, today's record joins the ring of finished days and
+// /stats.bin is rewritten (once a day). Today's record is saved on its own to
+// /stats_today.bin every hour, and points newer than that save are replayed
+// from the 5-minute series at boot, so a reset loses only the AC on-time of
+// the last hour.
+//
+// Values are fixed point: temperatures and humidity in tenths. Degree sums
+// are tenths of a degree per 5-minute point beyond the threshold, i.e.
+// degree-hours are degreesAbove / 10 / 12. A day keeps the thresholds
+// (config comfort_high/comfort_low) it started with; changes apply from the
+// next day, so every record is consistent with the thresholds stored in it.
+
+const size_t DAILY_STATS_DAYS = 366;
+const float COMFORT_DEFAULT_HIGH = 26.0f;     // °C
+const float COMFORT_DEFAULT_LOW = 18.0f;
+const uint32_t DAILY_STATS_POINT_MINUTES = 5;
+const char* const DAILY_STATS_PATH = "/stats.bin";
+const char* const DAILY_STATS_TODAY_PATH = "/stats_today.bin";
+const uint32_t DAILY_STATS_MAGIC = 0x59414453;  // "SDAY"
+const uint16_t DAILY_STATS_VERSION = 1;
+
+struct DailyStats {
+    int32_t temperatureSum;      // Tenths of a °C, over `points`
+    int32_t feelsLikeSum;
+    int32_t humiditySum;         // Tenths of a %
+    uint32_t degreesAbove;       // Tenths of a °C above `high`, summed over points
+    uint32_t degreesBelow;       // Tenths of a °C below `low`
+    uint16_t day;                // Local date, days since 1970-01-01 (see daysFromCivil())
+    int16_t minTemperature;      // Tenths of a °C
+    int16_t maxTemperature;
+    uint16_t points;             // 5-minute points, at most 288 (more on a DST fall-back day)
+    uint16_t pointsAbove;
+    uint16_t pointsBelow;
+    uint16_t acOnPoints;         // Points at which the AC was on
+    int16_t high;                // Thresholds, tenths of a °C
+    int16_t low;
+    uint16_t reserved;           // Zero; keeps the record at 40 bytes with no padding
+};
+
+struct DailyStatsFileHeader {
+    uint32_t magic;              // DAILY_STATS_MAGIC
+    uint16_t version;
+    uint16_t recordSize;         // sizeof(DailyStats)
+    uint32_t count;              // Records after the header, oldest first
+    uint32_t checksum;           // CRC32 of the records
+};
+
+struct DailyStatsStatus {
+    uint32_t finishedDays;       // In the ring
+    uint32_t lastTimestamp;      // Newest point folded in
+    uint32_t saves;              // Files queued for writing
+    uint32_t outOfOrder;         // Points older than today's record, skipped
+};
+
+// Boot, once the 5-minute series is loaded and staged points are recovered
+void loadDailyStats(const DataSeries& series5Min);
+// Control task, for every new 5-minute point of the primary sensor
+void updateDailyStats(const DataPoint& point, float feelsLike, bool acOn);
+
+// Readers (any task). Finished days and today's record, oldest first, with
+// day in [from, to]. Returns the number of records added to `out`.
+size_t readDailyStats(uint16_t from, uint16_t to, std::vector<DailyStats>& out);
+bool getTodayStats(DailyStats& today);        // false until a point has been folded in
+DailyStatsStatus getDailyStatsStatus();
+
+uint16_t getLocalDay(uint32_t epoch);         // Local date of `epoch` in the current zone
+// Body of GET /api/stats: one entry per day and totals over the range
+void writeDailyStatsJson(Print& out, const std::vector<DailyStats>& days);
+
+#endif
@@ -1,12 +1,15 @@
 // data.cpp
 #include <Arduino.h>
-#include <SPIFFS.h>
+#include <storage.h>
 #include <FS.h>
 #include <ArduinoJson.h>
 #include <time.h>
 #include <data.h>
 #include <vector>
 #include <numeric>
+#include <flash_writer.h>
+#include <boot_profile.h>
+#include <civil_time.h>
 
 // Define and initialize the activity log
 std::vector<ActivityLogEntry> activityLog = {
@@ -15,23 +18,102 @@ std::vector<ActivityLogEntry> activityLog = {
   {"11:10", "Turn AC Off", "Temperature stable"},
 };
 
-// Define global data vectors
-std::vector<DataPoint> temperatureData5Min;
-std::vector<DataPoint> temperatureDataHourly;
-std::vector<DataPoint> temperatureData6Hour;
+// Define global data series
+DataSeries temperatureData5Min(MAX_5MIN_POINTS);
+DataSeries temperatureDataHourly(MAX_HOURLY_POINTS);
+DataSeries temperatureData6Hour(MAX_6HOUR_POINTS);
 
+DataSeries::DataSeries(size_t capacity) : slots(capacity), claimed(0), published(0) {
+}
 
-void saveDataPoints(const char* path, const std::vector<DataPoint>& data) {
-    String tempPath = String(path) + String(millis()) + ".tmp";
-    File tempFile = SPIFFS.open(tempPath.c_str(), FILE_WRITE);
-    if (!tempFile) {
-        Serial.println("Failed to open temporary file for writing");
-        return;
+void DataSeries::push_back(const DataPoint& point) {
+    uint32_t sequence = published.load(std::memory_order_relaxed);
+    // Claim first, so a reader that copied the slot being overwritten sees that it is stale
+    claimed.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slots[sequence % slots.size()] = point;
+    published.store(sequence + 1, std::memory_order_release);
+}
+
+void DataSeries::assign(const std::vector<DataPoint>& points) {
+    size_t start = points.size() > slots.size() ? points.size() - slots.size() : 0;
+    for (size_t i = start; i < points.size(); ++i) {
+        push_back(points[i]);
     }
+}
+
+size_t DataSeries::size() const {
+    uint32_t end = published.load(std::memory_order_relaxed);
+    return end < slots.size() ? end : slots.size();
+}
+
+const DataPoint& DataSeries::operator[](size_t index) const {
+    uint32_t end = published.load(std::memory_order_relaxed);
+    return slots[(end - size() + index) % slots.size()];
+}
 
+std::vector<DataPoint> DataSeries::toVector() const {
+    std::vector<DataPoint> points;
+    points.reserve(size());
+    for (size_t i = 0; i < size(); ++i) points.push_back((*this)[i]);
+    return points;
+}
+
+size_t DataSeries::restamp(uint32_t bootOffset) {
+    // Readers see every point as stale while the stamps change, then either stamp
+    uint32_t end = published.load(std::memory_order_relaxed);
+    claimed.store(end + slots.size(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    size_t count = 0;
+    for (size_t i = 0; i < size(); ++i) {
+        DataPoint& point = slots[(end - size() + i) % slots.size()];
+        if (point.timestamp < MIN_VALID_EPOCH) {
+            point.timestamp += bootOffset;
+            count++;
+        }
+    }
+    claimed.store(end, std::memory_order_release);
+    return count;
+}
+
+SeriesView DataSeries::view() const {
+    uint32_t end = published.load(std::memory_order_acquire);
+    SeriesView view;
+    view.end = end;
+    // The oldest slot may already be claimed by the next write; read() catches that
+    view.first = end > slots.size() ? end - slots.size() : 0;
+    return view;
+}
+
+bool DataSeries::read(uint32_t sequence, DataPoint& point) const {
+    point = slots[sequence % slots.size()];
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Slot `sequence` is reused by write number sequence + capacity
+    return claimed.load(std::memory_order_relaxed) <= sequence + slots.size();
+}
+
+size_t DataSeries::readAll(std::vector<DataPoint>& out) const {
+    SeriesView range = view();
+    out.clear();
+    out.reserve(range.size());
+    DataPoint point;
+    for (uint32_t sequence = range.first; sequence != range.end; ++sequence) {
+        // Only the oldest points can be overwritten while we copy; drop those
+        if (read(sequence, point)) out.push_back(point);
+        else out.clear();
+    }
+    return out.size();
+}
+
+
+static void onDataPointsWritten(const char* path, FlashWriteResult result, void* context) {
+    if (result == FLASH_WRITE_OK) Serial.printf("Safely wrote data points to %s\n", path);
+    else if (result == FLASH_WRITE_FAILED) Serial.printf("Failed to write data points to %s\n", path);
+}
+
+std::vector<uint8_t> serializeDataPoints(const std::vector<DataPoint>& data) {
     // Calculate the checksum over the data points
     uint32_t checksum = calculateCRC32((uint8_t*)data.data(), data.size() * sizeof(DataPoint));
-    Serial.printf("Checksum calculated during save: 0x%08X\n", checksum);
 
     // Create and write DataPointHeader with checksum
     DataPointHeader header;
@@ -41,50 +123,54 @@ void saveDataPoints(const char* path, const std::vector<DataPoint>& data) {
     header.lastTimestamp = data.empty() ? 0 : data.back().timestamp;
     header.checksum = checksum;
 
-    tempFile.write((uint8_t*)&header, sizeof(DataPointHeader));
+    std::vector<uint8_t> contents(sizeof(DataPointHeader) + data.size() * sizeof(DataPoint));
+    memcpy(contents.data(), &header, sizeof(DataPointHeader));
+    if (!data.empty()) memcpy(contents.data() + sizeof(DataPointHeader), data.data(), data.size() * sizeof(DataPoint));
+    return contents;
+}
 
-    // Write each data point
-    for (const auto& dp : data) {
-        tempFile.write((uint8_t*)&dp, sizeof(DataPoint));
+// Serializes the points and hands them to the flash writer; the file is
+// written (temp file then rename) in the background. Series files go
+// through persistence.h instead.
+void saveDataPoints(const char* path, const std::vector<DataPoint>& data) {
+    std::vector<uint8_t> contents = serializeDataPoints(data);
+    if (!queueFileWrite(path, std::move(contents), onDataPointsWritten)) {
+        Serial.printf("Could not queue %d data points for %s\n", data.size(), path);
+        return;
     }
-    tempFile.close();
-
-    // Rename temporary file to final path (safe write)
-    SPIFFS.remove(path);                    // Remove old file if it exists
-    SPIFFS.rename(tempPath.c_str(), path);  // Rename temp file to final file name
+    Serial.printf("Queued %d data points for writing to %s\n", data.size(), path);
+}
 
-    Serial.printf("Safely wrote %d data points with checksum 0x%08X to file\n", data.size(), checksum);
+void saveDataPoints(const char* path, const DataSeries& series) {
+    saveDataPoints(path, series.toVector());
 }
 
 //Returns 1 on success, 0 on failure
 int loadDataPoints(const char* path, DataPointHeader& header, std::vector<DataPoint>& data) {
     data.clear(); // Clear existing data
 
-    File file = SPIFFS.open(path, FILE_READ);
-    if (!file) {
+    StorageStat info;
+    if (!storage().stat(path, info) ||
+        storage().readAt(path, 0, (uint8_t*)&header, sizeof(DataPointHeader)) != sizeof(DataPointHeader)) {
         Serial.println("Failed to open file for reading");
         return 0;
     }
-
-    // Read DataPointHeader
-    file.read((uint8_t*)&header, sizeof(DataPointHeader));
     Serial.printf("Expected checksum from header: 0x%08X\n", header.checksum);
 
     // Check the version (optional)
     if (header.version != 1) {
         Serial.println("Unsupported file version");
-        file.close();
         return 0;
     }
 
-    // Read each data point
-    while (file.available()) {
-        DataPoint dp;
-        file.read((uint8_t*)&dp, sizeof(DataPoint));
-        data.push_back(dp);
+    // Read the data points in one go
+    data.resize((info.size - sizeof(DataPointHeader)) / sizeof(DataPoint));
+    size_t bytes = data.size() * sizeof(DataPoint);
+    if (bytes && storage().readAt(path, sizeof(DataPointHeader), (uint8_t*)data.data(), bytes) != bytes) {
+        Serial.println("Failed to read data points");
+        data.clear();
+        return 0;
     }
-
-    file.close();
     Serial.printf("Read %d data points from file\n", data.size());
 
     // Print a sample of the loaded data points for verification
@@ -98,18 +184,11 @@ int loadDataPoints(const char* path, DataPointHeader& header, std::vector<DataPo
 
     // Check file size to ensure it matches expected size
     size_t expectedSize = sizeof(DataPointHeader) + (header.recordCount * sizeof(DataPoint));
-    // Reopen to check file size immediately after writing
-    File checkFile = SPIFFS.open(path, FILE_READ);
-    if (checkFile) {
-        Serial.printf("File %s read with size: %d bytes\n", path, checkFile.size());
-        if (checkFile.size() != expectedSize) {
-            Serial.printf("File size mismatch! Expected: %d bytes, Actual: %d bytes\n", expectedSize, checkFile.size());
-        } else {
-            Serial.println("File size matches expected size");
-        }
-        checkFile.close();
+    Serial.printf("File %s read with size: %d bytes\n", path, info.size);
+    if (info.size != expectedSize) {
+        Serial.printf("File size mismatch! Expected: %d bytes, Actual: %d bytes\n", expectedSize, info.size);
     } else {
-        Serial.println("Failed to reopen file for size check.");
+        Serial.println("File size matches expected size");
     }
 
     // Verify checksum
@@ -126,78 +205,75 @@ int loadDataPoints(const char* path, DataPointHeader& header, std::vector<DataPo
 
 // Helper function to get the current timestamp as a String
 String getCurrentTimestamp() {
-  time_t now = time(nullptr);
-  struct tm* timeInfo = localtime(&now);
-  char buffer[20];
-  strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M", timeInfo);
+  TimeZone zone;
+  CivilTime local;
+  getLocalTimeZone(zone);
+  toLocalTime(zone, time(nullptr), local);
+  char buffer[17];
+  formatDateMinute(buffer, local);
   return String(buffer);
 }
 
 uint32_t getCurrentEpoch() {
-    // Ensure time is initialized
     time_t now = time(nullptr);
-    if (now < 1000000000) { // A basic check if time is initialized (e.g., after 2001-09-09)
-        Serial.println("Error: Time not initialized");
-        return 0; // Return 0 or a default value if time is not yet set
+    if (now < MIN_VALID_EPOCH) {
+        // Not synced yet: stamp with seconds since boot, rebased by restamp() after NTP
+        return millis() / 1000;
     }
     return static_cast<uint32_t>(now);
 }
 
-
-// Load data from SPIFFS on boot
-void loadHistoricalData() {
-    DataPointHeader header;
-
-    // Load 5-minute data
-    Serial.println("Loading 5-minute data...");
-    if (!loadDataPoints("/data_5min.bin", header, temperatureData5Min)) {
-        Serial.println("Failed to load 5-minute data");
-    } else {
-        Serial.printf("Loaded %d 5-minute data points\n", temperatureData5Min.size());
+// Points stamped before a sync that never came (the device rebooted first)
+// can no longer be placed in time
+static void dropBootStamped(std::vector<DataPoint>& points, const char* label) {
+    size_t kept = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].timestamp >= MIN_VALID_EPOCH) points[kept++] = points[i];
     }
-    // Load hourly data
-    Serial.println("Loading hourly data...");
-    if (!loadDataPoints("/data_hourly.bin", header, temperatureDataHourly)) {
-        Serial.println("Failed to load hourly data");
-    } else {
-        Serial.printf("Loaded %d hourly data points\n", temperatureDataHourly.size());
-    }
-
-    // Load 6-hour data
-    Serial.println("Loading 6-hour data...");
-    if (!loadDataPoints("/data_6hour.bin", header, temperatureData6Hour)) {
-        Serial.println("Failed to load 6-hour data");
-    } else {
-        Serial.printf("Loaded %d 6-hour data points\n", temperatureData6Hour.size());
+    if (kept != points.size()) {
+        Serial.printf("Dropped %u unsynced %s data points\n", points.size() - kept, label);
+        points.resize(kept);
     }
 }
 
-void rotateAndSave5MinuteData() {
-    // Rotate out old data if we exceed the maximum points
-    while (temperatureData5Min.size() > MAX_5MIN_POINTS) {
-        temperatureData5Min.erase(temperatureData5Min.begin());
+
+// Load one tier from flash into an empty series
+bool loadSeries(const char* path, DataSeries& series, const char* label) {
+    DataPointHeader header;
+    std::vector<DataPoint> points;
+    Serial.printf("Loading %s data from %s...\n", label, path);
+    if (!loadDataPoints(path, header, points)) {
+        Serial.printf("Failed to load %s data\n", label);
+        return false;
     }
+    dropBootStamped(points, label);
+    series.assign(points);
+    Serial.printf("Loaded %d %s data points\n", series.size(), label);
+    return true;
+}
 
+// Load the primary sensor's data from flash on boot (other sensors: setupSensors())
+void loadHistoricalData() {
+    loadSeries("/data_5min.bin", temperatureData5Min, "5-minute");
+    markBootPhase("data_5min");
+    loadSeries("/data_hourly.bin", temperatureDataHourly, "hourly");
+    markBootPhase("data_hourly");
+    loadSeries("/data_6hour.bin", temperatureData6Hour, "6-hour");
+    markBootPhase("data_6hour");
+}
 
+// The series drop their oldest points themselves; these just save
+void rotateAndSave5MinuteData() {
+    saveDataPoints("/data_5min.bin", temperatureData5Min);
 }
 
 void rotateAndSaveHourlyData() {
-    // Rotate out old data if we exceed the maximum points
-    while (temperatureDataHourly.size() > MAX_HOURLY_POINTS) {
-        temperatureDataHourly.erase(temperatureDataHourly.begin());
-    }
-
-    // Save the latest hourly data to SPIFFS
+    // Save the latest hourly data to flash
     saveDataPoints("/data_hourly.bin", temperatureDataHourly);
 }
 
 void rotateAndSave6HourData() {
-    // Rotate out old data if we exceed the maximum points
-    while (temperatureData6Hour.size() > MAX_6HOUR_POINTS) {
-        temperatureData6Hour.erase(temperatureData6Hour.begin());
-    }
-
-    // Save the latest 6-hour data to SPIFFS
+    // Save the latest 6-hour data to flash
     saveDataPoints("/data_6hour.bin", temperatureData6Hour);
 }
 
@@ -222,7 +298,7 @@ void aggregateToHourlyData() {
         // Add the new hourly DataPoint to the vector
         temperatureDataHourly.push_back({avgTemp, avgHum, timestamp});
 
-        // Rotate and save hourly data to SPIFFS
+        // Rotate and save hourly data to flash
         rotateAndSaveHourlyData();
     }
 }
@@ -248,16 +324,16 @@ void aggregateTo6HourData() {
         // Add the new 6-hour DataPoint to the vector
         temperatureData6Hour.push_back({avgTemp, avgHum, timestamp});
 
-        // Rotate and save 6-hour data to SPIFFS
+        // Rotate and save 6-hour data to flash
         rotateAndSave6HourData();
     }
 }
 
-// Helper function to load JSON data from a file on SPIFFS
+// Helper function to load JSON data from a file in flash
 void loadJsonData(const char* path, std::vector<float>& temperatureData, std::vector<float>& humidityData,
                   std::vector<String>& timestamps, size_t jsonCapacity, const char* label) {
-    File file = SPIFFS.open(path, FILE_READ);
-    if (!file) {
+    std::vector<uint8_t> contents;
+    if (!storage().read(path, contents)) {
         Serial.printf("Failed to open %s\n", path);
         return;
     }
@@ -270,8 +346,7 @@ void loadJsonData(const char* path, std::vector<float>& temperatureData, std::ve
         return;
     }
 
-    DeserializationError error = deserializeJson(*doc, file);
-    file.close();
+    DeserializationError error = deserializeJson(*doc, (const char*)contents.data(), contents.size());
 
     if (error) {
         Serial.printf("Failed to deserialize %s data: %s\n", label, error.c_str());
@@ -295,29 +370,13 @@ void loadJsonData(const char* path, std::vector<float>& temperatureData, std::ve
 }
 
 void safeWriteToFile(const char* filePath, const JsonDocument& doc) {
-  // Generate a unique temporary file name using the current time
-  String tempFileName = "/temp_" + String(millis()) + ".json";
-
-  // Open the temporary file for writing
-  File tempFile = SPIFFS.open(tempFileName.c_str(), FILE_WRITE);
-  if (!tempFile) {
-    Serial.println("Failed to open temporary file for writing");
+  String contents;
+  if (serializeJson(doc, contents) == 0) {
+    Serial.println("Failed to serialize data for writing");
     return;
   }
-
-  // Serialize JSON document to the temporary file
-  if (serializeJson(doc, tempFile) == 0) {
-    Serial.println("Failed to write data to temporary file");
-    tempFile.close();
-    SPIFFS.remove(tempFileName);  // Clean up temporary file on failure
-    return;
-  }
-  tempFile.close();
-
-  // Safely rename the temporary file to the final file name
-  SPIFFS.remove(filePath);                    // Remove the old file if it exists
-  SPIFFS.rename(tempFileName.c_str(), filePath);  // Rename temporary file to final file
-  Serial.println("Data safely written to file");
+  // Written to a temporary file and renamed by the flash writer
+  queueFileWrite(filePath, contents);
 }
 
 // Helper function to filter data with a dynamic limit
@@ -340,7 +399,10 @@ void filterDataForDay(std::vector<float>& tempData, std::vector<float>& humData,
 
 // Helper function to calculate CRC32 checksum
 uint32_t calculateCRC32(const uint8_t* data, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
+    return ~updateCRC32(0xFFFFFFFF, data, length);
+}
+
+uint32_t updateCRC32(uint32_t crc, const uint8_t* data, size_t length) {
     for (size_t i = 0; i < length; ++i) {
         uint8_t byte = data[i];
         crc ^= byte;
@@ -352,7 +414,26 @@ uint32_t calculateCRC32(const uint8_t* data, size_t length) {
             }
         }
     }
-    return ~crc;
+    return crc;
+}
+
+// CRC32 of a whole file, read in chunks so large files need no buffer
+// (each chunk reopens the file, so they are not too small)
+bool calculateFileCRC32(const char* path, uint32_t& crc, size_t& size) {
+    StorageStat info;
+    if (!storage().stat(path, info) || info.isDirectory) return false;
+
+    uint8_t buffer[1024];
+    uint32_t running = 0xFFFFFFFF;
+    size = 0;
+    while (size < info.size) {
+        size_t n = storage().readAt(path, size, buffer, std::min(sizeof(buffer), info.size - size));
+        if (n == 0) return false;
+        running = updateCRC32(running, buffer, n);
+        size += n;
+    }
+    crc = ~running;
+    return true;
 }
 
 unsigned long calculateNextInterval(uint32_t lastTimestamp, unsigned long interval) {
@@ -364,18 +445,57 @@ unsigned long calculateNextInterval(uint32_t lastTimestamp, unsigned long interv
 }
 
 String formatTimestamp(uint32_t epoch, const String& timezone) {
-    // Convert the epoch to time structure
-    time_t rawTime = epoch;
-    struct tm *timeInfo = localtime(&rawTime);
+    TimeZone zone;
+    getLocalTimeZone(zone);
+    char buffer[48];
+    formatTimestamp(buffer, sizeof(buffer), zone, epoch, timezone.c_str());
+    return String(buffer);
+}
 
-    // Format the time as a string
-    char buffer[25];  // Enough space for "YYYY-MM-DD HH:MM:SS ±HH:MM"
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeInfo);
+size_t formatTimestamp(char* out, size_t size, const TimeZone& zone, uint32_t epoch, const char* suffix) {
+    // "YYYY-MM-DD HH:MM:SS" in local time, then the suffix
+    if (size < 20) return 0;
+    CivilTime local;
+    toLocalTime(zone, epoch, local);
+    size_t length = formatDateTime(out, local);
+    if (suffix && *suffix && length + 1 < size) {
+        out[length++] = ' ';
+        size_t suffixLength = strlen(suffix);
+        if (suffixLength > size - length - 1) suffixLength = size - length - 1;
+        memcpy(out + length, suffix, suffixLength);
+        length += suffixLength;
+        out[length] = '\0';
+    }
+    return length;
+}
 
-    // Append timezone
-    String formattedTime(buffer);
-    formattedTime += " " + timezone;
+void writeSeriesJson(Print& out, const std::vector<DataPoint>& points, const TimeZone& zone) {
+    out.print("{\"temperature\":[");
+    for (size_t i = 0; i < points.size(); ++i) {
+        out.print(points[i].temperature);
+        if (i < points.size() - 1) {
+            out.print(","); // Add comma between items
+        }
+    }
+    out.print("],\"humidity\":[");
 
-    return formattedTime;
+    for (size_t i = 0; i < points.size(); ++i) {
+        out.print(points[i].humidity);
+        if (i < points.size() - 1) {
+            out.print(",");
+        }
+    }
+    out.print("],\"timestamps\":[");
+
+    // Each stamp is formatted in place
+    char stamp[40];
+    for (size_t i = 0; i < points.size(); ++i) {
+        stamp[0] = '"';
+        size_t length = 1 + formatTimestamp(stamp + 1, sizeof(stamp) - 2, zone, points[i].timestamp, "+00:00");  // UTC offset as an example
+        stamp[length++] = '"';
+        if (i < points.size() - 1) stamp[length++] = ',';
+        out.write((const uint8_t*)stamp, length);
+    }
+    out.print("],\"message\":\"Thanks for using SmartAC Remote!\"}");
 }
 
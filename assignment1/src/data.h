@@ -2,8 +2,10 @@
 #define DATA_H
 
 #include <vector>
+#include <atomic>
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <civil_time.h>
 
 //We are using a custom binary format to store data points in SPIFFS. This is needed
 //to conserve memory and storage on the SPIFFS filesystem. The format is as follows:
@@ -25,19 +27,65 @@ struct DataPoint {
     uint32_t timestamp;          // Unix timestamp for the data point
 };
 
-// Data vectors for storing 5-minute, hourly, and 6-hourly data
-extern std::vector<DataPoint> temperatureData5Min;
-extern std::vector<DataPoint> temperatureDataHourly;
-extern std::vector<DataPoint> temperatureData6Hour;
-
 // Maximum points to retain for each data interval
 const size_t MAX_5MIN_POINTS = 2016;   // 1 week
 const size_t MAX_HOURLY_POINTS = 720;  // 1 month
 const size_t MAX_6HOUR_POINTS = 1460;  // 1 year
 
+// Timestamps below this are seconds since boot, taken before the clock was
+// set (see getCurrentEpoch() and connectivity.h)
+const uint32_t MIN_VALID_EPOCH = 1000000000;   // 2001-09-09
+
+// A series tier: a fixed-capacity ring of points, oldest dropped when full.
+// The control task is the only writer and uses it much like a vector. Web
+// handlers on the other core read through a view instead: view() captures
+// the range of sequence numbers present, and read() copies one point and
+// reports false if the writer has since overwritten it. Nothing is ever
+// reallocated or shifted, so a reader can never see freed memory, and the
+// writer never waits for a reader.
+struct SeriesView {
+    uint32_t first;              // Sequence number of the oldest point
+    uint32_t end;                // One past the newest
+    size_t size() const { return end - first; }
+};
+
+class DataSeries {
+public:
+    explicit DataSeries(size_t capacity);
+
+    // Writer (control task)
+    void push_back(const DataPoint& point);
+    void assign(const std::vector<DataPoint>& points);  // Keeps the newest points that fit
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return slots.size(); }
+    const DataPoint& operator[](size_t index) const;   // 0 = oldest
+    const DataPoint& back() const { return (*this)[size() - 1]; }
+    std::vector<DataPoint> toVector() const;
+    size_t restamp(uint32_t bootOffset);                // Rebase boot-time stamps once the clock is set
+
+    // Readers (any task)
+    SeriesView view() const;
+    bool read(uint32_t sequence, DataPoint& point) const;
+    size_t readAll(std::vector<DataPoint>& out) const;  // Consistent copy of the current view
+
+private:
+    std::vector<DataPoint> slots;
+    std::atomic<uint32_t> claimed;     // Writes started; the slot for `claimed - 1` may be changing
+    std::atomic<uint32_t> published;   // Writes finished
+};
+
+// Data series for storing 5-minute, hourly, and 6-hourly data
+extern DataSeries temperatureData5Min;
+extern DataSeries temperatureDataHourly;
+extern DataSeries temperatureData6Hour;
+
 // Data point load/save
+std::vector<uint8_t> serializeDataPoints(const std::vector<DataPoint>& data);  // Header and points, as stored
 void saveDataPoints(const char* path, const std::vector<DataPoint>& data);
+void saveDataPoints(const char* path, const DataSeries& series);
 int loadDataPoints(const char* path, DataPointHeader& header, std::vector<DataPoint>& data);
+bool loadSeries(const char* path, DataSeries& series, const char* label);
 void loadHistoricalData();
 
 // Function declarations
@@ -50,10 +98,16 @@ void rotateAndSave6HourData();
 void aggregateToHourlyData();
 void aggregateTo6HourData();
 String getCurrentTimestamp();
-uint32_t getCurrentEpoch();
+uint32_t getCurrentEpoch();  // Seconds since boot (below MIN_VALID_EPOCH) until the clock is set
 uint32_t calculateCRC32(const uint8_t* data, size_t length);
+uint32_t updateCRC32(uint32_t crc, const uint8_t* data, size_t length); // Running form: start at 0xFFFFFFFF, invert at the end
+bool calculateFileCRC32(const char* path, uint32_t& crc, size_t& size);
 unsigned long calculateNextInterval(uint32_t lastTimestamp, unsigned long interval);
 String formatTimestamp(uint32_t epoch, const String& timezone = "UTC");
+// Allocation-free form for formatting many points with one copy of the zone (see civil_time.h)
+size_t formatTimestamp(char* out, size_t size, const TimeZone& zone, uint32_t epoch, const char* suffix);
+// Body of GET /api/data for a series: values, local timestamps and a message
+void writeSeriesJson(Print& out, const std::vector<DataPoint>& points, const TimeZone& zone);
 
 struct ActivityLogEntry {
   String timestamp;
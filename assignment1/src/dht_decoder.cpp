@@ -0,0 +1,73 @@
+#include <dht_decoder.h>
+
+static bool inRange(uint16_t value, uint16_t low, uint16_t high) {
+    return value >= low && value <= high;
+}
+
+DhtDecodeStatus decodeDhtPulses(const DhtPulse* pulses, size_t count, uint8_t frame[DHT_FRAME_BYTES]) {
+    // Merge runs of the same level into one pulse
+    DhtPulse merged[DHT_MAX_PULSES];
+    size_t mergedCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (mergedCount && merged[mergedCount - 1].level == pulses[i].level) {
+            uint32_t sum = (uint32_t)merged[mergedCount - 1].micros + pulses[i].micros;
+            merged[mergedCount - 1].micros = sum > 0xFFFF ? 0xFFFF : (uint16_t)sum;
+        } else if (mergedCount < DHT_MAX_PULSES) {
+            merged[mergedCount++] = pulses[i];
+        } else {
+            break;
+        }
+    }
+
+    // The response is the first low/high pair of about 80 us each; anything
+    // before it is the tail of the host's start signal
+    size_t start = mergedCount;
+    for (size_t i = 0; i + 1 < mergedCount; ++i) {
+        if (merged[i].level == 0 && inRange(merged[i].micros, DHT_RESPONSE_MIN, DHT_RESPONSE_MAX) &&
+            merged[i + 1].level == 1 && inRange(merged[i + 1].micros, DHT_RESPONSE_MIN, DHT_RESPONSE_MAX)) {
+            start = i + 2;
+            break;
+        }
+    }
+    if (start == mergedCount) return DHT_DECODE_NO_RESPONSE;
+    if (mergedCount - start < 2 * DHT_FRAME_BITS) return DHT_DECODE_TRUNCATED;
+
+    for (size_t i = 0; i < DHT_FRAME_BYTES; ++i) frame[i] = 0;
+    for (size_t bit = 0; bit < DHT_FRAME_BITS; ++bit) {
+        const DhtPulse& low = merged[start + 2 * bit];
+        const DhtPulse& high = merged[start + 2 * bit + 1];
+        if (!inRange(low.micros, DHT_BIT_LOW_MIN, DHT_BIT_LOW_MAX) || !inRange(high.micros, DHT_BIT_HIGH_MIN, DHT_BIT_HIGH_MAX)) {
+            return DHT_DECODE_BAD_TIMING;
+        }
+        if (high.micros > DHT_BIT_ONE_THRESHOLD) frame[bit / 8] |= 0x80 >> (bit % 8);
+    }
+
+    uint8_t sum = frame[0] + frame[1] + frame[2] + frame[3];
+    if (sum != frame[4]) return DHT_DECODE_BAD_CHECKSUM;
+    return DHT_DECODE_OK;
+}
+
+void dhtFrameToReading(DhtModel model, const uint8_t frame[DHT_FRAME_BYTES], float& temperature, float& humidity) {
+    if (model == DHT_MODEL_DHT11) {
+        // Integer and tenths bytes; newer DHT11s flag negative temperatures in bit 7 of the tenths
+        humidity = frame[0] + frame[1] * 0.1f;
+        temperature = frame[2] + (frame[3] & 0x0F) * 0.1f;
+        if (frame[3] & 0x80) temperature = -temperature;
+    } else {
+        // Tenths as 16-bit values, temperature sign in bit 15
+        humidity = ((frame[0] << 8) | frame[1]) * 0.1f;
+        temperature = (((frame[2] & 0x7F) << 8) | frame[3]) * 0.1f;
+        if (frame[2] & 0x80) temperature = -temperature;
+    }
+}
+
+const char* dhtDecodeStatusName(DhtDecodeStatus status) {
+    switch (status) {
+        case DHT_DECODE_OK: return "ok";
+        case DHT_DECODE_NO_RESPONSE: return "no response";
+        case DHT_DECODE_TRUNCATED: return "truncated";
+        case DHT_DECODE_BAD_TIMING: return "bad timing";
+        case DHT_DECODE_BAD_CHECKSUM: return "bad checksum";
+    }
+    return "unknown";
+}
@@ -0,0 +1,59 @@
+#ifndef DHT_DECODER_H
+#define DHT_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Decoder for the DHT11/DHT22 single-wire frame, working on captured pulse
+// widths rather than on the line itself. A capture (RMT on the ESP32, see
+// dht_rmt.h, or a recorded waveform on the host) is a list of
+// (level, duration) pulses. After the host's start signal the sensor sends:
+//
+//   response  low ~80 us, high ~80 us
+//   40 bits   low ~50 us, then high ~26-28 us for 0 or ~70 us for 1
+//   end       low ~50 us, then the line idles high
+//
+// The bits are humidity (2 bytes), temperature (2 bytes) and a checksum
+// byte, MSB first. Pure functions, no Arduino dependencies.
+
+struct DhtPulse {
+    uint8_t level;               // 0 = low, 1 = high
+    uint16_t micros;
+};
+
+enum DhtModel : uint8_t {
+    DHT_MODEL_DHT11,
+    DHT_MODEL_DHT22
+};
+
+enum DhtDecodeStatus : uint8_t {
+    DHT_DECODE_OK = 0,
+    DHT_DECODE_NO_RESPONSE,      // No response pulse pair found
+    DHT_DECODE_TRUNCATED,        // Fewer than 40 bits after the response
+    DHT_DECODE_BAD_TIMING,       // A bit's pulses are out of range
+    DHT_DECODE_BAD_CHECKSUM
+};
+
+const size_t DHT_FRAME_BYTES = 5;
+const size_t DHT_FRAME_BITS = DHT_FRAME_BYTES * 8;
+const size_t DHT_MAX_PULSES = 2 * DHT_FRAME_BITS + 8;  // Frame plus start, response and end pulses
+
+// Pulse limits in microseconds, wide enough for the DHT11's loose timing
+const uint16_t DHT_RESPONSE_MIN = 40;
+const uint16_t DHT_RESPONSE_MAX = 120;
+const uint16_t DHT_BIT_LOW_MIN = 20;
+const uint16_t DHT_BIT_LOW_MAX = 100;
+const uint16_t DHT_BIT_HIGH_MIN = 8;
+const uint16_t DHT_BIT_HIGH_MAX = 100;
+const uint16_t DHT_BIT_ONE_THRESHOLD = 48;   // High longer than this is a 1
+
+// Decode a capture into the 5 frame bytes. Adjacent pulses of the same level
+// (split by a glitch filter) are merged first.
+DhtDecodeStatus decodeDhtPulses(const DhtPulse* pulses, size_t count, uint8_t frame[DHT_FRAME_BYTES]);
+
+// Frame bytes to °C and %RH (before any calibration offset) for the given model
+void dhtFrameToReading(DhtModel model, const uint8_t frame[DHT_FRAME_BYTES], float& temperature, float& humidity);
+
+const char* dhtDecodeStatusName(DhtDecodeStatus status);
+
+#endif
@@ -0,0 +1,194 @@
+#include <dht_rmt.h>
+
+#ifdef ESP32
+#include <driver/rmt.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <freertos/ringbuf.h>
+
+static const uint32_t DHT11_START_MICROS = 20000;  // Datasheet: at least 18 ms
+static const uint32_t DHT22_START_MICROS = 1100;   // Datasheet: at least 1 ms
+static const uint16_t DHT_IDLE_MICROS = 200;       // No edge for this long ends the capture
+
+enum DhtPhase : uint8_t {
+    DHT_PHASE_IDLE,
+    DHT_PHASE_WAITING,           // Timer running until the start signal
+    DHT_PHASE_START_SIGNAL,      // Holding the line low
+    DHT_PHASE_CAPTURING          // Line released, RMT recording
+};
+
+struct DhtCapture {
+    gpio_num_t pin;
+    DhtModel model;
+    rmt_channel_t channel;
+    RingbufHandle_t ringbuf;
+    esp_timer_handle_t timer;
+    volatile DhtPhase phase;
+    DhtCaptureStats stats;
+};
+
+// Runs on the esp_timer task, not in an interrupt
+static void onDhtTimer(void* arg) {
+    DhtCapture* capture = static_cast<DhtCapture*>(arg);
+    if (capture->phase == DHT_PHASE_WAITING) {
+        gpio_set_level(capture->pin, 0);
+        capture->phase = DHT_PHASE_START_SIGNAL;
+        esp_timer_start_once(capture->timer, capture->model == DHT_MODEL_DHT11 ? DHT11_START_MICROS : DHT22_START_MICROS);
+    } else if (capture->phase == DHT_PHASE_START_SIGNAL) {
+        // Arm the receiver first; it starts recording at the release edge
+        rmt_rx_start(capture->channel, true);
+        gpio_set_level(capture->pin, 1);
+        capture->phase = DHT_PHASE_CAPTURING;
+    }
+}
+
+void* createDhtCapture(uint8_t pin, DhtModel model, uint8_t slot) {
+    rmt_channel_t channel = (rmt_channel_t)(RMT_CHANNEL_MAX - 1 - slot);
+    rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)pin, channel);
+    config.clk_div = 80;                          // 1 us ticks from the 80 MHz APB clock
+    config.mem_block_num = 1;                     // 64 items; a frame is 43
+    config.rx_config.filter_en = true;
+    config.rx_config.filter_ticks_thresh = 200;   // Ignore glitches under 2.5 us (APB cycles)
+    config.rx_config.idle_threshold = DHT_IDLE_MICROS;
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel, 1024, 0) != ESP_OK) {
+        Serial.printf("DHT on GPIO %u: RMT channel %d unavailable\n", pin, channel);
+        return nullptr;
+    }
+
+    DhtCapture* capture = new DhtCapture();
+    capture->pin = (gpio_num_t)pin;
+    capture->model = model;
+    capture->channel = channel;
+    capture->phase = DHT_PHASE_IDLE;
+    rmt_get_ringbuf_handle(channel, &capture->ringbuf);
+
+    // rmt_config() left the pin input only; make it open drain with the pull-up so
+    // we can pull the line low for the start signal and the sensor can drive it after
+    gpio_set_direction(capture->pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(capture->pin, GPIO_PULLUP_ONLY);
+    gpio_set_level(capture->pin, 1);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onDhtTimer;
+    timerArgs.arg = capture;
+    timerArgs.name = "dht";
+    esp_timer_create(&timerArgs, &capture->timer);
+    return capture;
+}
+
+bool startDhtCapture(void* handle, unsigned long delayMillis) {
+    DhtCapture* capture = static_cast<DhtCapture*>(handle);
+    if (capture->phase != DHT_PHASE_IDLE) return false;
+
+    // Drop anything left over from an earlier capture
+    size_t size;
+    while (void* item = xRingbufferReceive(capture->ringbuf, &size, 0)) vRingbufferReturnItem(capture->ringbuf, item);
+
+    capture->phase = DHT_PHASE_WAITING;
+    esp_timer_start_once(capture->timer, delayMillis ? delayMillis * 1000 : 1);
+    return true;
+}
+
+DhtDecodeStatus readDhtCapture(void* handle, float& temperature, float& humidity) {
+    DhtCapture* capture = static_cast<DhtCapture*>(handle);
+    capture->stats.captures++;
+
+    DhtDecodeStatus status = DHT_DECODE_NO_RESPONSE;
+    if (capture->phase == DHT_PHASE_CAPTURING) {
+        size_t size = 0;
+        rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(capture->ringbuf, &size, 0);
+        if (items) {
+            DhtPulse pulses[DHT_MAX_PULSES];
+            size_t count = 0;
+            for (size_t i = 0; i < size / sizeof(rmt_item32_t) && count + 2 <= DHT_MAX_PULSES; ++i) {
+                if (items[i].duration0) pulses[count++] = {(uint8_t)items[i].level0, (uint16_t)items[i].duration0};
+                if (items[i].duration1) pulses[count++] = {(uint8_t)items[i].level1, (uint16_t)items[i].duration1};
+            }
+            vRingbufferReturnItem(capture->ringbuf, items);
+
+            uint8_t frame[DHT_FRAME_BYTES];
+            status = decodeDhtPulses(pulses, count, frame);
+            if (status == DHT_DECODE_OK) dhtFrameToReading(capture->model, frame, temperature, humidity);
+        }
+    }
+    esp_timer_stop(capture->timer);
+    rmt_rx_stop(capture->channel);
+    gpio_set_level(capture->pin, 1);
+    capture->phase = DHT_PHASE_IDLE;
+
+    switch (status) {
+        case DHT_DECODE_OK: capture->stats.ok++; break;
+        case DHT_DECODE_NO_RESPONSE: capture->stats.noResponse++; break;
+        case DHT_DECODE_TRUNCATED: capture->stats.truncated++; break;
+        case DHT_DECODE_BAD_TIMING: capture->stats.badTiming++; break;
+        case DHT_DECODE_BAD_CHECKSUM: capture->stats.badChecksum++; break;
+    }
+    return status;
+}
+
+DhtCaptureStats getDhtCaptureStats(void* handle) {
+    return static_cast<DhtCapture*>(handle)->stats;
+}
+
+#else
+// No RMT on the host. Tools either feed recorded pulses to decodeDhtPulses()
+// directly or install a pulse source, which then answers every capture
+
+struct DhtCapture {
+    uint8_t pin;
+    DhtModel model;
+    bool started;
+    DhtCaptureStats stats;
+};
+
+static DhtPulseSource pulseSource = nullptr;
+
+void setDhtPulseSource(DhtPulseSource source) {
+    pulseSource = source;
+}
+
+void* createDhtCapture(uint8_t pin, DhtModel model, uint8_t slot) {
+    (void)slot;
+    if (!pulseSource) return nullptr;
+    DhtCapture* capture = new DhtCapture();
+    capture->pin = pin;
+    capture->model = model;
+    return capture;
+}
+
+bool startDhtCapture(void* handle, unsigned long delayMillis) {
+    (void)delayMillis;
+    DhtCapture* capture = static_cast<DhtCapture*>(handle);
+    if (capture->started) return false;
+    capture->started = true;
+    return true;
+}
+
+DhtDecodeStatus readDhtCapture(void* handle, float& temperature, float& humidity) {
+    DhtCapture* capture = static_cast<DhtCapture*>(handle);
+    capture->stats.captures++;
+
+    DhtDecodeStatus status = DHT_DECODE_NO_RESPONSE;
+    if (capture->started && pulseSource) {
+        DhtPulse pulses[DHT_MAX_PULSES];
+        size_t count = pulseSource(capture->pin, capture->model, pulses, DHT_MAX_PULSES);
+        uint8_t frame[DHT_FRAME_BYTES];
+        status = decodeDhtPulses(pulses, count, frame);
+        if (status == DHT_DECODE_OK) dhtFrameToReading(capture->model, frame, temperature, humidity);
+    }
+    capture->started = false;
+
+    switch (status) {
+        case DHT_DECODE_OK: capture->stats.ok++; break;
+        case DHT_DECODE_NO_RESPONSE: capture->stats.noResponse++; break;
+        case DHT_DECODE_TRUNCATED: capture->stats.truncated++; break;
+        case DHT_DECODE_BAD_TIMING: capture->stats.badTiming++; break;
+        case DHT_DECODE_BAD_CHECKSUM: capture->stats.badChecksum++; break;
+    }
+    return status;
+}
+
+DhtCaptureStats getDhtCaptureStats(void* handle) {
+    return static_cast<DhtCapture*>(handle)->stats;
+}
+#endif
@@ -0,0 +1,48 @@
+#ifndef DHT_RMT_H
+#define DHT_RMT_H
+
+#include <Arduino.h>
+#include <dht_decoder.h>
+
+// DHT driver that never masks interrupts. The DHT library bit-bangs the
+// frame with interrupts off for ~5 ms (and waits out the 18 ms start signal
+// in delay()), which stalls WiFi and IR timing on the same core.
+//
+// Here a read is split in two:
+//   startDhtCapture()  pulls the line low; an esp_timer releases it after
+//                      the model's start time and arms an RMT receiver,
+//                      which timestamps every edge of the reply in hardware
+//   readDhtCapture()   (at least DHT_CAPTURE_MILLIS later) takes the
+//                      captured pulses and decodes them with decodeDhtPulses()
+// Nothing waits in between, so the caller does other work meanwhile.
+//
+// Each sensor uses one RMT channel, counting down from RMT channel 7 so the
+// low channels stay free for IR transmit.
+
+const unsigned long DHT_CAPTURE_MILLIS = 30;        // Start signal (18 ms on the DHT11) plus a ~5 ms frame
+const unsigned long DHT_MIN_INTERVAL_MILLIS = 2000; // Between reads of one sensor (DHT22 needs 2 s)
+
+struct DhtCaptureStats {
+    uint32_t captures;
+    uint32_t ok;
+    uint32_t noResponse;
+    uint32_t truncated;
+    uint32_t badTiming;
+    uint32_t badChecksum;
+};
+
+void* createDhtCapture(uint8_t pin, DhtModel model, uint8_t slot);  // nullptr if the RMT channel is unavailable
+bool startDhtCapture(void* capture, unsigned long delayMillis);    // Start signal `delayMillis` from now
+DhtDecodeStatus readDhtCapture(void* capture, float& temperature, float& humidity);
+DhtCaptureStats getDhtCaptureStats(void* capture);
+
+#ifndef ESP32
+// Host only: stand-in for the sensors, e.g. a simulated room. Fills `pulses`
+// with what the sensor on `pin` sends after the start signal and returns the
+// count (0 for no response). Set it before setupSensors(); without one,
+// createDhtCapture() returns nullptr as there is nothing to read.
+typedef size_t (*DhtPulseSource)(uint8_t pin, DhtModel model, DhtPulse* pulses, size_t capacity);
+void setDhtPulseSource(DhtPulseSource source);
+#endif
+
+#endif
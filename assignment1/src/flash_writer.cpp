@@ -0,0 +1,229 @@
+// flash_writer.cpp
+#include <flash_writer.h>
+#include <spsc_queue.h>
+#include <seqlock.h>
+#include <storage.h>
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+
+struct FlashWriteJob {
+    String path;
+    std::vector<uint8_t> contents;
+    FlashWriteCallback callback;
+    void* context;
+    uint32_t sequence;       // Jobs run oldest first
+    uint32_t queuedAt;       // Order of queueFileWrite() calls across lanes
+    bool pending;
+};
+
+// The control task's lane has a single producer by construction; the shared
+// lane has one because its producers take sharedLaneLock to push. The I/O
+// task is the only consumer of both.
+enum FlashWriteLane {
+    CONTROL_LANE,
+    SHARED_LANE,
+    FLASH_WRITE_LANES
+};
+static SpscQueue<FlashWriteJob, FLASH_WRITE_QUEUE_SIZE> lanes[FLASH_WRITE_LANES];
+static std::mutex sharedLaneLock;
+static std::atomic<uint32_t> nextQueuedAt(0);
+
+// Jobs taken off the lanes, coalesced by path. Owned by the I/O task.
+static FlashWriteJob jobs[FLASH_WRITE_QUEUE_SIZE * FLASH_WRITE_LANES];
+static uint32_t nextSequence = 0;
+
+static void (*wakeWriter)() = nullptr;         // Set once the I/O task is running
+static std::atomic<uint32_t> outstanding(0);   // Queued but not yet finished
+static std::atomic<uint32_t> rejected(0);
+static FlashWriterStats stats = {};            // Updated by the I/O task
+static Seqlock<FlashWriterStats> sharedStats;  // Published by it for getFlashWriterStats()
+
+#ifdef ESP32
+static TaskHandle_t writerTask = nullptr;
+static TaskHandle_t controlTask = nullptr;
+#endif
+
+void registerFlashWriterTask() {
+#ifdef ESP32
+    writerTask = xTaskGetCurrentTaskHandle();
+#endif
+}
+
+void registerFlashControlTask() {
+#ifdef ESP32
+    controlTask = xTaskGetCurrentTaskHandle();
+#endif
+}
+
+static FlashWriteLane currentLane() {
+#ifdef ESP32
+    if (controlTask && xTaskGetCurrentTaskHandle() == controlTask) return CONTROL_LANE;
+#endif
+    return SHARED_LANE;
+}
+
+bool writeFileAtomic(const char* path, const uint8_t* data, size_t length) {
+    return storage().replace(path, data, length);   // Temp file, then rename over the old one
+}
+
+static void runJob(FlashWriteJob& job) {
+    unsigned long start = millis();
+    bool ok = writeFileAtomic(job.path.c_str(), job.contents.data(), job.contents.size());
+    unsigned long elapsed = millis() - start;
+
+    if (ok) {
+        stats.written++;
+        stats.bytesWritten += job.contents.size();
+    } else {
+        stats.failed++;
+    }
+    if (elapsed > stats.maxWriteMillis) stats.maxWriteMillis = elapsed;
+
+    if (job.callback) job.callback(job.path.c_str(), ok ? FLASH_WRITE_OK : FLASH_WRITE_FAILED, job.context);
+}
+
+static bool tableFull() {
+    for (const FlashWriteJob& job : jobs) {
+        if (!job.pending) return false;
+    }
+    return true;
+}
+
+// Move newly queued jobs into the table, replacing pending writes of the same
+// file. Only one job is written per serviceFlashWrites(), so the table can
+// fill with distinct files (there are more than it holds); then the rest stay
+// in their lanes until a write frees a slot, and producers see a full queue.
+static void drainLanes() {
+    FlashWriteJob incoming;
+    for (int lane = 0; lane < FLASH_WRITE_LANES; ++lane) {
+        while (!tableFull() && lanes[lane].pop(incoming)) {
+            FlashWriteJob* slot = nullptr;
+            FlashWriteJob* freeSlot = nullptr;
+            for (FlashWriteJob& job : jobs) {
+                if (job.pending && job.path == incoming.path) slot = &job;
+                else if (!job.pending && !freeSlot) freeSlot = &job;
+            }
+
+            if (slot && (int32_t)(incoming.queuedAt - slot->queuedAt) < 0) {
+                // Queued earlier on the other lane than what is waiting; the newer contents stay
+                if (incoming.callback) incoming.callback(incoming.path.c_str(), FLASH_WRITE_SUPERSEDED, incoming.context);
+                stats.coalesced++;
+                outstanding--;
+                incoming.contents.clear();
+                continue;
+            }
+            if (slot) {
+                // Keep its place in line, replace what it will write
+                if (slot->callback) slot->callback(slot->path.c_str(), FLASH_WRITE_SUPERSEDED, slot->context);
+                stats.coalesced++;
+                outstanding--;
+            } else {
+                // Found: the table had a free slot before this pop
+                slot = freeSlot;
+                slot->path = incoming.path;
+                slot->sequence = nextSequence++;
+                slot->pending = true;
+            }
+            slot->contents.swap(incoming.contents);
+            slot->queuedAt = incoming.queuedAt;
+            slot->callback = incoming.callback;
+            slot->context = incoming.context;
+            incoming.contents.clear();
+        }
+    }
+
+    uint32_t depth = 0;
+    for (const FlashWriteJob& job : jobs) depth += job.pending ? 1 : 0;
+    if (depth > stats.maxDepth) stats.maxDepth = depth;
+}
+
+bool serviceFlashWrites() {
+    drainLanes();
+
+    FlashWriteJob* oldest = nullptr;
+    for (FlashWriteJob& job : jobs) {
+        if (job.pending && (!oldest || (int32_t)(job.sequence - oldest->sequence) < 0)) oldest = &job;
+    }
+    if (!oldest) {
+        sharedStats.write(stats);
+        return false;
+    }
+
+    runJob(*oldest);
+    oldest->pending = false;
+    oldest->contents.clear();
+    oldest->contents.shrink_to_fit();
+    sharedStats.write(stats);
+    outstanding--;
+    return true;
+}
+
+void startFlashWriter(void (*wake)()) {
+    wakeWriter = wake;
+}
+
+bool queueFileWrite(const char* path, std::vector<uint8_t>&& contents, FlashWriteCallback callback, void* context) {
+    FlashWriteJob job;
+    job.path = path;
+    job.contents = std::move(contents);
+    job.callback = callback;
+    job.context = context;
+
+    outstanding++;
+    FlashWriteLane lane = currentLane();
+    bool pushed;
+    if (lane == CONTROL_LANE) {
+        job.queuedAt = nextQueuedAt++;
+        pushed = lanes[lane].push(std::move(job));
+    } else {
+        std::lock_guard<std::mutex> guard(sharedLaneLock);
+        job.queuedAt = nextQueuedAt++;
+        pushed = lanes[lane].push(std::move(job));
+    }
+    if (!pushed) {
+        outstanding--;
+        rejected++;
+        Serial.printf("Flash write queue full, %s not queued\n", path);
+        return false;
+    }
+
+    if (wakeWriter) {
+        wakeWriter();
+    } else {
+        // No I/O task (early boot, host builds): write it now
+        while (serviceFlashWrites()) {}
+    }
+    return true;
+}
+
+bool queueFileWrite(const char* path, const String& contents, FlashWriteCallback callback, void* context) {
+    std::vector<uint8_t> bytes((const uint8_t*)contents.c_str(), (const uint8_t*)contents.c_str() + contents.length());
+    return queueFileWrite(path, std::move(bytes), callback, context);
+}
+
+void flushFileWrites() {
+#ifdef ESP32
+    // Would wait forever on itself
+    assert(!writerTask || xTaskGetCurrentTaskHandle() != writerTask);
+#endif
+    while (outstanding.load() > 0) {
+        if (!wakeWriter) {
+            while (serviceFlashWrites()) {}
+            continue;
+        }
+        wakeWriter();
+        delay(10);
+    }
+}
+
+size_t pendingFileWrites() {
+    return outstanding.load();
+}
+
+FlashWriterStats getFlashWriterStats() {
+    FlashWriterStats copy = sharedStats.read();
+    copy.queued = copy.written + copy.failed + copy.coalesced + outstanding.load();
+    copy.rejected = rejected.load();
+    return copy;
+}
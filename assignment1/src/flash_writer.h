@@ -0,0 +1,60 @@
+#ifndef FLASH_WRITER_H
+#define FLASH_WRITER_H
+
+#include <Arduino.h>
+#include <vector>
+
+// Background flash writer. Callers serialize what they want saved into a
+// buffer and queue it; the I/O task (see tasks.h) does the flash work
+// (Storage::replace(), see storage.h) so neither the control loop nor the
+// AsyncTCP task waits on flash. The control task, which saves most often,
+// has a lock-free SPSC queue of its own; every other task (AsyncTCP, setup(),
+// a shutdown handler) shares a second queue behind a mutex. Lanes are picked
+// by task identity, not by core, since more than one task runs on each core.
+// Jobs are coalesced by path on the I/O side: queueing a file that is still
+// waiting replaces the older contents, so a burst of saves of the same file
+// costs one write.
+//
+// Until startFlashWriter() is given a wake function (early boot, host
+// builds) queued writes are done synchronously by the caller.
+
+enum FlashWriteResult {
+  FLASH_WRITE_OK,
+  FLASH_WRITE_FAILED,
+  FLASH_WRITE_SUPERSEDED     // Replaced by a newer write of the same file before it ran
+};
+
+// Called on the I/O task when the job finishes or is superseded
+typedef void (*FlashWriteCallback)(const char* path, FlashWriteResult result, void* context);
+
+struct FlashWriterStats {
+  uint32_t queued;           // Jobs accepted (finished, superseded or still waiting)
+  uint32_t coalesced;        // Jobs that replaced a pending write of the same file
+  uint32_t written;
+  uint32_t failed;
+  uint32_t rejected;         // Jobs refused because the queue was full
+  uint32_t bytesWritten;
+  uint32_t maxDepth;         // Most jobs waiting at once
+  uint32_t maxWriteMillis;   // Slowest single write
+};
+
+const size_t FLASH_WRITE_QUEUE_SIZE = 8;   // Per lane; must be a power of two
+
+void startFlashWriter(void (*wake)());    // `wake` nudges the I/O task after a job is queued
+// Called by the task itself when it starts (no-ops off the ESP32)
+void registerFlashWriterTask();           // The I/O task, the only one that runs serviceFlashWrites()
+void registerFlashControlTask();          // The control task, owner of the lock-free lane
+bool serviceFlashWrites();                // I/O task: write one job; false when idle
+
+// Returns false if the queue is full (nothing is written in that case)
+bool queueFileWrite(const char* path, std::vector<uint8_t>&& contents,
+                    FlashWriteCallback callback = nullptr, void* context = nullptr);
+bool queueFileWrite(const char* path, const String& contents,
+                    FlashWriteCallback callback = nullptr, void* context = nullptr);
+
+bool writeFileAtomic(const char* path, const uint8_t* data, size_t length);  // Synchronous
+void flushFileWrites();       // Block until every queued write has finished (not from the I/O task)
+size_t pendingFileWrites();
+FlashWriterStats getFlashWriterStats();   // Any task; as of the I/O task's last job
+
+#endif
@@ -0,0 +1,96 @@
+// ir_frame.cpp
+#include <ir_frame.h>
+
+// Mirrors sendGeneric(): optional header, the bytes LSB first, then a
+// footer mark and the gap. A mark and the space after it make one item.
+static void appendSection(IrFrame& frame, bool header, const uint8_t* bytes, size_t length, uint8_t bits) {
+    auto add = [&frame](uint16_t mark, uint16_t space) {
+        frame.items.push_back(packIrItem(1, mark, 0, space));
+        frame.durationMicros += mark + space;
+    };
+
+    if (header) add(DAIKIN_HDR_MARK, DAIKIN_HDR_SPACE);
+    for (size_t i = 0; i < length; ++i) {
+        for (uint8_t bit = 0; bit < bits; ++bit) {
+            add(DAIKIN_BIT_MARK, (bytes[i] >> bit) & 1 ? DAIKIN_ONE_SPACE : DAIKIN_ZERO_SPACE);
+        }
+    }
+    add(DAIKIN_BIT_MARK, DAIKIN_ZERO_SPACE + DAIKIN_GAP);
+}
+
+void encodeDaikinFrame(const uint8_t* state, size_t length, IrFrame& frame) {
+    frame.items.clear();
+    frame.durationMicros = 0;
+    if (length < DAIKIN_SECTION1_LENGTH + DAIKIN_SECTION2_LENGTH) return;
+
+    const uint8_t leader = 0;
+    size_t section3 = length - DAIKIN_SECTION1_LENGTH - DAIKIN_SECTION2_LENGTH;
+    frame.items.reserve(1 + DAIKIN_LEADER_BITS + 3 * 2 + length * 8);
+    appendSection(frame, false, &leader, 1, DAIKIN_LEADER_BITS);
+    appendSection(frame, true, state, DAIKIN_SECTION1_LENGTH, 8);
+    appendSection(frame, true, state + DAIKIN_SECTION1_LENGTH, DAIKIN_SECTION2_LENGTH, 8);
+    appendSection(frame, true, state + DAIKIN_SECTION1_LENGTH + DAIKIN_SECTION2_LENGTH, section3, 8);
+}
+
+uint32_t irStateKey(const ACState& state) {
+    uint8_t mode = 0;
+    if (state.mode == "heat") mode = 1;
+    else if (state.mode == "dry") mode = 2;
+    else if (state.mode == "fan") mode = 3;
+    else if (state.mode == "auto") mode = 4;
+    else if (state.mode == "energy_saver") mode = 5;
+    uint8_t temperature = irTemperature(state.current_temp);
+    return (uint32_t)state.is_on | ((uint32_t)state.fan_on << 1) | ((uint32_t)mode << 2) | ((uint32_t)temperature << 8);
+}
+
+IrFrameCache::IrFrameCache(IrStateEncoder encoder) : encoder(encoder), useCounter(0), counters() {
+    clear();
+}
+
+const IrFrame* IrFrameCache::get(const ACState& state) {
+    uint32_t key = irStateKey(state);
+    Entry* victim = &entries[0];
+    for (Entry& entry : entries) {
+        if (entry.used && entry.key == key) {
+            entry.lastUse = ++useCounter;
+            counters.hits++;
+            publish();
+            return &entry.frame;
+        }
+        // Prefer an unused slot, then the least recently used one
+        if (victim->used && (!entry.used || entry.lastUse < victim->lastUse)) victim = &entry;
+    }
+
+    uint8_t bytes[DAIKIN_STATE_LENGTH];
+    size_t length = encoder ? encoder(state, bytes, sizeof(bytes)) : 0;
+    if (length == 0) return nullptr;
+
+    counters.misses++;
+    if (victim->used) counters.evictions++;
+    encodeDaikinFrame(bytes, length, victim->frame);   // Reuses the slot's buffer
+    victim->used = true;
+    victim->key = key;
+    victim->lastUse = ++useCounter;
+    publish();
+    return &victim->frame;
+}
+
+void IrFrameCache::clear() {
+    for (Entry& entry : entries) {
+        entry.used = false;
+        entry.key = 0;
+        entry.lastUse = 0;
+    }
+    publish();
+}
+
+size_t IrFrameCache::size() const {
+    size_t count = 0;
+    for (const Entry& entry : entries) count += entry.used;
+    return count;
+}
+
+void IrFrameCache::publish() {
+    counters.cached = size();
+    published.write(counters);
+}
@@ -0,0 +1,98 @@
+#ifndef IR_FRAME_H
+#define IR_FRAME_H
+
+#include <Arduino.h>
+#include <vector>
+#include <rules.h>
+#include <seqlock.h>
+
+// Pre-encoded IR frames. A Daikin frame is ~290 mark/space pairs; building
+// that per send and bit-banging the carrier blocked the control task for
+// the ~430 ms the frame lasts. Instead each distinct ACState is encoded once
+// into the exact item buffer the RMT peripheral plays back (see ir_rmt.h)
+// and kept in a small cache, so re-sending a known state costs a lookup.
+//
+// Nothing here touches hardware, so the encoder and cache run on Linux too
+// (tools/ir_frames).
+
+// Daikin timings in microseconds, as sent by IRremoteESP8266's sendDaikin()
+const uint16_t DAIKIN_HDR_MARK = 3650;
+const uint16_t DAIKIN_HDR_SPACE = 1623;
+const uint16_t DAIKIN_BIT_MARK = 428;
+const uint16_t DAIKIN_ZERO_SPACE = 428;
+const uint16_t DAIKIN_ONE_SPACE = 1280;
+const uint16_t DAIKIN_GAP = 29000;
+const uint8_t DAIKIN_LEADER_BITS = 5;           // 0b00000 sent before the first section
+const size_t DAIKIN_STATE_LENGTH = 35;
+const size_t DAIKIN_SECTION1_LENGTH = 8;
+const size_t DAIKIN_SECTION2_LENGTH = 8;
+const uint32_t IR_CARRIER_HZ = 38000;
+
+const size_t IR_FRAME_CACHE_SIZE = 8;
+
+// One frame as RMT items: each 32-bit word is two (level, duration) halves,
+// duration in bits 0-14 and level in bit 15 of each half, the layout of
+// rmt_item32_t. Level 1 is a mark (carrier on).
+struct IrFrame {
+    std::vector<uint32_t> items;
+    uint32_t durationMicros;     // Sum of all marks and spaces
+};
+
+inline uint32_t packIrItem(uint8_t level0, uint16_t duration0, uint8_t level1, uint16_t duration1) {
+    return (uint32_t)(duration0 & 0x7FFF) | ((uint32_t)(level0 & 1) << 15) |
+           ((uint32_t)(duration1 & 0x7FFF) << 16) | ((uint32_t)(level1 & 1) << 31);
+}
+
+// Encode a Daikin state (DAIKIN_STATE_LENGTH bytes, checksums included)
+void encodeDaikinFrame(const uint8_t* state, size_t length, IrFrame& frame);
+
+// Produces the protocol bytes for an ACState. Returns the byte count, 0 on failure.
+typedef size_t (*IrStateEncoder)(const ACState& state, uint8_t* bytes, size_t capacity);
+
+// Set point as it goes over the air: whole degrees
+inline uint8_t irTemperature(float celsius) { return (uint8_t)roundf(celsius); }
+
+// Key for an ACState as it goes over the air (see irTemperature())
+uint32_t irStateKey(const ACState& state);
+
+struct IrFrameCacheStats {
+    uint32_t hits;
+    uint32_t misses;             // Frames encoded
+    uint32_t evictions;
+    uint32_t cached;             // Frames held now
+};
+
+// Least recently used cache of encoded frames. Only the control task uses it.
+// A returned frame stays valid until IR_FRAME_CACHE_SIZE other states have
+// been looked up, which is what lets the transmitter play it asynchronously.
+// stats() may be called from any task; it reads a copy published after each
+// lookup.
+class IrFrameCache {
+public:
+    explicit IrFrameCache(IrStateEncoder encoder);
+
+    const IrFrame* get(const ACState& state);    // nullptr if the encoder failed
+    void clear();
+    size_t size() const;
+    IrFrameCacheStats stats() const { return published.read(); }
+
+private:
+    struct Entry {
+        bool used;
+        uint32_t key;
+        uint32_t lastUse;
+        IrFrame frame;
+    };
+
+    IrStateEncoder encoder;
+    Entry entries[IR_FRAME_CACHE_SIZE];
+    uint32_t useCounter;
+    IrFrameCacheStats counters;
+    Seqlock<IrFrameCacheStats> published;
+
+    void publish();
+};
+
+extern IrFrameCache irFrames;    // The AC's frames (main.cpp)
+
+#endif
@@ -0,0 +1,117 @@
+#include <ir_rmt.h>
+
+#ifdef ESP32
+#include <driver/rmt.h>
+#include <esp_timer.h>
+#include <atomic>
+
+static const rmt_channel_t IR_CHANNEL = RMT_CHANNEL_0;
+
+static bool ready = false;
+// Cleared by whichever of the interrupt and the timeout check gets there first
+static std::atomic<bool> transmitting(false);
+static int64_t startedAt = 0;            // Set before `transmitting`, only read while it is set
+static int64_t timeoutAt = 0;
+
+// Counted from the interrupt and the control task, read by web handlers
+static std::atomic<uint32_t> started(0);
+static std::atomic<uint32_t> completed(0);
+static std::atomic<uint32_t> busy(0);
+static std::atomic<uint32_t> timedOut(0);
+static std::atomic<uint32_t> lastFrameMicros(0);
+
+// Called from the RMT interrupt when the last item has gone out
+static void IRAM_ATTR onIrTransmitDone(rmt_channel_t channel, void* arg) {
+    (void)arg;
+    if (channel != IR_CHANNEL) return;
+    int64_t elapsed = esp_timer_get_time() - startedAt;
+    if (transmitting.exchange(false)) {
+        lastFrameMicros = (uint32_t)elapsed;
+        completed++;
+    }
+}
+
+static void stopTimedOutTransmit() {
+    if (!transmitting.load() || esp_timer_get_time() < timeoutAt) return;
+    rmt_tx_stop(IR_CHANNEL);
+    if (transmitting.exchange(false)) {
+        timedOut++;
+        Serial.println("IR frame timed out, transmitter stopped");
+    }
+}
+
+bool setupIrTransmitter(uint8_t pin) {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, IR_CHANNEL);
+    config.clk_div = 80;                                  // 1 us ticks
+    config.mem_block_num = 2;                             // 128 items, refilled from the frame as it drains
+    config.tx_config.carrier_en = true;
+    config.tx_config.carrier_freq_hz = IR_CARRIER_HZ;
+    config.tx_config.carrier_duty_percent = 50;
+    config.tx_config.carrier_level = RMT_CARRIER_LEVEL_HIGH;
+    config.tx_config.idle_output_en = true;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(IR_CHANNEL, 0, 0) != ESP_OK) {
+        Serial.printf("IR on GPIO %u: RMT channel %d unavailable\n", pin, IR_CHANNEL);
+        return false;
+    }
+    rmt_register_tx_end_callback(onIrTransmitDone, nullptr);
+    ready = true;
+    return true;
+}
+
+bool startIrTransmit(const IrFrame& frame) {
+    if (!ready || frame.items.empty()) return false;
+    stopTimedOutTransmit();
+    if (transmitting.load()) {
+        busy++;
+        return false;
+    }
+
+    startedAt = esp_timer_get_time();
+    timeoutAt = startedAt + (int64_t)frame.durationMicros * IR_TRANSMIT_TIMEOUT_FACTOR;
+    transmitting = true;
+    started++;
+    if (rmt_write_items(IR_CHANNEL, reinterpret_cast<const rmt_item32_t*>(frame.items.data()),
+                        frame.items.size(), false) != ESP_OK) {
+        transmitting = false;
+        return false;
+    }
+    return true;
+}
+
+bool isIrTransmitting() {
+    stopTimedOutTransmit();
+    return transmitting.load();
+}
+
+IrTransmitStats getIrTransmitStats() {
+    IrTransmitStats stats;
+    stats.started = started.load();
+    stats.completed = completed.load();
+    stats.busy = busy.load();
+    stats.timedOut = timedOut.load();
+    stats.lastFrameMicros = lastFrameMicros.load();
+    return stats;
+}
+
+#else
+// No RMT on the host; tools compare the frames themselves
+
+bool setupIrTransmitter(uint8_t pin) {
+    (void)pin;
+    return false;
+}
+
+bool startIrTransmit(const IrFrame& frame) {
+    (void)frame;
+    return false;
+}
+
+bool isIrTransmitting() {
+    return false;
+}
+
+IrTransmitStats getIrTransmitStats() {
+    return IrTransmitStats();
+}
+#endif
@@ -0,0 +1,33 @@
+#ifndef IR_RMT_H
+#define IR_RMT_H
+
+#include <Arduino.h>
+#include <ir_frame.h>
+
+// Plays pre-encoded IrFrames through RMT channel 0 with the 38 kHz carrier
+// generated in hardware. startIrTransmit() returns straight away; the RMT
+// refills its memory from the frame's buffer in its interrupt and reports
+// completion from there, so the caller never waits on IR. The frame must
+// stay untouched until isIrTransmitting() is false again. A frame still
+// going out after IR_TRANSMIT_TIMEOUT_FACTOR times its length has lost its
+// end-of-transmission interrupt; it is stopped and counted as timed out, so
+// one missed interrupt can't block IR for good.
+//
+// The DHT sensors take RMT channels from 7 downwards (see dht_rmt.h).
+
+const uint32_t IR_TRANSMIT_TIMEOUT_FACTOR = 2;
+
+struct IrTransmitStats {
+    uint32_t started;
+    uint32_t completed;
+    uint32_t busy;               // Sends refused because a frame was still going out
+    uint32_t timedOut;           // Frames stopped with no end-of-transmission
+    uint32_t lastFrameMicros;    // Start to end-of-transmission of the last frame
+};
+
+bool setupIrTransmitter(uint8_t pin);
+bool startIrTransmit(const IrFrame& frame);   // false if busy or not set up
+bool isIrTransmitting();                      // Control task; stops a frame that timed out
+IrTransmitStats getIrTransmitStats();         // Any task
+
+#endif
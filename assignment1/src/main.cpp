@@ -1,15 +1,13 @@
 #include <Arduino.h>
 #include <WiFi.h>
-#include "esp_wpa2.h" //For WPA Enterprise
 #include "ThingSpeak.h"
-#include <DHT.h>
 #include <IRremoteESP8266.h>
-#include <IRsend.h>
 #include <ir_Daikin.h>
 #include <ESPAsyncWebServer.h>
 #include <FS.h>
 #include <ArduinoJson.h>
-#include <SPIFFS.h>
+#include <storage.h>
+#include <storage_bench.h>
 #include <AsyncTCP.h> // https://randomnerdtutorials.com/esp32-esp8266-web-server-http-authentication/
 #include <base64.h>
 #include <CustomJWT.h>
@@ -18,36 +16,34 @@
 #include <web.h>
 #include <data.h>
 #include <config.h>
-#include <numeric>
 #include <rules.h>
+#include <actuator.h>
+#include <rule_program.h>
+#include <signals.h>
+#include <scheduler.h>
+#include <flash_writer.h>
+#include <tasks.h>
+#include <telemetry.h>
+#include <sensors.h>
+#include <connectivity.h>
+#include <boot_profile.h>
+#include <ir_frame.h>
+#include <ir_rmt.h>
+#include <persistence.h>
+#include <civil_time.h>
+#include <control.h>
+#include <daily_stats.h>
 
 #define LEDPIN 2
 #define IRTXPIN 5 //IR Transmitter pin
-#define DHTPIN 4     // Digital pin connected to the DHT sensor
 
-#define DHTTYPE DHT11   // DHT 11
-DHT dht(DHTPIN, DHTTYPE);
+// Sensors (DHT11 on GPIO 4 by default) are configured in the config ("sensors"); see sensors.h
 
 //Setup Daikin AC
 //https://github.com/crankyoldgit/IRremoteESP8266/blob/master/examples/TurnOnDaikinAC/TurnOnDaikinAC.ino
+//The library only builds the protocol bytes; frames go out through the RMT (see ir_rmt.h)
 const uint16_t kIrLed = IRTXPIN;  // ESP8266 GPIO pin to use. Recommended: 4 (D2). NOTE: ESP32 doesnt use the same pinout.
-IRDaikinESP ac(kIrLed);  // Set the GPIO to be used to sending the message
-
-IRsend irsend(kIrLed); // IR transmitter
-
-// Store individual 15-second readings temporarily
-std::vector<float> tempBuffer;
-std::vector<float> humBuffer;
-
-unsigned long lastCollectionTime = 0; // Last time data was collected per 15 seconds
-unsigned long lastAverageTime = 0;   // Last time data was aggregated to 5min data point
-unsigned long lastHourlyAggregation = 0; // Last time data was aggregated to hourly data point
-unsigned long last6HourAggregation = 0; // Last time data was aggregated to 6-hour data point
-unsigned long lastIRSendTime = 0; // Last time IR signal was sent
-
-unsigned long collectionInterval = 15000;    // 15 seconds
-unsigned long averageInterval = 300000;      // 5 minutes
-unsigned long irInterval = 10000;            // 10 seconds
+IRDaikinESP ac(kIrLed);
 
 void WiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
   switch(event) {
@@ -64,6 +60,49 @@ void WiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
   }
 }
 
+// Build the Daikin protocol bytes for an ACState (only on an IR frame cache miss)
+size_t encodeDaikinState(const ACState& state, uint8_t* bytes, size_t capacity) {
+  if (capacity < kDaikinStateLength) return 0;
+  if (state.is_on) {
+    ac.on();
+  } else {
+    ac.off();
+  }
+
+  if (state.mode == "heat") {
+    ac.setMode(kDaikinHeat);
+  } else if (state.mode == "dry") {
+    ac.setMode(kDaikinDry);
+  } else if (state.mode == "fan") {
+    ac.setMode(kDaikinFan);
+  } else if (state.mode == "auto") {
+    ac.setMode(kDaikinAuto);
+  } else {
+    ac.setMode(kDaikinCool); // "cool" and "energy_saver"
+  }
+  ac.setEcono(state.mode == "energy_saver");
+  ac.setFan(state.fan_on ? kDaikinFanAuto : kDaikinFanQuiet);
+  ac.setTemp(irTemperature(state.current_temp));
+  ac.setSwingVertical(false);
+  ac.setSwingHorizontal(false);
+
+  memcpy(bytes, ac.getRaw(), kDaikinStateLength);  // getRaw() fills in the checksums
+  return kDaikinStateLength;
+}
+
+IrFrameCache irFrames(encodeDaikinState);
+
+// Start sending one full Daikin frame for an ACState; returns without waiting for it
+bool sendACState(const ACState& state) {
+  // The frame going out may live in any cache slot, so don't look up (and
+  // possibly re-encode a slot) until it is done. Frames take ~430 ms and the
+  // actuator sends at most every 2 s, so this only trips on a stuck transmitter.
+  if (isIrTransmitting()) return false;
+
+  const IrFrame* frame = irFrames.get(state);
+  return frame && startIrTransmit(*frame);
+}
+
 void setupMulticastDNS() {
   Serial.println("Starting mDNS responder...");
   if (!MDNS.begin("smartac")) { // Start the mDNS responder for smartac.local
@@ -77,7 +116,7 @@ void setupMulticastDNS() {
 
 void generateSampleData(const char* path) {
     // Check if file already exists
-    if (SPIFFS.exists(path)) {
+    if (storage().exists(path)) {
         Serial.println("Sample data file already exists. Skipping creation.");
         return;
     }
@@ -89,7 +128,7 @@ void generateSampleData(const char* path) {
         sampleData.push_back({20.0f + i, 50.0f + i * 5, startTimestamp + i * 300});
     }
 
-    // Save data to SPIFFS
+    // Save data to flash
     saveDataPoints(path, sampleData);
 }
 
@@ -159,29 +198,13 @@ void createSampleRules() {
 }
 
 
-void setup() {
-  Serial.begin(115200);
-  Serial.println("Starting SmartAC Remote");
-
-  if (!SPIFFS.begin()) {
-    Serial.println("Failed to mount file system");
-    return;
-  }
-  Serial.println("SPIFFS is mounted");
-
-  // Print SPIFFS info
-  size_t totalBytes = SPIFFS.totalBytes();
-  size_t usedBytes = SPIFFS.usedBytes();
-  size_t freeBytes = totalBytes - usedBytes;
-
-  Serial.printf("Total SPIFFS size: %u bytes\n", totalBytes);
-  Serial.printf("Used SPIFFS size: %u bytes\n", usedBytes);
-  Serial.printf("Free SPIFFS space: %u bytes\n", freeBytes);
-
+// Write a few known points and read them back (build with -D STORAGE_SELF_TEST)
+void runStorageSelfTest() {
   const char* path = "/sample_data.bin";
   generateSampleData(path);
+  flushFileWrites(); // Read straight back below
 
-  // Load and verify data from SPIFFS
+  // Load and verify data from flash
   DataPointHeader header;
   std::vector<DataPoint> loadedData;
   if (!loadDataPoints(path, header, loadedData)) {
@@ -213,33 +236,130 @@ void setup() {
   } else {
       Serial.println("Test FAILED: Loaded data does not match generated sample data.");
   }
+}
+
+// Called once by the connectivity task when NTP first sets the clock
+void onTimeSynced(uint32_t bootOffset) {
+  // Samples taken before the sync were stamped with seconds since boot
+  restampStagedPoints(bootOffset);
+  for (size_t i = 0; i < getSensorCount(); ++i) {
+    Sensor& sensor = getSensor(i);
+    size_t restamped5Min = sensor.series5Min->restamp(bootOffset);
+    size_t restampedHourly = sensor.seriesHourly->restamp(bootOffset);
+    size_t restamped6Hour = sensor.series6Hour->restamp(bootOffset);
+    if (restamped5Min) persistSeries(*sensor.series5Min);
+    if (restampedHourly) persistSeries(*sensor.seriesHourly);
+    if (restamped6Hour) persistSeries(*sensor.series6Hour);
+    Serial.printf("Rebased %u 5-minute, %u hourly and %u 6-hour points from %s taken before the sync\n",
+                  restamped5Min, restampedHourly, restamped6Hour, sensor.config.id.c_str());
+  }
+
+  struct tm timeinfo;
+  getLocalTime(&timeinfo, 0);
+  Serial.println(&timeinfo, "Local Time is: %A, %B %d %Y %H:%M:%S zone %Z (%z)");
+
+  // Calculate UTC offset in seconds
+  time_t rawtime = mktime(&timeinfo);
+  struct tm *utcTime = gmtime(&rawtime);
+  int utcOffsetSeconds = difftime(mktime(&timeinfo), mktime(utcTime));
+  Serial.printf("UTC Offset: %d seconds\n", utcOffsetSeconds);
+  Serial.printf("DST: %s\n", (timeinfo.tm_isdst > 0) ? "Active" : "Inactive");
+  Serial.printf("Season: %s\n", getCurrentSeason().c_str());
+  Serial.printf("Hemisphere: %s\n", determineHemisphere().c_str());
+}
+
+// Boot only does local work (flash, sensor, web server) and hands the
+// network to the connectivity task, so sampling starts straight away.
+// WiFi and NTP come up in the background; see connectivity.h.
+void setup() {
+  beginBootProfile();
+  Serial.begin(115200);
+  Serial.println("Starting SmartAC Remote");
+
+  if (!storage().begin()) {
+    Serial.println("Failed to mount file system");
+    return;
+  }
+  Serial.printf("%s is mounted\n", storage().name());
+  markBootPhase("storage");
+  startIoTask(); // Saves from here on are written in the background on core 0
+  markBootPhase("io_task");
+
+  // Print file system info
+  size_t totalBytes = storage().totalBytes();
+  size_t usedBytes = storage().usedBytes();
+  size_t freeBytes = totalBytes - usedBytes;
+
+  Serial.printf("Total %s size: %u bytes\n", storage().name(), totalBytes);
+  Serial.printf("Used %s size: %u bytes\n", storage().name(), usedBytes);
+  Serial.printf("Free %s space: %u bytes\n", storage().name(), freeBytes);
+
+#ifdef STORAGE_SELF_TEST
+  runStorageSelfTest();
+  markBootPhase("self_test");
+#endif
+
+#ifdef STORAGE_BENCHMARK
+  runStorageBenchmark(20);
+  markBootPhase("benchmark");
+#endif
 
-  
   Serial.println("Loading config...");
   loadConfig();
   Serial.println("Config loaded");
+  markBootPhase("config");
+
+  // The timezone does not need the clock; set it now so local time is right from the first sync
+  // Timezone for Australia/Sydney: https://github.com/nayarsystems/posix_tz_db/blob/1f0cc11d79f7384afcf6acd860d8565165d940db/zones.csv#L317
+  // AEST-10AEDT,M10.1.0,M4.1.0/3
+  Serial.println("Setting timezone to " + config.timezone);
+  Serial.println("Setting POSIX timezone to " + config.posix_tz);
+  //https://randomnerdtutorials.com/esp32-ntp-timezones-daylight-saving/
+  setLocalTimeZone(config.posix_tz.c_str());
+
   Serial.println("Loading historical data...");
   loadHistoricalData();
 
-  // Check if we have any historical data and set last aggregation times
-  if (!temperatureData5Min.empty()) {
-      lastAverageTime = millis() - (millis() - calculateNextInterval(temperatureData5Min.back().timestamp, averageInterval));
-      Serial.printf("Setting last 5-minute aggregation: %lu\n", lastAverageTime);
-  }
-  if (!temperatureDataHourly.empty()) {
-      lastHourlyAggregation = millis() - (millis() - calculateNextInterval(temperatureDataHourly.back().timestamp, 3600000)); // 1 hour
-      Serial.printf("Setting last hourly aggregation: %lu\n", lastHourlyAggregation);
-  }
-  if (!temperatureData6Hour.empty()) {
-      last6HourAggregation = millis() - (millis() - calculateNextInterval(temperatureData6Hour.back().timestamp, 21600000)); // 6 hours
-      Serial.printf("Setting last 6-hour aggregation: %lu\n", last6HourAggregation);
-  }
+  resumeAggregation();
 
   Serial.println("Historical data loaded. Ready to start data collection.");
   Serial.printf("Loaded %d 5-minute data points\n", temperatureData5Min.size());
+  seedTrendSignals(temperatureData5Min);
   Serial.printf("Loaded %d hourly data points\n", temperatureDataHourly.size());
   Serial.printf("Loaded %d 6-hour data points\n", temperatureData6Hour.size());
+  markBootPhase("history");
+
+  // Setup sensors, loading the history of any beyond the primary; rules refer to them by id
+  if (config.sensors.empty()) config.sensors.push_back(defaultSensorConfig());
+  setupSensors(config.sensors);
+  Serial.printf("Started %u sensors\n", getSensorCount());
+  markBootPhase("sensors");
+
+  // Batch data file writes; put back points staged before a reset
+  for (size_t i = 0; i < getSensorCount(); ++i) {
+    Sensor& sensor = getSensor(i);
+    registerPersistentSeries(sensorDataPath(sensor, "5min").c_str(), sensor.series5Min);
+    registerPersistentSeries(sensorDataPath(sensor, "hourly").c_str(), sensor.seriesHourly);
+    registerPersistentSeries(sensorDataPath(sensor, "6hour").c_str(), sensor.series6Hour);
+  }
+  setDurabilityWindow(config.durability_window);
+  recoverStagedPoints();
+  installShutdownFlush();
+  markBootPhase("staging");
+
+  // Daily statistics, caught up with the 5-minute points saved since
+  loadDailyStats(temperatureData5Min);
+  markBootPhase("stats");
+
+  // Load rules; they are evaluated once the clock is set
+  loadRules();
+  Serial.printf("Loaded %d rules\n", getRuleProgram()->rules.size());
+  markBootPhase("rules");
 
+  pinMode (LEDPIN, OUTPUT);
+  setupIrTransmitter(kIrLed);
+  setupActuator(sendACState);
+  markBootPhase("devices");
 
   Serial.print("Setting up AP: ");
   if (!WiFi.softAP(local_wifi_ssid.c_str(), local_wifi_password.c_str())) {
@@ -250,217 +370,25 @@ void setup() {
   IPAddress IP = WiFi.softAPIP();
   Serial.print("AP IP address: ");
   Serial.println(IP);
-
-  // Setup DHT
-  dht.begin();
-  Serial.println("Started DHT");
-
-  pinMode (LEDPIN, OUTPUT);
-  ac.begin();
+  markBootPhase("ap");
 
   //jwt.allocateJWTMemory();
   Serial.println("Starting Web Server...");
   setupWebServer(); //Setup HTTP Routing
+  markBootPhase("web_server");
   setupMulticastDNS();
+  markBootPhase("mdns");
 
-
-  if (config.wifi_ssid.length() > 0) {
-    Serial.println("Found saved WiFi credentials for: " + config.wifi_ssid);
-
-    if (config.wifi_security == "WPA2-Enterprise") {
-      WiFi.disconnect(true);
-      Serial.println("Connecting to WPA2-Enterprise WiFi...");
-      esp_wifi_sta_wpa2_ent_set_identity((uint8_t *)config.wifi_identity.c_str(), config.wifi_identity.length());
-      esp_wifi_sta_wpa2_ent_set_username((uint8_t *)config.wifi_username.c_str(), config.wifi_username.length());
-      esp_wifi_sta_wpa2_ent_set_password((uint8_t *)config.wifi_password.c_str(), config.wifi_password.length());
-      esp_wifi_sta_wpa2_ent_enable();
-    }
-
-    Serial.println("Connecting to WiFi...");
-    WiFi.begin(config.wifi_ssid.c_str(), config.wifi_password.c_str());
-    while (WiFi.status() != WL_CONNECTED) {
-      delay(1000);
-      Serial.println("Connecting to WiFi...");
-    }
-    Serial.println("Connected to WiFi with IP: " + WiFi.localIP().toString());
-  }
-
-  // Configure time with NTP
-  // Timezone for Australia/Sydney: https://github.com/nayarsystems/posix_tz_db/blob/1f0cc11d79f7384afcf6acd860d8565165d940db/zones.csv#L317
-  // AEST-10AEDT,M10.1.0,M4.1.0/3
-  configTime(0, 0, "pool.ntp.org", "time.nist.gov");  // Adjust time offset if needed (e.g., UTC offset)
-
-  // Wait for time to be set
-  struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-      Serial.println("Failed to obtain time");
-      return;
-  }
-  Serial.println("Time initialized with NTP");
-
-  Serial.println(&timeinfo, "UTC Time is: %A, %B %d %Y %H:%M:%S zone %Z (%z)");
-  Serial.println("Setting timezone to " + config.timezone);
-  Serial.println("Setting POSIX timezone to " + config.posix_tz);
-  //Now we can set timezone
-  //https://randomnerdtutorials.com/esp32-ntp-timezones-daylight-saving/
-  setenv("TZ", config.posix_tz.c_str(), 1);
-  tzset();
-  Serial.println(&timeinfo, "Local Time is: %A, %B %d %Y %H:%M:%S zone %Z (%z)");
-
-  // Calculate UTC offset in seconds
-  time_t rawtime = mktime(&timeinfo);
-  struct tm *utcTime = gmtime(&rawtime);
-  int utcOffsetSeconds = difftime(mktime(&timeinfo), mktime(utcTime));
-  Serial.printf("UTC Offset: %d seconds\n", utcOffsetSeconds);
-  Serial.printf("DST: %s\n", (timeinfo.tm_isdst > 0) ? "Active" : "Inactive");
-  Serial.printf("Season: %s\n", getCurrentSeason().c_str());
-  Serial.printf("Hemisphere: %s\n", determineHemisphere().c_str());
-
-  // Load rules
-  loadRules();
-  Serial.printf("Loaded %d rules\n", rules.size());
+  // Station WiFi and NTP, retried with backoff by the connectivity task
+  startConnectivity(onTimeSynced);
+  setupTasks();
+  markBootPhase("setup");
 
   Serial.println("SmartAC Remote is ready");
 }
 
 void loop() {
-
-    unsigned long now = millis();
-
-    // Collect data every 15 seconds (5-minute averaging is done here)
-    if ((now - lastCollectionTime) > collectionInterval) {
-        lastCollectionTime = now;
-        
-        // Read and store data every 15 seconds
-        float temp = dht.readTemperature();
-        float hum = dht.readHumidity();
-        if (!isnan(temp) && !isnan(hum)) {
-          tempBuffer.push_back(temp);
-          humBuffer.push_back(hum);
-          temperature_data.temperature = temp; // Update global temperature
-          temperature_data.humidity = hum; // Update global humidity
-          temperature_data.feels_like = getFeelsLikeTemperature(temp, hum); // Update global feels like temperature
-          Serial.printf("Collected data - Temp: %.2f, Humidity: %.2f\n", temp, hum);
-        } else {
-          Serial.println("Failed to read from DHT sensor.");
-        }
-    }
-
-    // Average data every 5 minutes
-    if ((now - lastAverageTime) > averageInterval) {
-        lastAverageTime = now;
-
-        if (!tempBuffer.empty() && !humBuffer.empty()) {
-            // Calculate and store 5-minute average
-            float avgTemp = std::accumulate(tempBuffer.begin(), tempBuffer.end(), 0.0) / tempBuffer.size();
-            float avgHum = std::accumulate(humBuffer.begin(), humBuffer.end(), 0.0) / humBuffer.size();
-            //DataPoint newPoint = {avgTemp, avgHum, getCurrentEpoch()};
-            temperatureData5Min.push_back({avgTemp, avgHum, getCurrentEpoch()});
-            temperature_data.temperature_5min = avgTemp; // Update global temperature
-            temperature_data.humidity_5min = avgHum; // Update global humidity
-            temperature_data.feels_like_5min = getFeelsLikeTemperature(avgTemp, avgHum); // Update global feels like temperature
-            Serial.printf("5-Minute Average - Temp: %.2f, Humidity: %.2f\n", avgTemp, avgHum);
-
-            // Save the latest 5-minute data to SPIFFS
-            saveDataPoints("/data_5min.bin", temperatureData5Min);
-            
-            // Clear buffers for the next 5-minute period
-            tempBuffer.clear();
-            humBuffer.clear();
-        }
-    }
-
-    // Aggregate to hourly data every hour
-    if ((now - lastHourlyAggregation) >= 3600000) { // 1 hour
-      lastHourlyAggregation = now;
-
-      // Aggregate the last 12 5-minute points into an hourly average
-      if (temperatureData5Min.size() >= 12) {
-            float tempSum = 0.0;
-            float humSum = 0.0;
-
-            // Sum temperature and humidity from the last 12 5 min DataPoints
-            for (auto it = temperatureData5Min.end() - 12; it != temperatureData5Min.end(); ++it) {
-                tempSum += it->temperature;
-                humSum += it->humidity;
-            }
-
-            // Calculate averages and add new 1-hour DataPoint
-            float avgTemp = tempSum / 12;
-            float avgHum = humSum / 12;
-            temperatureDataHourly.push_back({avgTemp, avgHum, getCurrentEpoch()});
-
-
-          Serial.printf("Hourly Average - Temp: %.2f, Humidity: %.2f\n", avgTemp, avgHum);
-
-          saveDataPoints("/data_hourly.bin", temperatureDataHourly);
-
-          // Rotate old points now that we have aggregated
-          while (temperatureData5Min.size() > MAX_5MIN_POINTS) {
-              temperatureData5Min.erase(temperatureData5Min.begin());
-          }
-      }
-    }
-
-
-    // Aggregate to 6-hour data every 6 hours
-    if ((now - last6HourAggregation) >= 21600000) { // 6 hours
-        last6HourAggregation = now;
-
-        if (temperatureDataHourly.size() >= 6) {  // Ensure we have enough hourly data for 6-hour aggregation
-            float tempSum = 0.0;
-            float humSum = 0.0;
-
-            // Sum temperature and humidity from the last 6 hourly DataPoints
-            for (auto it = temperatureDataHourly.end() - 6; it != temperatureDataHourly.end(); ++it) {
-                tempSum += it->temperature;
-                humSum += it->humidity;
-            }
-
-            // Calculate averages and add new 6-hour DataPoint
-            float avgTemp = tempSum / 6;
-            float avgHum = humSum / 6;
-            temperatureData6Hour.push_back({avgTemp, avgHum, getCurrentEpoch()});
-
-            Serial.printf("6-Hour Average - Temp: %.2f, Humidity: %.2f\n", avgTemp, avgHum);
-
-            saveDataPoints("/data_6hour.bin", temperatureData6Hour);
-
-        }
-
-        //Now we've done our aggregation, rotate old points.
-        while (temperatureDataHourly.size() > MAX_HOURLY_POINTS) {
-            temperatureDataHourly.erase(temperatureDataHourly.begin());
-        }
-
-        while (temperatureData6Hour.size() > MAX_6HOUR_POINTS) {
-            temperatureData6Hour.erase(temperatureData6Hour.begin());
-        }
-    }
-
-
-
-    // Send IR signal every 10 seconds
-    if ((now - lastIRSendTime) > irInterval) {
-        lastIRSendTime = now;
-
-        //https://forum.arduino.cc/t/ir-remote-tranmission-for-sony-tv-help-with-code/275395
-        irsend.sendSony(0xA90, 12); // Send Sony power toggle command
-        Serial.println("Sent Sony Power Toggle");
-
-
-        // Send IR signal to AC
-        ac.on();
-        ac.setFan(1);
-        ac.setMode(kDaikinCool);
-        ac.setTemp(25);
-        ac.setSwingVertical(false);
-        ac.setSwingHorizontal(false);
-
-        Serial.println("Sending IR Data...");
-        //Serial.println(ac.toString());
-
-        // Now send the IR signal.
-        ac.send();
-    }
+    // The scheduler runs on the control task (see tasks.h); hand over and retire the Arduino loop task
+    startControlTask();
+    vTaskDelete(NULL);
 }
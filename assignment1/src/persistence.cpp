@@ -0,0 +1,357 @@
+// persistence.cpp
+#include <persistence.h>
+#include <flash_writer.h>
+#include <atomic>
+#include <seqlock.h>
+#ifdef ESP32
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <tasks.h>
+#endif
+
+static const uint32_t STAGING_MAGIC = 0x53544147;  // "STAG"
+
+struct StagedPoint {
+    uint32_t fileHash;           // FNV-1a of the file's path
+    uint32_t sequence;           // Staging order, carried across resets
+    DataPoint point;
+};
+
+// Garbage after a power cycle; the magic and checksum tell
+struct StagingBuffer {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t nextSequence;
+    uint32_t checksum;           // Over count, nextSequence and the points
+    StagedPoint points[PERSIST_STAGING_CAPACITY];
+};
+
+#ifdef ESP32
+RTC_NOINIT_ATTR static StagingBuffer staging;
+#else
+static StagingBuffer staging;
+#endif
+
+struct PersistentFile {
+    String path;
+    uint32_t hash;
+    DataSeries* series;
+    uint32_t queuedThrough;                   // Points staged before this sequence are in a queued write
+    std::atomic<uint32_t> confirmedThrough;   // ... and before this one in a finished write (I/O task)
+    std::atomic<bool> writeFailed;            // Set by the I/O task; requeue what it held
+    std::atomic<uint32_t> staged;             // Points in the staging buffer (control task)
+    Seqlock<PersistentFileStats> stats;       // Written by the I/O task only
+};
+
+// Carried through the flash writer with each file write
+struct WriteTicket {
+    PersistentFile* file;
+    uint32_t through;
+    uint32_t bytes;
+};
+
+static PersistentFile files[PERSIST_MAX_FILES];
+static size_t fileCount = 0;
+static unsigned long windowMillis = PERSIST_DEFAULT_WINDOW * 60000UL;
+static bool hasUnwritten = false;
+static unsigned long oldestUnwritten = 0;     // millis() when the oldest unwritten point was staged
+static PersistenceStats stats = {PERSIST_DEFAULT_WINDOW};   // Control task's working copy
+static Seqlock<PersistenceStats> sharedStats(stats);          // What getPersistenceStats() reads
+
+static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static uint32_t pathHash(const char* path) {
+    uint32_t hash = 2166136261u;
+    while (*path) {
+        hash ^= (uint8_t)*path++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t stagingChecksum() {
+    uint32_t crc = 0xFFFFFFFF;
+    crc = updateCRC32(crc, (const uint8_t*)&staging.count, sizeof(staging.count));
+    crc = updateCRC32(crc, (const uint8_t*)&staging.nextSequence, sizeof(staging.nextSequence));
+    crc = updateCRC32(crc, (const uint8_t*)staging.points, staging.count * sizeof(StagedPoint));
+    return ~crc;
+}
+
+static bool stagingValid() {
+    return staging.magic == STAGING_MAGIC && staging.count <= PERSIST_STAGING_CAPACITY &&
+           staging.checksum == stagingChecksum();
+}
+
+static PersistentFile* findFile(const DataSeries& series) {
+    for (size_t i = 0; i < fileCount; ++i) {
+        if (files[i].series == &series) return &files[i];
+    }
+    return nullptr;
+}
+
+static PersistentFile* findFile(uint32_t hash) {
+    for (size_t i = 0; i < fileCount; ++i) {
+        if (files[i].hash == hash) return &files[i];
+    }
+    return nullptr;
+}
+
+// Recount after the buffer changed and reseal it
+static void updateStaging() {
+    staging.checksum = stagingChecksum();
+
+    uint32_t unwritten = 0;
+    uint32_t staged[PERSIST_MAX_FILES] = {};
+    for (uint32_t i = 0; i < staging.count; ++i) {
+        PersistentFile* file = findFile(staging.points[i].fileHash);
+        if (!file) continue;
+        staged[file - files]++;
+        if (!before(staging.points[i].sequence, file->queuedThrough)) unwritten++;
+    }
+    for (size_t i = 0; i < fileCount; ++i) files[i].staged = staged[i];
+    stats.staged = staging.count;
+    stats.unwritten = unwritten;
+    sharedStats.write(stats);   // Every change to stats is followed by a call here
+
+    if (unwritten && !hasUnwritten) oldestUnwritten = millis();
+    hasUnwritten = unwritten > 0;
+}
+
+// Drop points whose file has been rewritten since they were staged
+static void compactStaging() {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < staging.count; ++i) {
+        PersistentFile* file = findFile(staging.points[i].fileHash);
+        if (file && !before(staging.points[i].sequence, file->confirmedThrough.load())) {
+            staging.points[kept++] = staging.points[i];
+        }
+    }
+    if (kept != staging.count) {
+        staging.count = kept;
+        updateStaging();
+    }
+}
+
+static void onSeriesWritten(const char* path, FlashWriteResult result, void* context) {
+    WriteTicket* ticket = static_cast<WriteTicket*>(context);
+    PersistentFile* file = ticket->file;
+    if (result == FLASH_WRITE_OK) {
+        Serial.printf("Safely wrote data points to %s\n", path);
+        PersistentFileStats stats = file->stats.read();
+        stats.writes++;
+        stats.bytesWritten += ticket->bytes;
+        stats.eraseBlocks += estimateEraseBlocks(ticket->bytes);
+        file->stats.write(stats);
+        if (before(file->confirmedThrough.load(), ticket->through)) file->confirmedThrough.store(ticket->through);
+    } else if (result == FLASH_WRITE_FAILED) {
+        Serial.printf("Failed to write data points to %s\n", path);
+        PersistentFileStats stats = file->stats.read();
+        stats.failed++;
+        file->stats.write(stats);
+        file->writeFailed = true;
+    }
+    delete ticket;
+}
+
+// Queue a rewrite of the file with everything the series holds now
+static bool queueSeriesWrite(PersistentFile& file) {
+    std::vector<DataPoint> points;
+    file.series->readAll(points);   // Not toVector(): the shutdown hook may run on another task
+    std::vector<uint8_t> contents = serializeDataPoints(points);
+
+    WriteTicket* ticket = new WriteTicket{&file, staging.nextSequence, (uint32_t)contents.size()};
+    if (!queueFileWrite(file.path.c_str(), std::move(contents), onSeriesWritten, ticket)) {
+        Serial.printf("Could not queue %u data points for %s\n", points.size(), file.path.c_str());
+        delete ticket;
+        return false;
+    }
+    file.queuedThrough = staging.nextSequence;
+    return true;
+}
+
+void setDurabilityWindow(uint32_t minutes) {
+    if (minutes > PERSIST_MAX_WINDOW) minutes = PERSIST_MAX_WINDOW;
+    windowMillis = minutes * 60000UL;
+    stats.windowMinutes = minutes;
+    sharedStats.write(stats);
+}
+
+bool registerPersistentSeries(const char* path, DataSeries* series) {
+    if (fileCount >= PERSIST_MAX_FILES) {
+        Serial.printf("Too many data files, %s is written through\n", path);
+        return false;
+    }
+    PersistentFile& file = files[fileCount++];
+    file.path = path;
+    file.hash = pathHash(path);
+    file.series = series;
+    file.queuedThrough = 0;
+    file.confirmedThrough = 0;
+    file.writeFailed = false;
+    file.staged = 0;
+    file.stats.write(PersistentFileStats());
+    return true;
+}
+
+size_t recoverStagedPoints() {
+    if (!stagingValid()) {
+        staging.magic = STAGING_MAGIC;
+        staging.count = 0;
+        staging.nextSequence = 0;
+        updateStaging();
+        return 0;
+    }
+
+    // Points still staged at the reset; put back the ones their file is missing
+    size_t recovered = 0;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < staging.count; ++i) {
+        const StagedPoint& staged = staging.points[i];
+        PersistentFile* file = findFile(staged.fileHash);
+        if (!file || staged.point.timestamp < MIN_VALID_EPOCH) continue;   // Sensor removed, or never placed in time
+        DataSeries& series = *file->series;
+        if (!series.empty() && staged.point.timestamp <= series.back().timestamp) continue;  // Already written
+        series.push_back(staged.point);
+        staging.points[kept++] = staged;   // Until the file is rewritten with it
+        recovered++;
+    }
+    staging.count = kept;
+
+    // Kept points are in staging order; all of them are still to be written
+    uint32_t firstKept = kept ? staging.points[0].sequence : staging.nextSequence;
+    for (size_t i = 0; i < fileCount; ++i) {
+        files[i].queuedThrough = firstKept;
+        files[i].confirmedThrough = firstKept;
+    }
+    stats.recovered = recovered;
+    updateStaging();
+
+    if (recovered) {
+        Serial.printf("Recovered %u staged data points\n", recovered);
+        flushPersistence(PERSIST_FLUSH_FORCED);
+    }
+    return recovered;
+}
+
+#ifdef ESP32
+static void flushForShutdown() {
+    flushPersistence(PERSIST_FLUSH_SHUTDOWN);
+    flushFileWrites();
+}
+
+// esp_restart() runs this on whichever task restarts, before the CPU resets.
+// The staging buffer and the file table belong to the control task, so the
+// flush is handed to it rather than run here alongside it.
+static void onShutdown() {
+    if (!runOnControlTask(flushForShutdown, SHUTDOWN_FLUSH_TIMEOUT)) {
+        Serial.println("Shutdown flush did not finish, staged points are recovered at boot");
+    }
+}
+
+void installShutdownFlush() {
+    esp_register_shutdown_handler(onShutdown);
+}
+#else
+void installShutdownFlush() {}
+#endif
+
+void persistLatest(const DataSeries& series) {
+    PersistentFile* file = findFile(series);
+    if (!file) {
+        Serial.println("Data series not registered for persistence");
+        return;
+    }
+    if (series.empty()) return;
+
+    compactStaging();
+    if (staging.count == PERSIST_STAGING_CAPACITY) {
+        // Nothing has been confirmed for a whole buffer; give up the oldest point
+        memmove(staging.points, staging.points + 1, (staging.count - 1) * sizeof(StagedPoint));
+        staging.count--;
+        stats.dropped++;
+    }
+    StagedPoint& staged = staging.points[staging.count++];
+    staged.fileHash = file->hash;
+    staged.sequence = staging.nextSequence++;
+    staged.point = series.back();
+    updateStaging();
+
+    if (windowMillis == 0) {
+        if (queueSeriesWrite(*file)) stats.flushes[PERSIST_FLUSH_FORCED]++;
+        updateStaging();
+    } else if (stats.unwritten >= PERSIST_FLUSH_THRESHOLD) {
+        flushPersistence(PERSIST_FLUSH_PRESSURE);
+    }
+}
+
+void persistSeries(const DataSeries& series) {
+    PersistentFile* file = findFile(series);
+    if (!file) return;
+    if (queueSeriesWrite(*file)) stats.flushes[PERSIST_FLUSH_FORCED]++;
+    updateStaging();
+}
+
+void restampStagedPoints(uint32_t bootOffset) {
+    for (uint32_t i = 0; i < staging.count; ++i) {
+        if (staging.points[i].point.timestamp < MIN_VALID_EPOCH) staging.points[i].point.timestamp += bootOffset;
+    }
+    updateStaging();
+}
+
+void servicePersistence(unsigned long now) {
+    for (size_t i = 0; i < fileCount; ++i) {
+        if (files[i].writeFailed.exchange(false)) files[i].queuedThrough = files[i].confirmedThrough.load();
+    }
+    compactStaging();
+    updateStaging();
+
+    if (hasUnwritten && now - oldestUnwritten >= windowMillis) flushPersistence(PERSIST_FLUSH_WINDOW);
+}
+
+void flushPersistence(PersistFlushReason reason) {
+    bool flushed = false;
+    for (size_t i = 0; i < fileCount; ++i) {
+        PersistentFile& file = files[i];
+        bool unwritten = false;
+        for (uint32_t p = 0; p < staging.count && !unwritten; ++p) {
+            unwritten = staging.points[p].fileHash == file.hash && !before(staging.points[p].sequence, file.queuedThrough);
+        }
+        if (unwritten && queueSeriesWrite(file)) flushed = true;
+    }
+    if (flushed) stats.flushes[reason]++;
+
+    // Anything that could not be queued waits another window
+    hasUnwritten = false;
+    updateStaging();
+}
+
+// SPIFFS keeps 252 data bytes in each 256-byte page, plus an index page. A
+// rewrite programs that many fresh pages, and the garbage collector later
+// erases the blocks the old copy occupied, so each rewrite costs about this
+// many erase blocks.
+uint32_t estimateEraseBlocks(size_t fileSize) {
+    size_t pages = (fileSize + 251) / 252 + 1;
+    return (pages * 256 + FLASH_ERASE_BLOCK_SIZE - 1) / FLASH_ERASE_BLOCK_SIZE;
+}
+
+PersistenceStats getPersistenceStats() {
+    return sharedStats.read();
+}
+
+size_t getPersistentFileCount() {
+    return fileCount;
+}
+
+const char* getPersistentFilePath(size_t index) {
+    return files[index].path.c_str();
+}
+
+PersistentFileStats getPersistentFileStats(size_t index) {
+    return files[index].stats.read();
+}
+
+size_t getPersistentFileStaged(size_t index) {
+    return files[index].staged;
+}
@@ -0,0 +1,72 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <Arduino.h>
+#include <data.h>
+
+// Write policy for the data series files. Every new 5-minute, hourly and
+// 6-hour point used to rewrite its whole file straight away, so one unit
+// rewrote ~25 KB of SPIFFS every five minutes per sensor. Now a new point is
+// only staged, in RTC memory that survives soft resets (panic, watchdog,
+// esp_restart), and the files with staged points are rewritten together when
+//   - the durability window has passed since the oldest unwritten point,
+//   - the staging buffer is filling up, or
+//   - the firmware restarts (shutdown hook).
+// After a reset, recoverStagedPoints() puts the points the files are missing
+// back into the series. A power cut loses at most one window of points.
+//
+// Staged points are kept until the flash writer confirms the file holding
+// them, so a write lost to a reset is recovered like any other.
+
+const uint32_t PERSIST_DEFAULT_WINDOW = 30;       // Minutes
+const uint32_t PERSIST_MAX_WINDOW = 360;
+const size_t PERSIST_STAGING_CAPACITY = 128;      // Points; 2.5 KB of RTC memory
+const size_t PERSIST_FLUSH_THRESHOLD = 96;        // Flush early beyond this many
+const size_t PERSIST_MAX_FILES = 12;              // Three tiers for MAX_SENSORS sensors
+const uint32_t FLASH_ERASE_BLOCK_SIZE = 4096;
+const uint32_t FLASH_ERASE_CYCLES = 100000;       // Typical NOR flash endurance per block
+
+enum PersistFlushReason {
+    PERSIST_FLUSH_WINDOW,
+    PERSIST_FLUSH_PRESSURE,
+    PERSIST_FLUSH_SHUTDOWN,
+    PERSIST_FLUSH_FORCED,        // Whole-series changes (restamp) and write-through
+    PERSIST_FLUSH_REASONS
+};
+
+struct PersistentFileStats {
+    uint32_t writes;             // Confirmed file rewrites
+    uint32_t bytesWritten;
+    uint32_t eraseBlocks;        // Estimated erase blocks consumed (see estimateEraseBlocks())
+    uint32_t failed;
+};
+
+struct PersistenceStats {
+    uint32_t windowMinutes;
+    uint32_t staged;             // Points in the staging buffer
+    uint32_t unwritten;          // Of those, points not yet queued for writing
+    uint32_t recovered;          // Points restored from the staging buffer at boot
+    uint32_t dropped;            // Points pushed out of a full staging buffer
+    uint32_t flushes[PERSIST_FLUSH_REASONS];
+};
+
+void setDurabilityWindow(uint32_t minutes);      // 0 writes every point straight through
+bool registerPersistentSeries(const char* path, DataSeries* series);
+size_t recoverStagedPoints();                    // Once every series is loaded and registered
+void installShutdownFlush();
+
+void persistLatest(const DataSeries& series);    // Stage the point just pushed onto `series`
+void persistSeries(const DataSeries& series);    // Rewrite the whole file now
+void restampStagedPoints(uint32_t bootOffset);   // See DataSeries::restamp()
+void servicePersistence(unsigned long now);      // Control task: flush when the window has passed
+void flushPersistence(PersistFlushReason reason);
+
+uint32_t estimateEraseBlocks(size_t fileSize);
+// Any task: snapshots published by the control task (staging) and the I/O task (file writes)
+PersistenceStats getPersistenceStats();
+size_t getPersistentFileCount();
+const char* getPersistentFilePath(size_t index);
+PersistentFileStats getPersistentFileStats(size_t index);
+size_t getPersistentFileStaged(size_t index);
+
+#endif
@@ -0,0 +1,520 @@
+// rule_program.cpp
+#include <rule_program.h>
+#include <data.h>
+#include <flash_writer.h>
+#include <storage.h>
+#include <time.h>
+#include <civil_time.h>
+
+static RuleProgramPtr currentProgram = std::make_shared<RuleProgram>();
+
+RuleProgramPtr getRuleProgram() {
+    return std::atomic_load(&currentProgram);
+}
+
+void publishRuleProgram(const RuleProgramPtr& program) {
+    std::atomic_store(&currentProgram, program);
+}
+
+// AC modes understood by set_mode; index 0 is the default
+static const char* const acModes[] = {"cool", "heat", "dry", "fan", "auto", "energy_saver"};
+static const size_t acModeCount = sizeof(acModes) / sizeof(acModes[0]);
+
+const char* acModeName(uint8_t mode) {
+    return mode < acModeCount ? acModes[mode] : acModes[0];
+}
+
+void RuleProgram::clear() {
+    rules.clear();
+    groups.clear();
+    children.clear();
+    conditions.clear();
+    actions.clear();
+    names.clear();
+    sourceCrc = 0;
+    sourceSize = 0;
+    sensorLayout = 0;
+}
+
+// ---- Compilation ----
+
+static uint8_t compileSensorField(const String& field) {
+    // sensor.<id>.<quantity>
+    int dot = field.lastIndexOf('.');
+    if (dot <= 7) return RULE_FIELD_NONE;
+    int slot = findSensor(field.substring(7, dot));
+    if (slot < 0) return RULE_FIELD_NONE;
+
+    String quantity = field.substring(dot + 1);
+    uint8_t index;
+    if (quantity == "temperature") index = RULE_SENSOR_TEMPERATURE;
+    else if (quantity == "humidity") index = RULE_SENSOR_HUMIDITY;
+    else if (quantity == "feels_like" || quantity == "feels_like_temp") index = RULE_SENSOR_FEELS_LIKE;
+    else return RULE_FIELD_NONE;
+    return RULE_FIELD_SENSOR_FIRST + slot * RULE_SENSOR_QUANTITIES + index;
+}
+
+static uint8_t compileField(const String& field) {
+    if (field.startsWith("sensor.")) return compileSensorField(field);
+    if (field == "temperature") return RULE_FIELD_TEMPERATURE;
+    if (field == "humidity") return RULE_FIELD_HUMIDITY;
+    if (field == "feels_like_temp" || field == "feels_like") return RULE_FIELD_FEELS_LIKE;
+    if (field == "temperature_5min") return RULE_FIELD_TEMPERATURE_5MIN;
+    if (field == "humidity_5min") return RULE_FIELD_HUMIDITY_5MIN;
+    if (field == "feels_like_5min") return RULE_FIELD_FEELS_LIKE_5MIN;
+    if (field == "target_temp") return RULE_FIELD_TARGET_TEMP;
+    if (field == "time_of_day") return RULE_FIELD_TIME_OF_DAY;
+    if (field == "temperature_ewma") return RULE_FIELD_TEMPERATURE_EWMA;
+    if (field == "feels_like_ewma") return RULE_FIELD_FEELS_LIKE_EWMA;
+    if (field == "temperature_rate") return RULE_FIELD_TEMPERATURE_RATE;
+    if (field == "temperature_slope") return RULE_FIELD_TEMPERATURE_SLOPE;
+    if (field == "minutes_since_ac_change") return RULE_FIELD_MINUTES_SINCE_AC_CHANGE;
+    return RULE_FIELD_NONE;
+}
+
+static uint8_t compileOperator(const String& op) {
+    if (op == ">") return RULE_OP_GT;
+    if (op == "<") return RULE_OP_LT;
+    if (op == ">=") return RULE_OP_GE;
+    if (op == "<=") return RULE_OP_LE;
+    if (op == "==" || op == "=") return RULE_OP_EQ;
+    if (op == "between" || op == "within") return RULE_OP_BETWEEN;
+    return RULE_OP_NONE;
+}
+
+// "HH:MM" to minutes since midnight, RULE_NO_TIME if unset or malformed
+static uint16_t parseMinutes(const String& time) {
+    int colon = time.indexOf(':');
+    if (colon <= 0) return RULE_NO_TIME;
+    long hours = time.substring(0, colon).toInt();
+    long minutes = time.substring(colon + 1).toInt();
+    if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59) return RULE_NO_TIME;
+    return (uint16_t)(hours * 60 + minutes);
+}
+
+static uint8_t compileDays(const std::vector<String>& days) {
+    static const char* const names[] = {"sunday", "monday", "tuesday", "wednesday", "thursday", "friday", "saturday"};
+    if (days.empty()) return RULE_DAY_ALL;
+    uint8_t mask = 0;
+    for (const String& day : days) {
+        for (uint8_t i = 0; i < 7; ++i) {
+            if (day.equalsIgnoreCase(names[i])) mask |= (1 << i);
+        }
+    }
+    return mask;
+}
+
+static uint8_t compileSeasons(const std::vector<String>& seasons) {
+    if (seasons.empty()) return RULE_SEASON_ALL;
+    uint8_t mask = 0;
+    for (const String& season : seasons) {
+        if (season.equalsIgnoreCase("spring")) mask |= RULE_SEASON_SPRING;
+        else if (season.equalsIgnoreCase("summer")) mask |= RULE_SEASON_SUMMER;
+        else if (season.equalsIgnoreCase("autumn") || season.equalsIgnoreCase("fall")) mask |= RULE_SEASON_AUTUMN;
+        else if (season.equalsIgnoreCase("winter")) mask |= RULE_SEASON_WINTER;
+    }
+    return mask;
+}
+
+static uint8_t compileMode(const String& mode) {
+    for (size_t i = 0; i < acModeCount; ++i) {
+        if (mode.equalsIgnoreCase(acModes[i])) return (uint8_t)i;
+    }
+    return 0;
+}
+
+static CompiledCondition compileCondition(const Condition& condition) {
+    CompiledCondition compiled = {};
+    compiled.field = compileField(condition.field);
+    compiled.op = compileOperator(condition.operator_);
+    compiled.value = condition.value;
+    if (compiled.field == RULE_FIELD_TIME_OF_DAY) {
+        compiled.low = parseMinutes(condition.start);
+        compiled.high = parseMinutes(condition.end);
+        if (compiled.low == RULE_NO_TIME || compiled.high == RULE_NO_TIME) compiled.op = RULE_OP_NONE;
+    } else {
+        compiled.low = condition.start.toFloat();
+        compiled.high = condition.end.toFloat();
+    }
+    if (compiled.field == RULE_FIELD_NONE || compiled.op == RULE_OP_NONE) {
+        Serial.printf("Rule condition '%s %s' is not supported and will never match\n",
+                      condition.field.c_str(), condition.operator_.c_str());
+        compiled.op = RULE_OP_NONE;
+    }
+    return compiled;
+}
+
+// Groups are appended depth first; each group's conditions and children are contiguous
+static uint16_t compileGroup(const ConditionGroup& group, RuleProgram& program) {
+    bool isAnd = group.operator_.equalsIgnoreCase("AND");
+    bool isOr = group.operator_.equalsIgnoreCase("OR");
+    if (!isAnd && !isOr && group.conditions.empty() && group.groups.empty()) return RULE_NO_GROUP;
+
+    std::vector<uint16_t> childGroups;
+    for (const ConditionGroup& nested : group.groups) {
+        uint16_t child = compileGroup(nested, program);
+        if (child != RULE_NO_GROUP) childGroups.push_back(child);
+    }
+
+    CompiledGroup compiled = {};
+    compiled.isOr = isOr ? 1 : 0;
+    compiled.firstCondition = program.conditions.size();
+    compiled.conditionCount = group.conditions.size();
+    for (const Condition& condition : group.conditions) {
+        program.conditions.push_back(compileCondition(condition));
+    }
+    compiled.firstChild = program.children.size();
+    compiled.childCount = childGroups.size();
+    program.children.insert(program.children.end(), childGroups.begin(), childGroups.end());
+
+    program.groups.push_back(compiled);
+    return program.groups.size() - 1;
+}
+
+static uint8_t compileActionType(const String& type) {
+    if (type == "set_temp") return RULE_ACTION_SET_TEMP;
+    if (type == "increment_temp") return RULE_ACTION_INCREMENT_TEMP;
+    if (type == "set_mode") return RULE_ACTION_SET_MODE;
+    if (type == "turn_on") return RULE_ACTION_TURN_ON;
+    if (type == "turn_off") return RULE_ACTION_TURN_OFF;
+    return RULE_ACTION_NONE;
+}
+
+void compileRules(const std::vector<RuleSet>& source, RuleProgram& program) {
+    program.clear();
+    program.rules.reserve(source.size());
+    program.sensorLayout = (uint16_t)sensorLayoutHash();
+
+    for (const RuleSet& rule : source) {
+        CompiledRule compiled = {};
+        compiled.dayMask = compileDays(rule.timeframe.days);
+        compiled.seasonMask = compileSeasons(rule.timeframe.seasons);
+        compiled.startMinute = parseMinutes(rule.timeframe.start_time);
+        compiled.endMinute = parseMinutes(rule.timeframe.end_time);
+        if (compiled.startMinute == RULE_NO_TIME || compiled.endMinute == RULE_NO_TIME) {
+            compiled.startMinute = compiled.endMinute = RULE_NO_TIME;
+        }
+        compiled.rootGroup = compileGroup(rule.conditions, program);
+
+        compiled.nameOffset = program.names.size();
+        program.names.insert(program.names.end(), rule.name.c_str(), rule.name.c_str() + rule.name.length() + 1);
+
+        compiled.firstAction = program.actions.size();
+        for (const Action& action : rule.actions) {
+            CompiledAction compiledAction = {};
+            compiledAction.type = compileActionType(action.type);
+            if (compiledAction.type == RULE_ACTION_NONE) {
+                Serial.printf("Rule '%s': unknown action '%s' ignored\n", rule.name.c_str(), action.type.c_str());
+                continue;
+            }
+            compiledAction.mode = compileMode(action.mode);
+            compiledAction.condition = compileGroup(action.condition, program);
+            compiledAction.target_temp = action.target_temp;
+            compiledAction.increment_value = action.increment_value;
+            if (action.repeat_if.field.length() > 0 && action.repeat_if.field != "null") {
+                compiledAction.repeat_if = compileCondition(action.repeat_if);
+            }
+            program.actions.push_back(compiledAction);
+        }
+        compiled.actionCount = program.actions.size() - compiled.firstAction;
+        program.rules.push_back(compiled);
+    }
+}
+
+// ---- Snapshot file ----
+
+static uint32_t programImageCrc(const RuleProgram& program) {
+    uint32_t crc = 0xFFFFFFFF;
+    crc = updateCRC32(crc, (const uint8_t*)program.rules.data(), program.rules.size() * sizeof(CompiledRule));
+    crc = updateCRC32(crc, (const uint8_t*)program.groups.data(), program.groups.size() * sizeof(CompiledGroup));
+    crc = updateCRC32(crc, (const uint8_t*)program.children.data(), program.children.size() * sizeof(uint16_t));
+    crc = updateCRC32(crc, (const uint8_t*)program.conditions.data(), program.conditions.size() * sizeof(CompiledCondition));
+    crc = updateCRC32(crc, (const uint8_t*)program.actions.data(), program.actions.size() * sizeof(CompiledAction));
+    crc = updateCRC32(crc, (const uint8_t*)program.names.data(), program.names.size());
+    return ~crc;
+}
+
+// Compile rules into a new, immutable program tagged with the JSON it came from
+RuleProgramPtr buildRuleProgram(const std::vector<RuleSet>& source, uint32_t sourceCrc, uint32_t sourceSize) {
+    std::shared_ptr<RuleProgram> program = std::make_shared<RuleProgram>();
+    compileRules(source, *program);
+    program->sourceCrc = sourceCrc;
+    program->sourceSize = sourceSize;
+    return program;
+}
+
+template <typename T>
+static void appendSection(std::vector<uint8_t>& image, const T* data, size_t count) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    image.insert(image.end(), bytes, bytes + count * sizeof(T));
+}
+
+// Queues the snapshot on the flash writer
+bool saveRuleProgram(const char* path, const RuleProgram& program) {
+    RuleProgramHeader header = {};
+    header.magic = RULE_PROGRAM_MAGIC;
+    header.version = RULE_PROGRAM_VERSION;
+    header.ruleCount = program.rules.size();
+    header.sourceCrc = program.sourceCrc;
+    header.sourceSize = program.sourceSize;
+    header.imageCrc = programImageCrc(program);
+    header.groupCount = program.groups.size();
+    header.childCount = program.children.size();
+    header.conditionCount = program.conditions.size();
+    header.actionCount = program.actions.size();
+    header.nameBytes = program.names.size();
+    header.sensorLayout = program.sensorLayout;
+
+    std::vector<uint8_t> image;
+    appendSection(image, &header, 1);
+    appendSection(image, program.rules.data(), program.rules.size());
+    appendSection(image, program.groups.data(), program.groups.size());
+    appendSection(image, program.children.data(), program.children.size());
+    appendSection(image, program.conditions.data(), program.conditions.size());
+    appendSection(image, program.actions.data(), program.actions.size());
+    appendSection(image, program.names.data(), program.names.size());
+
+    if (!queueFileWrite(path, std::move(image))) {
+        Serial.println("Failed to queue rule snapshot for writing");
+        return false;
+    }
+    Serial.printf("Saved rule snapshot: %d rules, image CRC 0x%08X\n", header.ruleCount, header.imageCrc);
+    return true;
+}
+
+template <typename T>
+static bool readSection(const std::vector<uint8_t>& image, size_t& offset, std::vector<T>& section, size_t count) {
+    size_t bytes = count * sizeof(T);
+    if (offset + bytes > image.size()) return false;
+    section.resize(count);
+    if (bytes) memcpy((uint8_t*)section.data(), image.data() + offset, bytes);
+    offset += bytes;
+    return true;
+}
+
+// Loads the snapshot if it is intact and was compiled from the current /rules.json
+bool loadRuleProgram(const char* path, RuleProgram& program) {
+    std::vector<uint8_t> image;
+    if (!storage().read(path, image)) return false;
+
+    RuleProgramHeader header;
+    if (image.size() < sizeof(header)) {
+        Serial.println("Rule snapshot has an unsupported format");
+        return false;
+    }
+    memcpy(&header, image.data(), sizeof(header));
+    if (header.magic != RULE_PROGRAM_MAGIC || header.version != RULE_PROGRAM_VERSION) {
+        Serial.println("Rule snapshot has an unsupported format");
+        return false;
+    }
+
+    uint32_t sourceCrc = 0;
+    size_t sourceSize = 0;
+    if (!calculateFileCRC32("/rules.json", sourceCrc, sourceSize) ||
+        sourceCrc != header.sourceCrc || sourceSize != header.sourceSize) {
+        Serial.println("Rule snapshot is stale");
+        return false;
+    }
+    if (header.sensorLayout != (uint16_t)sensorLayoutHash()) {
+        Serial.println("Rule snapshot was compiled for other sensors");
+        return false;
+    }
+
+    program.clear();
+    size_t offset = sizeof(header);
+    bool ok = readSection(image, offset, program.rules, header.ruleCount) &&
+              readSection(image, offset, program.groups, header.groupCount) &&
+              readSection(image, offset, program.children, header.childCount) &&
+              readSection(image, offset, program.conditions, header.conditionCount) &&
+              readSection(image, offset, program.actions, header.actionCount) &&
+              readSection(image, offset, program.names, header.nameBytes);
+
+    if (!ok || programImageCrc(program) != header.imageCrc) {
+        Serial.println("Rule snapshot is corrupt");
+        program.clear();
+        return false;
+    }
+    program.sourceCrc = header.sourceCrc;
+    program.sourceSize = header.sourceSize;
+    program.sensorLayout = header.sensorLayout;
+    return true;
+}
+
+// ---- Evaluation ----
+
+// Everything a pass needs from the clock, resolved once per pass
+struct EvaluationContext {
+    float fields[RULE_FIELD_LIMIT];
+    uint8_t dayBit;
+    uint8_t seasonBit;
+    uint16_t minuteOfDay;
+    const ACState* state;
+};
+
+// Same answer as determineHemisphere(), read off the zone's DST rule, and
+// only redone when the zone changes
+static bool isSouthernHemisphere() {
+    static uint32_t cachedVersion = 0;
+    static bool southern = true;
+    uint32_t version = localTimeZoneVersion();
+    if (version != cachedVersion) {
+        TimeZone zone;
+        getLocalTimeZone(zone);
+        // Default to southern (Australia) when we cannot tell, like getCurrentSeason()
+        southern = !zone.hasDst || isSouthernDst(zone);
+        cachedVersion = version;
+    }
+    return southern;
+}
+
+static uint8_t seasonBitForMonth(int month, bool southern) {
+    static const uint8_t northern[12] = {
+        RULE_SEASON_WINTER, RULE_SEASON_WINTER, RULE_SEASON_SPRING, RULE_SEASON_SPRING, RULE_SEASON_SPRING, RULE_SEASON_SUMMER,
+        RULE_SEASON_SUMMER, RULE_SEASON_SUMMER, RULE_SEASON_AUTUMN, RULE_SEASON_AUTUMN, RULE_SEASON_AUTUMN, RULE_SEASON_WINTER};
+    uint8_t season = northern[month];
+    if (!southern) return season;
+    // Opposite season in the southern hemisphere
+    switch (season) {
+        case RULE_SEASON_WINTER: return RULE_SEASON_SUMMER;
+        case RULE_SEASON_SUMMER: return RULE_SEASON_WINTER;
+        case RULE_SEASON_SPRING: return RULE_SEASON_AUTUMN;
+        default: return RULE_SEASON_SPRING;
+    }
+}
+
+static void prepareContext(EvaluationContext& ctx, const ACState& state) {
+    static LocalClock clock;     // Evaluation runs on the control task only
+    time_t now = time(nullptr);
+    CivilTime local;
+    clock.now(local);
+
+    ctx.dayBit = 1 << local.weekday;
+    ctx.seasonBit = seasonBitForMonth(local.month - 1, isSouthernHemisphere());
+    ctx.minuteOfDay = local.hour * 60 + local.minute;
+    ctx.state = &state;
+
+    ctx.fields[RULE_FIELD_NONE] = 0;
+    ctx.fields[RULE_FIELD_TEMPERATURE] = temperature_data.temperature;
+    ctx.fields[RULE_FIELD_HUMIDITY] = temperature_data.humidity;
+    ctx.fields[RULE_FIELD_FEELS_LIKE] = temperature_data.feels_like;
+    ctx.fields[RULE_FIELD_TEMPERATURE_5MIN] = temperature_data.temperature_5min;
+    ctx.fields[RULE_FIELD_HUMIDITY_5MIN] = temperature_data.humidity_5min;
+    ctx.fields[RULE_FIELD_FEELS_LIKE_5MIN] = temperature_data.feels_like_5min;
+    ctx.fields[RULE_FIELD_TIME_OF_DAY] = ctx.minuteOfDay;
+    ctx.fields[RULE_FIELD_TEMPERATURE_EWMA] = temperature_data.temperature_ewma;
+    ctx.fields[RULE_FIELD_FEELS_LIKE_EWMA] = temperature_data.feels_like_ewma;
+    ctx.fields[RULE_FIELD_TEMPERATURE_RATE] = temperature_data.temperature_rate;
+    ctx.fields[RULE_FIELD_TEMPERATURE_SLOPE] = temperature_data.temperature_slope;
+    ctx.fields[RULE_FIELD_MINUTES_SINCE_AC_CHANGE] = temperature_data.minutes_since_ac_change;
+
+    // A sensor that has not read well lately compares false rather than on an old value
+    for (size_t i = 0; i < MAX_SENSORS; ++i) {
+        float* values = ctx.fields + RULE_FIELD_SENSOR_FIRST + i * RULE_SENSOR_QUANTITIES;
+        bool fresh = false;
+        if (i < getSensorCount()) {
+            const SensorReading& reading = getSensor(i).latest;
+            fresh = reading.timestamp && (uint32_t)now - reading.timestamp <= SENSOR_STALE_AFTER;
+            values[RULE_SENSOR_TEMPERATURE] = reading.temperature;
+            values[RULE_SENSOR_HUMIDITY] = reading.humidity;
+            values[RULE_SENSOR_FEELS_LIKE] = reading.feels_like;
+        }
+        if (!fresh) {
+            for (size_t q = 0; q < RULE_SENSOR_QUANTITIES; ++q) values[q] = NAN;
+        }
+    }
+}
+
+static bool inMinuteRange(float minute, float start, float end) {
+    if (start <= end) return minute >= start && minute <= end;
+    return minute >= start || minute <= end; // Wraps past midnight (e.g. 21:00-10:00)
+}
+
+static bool conditionMatches(const CompiledCondition& condition, const EvaluationContext& ctx) {
+    // target_temp tracks the state as earlier actions in the pass change it
+    float value = condition.field == RULE_FIELD_TARGET_TEMP ? ctx.state->current_temp : ctx.fields[condition.field];
+    switch (condition.op) {
+        case RULE_OP_GT: return value > condition.value;
+        case RULE_OP_LT: return value < condition.value;
+        case RULE_OP_GE: return value >= condition.value;
+        case RULE_OP_LE: return value <= condition.value;
+        case RULE_OP_EQ: return value == condition.value;
+        case RULE_OP_BETWEEN:
+            if (condition.field == RULE_FIELD_TIME_OF_DAY) return inMinuteRange(value, condition.low, condition.high);
+            return value >= condition.low && value <= condition.high;
+        default: return false;
+    }
+}
+
+static bool groupMatches(const RuleProgram& program, uint16_t groupIndex, const EvaluationContext& ctx) {
+    if (groupIndex == RULE_NO_GROUP) return true;
+    const CompiledGroup& group = program.groups[groupIndex];
+    bool isOr = group.isOr;
+
+    for (uint16_t i = 0; i < group.conditionCount; ++i) {
+        if (conditionMatches(program.conditions[group.firstCondition + i], ctx) == isOr) return isOr;
+    }
+    for (uint16_t i = 0; i < group.childCount; ++i) {
+        if (groupMatches(program, program.children[group.firstChild + i], ctx) == isOr) return isOr;
+    }
+    return !isOr;
+}
+
+static bool timeframeMatches(const CompiledRule& rule, const EvaluationContext& ctx) {
+    if (!(rule.dayMask & ctx.dayBit)) return false;
+    if (!(rule.seasonMask & ctx.seasonBit)) return false;
+    if (rule.startMinute == RULE_NO_TIME) return true;
+    return inMinuteRange(ctx.minuteOfDay, rule.startMinute, rule.endMinute);
+}
+
+static void applyAction(const CompiledAction& action, ACState& state) {
+    switch (action.type) {
+        case RULE_ACTION_SET_TEMP:
+            state.is_on = true;
+            state.current_temp = action.target_temp;
+            break;
+        case RULE_ACTION_INCREMENT_TEMP:
+            state.is_on = true;
+            state.current_temp += action.increment_value; // Might be negative for decrement
+            break;
+        case RULE_ACTION_SET_MODE:
+            state.is_on = true;
+            if (state.mode != acModeName(action.mode)) state.mode = acModeName(action.mode);
+            break;
+        case RULE_ACTION_TURN_ON:
+            state.is_on = true;
+            break;
+        case RULE_ACTION_TURN_OFF:
+            state.is_on = false;
+            break;
+    }
+    state.current_temp = std::min(AC_MAX_TEMP, std::max(AC_MIN_TEMP, state.current_temp));
+}
+
+void evaluateRuleProgram(const RuleProgram& program, ACState& state, std::vector<uint8_t>& active, RuleFiredCallback onFired) {
+    EvaluationContext ctx;
+    prepareContext(ctx, state);
+    active.resize(program.rules.size(), 0);
+
+    for (size_t i = 0; i < program.rules.size(); ++i) {
+        const CompiledRule& rule = program.rules[i];
+        bool matches = timeframeMatches(rule, ctx) && groupMatches(program, rule.rootGroup, ctx);
+        bool justActivated = matches && !active[i];
+        active[i] = matches;
+        if (!matches) continue;
+
+        if (justActivated) Serial.printf("Executing actions for rule: %s\n", program.ruleName(i));
+        if (onFired) onFired(i, program.ruleName(i));
+
+        for (uint16_t a = 0; a < rule.actionCount; ++a) {
+            const CompiledAction& action = program.actions[rule.firstAction + a];
+            if (!groupMatches(program, action.condition, ctx)) continue;
+            // Relative actions would ramp on every pass, so they run when the
+            // rule activates and afterwards only while their repeat_if holds.
+            if (action.type == RULE_ACTION_INCREMENT_TEMP && !justActivated &&
+                !(action.repeat_if.op != RULE_OP_NONE && conditionMatches(action.repeat_if, ctx))) {
+                continue;
+            }
+            applyAction(action, state);
+        }
+    }
+}
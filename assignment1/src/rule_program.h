@@ -0,0 +1,174 @@
+#ifndef RULE_PROGRAM_H
+#define RULE_PROGRAM_H
+
+#include <Arduino.h>
+#include <vector>
+#include <memory>
+#include <rules.h>
+#include <sensors.h>
+
+//Rules are edited and stored as JSON, but evaluated from a compiled "program":
+//flat arrays of fixed-size records with every string (field names, operators,
+//days, seasons, times) resolved to small integers up front. The same image is
+//written to /rules.bin so boot can load it with a handful of reads instead of
+//parsing /rules.json. The format is as follows:
+//  - Header: RuleProgramHeader struct
+//  - Rules, groups, group children, conditions, actions (in that order)
+//  - Rule names (NUL-terminated, referenced by offset)
+
+const uint32_t RULE_PROGRAM_MAGIC = 0x4C555253;  // "SRUL"
+const uint16_t RULE_PROGRAM_VERSION = 2;
+const uint16_t RULE_NO_GROUP = 0xFFFF;
+const uint16_t RULE_NO_TIME = 0xFFFF;
+
+enum RuleFieldId : uint8_t {
+  RULE_FIELD_NONE = 0,
+  RULE_FIELD_TEMPERATURE,
+  RULE_FIELD_HUMIDITY,
+  RULE_FIELD_FEELS_LIKE,
+  RULE_FIELD_TEMPERATURE_5MIN,
+  RULE_FIELD_HUMIDITY_5MIN,
+  RULE_FIELD_FEELS_LIKE_5MIN,
+  RULE_FIELD_TARGET_TEMP,
+  RULE_FIELD_TIME_OF_DAY,     // Minutes since local midnight
+  RULE_FIELD_TEMPERATURE_EWMA,
+  RULE_FIELD_FEELS_LIKE_EWMA,
+  RULE_FIELD_TEMPERATURE_RATE,
+  RULE_FIELD_TEMPERATURE_SLOPE,
+  RULE_FIELD_MINUTES_SINCE_AC_CHANGE,
+  RULE_FIELD_COUNT
+};
+
+// sensor.<id>.temperature / .humidity / .feels_like compile to
+// RULE_FIELD_SENSOR_FIRST + registry slot * RULE_SENSOR_QUANTITIES + quantity
+enum RuleSensorQuantity : uint8_t {
+  RULE_SENSOR_TEMPERATURE = 0,
+  RULE_SENSOR_HUMIDITY,
+  RULE_SENSOR_FEELS_LIKE,
+  RULE_SENSOR_QUANTITIES
+};
+
+const uint8_t RULE_FIELD_SENSOR_FIRST = 32;
+const size_t RULE_FIELD_LIMIT = RULE_FIELD_SENSOR_FIRST + MAX_SENSORS * RULE_SENSOR_QUANTITIES;
+static_assert(RULE_FIELD_COUNT <= RULE_FIELD_SENSOR_FIRST, "Rule fields overlap the sensor fields");
+
+enum RuleOperatorId : uint8_t {
+  RULE_OP_NONE = 0,           // Unknown operator, never matches
+  RULE_OP_GT,
+  RULE_OP_LT,
+  RULE_OP_GE,
+  RULE_OP_LE,
+  RULE_OP_EQ,
+  RULE_OP_BETWEEN             // Inclusive; wraps past midnight for time_of_day
+};
+
+enum RuleActionId : uint8_t {
+  RULE_ACTION_NONE = 0,
+  RULE_ACTION_SET_TEMP,
+  RULE_ACTION_INCREMENT_TEMP,
+  RULE_ACTION_SET_MODE,
+  RULE_ACTION_TURN_ON,
+  RULE_ACTION_TURN_OFF
+};
+
+enum RuleSeasonBit : uint8_t {
+  RULE_SEASON_SPRING = 0x01,
+  RULE_SEASON_SUMMER = 0x02,
+  RULE_SEASON_AUTUMN = 0x04,
+  RULE_SEASON_WINTER = 0x08,
+  RULE_SEASON_ALL = 0x0F
+};
+
+const uint8_t RULE_DAY_ALL = 0x7F;  // Bit n = tm_wday n (0 = Sunday)
+
+struct RuleProgramHeader {
+    uint32_t magic;              // RULE_PROGRAM_MAGIC
+    uint16_t version;            // RULE_PROGRAM_VERSION
+    uint16_t ruleCount;
+    uint32_t sourceCrc;          // CRC32 of the /rules.json this was compiled from
+    uint32_t sourceSize;         // Size of that /rules.json
+    uint32_t imageCrc;           // CRC32 of everything after the header
+    uint16_t groupCount;
+    uint16_t childCount;
+    uint16_t conditionCount;
+    uint16_t actionCount;
+    uint16_t nameBytes;
+    uint16_t sensorLayout;       // Low bits of sensorLayoutHash() the sensor fields were compiled against
+};
+
+struct CompiledCondition {
+    uint8_t field;               // RuleFieldId
+    uint8_t op;                  // RuleOperatorId
+    uint16_t reserved;
+    float value;                 // Threshold for comparisons
+    float low;                   // Range start for "between"
+    float high;                  // Range end for "between"
+};
+
+struct CompiledGroup {
+    uint8_t isOr;                // 0 = AND, 1 = OR
+    uint8_t reserved;
+    uint16_t firstCondition;     // Index into conditions
+    uint16_t conditionCount;
+    uint16_t firstChild;         // Index into children (which hold group indices)
+    uint16_t childCount;
+    uint16_t reserved2;
+};
+
+struct CompiledAction {
+    uint8_t type;                // RuleActionId
+    uint8_t mode;                // Index into the AC mode table for set_mode
+    uint16_t condition;          // Group that must also hold, or RULE_NO_GROUP
+    float target_temp;
+    float increment_value;
+    CompiledCondition repeat_if; // op == RULE_OP_NONE when not set
+};
+
+struct CompiledRule {
+    uint8_t dayMask;             // Days the rule applies, RULE_DAY_ALL when not restricted
+    uint8_t seasonMask;          // RuleSeasonBit mask, RULE_SEASON_ALL when not restricted
+    uint16_t startMinute;        // Timeframe start, RULE_NO_TIME when not restricted
+    uint16_t endMinute;          // Timeframe end (inclusive; may be before start to wrap midnight)
+    uint16_t rootGroup;          // Main condition group, RULE_NO_GROUP when there is none
+    uint16_t firstAction;
+    uint16_t actionCount;
+    uint16_t nameOffset;         // Offset into names
+    uint16_t reserved;
+};
+
+struct RuleProgram {
+    std::vector<CompiledRule> rules;
+    std::vector<CompiledGroup> groups;
+    std::vector<uint16_t> children;
+    std::vector<CompiledCondition> conditions;
+    std::vector<CompiledAction> actions;
+    std::vector<char> names;
+    uint32_t sourceCrc = 0;
+    uint32_t sourceSize = 0;
+    uint16_t sensorLayout = 0;
+
+    const char* ruleName(size_t index) const { return names.data() + rules[index].nameOffset; }
+    void clear();
+};
+
+// The program evaluateRules() runs is published as an immutable, reference
+// counted snapshot. Writers (the web server) build and compile a new program
+// off to the side and swap the pointer atomically; readers take a reference
+// for the length of a pass and never see a half-built rule set.
+typedef std::shared_ptr<const RuleProgram> RuleProgramPtr;
+RuleProgramPtr getRuleProgram();  // Never null
+void publishRuleProgram(const RuleProgramPtr& program);
+
+void compileRules(const std::vector<RuleSet>& source, RuleProgram& program);
+RuleProgramPtr buildRuleProgram(const std::vector<RuleSet>& source, uint32_t sourceCrc, uint32_t sourceSize);
+bool saveRuleProgram(const char* path, const RuleProgram& program);
+bool loadRuleProgram(const char* path, RuleProgram& program);
+
+// Run one evaluation pass, applying the actions of matching rules to `state`.
+// `active` holds per-rule state between passes and is resized as needed.
+void evaluateRuleProgram(const RuleProgram& program, ACState& state, std::vector<uint8_t>& active,
+                         RuleFiredCallback onFired = nullptr);
+
+const char* acModeName(uint8_t mode);
+
+#endif
@@ -1,27 +1,38 @@
 #include "rules.h"
+#include "rule_program.h"
+#include "data.h"
+#include "flash_writer.h"
+#include "storage.h"
+#include "civil_time.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <ctime>
+#include <memory>
 
 std::vector<RuleSet> rules;
 ACState ac_state = {false, 22.0, "cool", 1 }; // Default state
 TemperatureData temperature_data = { 0 };
+static RuleFiredCallback ruleFiredCallback = nullptr;
+static std::vector<uint8_t> ruleWasActive; // Per rule: did it match on the previous evaluation?
+static RuleProgramPtr evaluatedProgram;     // Program ruleWasActive belongs to
+
 
 // Helper to get the current day as a string
+// (control task; the local time is worked out once a minute)
+static LocalClock rulesClock;
+
 String getCurrentDay() {
-    time_t now = time(nullptr);
-    struct tm *timeInfo = localtime(&now);
-    char dayOfWeek[10];
-    strftime(dayOfWeek, sizeof(dayOfWeek), "%A", timeInfo); // Full day name (e.g., "Monday")
-    return String(dayOfWeek);
+    CivilTime now;
+    rulesClock.now(now);
+    return String(weekdayName(now.weekday)); // Full day name (e.g., "Monday")
 }
 
 // Helper to get the current time in HH:MM format
 String getCurrentTime() {
-    time_t now = time(nullptr);
-    struct tm *timeInfo = localtime(&now);
+    CivilTime now;
+    rulesClock.now(now);
     char currentTime[6];
-    strftime(currentTime, sizeof(currentTime), "%H:%M", timeInfo); // Format to HH:MM
+    formatHourMinute(currentTime, now);
     return String(currentTime);
 }
 
@@ -110,159 +121,104 @@ String getCurrentSeason() {
 }
 
 
-// Helper function to load rules from SPIFFS
+// Load rules on boot. The compiled snapshot (/rules.bin) is used when it
+// matches /rules.json; otherwise the JSON is parsed, compiled and the
+// snapshot rewritten. The editable RuleSets are only needed for the web
+// API, which loads them on demand (see ensureRuleSetsLoaded).
 void loadRules() {
-    File file = SPIFFS.open("/rules.json", "r");
-    if (!file) {
-        Serial.println("Failed to open rules file");
+    std::shared_ptr<RuleProgram> snapshot = std::make_shared<RuleProgram>();
+    if (loadRuleProgram("/rules.bin", *snapshot)) {
+        publishRuleProgram(snapshot);
+        Serial.printf("Loaded %d compiled rules from snapshot\n", snapshot->rules.size());
         return;
     }
 
+    if (!loadRuleSetsFromFile()) return;
+    uint32_t crc = 0;
+    size_t size = 0;
+    calculateFileCRC32("/rules.json", crc, size);
+    RuleProgramPtr program = buildRuleProgram(rules, crc, size);
+    saveRuleProgram("/rules.bin", *program);
+    publishRuleProgram(program);
+    Serial.printf("Loaded %d rules from JSON\n", program->rules.size());
+}
+
+// Parse /rules.json into the editable rules vector
+bool loadRuleSetsFromFile() {
+    std::vector<uint8_t> contents;
+    if (!storage().read("/rules.json", contents)) {
+        Serial.println("Failed to open rules file");
+        return false;
+    }
+
     DynamicJsonDocument doc(4096); // Adjust size as needed
-    DeserializationError error = deserializeJson(doc, file);
-    file.close();
+    DeserializationError error = deserializeJson(doc, (const char*)contents.data(), contents.size());
     if (error) {
         Serial.println("Failed to parse rules file");
-        return;
+        return false;
     }
 
-    Serial.println("Loading rules...");
-    JsonArray rulesArray = doc["rules"].as<JsonArray>();
+    // The file holds {"rules":[...]}; accept a bare array as well
+    JsonArray rulesArray = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["rules"].as<JsonArray>();
     Serial.printf("Found %d rules\n", rulesArray.size());
-    Serial.println("----");
-
-    rules.clear();
-    for (JsonObject ruleObj : rulesArray) {
-        RuleSet rule;
-        rule.name = ruleObj["name"].as<String>();
-        rule.description = ruleObj["description"].as<String>();
-        Serial.printf("Loading rule: %s\n", rule.name.c_str());
-
-        // Load timeframe
-        JsonObject timeframe = ruleObj["timeframe"];
-        for (JsonVariant day : timeframe["days"].as<JsonArray>()) {
-            rule.timeframe.days.push_back(day.as<String>());
-        }
-        rule.timeframe.start_time = timeframe["start_time"].as<String>();
-        rule.timeframe.end_time = timeframe["end_time"].as<String>();
-        for (JsonVariant season : timeframe["seasons"].as<JsonArray>()) {
-            rule.timeframe.seasons.push_back(season.as<String>());
-        }
-
-        // Load main condition group
-        JsonObject conditionsObj = ruleObj["conditions"];
-        rule.conditions = loadConditionGroup(conditionsObj);
-        Serial.println("Main Conditions:");
-        for (const Condition &condition : rule.conditions.conditions) {
-            Serial.printf("%s %s %.2f\n", condition.field.c_str(), condition.operator_.c_str(), condition.value);
-        }
-
-        // Load actions
-        for (JsonObject actionObj : ruleObj["actions"].as<JsonArray>()) {
-            Action action;
-            action.type = actionObj["type"].as<String>();
-            action.target_temp = actionObj["target_temp"].as<float>();
-            action.increment_value = actionObj["increment_value"].as<float>();
-            Serial.printf("Action: %s\n", action.type.c_str());
-            Serial.printf("Target Temp: %.2f, Increment: %.2f\n", action.target_temp, action.increment_value);
-
-            // Load repeat_if condition
-            JsonObject repeatIfObj = actionObj["repeat_if"];
-            if (!repeatIfObj.isNull()) {
-                action.repeat_if.field = repeatIfObj["field"].as<String>();
-                action.repeat_if.operator_ = repeatIfObj["operator"].as<String>();
-                action.repeat_if.value = repeatIfObj["value"].as<float>();
-                Serial.printf("Repeat If: %s %s %.2f\n", action.repeat_if.field.c_str(), action.repeat_if.operator_.c_str(), action.repeat_if.value);
-            }
-
-            // Load additional condition group for action
-            JsonObject conditionGroupObj = actionObj["condition"];
-            if (!conditionGroupObj.isNull()) {
-                action.condition = loadConditionGroup(conditionGroupObj);
-                Serial.println("Additional Conditions:");
-                for (const Condition &condition : action.condition.conditions) {
-                    Serial.printf("%s %s %.2f\n", condition.field.c_str(), condition.operator_.c_str(), condition.value);
-                }
-            }
-
-            rule.actions.push_back(action);
-        }
+    return parseRuleSets(rulesArray, rules);
+}
 
-        Serial.printf("Rule loaded: %s\n", rule.name.c_str());
-        Serial.printf("Conditions: %d, Actions: %d\n", rule.conditions.conditions.size(), rule.actions.size());
-        Serial.println("----");
-        rules.push_back(rule);
+// Make sure the editable rules are in memory (they are not when booting from the snapshot)
+void ensureRuleSetsLoaded() {
+    if (rules.empty() && !getRuleProgram()->rules.empty()) {
+        loadRuleSetsFromFile();
     }
-    Serial.println("Rules loaded successfully");
-    Serial.printf("Loaded %d rules\n", rules.size());
 }
 
-// Helper function to save rules to SPIFFS
-void saveRules() {
-    File file = SPIFFS.open("/rules.json", "w");
-    if (!file) {
-        Serial.println("Failed to open rules file for writing");
+// The stored form of a rule set: {"rules":[...]}
+static String serializeRuleSets(const std::vector<RuleSet> &source) {
+    DynamicJsonDocument doc(4096);
+    JsonArray rulesArray = doc.createNestedArray("rules");
+    saveRulesToJson(source, rulesArray);
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+// Queue /rules.json and its snapshot on the flash writer. The JSON goes first,
+// so if only one of them makes it the snapshot's CRC check catches it on boot.
+static void queueRulesWrite(const String &json, const RuleProgram &program) {
+    if (!queueFileWrite("/rules.json", json)) {
+        Serial.println("Failed to queue rules file for writing");
         return;
     }
+    saveRuleProgram("/rules.bin", program);
+    Serial.printf("Queued %d rules for saving\n", program.rules.size());
+}
 
-    DynamicJsonDocument doc(4096); // Adjust size as needed
-    JsonArray rulesArray = doc.to<JsonArray>();
-
-    for (const RuleSet &rule : rules) {
-        JsonObject ruleObj = rulesArray.createNestedObject();
-        ruleObj["name"] = rule.name;
-        ruleObj["description"] = rule.description;
-
-        JsonObject timeframe = ruleObj.createNestedObject("timeframe");
-        JsonArray days = timeframe.createNestedArray("days");
-        for (const String &day : rule.timeframe.days) days.add(day);
-        timeframe["start_time"] = rule.timeframe.start_time;
-        timeframe["end_time"] = rule.timeframe.end_time;
-        JsonArray seasons = timeframe.createNestedArray("seasons");
-        for (const String &season : rule.timeframe.seasons) seasons.add(season);
-
-        // Save main condition group
-        JsonObject conditionsObj = ruleObj.createNestedObject("conditions");
-        saveConditionGroup(rule.conditions, conditionsObj);
-
-        // Save actions
-        JsonArray actions = ruleObj.createNestedArray("actions");
-        for (const Action &action : rule.actions) {
-            JsonObject actionObj = actions.createNestedObject();
-            actionObj["type"] = action.type;
-            actionObj["target_temp"] = action.target_temp;
-            actionObj["increment_value"] = action.increment_value;
-
-            // Save repeat_if condition
-            JsonObject repeatIfObj = actionObj.createNestedObject("repeat_if");
-            repeatIfObj["field"] = action.repeat_if.field;
-            repeatIfObj["operator"] = action.repeat_if.operator_;
-            repeatIfObj["value"] = action.repeat_if.value;
-
-            // Save additional condition group for action
-            JsonObject conditionGroupObj = actionObj.createNestedObject("condition");
-            saveConditionGroup(action.condition, conditionGroupObj);
-        }
-    }
+// Save the current rules and their compiled snapshot (written in the background)
+void saveRules() {
+    String json = serializeRuleSets(rules);
+    RuleProgramPtr program = buildRuleProgram(rules, calculateCRC32((const uint8_t*)json.c_str(), json.length()), json.length());
+    queueRulesWrite(json, *program);
+}
 
-    serializeJson(doc, file);
-    file.close();
-    Serial.println("Rules saved successfully");
-    Serial.printf("Saved %d rules\n", rules.size());
+// Range bounds may be times ("21:00") or numbers (18.5)
+static String jsonBound(JsonVariant value) {
+    if (value.isNull()) return String();
+    if (value.is<const char*>()) return value.as<String>();
+    return String(value.as<float>());
 }
 
 // Helper to load a ConditionGroup from JSON
 ConditionGroup loadConditionGroup(const JsonObject &groupObj) {
     ConditionGroup group;
-    group.operator_ = groupObj["operator"].as<String>();
+    group.operator_ = groupObj["operator"] | "";
 
     // Load each condition or nested group
     for (JsonVariant condition : groupObj["conditions"].as<JsonArray>()) {
         if (condition.is<JsonObject>()) {
             JsonObject conditionObj = condition.as<JsonObject>();
 
-            // Check if it’s a nested group or a simple condition
-            if (conditionObj.containsKey("operator")) {
+            // Nested groups have their own conditions array; simple conditions
+            // have an operator too, so that alone does not identify a group
+            if (conditionObj.containsKey("conditions")) {
                 ConditionGroup nestedGroup = loadConditionGroup(conditionObj);
                 group.groups.push_back(nestedGroup); // Add as nested group
             } else {
@@ -270,6 +226,8 @@ ConditionGroup loadConditionGroup(const JsonObject &groupObj) {
                 simpleCondition.field = conditionObj["field"].as<String>();
                 simpleCondition.operator_ = conditionObj["operator"].as<String>();
                 simpleCondition.value = conditionObj["value"].as<float>();
+                simpleCondition.start = jsonBound(conditionObj["start"]);
+                simpleCondition.end = jsonBound(conditionObj["end"]);
                 group.conditions.push_back(simpleCondition); // Add as simple condition
             }
         }
@@ -279,23 +237,21 @@ ConditionGroup loadConditionGroup(const JsonObject &groupObj) {
 
 // Helper to save a ConditionGroup to JSON
 void saveConditionGroup(const ConditionGroup &group, JsonObject &groupObj) {
-    Serial.printf("Saving group with %d conditions and %d groups\n", group.conditions.size(), group.groups.size());
     groupObj["operator"] = group.operator_;
     JsonArray conditions = groupObj.createNestedArray("conditions");
-    Serial.printf("Operator: %s\n", group.operator_.c_str());
 
     for (const Condition &condition : group.conditions) {
         JsonObject conditionObj = conditions.createNestedObject();
         conditionObj["field"] = condition.field;
         conditionObj["operator"] = condition.operator_;
         conditionObj["value"] = condition.value;
-        Serial.printf("Condition: %s %s %.2f\n", condition.field.c_str(), condition.operator_.c_str(), condition.value);
+        if (condition.start.length() > 0) conditionObj["start"] = condition.start;
+        if (condition.end.length() > 0) conditionObj["end"] = condition.end;
     }
 
     for (const ConditionGroup &nestedGroup : group.groups) {
         JsonObject nestedGroupObj = conditions.createNestedObject();
         saveConditionGroup(nestedGroup, nestedGroupObj);
-        Serial.println("Nested group saved");
     }
 }
 
@@ -304,6 +260,7 @@ Action loadAction(const JsonObject &actionObj) {
     action.type = actionObj["type"].as<String>();
     action.target_temp = actionObj["target_temp"].as<float>();
     action.increment_value = actionObj["increment_value"].as<float>();
+    action.mode = actionObj["mode"] | "";
 
     JsonObject repeatIfObj = actionObj["repeat_if"];
     action.repeat_if.field = repeatIfObj["field"].as<String>();
@@ -320,6 +277,7 @@ void saveAction(const Action &action, const JsonObject &actionObj) {
     actionObj["type"] = action.type;
     actionObj["target_temp"] = action.target_temp;
     actionObj["increment_value"] = action.increment_value;
+    if (action.mode.length() > 0) actionObj["mode"] = action.mode;
 
     JsonObject repeatIfObj = actionObj.createNestedObject("repeat_if");
     repeatIfObj["field"] = action.repeat_if.field;
@@ -330,9 +288,9 @@ void saveAction(const Action &action, const JsonObject &actionObj) {
     saveConditionGroup(action.condition, conditionGroupObj);
 }
 
-// Load rules from JSON file or API request
-bool loadRulesFromJson(const JsonArray &rulesArray) {
-    rules.clear();
+// Parse a JSON rules array into `out`
+bool parseRuleSets(const JsonArray &rulesArray, std::vector<RuleSet> &out) {
+    out.clear();
     for (JsonObject ruleObj : rulesArray) {
         RuleSet rule;
         rule.name = ruleObj["name"].as<String>();
@@ -349,14 +307,36 @@ bool loadRulesFromJson(const JsonArray &rulesArray) {
         for (JsonObject actionObj : ruleObj["actions"].as<JsonArray>()) {
             rule.actions.push_back(loadAction(actionObj));
         }
-        rules.push_back(rule);
+        out.push_back(rule);
     }
     return true;
 }
 
+// Replace the rules from an API request. The new set is parsed, serialized
+// and compiled off to the side, then swapped in with one atomic pointer
+// store; the evaluator keeps running the old program until its next pass.
+// The flash write is queued on the background writer.
+bool loadRulesFromJson(const JsonArray &rulesArray) {
+    std::vector<RuleSet> newRules;
+    if (!parseRuleSets(rulesArray, newRules)) return false;
+
+    // Serialize once: this is exactly what gets written, so its CRC ties the snapshot to it
+    String json = serializeRuleSets(newRules);
+    RuleProgramPtr program = buildRuleProgram(newRules, calculateCRC32((const uint8_t*)json.c_str(), json.length()), json.length());
+
+    publishRuleProgram(program);
+    rules.swap(newRules);
+    queueRulesWrite(json, *program);
+    return true;
+}
+
 // Save rules to JSON document
 void saveRulesToJson(JsonArray &rulesArray) {
-    for (const RuleSet &rule : rules) {
+    saveRulesToJson(rules, rulesArray);
+}
+
+void saveRulesToJson(const std::vector<RuleSet> &source, JsonArray &rulesArray) {
+    for (const RuleSet &rule : source) {
         JsonObject ruleObj = rulesArray.createNestedObject();
         ruleObj["name"] = rule.name;
         ruleObj["description"] = rule.description;
@@ -379,133 +359,24 @@ void saveRulesToJson(JsonArray &rulesArray) {
     }
 }
 
-// Function to check if the current time is within a rule's timeframe
-// Works off local time only.
-bool isTimeframeValid(const Timeframe &timeframe) {
-    // Get the current day, time, and season
-    String currentDay = getCurrentDay();
-    String currentTime = getCurrentTime();
-    String currentSeason = getCurrentSeason();
-
-    // Check if the current day is within the allowed days
-    if (!timeframe.days.empty() && std::find(timeframe.days.begin(), timeframe.days.end(), currentDay) == timeframe.days.end()) {
-        return false;
-    }
-
-    // Check if the current season is within the allowed seasons
-    if (!timeframe.seasons.empty() && std::find(timeframe.seasons.begin(), timeframe.seasons.end(), currentSeason) == timeframe.seasons.end()) {
-        return false;
-    }
-
-    // Check if the current time falls within the start and end times
-    if (timeframe.start_time <= currentTime && currentTime <= timeframe.end_time) {
-        return true;
-    }
-
-    return false;
-}
-
-// Function to check if all conditions in a rule are met
-bool areConditionsMet(const ConditionGroup &conditionGroup, const ACState &ac_state) {
-    bool result = (conditionGroup.operator_ == "AND");
-
-    for (const Condition &condition : conditionGroup.conditions) {
-        bool conditionMet = false;
-        float value = 0.0;
-
-        // Determine value based on the condition field
-        if (condition.field == "temperature") {
-            value = temperature_data.temperature;
-        } else if (condition.field == "feels_like_temp") {
-            value = temperature_data.feels_like; // Replace with actual calculation if available
-        } else if (condition.field == "time_of_day") {
-            conditionMet = (currentTimeIsWithinRange(condition.start, condition.end));
-        }
-
-        // Evaluate the condition operator
-        if (condition.operator_ == ">" && value > condition.value) conditionMet = true;
-        else if (condition.operator_ == "<" && value < condition.value) conditionMet = true;
-        else if (condition.operator_ == ">=" && value >= condition.value) conditionMet = true;
-        else if (condition.operator_ == "<=" && value <= condition.value) conditionMet = true;
-        else if (condition.operator_ == "between") conditionMet = (value >= condition.start.toFloat() && value <= condition.end.toFloat());
-
-        // Combine with previous results based on the operator
-        if (conditionGroup.operator_ == "AND") result = result && conditionMet;
-        else if (conditionGroup.operator_ == "OR") result = result || conditionMet;
-
-        // Exit early if result is already determined
-        if (result == (conditionGroup.operator_ == "OR")) return result;
-    }
-    return result;
-}
-
-bool currentTimeIsWithinRange(String start, String end) {
-    // Compare current time with start and end times
-    // Convert times to comparable format and evaluate
-    time_t now = time(nullptr);
-    struct tm *timeInfo = localtime(&now);
-    String currentTimeStr = String(timeInfo->tm_hour) + ":" + String(timeInfo->tm_min);
-    
-    // Implement comparison logic here
-    return (currentTimeStr >= start && currentTimeStr <= end);
-}
-
-// Function to execute actions based on the rule's configuration
-void executeAction(const Action &action, ACState &ac_state) {
-    if (action.type == "set_temp") {
-        ac_state.current_temp = action.target_temp;
-        Serial.printf("AC temperature set to %.2f\n", ac_state.current_temp);
-    } else if (action.type == "increment_temp") {
-        ac_state.current_temp += action.increment_value; // Might be negative for decrement
-        if (action.increment_value < 0) {
-            Serial.printf("AC temperature decremented by %.2f to %.2f\n", -action.increment_value, ac_state.current_temp);
-        } else {
-            Serial.printf("AC temperature incremented by %.2f to %.2f\n", action.increment_value, ac_state.current_temp);
-        }
-    }
-}
-
-// Main function to evaluate all rules and execute actions if conditions are met
+// Main function to evaluate all rules. All actions from one pass are
+// reduced into a single desired state, which is only published to ac_state
+// once the pass is complete; the actuator decides when to transmit it.
 void evaluateRules() {
-    for (const RuleSet &rule : rules) {
-        if (isTimeframeValid(rule.timeframe) && isSeasonValid(rule.timeframe.seasons) && areConditionsMet(rule.conditions, ac_state)) {
-            Serial.printf("Executing actions for rule: %s\n", rule.name.c_str());
-            for (const Action &action : rule.actions) {
-                executeAction(action, ac_state);
-            }
-        }
+    // Hold our own reference so a concurrent swap cannot free the program mid-pass
+    RuleProgramPtr program = getRuleProgram();
+    if (program != evaluatedProgram) {
+        ruleWasActive.clear(); // New rule set: every rule starts inactive
+        evaluatedProgram = program;
     }
-}
 
-bool isSeasonValid(const std::vector<String> &seasons) {
-    String currentSeason = getCurrentSeason();
-    for (const String &season : seasons) {
-        if (season == currentSeason) return true;
-    }
-    return false;
+    ACState desired = ac_state;
+    evaluateRuleProgram(*program, desired, ruleWasActive, ruleFiredCallback);
+    ac_state = desired;
 }
 
-bool isDayValid(const std::vector<String> &days) {
-    time_t now = time(nullptr);
-    struct tm *timeInfo = localtime(&now);
-    String currentDay = weekdayToString(timeInfo->tm_wday);
-    for (const String &day : days) {
-        if (day == currentDay) return true;
-    }
-    return false;
-}
-
-String weekdayToString(int wday) {
-    switch (wday) {
-        case 0: return "Sunday";
-        case 1: return "Monday";
-        case 2: return "Tuesday";
-        case 3: return "Wednesday";
-        case 4: return "Thursday";
-        case 5: return "Friday";
-        case 6: return "Saturday";
-        default: return "";
-    }
+void setRuleFiredCallback(RuleFiredCallback callback) {
+    ruleFiredCallback = callback;
 }
 
 //Based on : https://byjus.com/heat-index-formula
@@ -3,7 +3,6 @@
 
 #include <ArduinoJson.h>
 #include <vector>
-#include <SPIFFS.h>
 #include <string>
 
 // Define the structure for AC state tracking
@@ -22,6 +21,11 @@ struct TemperatureData {
   float temperature_5min;
   float humidity_5min;
   float feels_like_5min;
+  float temperature_ewma;       // Derived signals, see signals.h
+  float feels_like_ewma;
+  float temperature_rate;       // °C per hour
+  float temperature_slope;      // °C per hour over the last few 5-minute points
+  float minutes_since_ac_change;
 };
 
 // Define structures for rules
@@ -47,8 +51,9 @@ struct ConditionGroup {
 };
 
 struct Action {
-  String type;         // Action type (e.g., "set_temp", "increment_temp")
+  String type;         // Action type ("set_temp", "increment_temp", "set_mode", "turn_on", "turn_off")
   float target_temp;   // Target temperature for set_temp action
+  String mode;         // Mode for set_mode action (e.g., "cool", "heat", "energy_saver")
   float increment_value; // Value to increment or decrement temp by
   Condition repeat_if; // Condition to repeat the action
   ConditionGroup condition; // Additional condition for action
@@ -77,22 +82,28 @@ bool isDSTActive(int month, int day);
 
 // Functions to manage rules and AC state
 void loadRules();
+bool loadRuleSetsFromFile();
+void ensureRuleSetsLoaded();
 ConditionGroup loadConditionGroup(const JsonObject &groupObj);
-void saveRules();
+void saveRules(); // Queues /rules.json and /rules.bin on the flash writer
 void saveConditionGroup(const ConditionGroup &group, JsonObject &groupObj);
 Action loadAction(const JsonObject &actionObj);
 void saveAction(const Action &action, const JsonObject &actionObj);
+bool parseRuleSets(const JsonArray &rulesArray, std::vector<RuleSet> &out);
 bool loadRulesFromJson(const JsonArray &rulesArray);
 void saveRulesToJson(JsonArray &rulesArray);
-bool isTimeframeValid(const Timeframe& timeframe);
-bool areConditionsMet(const std::vector<Condition>& conditions, const ACState& ac_state);
-bool isSeasonValid(const std::vector<String>& seasons);
-bool isDayValid(const std::vector<String>& days);
-bool currentTimeIsWithinRange(String start, String end);
-String weekdayToString(int wday);
-void executeAction(const Action& action);
+void saveRulesToJson(const std::vector<RuleSet> &source, JsonArray &rulesArray);
 void evaluateRules(); // Main function to evaluate all rules against current AC state
 
+// Optional observer, called on each evaluation for every rule whose timeframe
+// and conditions match. Used by the host replay tool to build a timeline.
+typedef void (*RuleFiredCallback)(size_t ruleIndex, const char* ruleName);
+void setRuleFiredCallback(RuleFiredCallback callback);
+
+// Setpoint limits accepted by the AC (Daikin kDaikinMinTemp/kDaikinMaxTemp)
+const float AC_MIN_TEMP = 10.0;
+const float AC_MAX_TEMP = 32.0;
+
 float getFeelsLikeTemperature(float temp, float humidity);
 
 #endif // RULES_H
\ No newline at end of file
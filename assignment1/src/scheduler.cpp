@@ -0,0 +1,168 @@
+// scheduler.cpp
+#include <scheduler.h>
+#include <seqlock.h>
+#include <atomic>
+
+struct Task {
+    TaskFunction function;
+    unsigned long deadline;
+    bool active;
+    TaskStats stats;
+};
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static int taskCount = 0;
+
+// Copies of each task's stats for readers on other tasks
+static Seqlock<TaskStats> publishedStats[SCHEDULER_MAX_TASKS];
+static std::atomic<int> publishedCount(0);
+static std::atomic<bool> resetRequested(false);
+
+// Binary min-heap of task ids ordered by deadline. Deadlines are compared
+// as a signed difference so ordering survives millis() wrapping.
+static int heap[SCHEDULER_MAX_TASKS];
+static int heapSize = 0;
+
+static bool before(int a, int b) {
+    return (long)(tasks[a].deadline - tasks[b].deadline) < 0;
+}
+
+static void siftUp(int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!before(heap[pos], heap[parent])) break;
+        int swap = heap[pos]; heap[pos] = heap[parent]; heap[parent] = swap;
+        pos = parent;
+    }
+}
+
+static void siftDown(int pos) {
+    while (true) {
+        int smallest = pos;
+        int left = pos * 2 + 1;
+        int right = left + 1;
+        if (left < heapSize && before(heap[left], heap[smallest])) smallest = left;
+        if (right < heapSize && before(heap[right], heap[smallest])) smallest = right;
+        if (smallest == pos) break;
+        int swap = heap[pos]; heap[pos] = heap[smallest]; heap[smallest] = swap;
+        pos = smallest;
+    }
+}
+
+static void heapPush(int id) {
+    heap[heapSize] = id;
+    siftUp(heapSize++);
+}
+
+static void heapRemove(int id) {
+    for (int i = 0; i < heapSize; ++i) {
+        if (heap[i] != id) continue;
+        heap[i] = heap[--heapSize];
+        if (i < heapSize) {
+            siftUp(i);
+            siftDown(i);
+        }
+        return;
+    }
+}
+
+int scheduleTask(const char* name, TaskFunction function, unsigned long period, unsigned long delay, unsigned long budget) {
+    if (taskCount >= SCHEDULER_MAX_TASKS || !function) return -1;
+
+    int id = taskCount++;
+    Task& task = tasks[id];
+    task.function = function;
+    task.deadline = millis() + delay;
+    task.active = true;
+    task.stats = {};
+    task.stats.name = name;
+    task.stats.period = period;
+    task.stats.budget = budget ? budget : (period ? period : 100);
+    publishedStats[id].write(task.stats);
+    publishedCount = taskCount;
+    heapPush(id);
+    return id;
+}
+
+bool rescheduleTask(int id, unsigned long delay) {
+    if (id < 0 || id >= taskCount) return false;
+    Task& task = tasks[id];
+    if (task.active) heapRemove(id);
+    task.deadline = millis() + delay;
+    task.active = true;
+    heapPush(id);
+    return true;
+}
+
+void cancelTask(int id) {
+    if (id < 0 || id >= taskCount || !tasks[id].active) return;
+    heapRemove(id);
+    tasks[id].active = false;
+}
+
+static void resetStats() {
+    for (int i = 0; i < taskCount; ++i) {
+        TaskStats& stats = tasks[i].stats;
+        stats.calls = stats.overruns = stats.skipped = 0;
+        stats.totalMicros = 0;
+        stats.maxMicros = stats.maxLateMillis = 0;
+        publishedStats[i].write(stats);
+    }
+}
+
+unsigned long runScheduler(unsigned long now) {
+    if (resetRequested.exchange(false)) resetStats();
+
+    while (heapSize > 0) {
+        int id = heap[0];
+        Task& task = tasks[id];
+        long late = (long)(now - task.deadline);
+        if (late < 0) return (unsigned long)-late < SCHEDULER_MAX_SLEEP ? (unsigned long)-late : SCHEDULER_MAX_SLEEP;
+
+        // Work out the next deadline before running, so a task can reschedule or cancel itself
+        if (task.stats.period) {
+            task.deadline += task.stats.period;
+            if ((long)(now - task.deadline) >= 0) {
+                unsigned long behind = (now - task.deadline) / task.stats.period + 1;
+                task.stats.skipped += behind;
+                task.deadline += behind * task.stats.period;
+            }
+            siftDown(0);
+        } else {
+            heapRemove(id);
+            task.active = false;
+        }
+
+        unsigned long start = micros();
+        task.function();
+        unsigned long elapsed = micros() - start;
+
+        task.stats.calls++;
+        task.stats.totalMicros += elapsed;
+        if (elapsed > task.stats.maxMicros) task.stats.maxMicros = elapsed;
+        if ((unsigned long)late > task.stats.maxLateMillis) task.stats.maxLateMillis = late;
+        if (elapsed > task.stats.budget * 1000) {
+            task.stats.overruns++;
+            Serial.printf("Task %s overran: %lu ms (budget %lu ms)\n", task.stats.name, elapsed / 1000, task.stats.budget);
+        }
+        publishedStats[id].write(task.stats);
+
+        // Tasks may take a while; anything that came due meanwhile runs this pass too
+        now = millis();
+    }
+    return SCHEDULER_MAX_SLEEP;
+}
+
+int getTaskCount() {
+    return publishedCount.load();
+}
+
+bool getTaskStats(int id, TaskStats& stats) {
+    if (id < 0 || id >= publishedCount.load()) return false;
+    stats = publishedStats[id].read();
+    return true;
+}
+
+void resetSchedulerStats() {
+    resetRequested = true;
+}
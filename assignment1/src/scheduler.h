@@ -0,0 +1,53 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative scheduler for the control task (tasks.h). Tasks are plain
+// functions run on that task, ordered by deadline in a min-heap.
+// runScheduler() runs whatever is due and returns how long until the next
+// deadline, so the control task can block until then instead of spinning on
+// millis().
+//
+// Periodic tasks keep a fixed rate: the next deadline is the previous one
+// plus the period, so jitter does not accumulate. A task that falls more
+// than a period behind skips the missed runs instead of running back to back.
+//
+// Statistics are kept by the control task and published per task through a
+// seqlock after every run, so the web side (another core) reads a whole
+// snapshot. A reset is only requested from outside; the control task applies
+// it before its next pass.
+
+typedef void (*TaskFunction)();
+
+struct TaskStats {
+  const char* name;
+  unsigned long period;      // ms, 0 for one-shot tasks
+  unsigned long budget;      // ms a run may take before it counts as an overrun
+  uint32_t calls;
+  uint32_t overruns;         // Runs that took longer than the budget
+  uint32_t skipped;          // Periods skipped because the task fell behind
+  uint64_t totalMicros;      // Time spent in the task
+  uint32_t maxMicros;
+  uint32_t maxLateMillis;    // Worst start delay after the deadline (jitter)
+};
+
+const int SCHEDULER_MAX_TASKS = 16;
+const unsigned long SCHEDULER_MAX_SLEEP = 1000;   // Never sleep longer than this
+
+// Add a task. A period of 0 makes a one-shot task that runs once after `delay`
+// and can be re-armed with rescheduleTask(). `budget` defaults to the period
+// (or 100 ms for one-shot tasks). Returns the task id, or -1 if the table is full.
+int scheduleTask(const char* name, TaskFunction function, unsigned long period,
+                 unsigned long delay = 0, unsigned long budget = 0);
+bool rescheduleTask(int id, unsigned long delay);   // Next run `delay` ms from now
+void cancelTask(int id);
+
+// Run every task that is due at `now`; returns ms until the next deadline
+unsigned long runScheduler(unsigned long now);
+
+int getTaskCount();
+bool getTaskStats(int id, TaskStats& stats);   // false for unknown ids
+void resetSchedulerStats();                    // Any task; applied by the next runScheduler()
+
+#endif
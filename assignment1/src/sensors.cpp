@@ -0,0 +1,246 @@
+#include <sensors.h>
+#include <rules.h>
+#ifdef ESP32
+#include <DHT.h>
+#endif
+
+// A driver makes an object for a pin and reads it; both temperature and
+// humidity come from one transaction. Drivers with a start function capture
+// in the background: start() begins a capture that read() collects later.
+struct SensorDriver {
+    const char* name;
+    void* (*create)(uint8_t pin, uint8_t slot);
+    bool (*start)(void* driver, unsigned long delayMillis);  // nullptr: read() does the whole transaction
+    bool (*read)(void* driver, float& temperature, float& humidity);
+};
+
+template <DhtModel Model>
+static void* createDhtCaptureDriver(uint8_t pin, uint8_t slot) {
+    return createDhtCapture(pin, Model, slot);
+}
+
+static bool readDhtCaptureDriver(void* driver, float& temperature, float& humidity) {
+    DhtDecodeStatus status = readDhtCapture(driver, temperature, humidity);
+    if (status != DHT_DECODE_OK) Serial.printf("DHT capture failed: %s\n", dhtDecodeStatusName(status));
+    return status == DHT_DECODE_OK;
+}
+
+#ifdef ESP32
+// Adafruit DHT library: blocks for the start signal and masks interrupts for the frame
+template <uint8_t Type>
+static void* createDHT(uint8_t pin, uint8_t slot) {
+    (void)slot;
+    DHT* dht = new DHT(pin, Type);
+    dht->begin();
+    return dht;
+}
+
+static bool readDHT(void* driver, float& temperature, float& humidity) {
+    DHT* dht = static_cast<DHT*>(driver);
+    temperature = dht->readTemperature();
+    humidity = dht->readHumidity();  // Same transaction; the DHT library caches it
+    return !isnan(temperature) && !isnan(humidity);
+}
+#endif
+
+static const SensorDriver drivers[] = {
+    {"dht11", createDhtCaptureDriver<DHT_MODEL_DHT11>, startDhtCapture, readDhtCaptureDriver},
+    {"dht22", createDhtCaptureDriver<DHT_MODEL_DHT22>, startDhtCapture, readDhtCaptureDriver},
+#ifdef ESP32
+    {"dht11_lib", createDHT<DHT11>, nullptr, readDHT},
+    {"dht22_lib", createDHT<DHT22>, nullptr, readDHT},
+#endif
+    {nullptr, nullptr, nullptr, nullptr}
+};
+
+static Sensor* sensors[MAX_SENSORS];
+static const SensorDriver* sensorDrivers[MAX_SENSORS];
+static size_t sensorCount = 0;
+
+static const SensorDriver* findDriver(const String& name) {
+    for (const SensorDriver* driver = drivers; driver->name; ++driver) {
+        if (name.equalsIgnoreCase(driver->name)) return driver;
+    }
+    return nullptr;
+}
+
+bool isValidSensorId(const String& id) {
+    if (id.length() == 0 || id.length() > SENSOR_ID_LENGTH) return false;
+    for (size_t i = 0; i < id.length(); ++i) {
+        char c = id[i];
+        if (!isalnum((unsigned char)c) && c != '_') return false;
+    }
+    return true;
+}
+
+bool isKnownSensorDriver(const String& name) {
+    return findDriver(name) != nullptr;
+}
+
+bool validateSensorConfigs(const std::vector<SensorConfig>& configs, String& error) {
+    if (configs.size() > MAX_SENSORS) {
+        error = String("At most ") + String((unsigned)MAX_SENSORS) + " sensors";
+        return false;
+    }
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const SensorConfig& sensor = configs[i];
+        if (!isValidSensorId(sensor.id)) {
+            error = String("Invalid sensor id '") + sensor.id + "': 1 to " + String((unsigned)SENSOR_ID_LENGTH) +
+                    " letters, digits or '_'";
+            return false;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (configs[j].id == sensor.id) {
+                error = String("Duplicate sensor id '") + sensor.id + "'";
+                return false;
+            }
+        }
+        if (!isKnownSensorDriver(sensor.driver)) {
+            error = String("Unknown driver '") + sensor.driver + "' for sensor '" + sensor.id + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+SensorConfig defaultSensorConfig() {
+    // The single DHT11 on GPIO 4 the board was built with
+    SensorConfig sensor;
+    sensor.id = "main";
+    sensor.driver = "dht11";
+    sensor.pin = 4;
+    sensor.temperature_offset = 0;
+    sensor.humidity_offset = 0;
+    return sensor;
+}
+
+String sensorDataPath(const Sensor& sensor, const char* tier) {
+    if (&sensor == sensors[PRIMARY_SENSOR]) return String("/data_") + tier + ".bin";
+    return String("/data_") + tier + "_" + sensor.config.id + ".bin";
+}
+
+void setupSensors(const std::vector<SensorConfig>& configs) {
+    for (const SensorConfig& config : configs) {
+        if (sensorCount == MAX_SENSORS) {
+            Serial.printf("Ignoring sensor %s: at most %u sensors\n", config.id.c_str(), MAX_SENSORS);
+            break;
+        }
+        if (!isValidSensorId(config.id) || findSensor(config.id) >= 0) {
+            Serial.printf("Ignoring sensor with invalid or duplicate id '%s'\n", config.id.c_str());
+            continue;
+        }
+
+        Sensor* sensor = new Sensor();
+        sensor->config = config;
+        sensorDrivers[sensorCount] = findDriver(config.driver);
+        sensor->driver = sensorDrivers[sensorCount] ? sensorDrivers[sensorCount]->create(config.pin, sensorCount) : nullptr;
+        if (!sensor->driver) Serial.printf("Sensor %s: no driver '%s'\n", config.id.c_str(), config.driver.c_str());
+        sensor->latest = {0, NAN, NAN, NAN, SENSOR_READ_NONE};
+        sensor->pending = false;
+        sensor->attempts = 0;
+        sensor->failures = 0;
+        sensor->rejected = 0;
+        sensor->published.write(sensor->latest);
+
+        if (sensorCount == PRIMARY_SENSOR) {
+            // loadHistoricalData() fills these
+            sensor->series5Min = &temperatureData5Min;
+            sensor->seriesHourly = &temperatureDataHourly;
+            sensor->series6Hour = &temperatureData6Hour;
+        } else {
+            sensor->series5Min = new DataSeries(MAX_5MIN_POINTS);
+            sensor->seriesHourly = new DataSeries(MAX_HOURLY_POINTS);
+            sensor->series6Hour = new DataSeries(MAX_6HOUR_POINTS);
+        }
+        sensors[sensorCount++] = sensor;
+
+        if (sensor->series5Min != &temperatureData5Min) {
+            loadSeries(sensorDataPath(*sensor, "5min").c_str(), *sensor->series5Min, "5-minute");
+            loadSeries(sensorDataPath(*sensor, "hourly").c_str(), *sensor->seriesHourly, "hourly");
+            loadSeries(sensorDataPath(*sensor, "6hour").c_str(), *sensor->series6Hour, "6-hour");
+        }
+        Serial.printf("Sensor %s: %s on GPIO %u, offsets %.1f °C %.1f %%RH\n", config.id.c_str(),
+                      config.driver.c_str(), config.pin, config.temperature_offset, config.humidity_offset);
+    }
+
+    // The control task always reads the primary sensor
+    if (sensorCount == 0) {
+        Serial.println("No usable sensors configured, using the default sensor");
+        setupSensors(std::vector<SensorConfig>(1, defaultSensorConfig()));
+    }
+}
+
+size_t getSensorCount() {
+    return sensorCount;
+}
+
+Sensor& getSensor(size_t index) {
+    return *sensors[index];
+}
+
+int findSensor(const String& id) {
+    for (size_t i = 0; i < sensorCount; ++i) {
+        if (sensors[i]->config.id == id) return (int)i;
+    }
+    return -1;
+}
+
+uint32_t sensorLayoutHash() {
+    // FNV-1a over the IDs in order
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sensorCount; ++i) {
+        const String& id = sensors[i]->config.id;
+        for (size_t j = 0; j <= id.length(); ++j) {
+            hash ^= (uint8_t)(j < id.length() ? id[j] : 0);
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+void startSensorReads() {
+    for (size_t i = 0; i < sensorCount; ++i) {
+        Sensor& sensor = *sensors[i];
+        sensor.pending = true;
+        sensor.attempts = 1;
+        if (sensor.driver && sensorDrivers[i]->start) sensorDrivers[i]->start(sensor.driver, 0);
+    }
+}
+
+unsigned long readSensors(uint32_t timestamp) {
+    unsigned long wait = 0;
+    for (size_t i = 0; i < sensorCount; ++i) {
+        Sensor& sensor = *sensors[i];
+        if (!sensor.pending) continue;
+
+        const SensorDriver* driver = sensorDrivers[i];
+        float temperature, humidity;
+        if (!sensor.driver || !driver->read(sensor.driver, temperature, humidity)) {
+            // Capturing drivers get another go once the sensor will answer again
+            if (sensor.driver && driver->start && sensor.attempts < SENSOR_READ_ATTEMPTS &&
+                driver->start(sensor.driver, SENSOR_RETRY_DELAY)) {
+                sensor.attempts++;
+                wait = SENSOR_RETRY_DELAY + SENSOR_CAPTURE_TIME;
+                continue;
+            }
+            sensor.latest.result = SENSOR_READ_FAILED;
+            sensor.failures++;
+        } else {
+            temperature += sensor.config.temperature_offset;
+            humidity += sensor.config.humidity_offset;
+            if (!sensor.accumulator.add(temperature, humidity)) {
+                sensor.latest.result = SENSOR_READ_REJECTED;
+                sensor.rejected++;
+            } else {
+                sensor.latest.timestamp = timestamp;
+                sensor.latest.temperature = temperature;
+                sensor.latest.humidity = humidity;
+                sensor.latest.feels_like = getFeelsLikeTemperature(temperature, humidity);
+                sensor.latest.result = SENSOR_READ_OK;
+            }
+        }
+        sensor.pending = false;
+        sensor.published.write(sensor.latest);
+    }
+    return wait;
+}
@@ -0,0 +1,99 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <Arduino.h>
+#include <vector>
+#include <data.h>
+#include <accumulator.h>
+#include <seqlock.h>
+#include <dht_rmt.h>
+
+// Sensor registry. Each configured sensor (config "sensors", see
+// config.h) gets a driver, a calibration offset, its own 15-second
+// accumulator and its own set of three tiers. A sampling pass starts all
+// sensors at once with startSensorReads(); SENSOR_CAPTURE_TIME later
+// readSensors() collects them, restarting any failed capture after
+// SENSOR_RETRY_DELAY up to SENSOR_READ_ATTEMPTS times.
+//
+// Sensor 0 is the primary: it drives temperature_data and the derived
+// signals, uses the global temperatureData* series and keeps the original
+// file names (/data_5min.bin ...). Others store to /data_5min_<id>.bin etc.
+// Rules can read any sensor as sensor.<id>.temperature, .humidity or
+// .feels_like.
+//
+// Cost per additional sensor is fixed: the three tiers take
+// (MAX_5MIN_POINTS + MAX_HOURLY_POINTS + MAX_6HOUR_POINTS) * sizeof(DataPoint)
+// = 50 KB of RAM (large blocks go to PSRAM on the WROVER) and the same again
+// in flash when full, plus about 200 bytes of bookkeeping.
+
+const size_t MAX_SENSORS = 4;
+// Keeps /data_hourly_<id>.bin.tmp, the longest name a save uses, within
+// SPIFFS_MAX_PATH_LENGTH (13 + 10 + 4 + 4 = 31)
+const size_t SENSOR_ID_LENGTH = 10;
+const size_t PRIMARY_SENSOR = 0;
+const uint32_t SENSOR_STALE_AFTER = 120;  // s without a good read before rules stop using a sensor
+const uint8_t SENSOR_READ_ATTEMPTS = 3;    // Per pass, for drivers that capture in the background
+const unsigned long SENSOR_CAPTURE_TIME = DHT_CAPTURE_MILLIS;     // ms from starting a capture to reading it
+const unsigned long SENSOR_RETRY_DELAY = DHT_MIN_INTERVAL_MILLIS;  // ms before re-reading a sensor that failed
+
+struct SensorConfig {
+  String id;                 // Letters, digits and '_' only
+  String driver;             // "dht11"/"dht22" (RMT capture) or "dht11_lib"/"dht22_lib" (DHT library)
+  uint8_t pin;
+  float temperature_offset;  // Added to every reading, °C
+  float humidity_offset;     // Added to every reading, %RH
+};
+
+enum SensorReadResult : uint8_t {
+  SENSOR_READ_NONE = 0,      // Not read yet
+  SENSOR_READ_OK,
+  SENSOR_READ_FAILED,        // Driver returned nothing (NaN)
+  SENSOR_READ_REJECTED       // Outlier, dropped by the accumulator
+};
+
+struct SensorReading {
+  uint32_t timestamp;        // Of the last good read
+  float temperature;         // Calibrated; NaN until the first good read
+  float humidity;
+  float feels_like;
+  uint8_t result;            // SensorReadResult of the last pass
+};
+
+struct Sensor {
+  SensorConfig config;
+  void* driver;              // Driver object, owned by the registry
+  SampleAccumulator accumulator;
+  DataSeries* series5Min;
+  DataSeries* seriesHourly;
+  DataSeries* series6Hour;
+  SensorReading latest;      // Control task's copy
+  bool pending;              // Started this pass, not read yet
+  uint8_t attempts;
+  uint32_t failures;
+  uint32_t rejected;
+  Seqlock<SensorReading> published;  // `latest` for web handlers
+};
+
+bool isValidSensorId(const String& id);
+bool isKnownSensorDriver(const String& name);
+// What setupSensors() would refuse: bad or duplicate ids, unknown drivers, too many
+bool validateSensorConfigs(const std::vector<SensorConfig>& configs, String& error);
+SensorConfig defaultSensorConfig();
+
+// Registry; set up once in setup() and fixed after that. Entries it can't use
+// are skipped; if none is left, it sets up defaultSensorConfig() so there is
+// always a primary sensor.
+void setupSensors(const std::vector<SensorConfig>& configs);
+size_t getSensorCount();
+Sensor& getSensor(size_t index);
+int findSensor(const String& id);                  // -1 if unknown
+String sensorDataPath(const Sensor& sensor, const char* tier);  // tier: "5min", "hourly", "6hour"
+uint32_t sensorLayoutHash();                       // Changes when the IDs or their order change
+
+// One sampling pass over every sensor (control task). readSensors() returns
+// 0 once every sensor has a result, otherwise how many ms to wait before
+// calling it again for the retries.
+void startSensorReads();
+unsigned long readSensors(uint32_t timestamp);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Sequence lock for small, trivially copyable structs with a single writer.
+// The writer never waits: it bumps the sequence to odd, copies the value in
+// and bumps it back to even. Readers copy the value out and retry if the
+// sequence was odd or changed underneath them, so they always return a
+// value that was written as a whole. Meant for readers on the other core
+// (web handlers) - a reader that preempts the writer on its own core would
+// spin until the writer runs again.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a trivially copyable type");
+
+public:
+    Seqlock() : sequence(0) { memset(&value, 0, sizeof(value)); }
+    explicit Seqlock(const T& initial) : sequence(0) { memcpy(&value, &initial, sizeof(value)); }
+
+    void write(const T& newValue) {
+        uint32_t s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&value, &newValue, sizeof(T));
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        T copy;
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&copy, &value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return copy;
+    }
+
+    // Even, and advances by 2 on every write
+    uint32_t version() const { return sequence.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> sequence;
+    T value;
+};
+
+#endif
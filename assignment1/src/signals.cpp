@@ -0,0 +1,95 @@
+// signals.cpp
+#include <signals.h>
+
+static bool ewmaSeeded = false;
+static unsigned long lastSampleTime = 0;
+static float temperatureEwma2 = 0;    // EWMA of temperature_ewma, for the trend
+static float sampleInterval = 0;      // ms, smoothed like the values
+
+// Sliding window for the slope. x is the point's position in the window
+// (0 = oldest), so sums are adjusted as points shift instead of recomputed.
+static float slopeWindow[SIGNAL_SLOPE_POINTS];
+static size_t slopeHead = 0;   // Index of the oldest point once the window is full
+static size_t slopeCount = 0;
+static double sumY = 0;
+static double sumXY = 0;
+
+void resetSignals() {
+    ewmaSeeded = false;
+    lastSampleTime = 0;
+    temperatureEwma2 = 0;
+    sampleInterval = 0;
+    slopeHead = 0;
+    slopeCount = 0;
+    sumY = 0;
+    sumXY = 0;
+    temperature_data.temperature_ewma = 0;
+    temperature_data.feels_like_ewma = 0;
+    temperature_data.temperature_rate = 0;
+    temperature_data.temperature_slope = 0;
+    temperature_data.minutes_since_ac_change = NAN;
+}
+
+// Called for every good 15-second sample, before the rules are evaluated
+void updateSampleSignals(float temp, float feelsLike, unsigned long now, bool acChanged, unsigned long lastACChange) {
+    if (!ewmaSeeded) {
+        temperature_data.temperature_ewma = temp;
+        temperature_data.feels_like_ewma = feelsLike;
+        temperature_data.temperature_rate = 0;
+        temperatureEwma2 = temp;
+        sampleInterval = 0;
+        ewmaSeeded = true;
+    } else {
+        temperature_data.temperature_ewma += SIGNAL_EWMA_ALPHA * (temp - temperature_data.temperature_ewma);
+        temperatureEwma2 += SIGNAL_EWMA_ALPHA * (temperature_data.temperature_ewma - temperatureEwma2);
+        temperature_data.feels_like_ewma += SIGNAL_EWMA_ALPHA * (feelsLike - temperature_data.feels_like_ewma);
+
+        // The difference between consecutive samples is mostly sensor noise.
+        // On a steady ramp each EWMA lags its input by (1 - alpha) / alpha
+        // samples, so the gap between the two is the ramp over that many
+        // samples, with the noise smoothed twice.
+        unsigned long elapsed = now - lastSampleTime;
+        sampleInterval = sampleInterval > 0 ? sampleInterval + SIGNAL_EWMA_ALPHA * (elapsed - sampleInterval) : elapsed;
+        if (sampleInterval > 0) {
+            float perSample = (temperature_data.temperature_ewma - temperatureEwma2) * SIGNAL_EWMA_ALPHA / (1 - SIGNAL_EWMA_ALPHA);
+            temperature_data.temperature_rate = perSample * 3600000.0 / sampleInterval;
+        }
+    }
+    lastSampleTime = now;
+    temperature_data.minutes_since_ac_change = acChanged ? (now - lastACChange) / 60000.0 : NAN;
+}
+
+// Called for every new 5-minute point
+void updateTrendSignals(float temp5min) {
+    const size_t n = SIGNAL_SLOPE_POINTS;
+    if (slopeCount < n) {
+        slopeWindow[slopeCount] = temp5min;
+        sumXY += (double)slopeCount * temp5min;
+        sumY += temp5min;
+        slopeCount++;
+    } else {
+        // Every remaining point moves one place left (x - 1) and the new one goes in at x = n - 1
+        float oldest = slopeWindow[slopeHead];
+        sumXY += -(sumY - oldest) + (double)(n - 1) * temp5min;
+        sumY += temp5min - oldest;
+        slopeWindow[slopeHead] = temp5min;
+        slopeHead = (slopeHead + 1) % n;
+    }
+
+    if (slopeCount < 2) {
+        temperature_data.temperature_slope = 0;
+        return;
+    }
+    double count = slopeCount;
+    double sumX = count * (count - 1) / 2;
+    double sumXX = (count - 1) * count * (2 * count - 1) / 6;
+    double slopePerPoint = (count * sumXY - sumX * sumY) / (count * sumXX - sumX * sumX);
+    temperature_data.temperature_slope = slopePerPoint * 3600.0 / SIGNAL_POINT_INTERVAL;
+}
+
+void seedTrendSignals(const DataSeries& points) {
+    size_t start = points.size() > SIGNAL_SLOPE_POINTS ? points.size() - SIGNAL_SLOPE_POINTS : 0;
+    for (size_t i = start; i < points.size(); ++i) {
+        updateTrendSignals(points[i].temperature);
+    }
+}
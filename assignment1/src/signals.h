@@ -0,0 +1,31 @@
+#ifndef SIGNALS_H
+#define SIGNALS_H
+
+#include <Arduino.h>
+#include <vector>
+#include <data.h>
+#include <rules.h>
+
+// Derived signals (smoothed values and trends) that rules can use as
+// condition fields. Each is updated in O(1) as samples arrive, so the
+// evaluator reads them from temperature_data like any other field and
+// nothing rescans the 5-minute history.
+//
+//   temperature_ewma / feels_like_ewma  EWMA of the 15-second samples
+//   temperature_rate                    Trend of temperature_ewma over its time constant, °C
+//                                       per hour (double exponential smoothing)
+//   temperature_slope                   Least squares slope over the last SIGNAL_SLOPE_POINTS
+//                                       5-minute points, °C per hour
+//   minutes_since_ac_change             Minutes since the actuator last changed the AC state;
+//                                       NaN until it has (no condition on it holds)
+
+const float SIGNAL_EWMA_ALPHA = 0.05;          // Per 15 s sample, roughly a 5 minute time constant
+const size_t SIGNAL_SLOPE_POINTS = 6;          // 30 minutes of 5-minute points
+const unsigned long SIGNAL_POINT_INTERVAL = 300; // Seconds between 5-minute points
+
+void updateSampleSignals(float temp, float feelsLike, unsigned long now, bool acChanged, unsigned long lastACChange);
+void updateTrendSignals(float temp5min);
+void seedTrendSignals(const DataSeries& points); // Prime the slope from history on boot
+void resetSignals();
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+// Bounded single-producer/single-consumer ring queue, lock free.
+//
+// Exactly one task may call push() and exactly one (other) task may call
+// pop(). The producer owns `tail`, the consumer owns `head`; each reads the
+// other's index with acquire ordering and publishes its own with release
+// ordering, which is what makes the slot contents visible across cores.
+// Capacity must be a power of two; all of it is usable (the indices run
+// freely and are masked on access).
+//
+// Built for the ESP32 (Xtensa, two cores) and for Linux, where
+// tools/spsc_stress hammers it from two threads.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    // Producer side. Returns false (and leaves `item` untouched) when full.
+    bool push(T&& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) >= Capacity) return false;
+        slots[t & (Capacity - 1)] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const T& item) {
+        T copy = item;
+        return push(std::move(copy));
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (tail.load(std::memory_order_acquire) == h) return false;
+        item = std::move(slots[h & (Capacity - 1)]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from either side; exact from the consumer when the producer is idle
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    T slots[Capacity];
+    // Kept on separate cache lines on hosts that have them; harmless on the ESP32
+    alignas(64) std::atomic<uint32_t> head;   // Next slot to pop, written by the consumer
+    alignas(64) std::atomic<uint32_t> tail;   // Next slot to push, written by the producer
+};
+
+#endif
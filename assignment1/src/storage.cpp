@@ -0,0 +1,198 @@
+// storage.cpp
+#include <storage.h>
+
+#ifdef ESP32
+#ifdef STORAGE_LITTLEFS
+#include <LittleFS.h>
+#else
+#include <SPIFFS.h>
+#endif
+#include <arduino_storage.h>
+
+Storage& storage() {
+#ifdef STORAGE_LITTLEFS
+    static ArduinoStorage<fs::LittleFSFS> backend(LittleFS, "LittleFS", true);
+#else
+    static ArduinoStorage<fs::SPIFFSFS> backend(SPIFFS, "SPIFFS", false);
+#endif
+    return backend;
+}
+
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+
+// Plain files under a host directory; replace() is write, fsync, rename(2)
+class PosixStorage : public Storage {
+public:
+    const char* name() const override { return "POSIX"; }
+
+    bool begin(bool formatOnFail) override {
+        (void)formatOnFail;
+        struct stat st;
+        if (::stat(root.c_str(), &st) == 0) return S_ISDIR(st.st_mode);
+        return makeDirectories(root) && ::mkdir(root.c_str(), 0755) == 0;
+    }
+
+    bool exists(const char* path) override {
+        return access(hostPath(path).c_str(), F_OK) == 0;
+    }
+
+    bool stat(const char* path, StorageStat& info) override {
+        struct stat st;
+        if (::stat(hostPath(path).c_str(), &st) != 0) return false;
+        info.size = S_ISDIR(st.st_mode) ? 0 : st.st_size;
+        info.isDirectory = S_ISDIR(st.st_mode);
+        return true;
+    }
+
+    bool read(const char* path, std::vector<uint8_t>& contents) override {
+        int fd = ::open(hostPath(path).c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && !S_ISDIR(st.st_mode);
+        if (ok) {
+            contents.resize(st.st_size);
+            ok = readFully(fd, 0, contents.data(), contents.size()) == contents.size();
+        }
+        ::close(fd);
+        return ok;
+    }
+
+    size_t readAt(const char* path, size_t offset, uint8_t* buffer, size_t length) override {
+        int fd = ::open(hostPath(path).c_str(), O_RDONLY);
+        if (fd < 0) return 0;
+        size_t n = readFully(fd, offset, buffer, length);
+        ::close(fd);
+        return n;
+    }
+
+    bool append(const char* path, const uint8_t* data, size_t length) override {
+        String file = hostPath(path);
+        if (!makeDirectories(file)) return false;
+        int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) return false;
+        bool ok = writeFully(fd, data, length);
+        return ::close(fd) == 0 && ok;
+    }
+
+    bool replace(const char* path, const uint8_t* data, size_t length) override {
+        String file = hostPath(path);
+        String tempFile = file + ".tmp";
+        if (!makeDirectories(file)) return false;
+        int fd = ::open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            Serial.printf("Failed to open %s for writing\n", tempFile.c_str());
+            return false;
+        }
+        bool ok = writeFully(fd, data, length) && fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if (!ok || ::rename(tempFile.c_str(), file.c_str()) != 0) {
+            Serial.printf("Failed to replace %s\n", file.c_str());
+            unlink(tempFile.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool remove(const char* path) override {
+        return unlink(hostPath(path).c_str()) == 0;
+    }
+
+    bool list(const char* directory, std::vector<StorageEntry>& entries) override {
+        entries.clear();
+        DIR* dir = opendir(hostPath(directory).c_str());
+        if (!dir) return false;
+        String prefix = directory;
+        if (!prefix.endsWith("/")) prefix += "/";
+        while (struct dirent* entry = readdir(dir)) {
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) continue;
+            StorageEntry item = {prefix + entry->d_name, 0, false};
+            StorageStat info;
+            if (stat(item.path.c_str(), info)) {
+                item.size = info.size;
+                item.isDirectory = info.isDirectory;
+            }
+            entries.push_back(item);
+        }
+        closedir(dir);
+        return true;
+    }
+
+    size_t totalBytes() override {
+        struct statvfs fs;
+        return statvfs(root.c_str(), &fs) == 0 ? (size_t)fs.f_blocks * fs.f_frsize : 0;
+    }
+
+    size_t usedBytes() override {
+        struct statvfs fs;
+        return statvfs(root.c_str(), &fs) == 0 ? (size_t)(fs.f_blocks - fs.f_bfree) * fs.f_frsize : 0;
+    }
+
+    fs::FS& filesystem() override { return files; }
+
+    void setRoot(const String& directory) {
+        root = directory;
+        files.setHostRoot(directory);
+    }
+
+private:
+    String root = ".";
+    fs::FS files;                // The same directory through the fs::FS shim
+
+    String hostPath(const char* path) const {
+        return root + (path[0] == '/' ? "" : "/") + path;
+    }
+
+    // Create the directories above `file`
+    static bool makeDirectories(const String& file) {
+        for (int slash = file.indexOf('/', 1); slash > 0; slash = file.indexOf('/', slash + 1)) {
+            String dir = file.substring(0, slash);
+            if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        }
+        return true;
+    }
+
+    static size_t readFully(int fd, size_t offset, uint8_t* buffer, size_t length) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = pread(fd, buffer + done, length - done, offset + done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += n;
+        }
+        return done;
+    }
+
+    static bool writeFully(int fd, const uint8_t* data, size_t length) {
+        while (length) {
+            ssize_t n = ::write(fd, data, length);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            length -= n;
+        }
+        return true;
+    }
+};
+
+static PosixStorage posixStorage;
+static Storage* activeStorage = &posixStorage;
+
+Storage& storage() {
+    return *activeStorage;
+}
+
+void setStorage(Storage* backend) {
+    activeStorage = backend ? backend : &posixStorage;
+}
+
+void setStorageRoot(const String& root) {
+    posixStorage.setRoot(root);
+}
+#endif
@@ -0,0 +1,63 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <FS.h>
+
+// Everything we keep in flash goes through storage(), so the filesystem can
+// be swapped without touching the callers. Backends:
+//   SPIFFS    default firmware build
+//   LittleFS  -D STORAGE_LITTLEFS (env:upesy_wrover_littlefs); real
+//             directories, faster open/exists, and rename replaces the
+//             target atomically
+//   POSIX     Linux builds and host tools; "/x" is <root>/x, see setStorageRoot()
+//
+// SPIFFS and LittleFS share one implementation, see arduino_storage.h.
+//
+// Callers read whole files or byte ranges and write whole files or appends;
+// nothing keeps a file open across calls, so no backend needs handles in the
+// interface. Paths start with '/'.
+
+const size_t SPIFFS_MAX_PATH_LENGTH = 31;    // SPIFFS_OBJ_NAME_LEN is 32 with the NUL
+const size_t REPLACE_SUFFIX_LENGTH = 4;      // ".tmp"/".new" added by replace(), see arduino_storage.h
+
+struct StorageStat {
+    size_t size;
+    bool isDirectory;
+};
+
+struct StorageEntry {
+    String path;                 // Full path, e.g. "/data_5min.bin"
+    size_t size;
+    bool isDirectory;
+};
+
+class Storage {
+public:
+    virtual ~Storage() {}
+
+    virtual const char* name() const = 0;
+    virtual bool begin(bool formatOnFail = false) = 0;
+    virtual bool exists(const char* path) = 0;
+    virtual bool stat(const char* path, StorageStat& info) = 0;
+    virtual bool read(const char* path, std::vector<uint8_t>& contents) = 0;     // Whole file
+    virtual size_t readAt(const char* path, size_t offset, uint8_t* buffer, size_t length) = 0;
+    virtual bool append(const char* path, const uint8_t* data, size_t length) = 0;
+    virtual bool replace(const char* path, const uint8_t* data, size_t length) = 0;  // Never leaves a partial file
+    virtual bool remove(const char* path) = 0;
+    virtual bool list(const char* directory, std::vector<StorageEntry>& entries) = 0;
+    virtual size_t totalBytes() = 0;
+    virtual size_t usedBytes() = 0;
+
+    virtual fs::FS& filesystem() = 0;    // For the web server's static files and downloads
+};
+
+Storage& storage();
+
+#ifndef ESP32
+void setStorageRoot(const String& root);     // Host directory that "/" maps to (default ".")
+void setStorage(Storage* backend);           // Another backend for host tools (nullptr = POSIX)
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+// storage_bench.cpp
+#include <storage_bench.h>
+#include <storage.h>
+#include <data.h>
+
+struct BenchTiming {
+    uint32_t count;
+    uint32_t totalMicros;
+    uint32_t maxMicros;
+    uint32_t failures;
+};
+
+static void record(BenchTiming& timing, unsigned long start, bool ok) {
+    uint32_t elapsed = micros() - start;
+    timing.count++;
+    timing.totalMicros += elapsed;
+    if (elapsed > timing.maxMicros) timing.maxMicros = elapsed;
+    if (!ok) timing.failures++;
+}
+
+static void report(const char* operation, const char* file, const BenchTiming& timing) {
+    Serial.printf("  %-8s %-28s %9.3f ms avg %9.3f ms max%s\n", operation, file,
+                  timing.count ? timing.totalMicros / 1000.0f / timing.count : 0.0f, timing.maxMicros / 1000.0f,
+                  timing.failures ? "  FAILED" : "");
+}
+
+// Load the way loadDataPoints() does: size, header, then all points
+static bool loadBenchFile(const char* path, std::vector<DataPoint>& points) {
+    StorageStat info;
+    DataPointHeader header;
+    if (!storage().stat(path, info) ||
+        storage().readAt(path, 0, (uint8_t*)&header, sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+    points.resize(header.recordCount);
+    size_t bytes = points.size() * sizeof(DataPoint);
+    return info.size == sizeof(header) + bytes &&
+           storage().readAt(path, sizeof(header), (uint8_t*)points.data(), bytes) == bytes;
+}
+
+void runStorageBenchmark(int iterations) {
+    struct Tier {
+        const char* path;
+        size_t points;
+    };
+    const Tier tiers[] = {
+        {"/bench_data_5min.bin", MAX_5MIN_POINTS},
+        {"/bench_data_hourly.bin", MAX_HOURLY_POINTS},
+        {"/bench_data_6hour.bin", MAX_6HOUR_POINTS},
+    };
+
+    Serial.printf("Storage benchmark on %s, %d iterations\n", storage().name(), iterations);
+    for (const Tier& tier : tiers) {
+        std::vector<DataPoint> points;
+        for (size_t i = 0; i < tier.points; ++i) points.push_back({20.0f + i % 7, 50.0f + i % 11, 1700000000u + (uint32_t)i * 300});
+        std::vector<uint8_t> contents = serializeDataPoints(points);
+
+        BenchTiming save = {}, load = {}, exists = {}, stat = {};
+        std::vector<DataPoint> loaded;
+        for (int i = 0; i < iterations; ++i) {
+            unsigned long start = micros();
+            record(save, start, storage().replace(tier.path, contents.data(), contents.size()));
+
+            start = micros();
+            bool ok = loadBenchFile(tier.path, loaded) && loaded.size() == points.size() &&
+                      memcmp(loaded.data(), points.data(), points.size() * sizeof(DataPoint)) == 0;
+            record(load, start, ok);
+
+            start = micros();
+            record(exists, start, storage().exists(tier.path));
+
+            StorageStat info;
+            start = micros();
+            record(stat, start, storage().stat(tier.path, info) && info.size == contents.size());
+        }
+
+        char file[48];
+        snprintf(file, sizeof(file), "%s (%u B)", tier.path + 7, (unsigned)contents.size());
+        report("save", file, save);
+        report("load", file, load);
+        report("exists", file, exists);
+        report("stat", file, stat);
+    }
+
+    // A point at a time, as an append-only log would write them
+    BenchTiming append = {};
+    DataPoint point = {21.5f, 48.0f, 1700000000};
+    for (int i = 0; i < iterations * 10; ++i) {
+        unsigned long start = micros();
+        record(append, start, storage().append("/bench_append.bin", (const uint8_t*)&point, sizeof(point)));
+    }
+    report("append", "12 B point", append);
+
+    BenchTiming list = {};
+    std::vector<StorageEntry> entries;
+    for (int i = 0; i < iterations; ++i) {
+        unsigned long start = micros();
+        record(list, start, storage().list("/", entries));
+    }
+    char listed[32];
+    snprintf(listed, sizeof(listed), "/ (%u entries)", (unsigned)entries.size());
+    report("list", listed, list);
+
+    for (const Tier& tier : tiers) storage().remove(tier.path);
+    storage().remove("/bench_append.bin");
+}
@@ -0,0 +1,14 @@
+#ifndef STORAGE_BENCH_H
+#define STORAGE_BENCH_H
+
+#include <Arduino.h>
+
+// Save/load latency of files shaped like the data_*.bin tiers on whichever
+// backend storage() is (see storage.h). Build the firmware with
+// -D STORAGE_BENCHMARK to run it at boot, once per backend, and compare the
+// printed tables; tools/storage_bench runs it against the POSIX backend.
+// Uses /bench_* files and removes them afterwards.
+
+void runStorageBenchmark(int iterations);
+
+#endif
@@ -0,0 +1,72 @@
+// tasks.cpp
+#include <tasks.h>
+#include <scheduler.h>
+#include <flash_writer.h>
+#include <telemetry.h>
+#include <atomic>
+
+static TaskHandle_t ioTask = nullptr;
+static TaskHandle_t controlTask = nullptr;
+static std::atomic<void (*)()> controlRequest(nullptr);   // Cleared by the control task once run
+
+static void ioTaskMain(void* parameter) {
+    registerFlashWriterTask();
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IO_TASK_IDLE_WAKE));
+        serviceTelemetry();
+        // One file at a time, so telemetry is not held up behind a long series of writes
+        while (serviceFlashWrites()) {
+            serviceTelemetry();
+        }
+    }
+}
+
+static void controlTaskMain(void* parameter) {
+    registerFlashControlTask();
+    while (true) {
+        // Run whatever is due, then sleep until the next deadline
+        unsigned long idle = runScheduler(millis());
+        void (*request)() = controlRequest.load();
+        if (request) {
+            request();
+            controlRequest = nullptr;
+            continue;
+        }
+        // A request (runOnControlTask()) cuts the sleep short
+        if (idle > 0) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idle));
+    }
+}
+
+bool runOnControlTask(void (*fn)(), unsigned long timeoutMs) {
+    if (!controlTask || xTaskGetCurrentTaskHandle() == controlTask) {
+        fn();
+        return true;
+    }
+    void (*expected)() = nullptr;
+    if (!controlRequest.compare_exchange_strong(expected, fn)) return false;
+    xTaskNotifyGive(controlTask);
+
+    // The control task may wait on file writes, which only the I/O task does
+    bool onIoTask = xTaskGetCurrentTaskHandle() == ioTask;
+    unsigned long start = millis();
+    while (controlRequest.load() == fn) {
+        if (millis() - start >= timeoutMs) return false;
+        if (!onIoTask || !serviceFlashWrites()) delay(1);
+    }
+    return true;
+}
+
+void wakeIoTask() {
+    if (ioTask) xTaskNotifyGive(ioTask);
+}
+
+void startIoTask() {
+    if (ioTask) return;
+    xTaskCreatePinnedToCore(ioTaskMain, "io", IO_TASK_STACK, nullptr, IO_TASK_PRIORITY, &ioTask, IO_TASK_CORE);
+    startFlashWriter(wakeIoTask);
+}
+
+void startControlTask() {
+    if (controlTask) return;
+    xTaskCreatePinnedToCore(controlTaskMain, "control", CONTROL_TASK_STACK, nullptr, CONTROL_TASK_PRIORITY, &controlTask, CONTROL_TASK_CORE);
+}
@@ -0,0 +1,38 @@
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <Arduino.h>
+
+// Task layout. The ESP32 has two cores; work is split so that sensing, rule
+// evaluation and IR timing never share a core with flash or network I/O.
+//
+//   Core 1  control task  The scheduler (scheduler.h): DHT sampling, rule
+//                         evaluation, actuator, aggregation. Replaces loop().
+//   Core 0  I/O task      Flash writes (flash_writer.h) and control telemetry
+//                         for the web side (telemetry.h). AsyncTCP (built with
+//                         CONFIG_ASYNC_TCP_RUNNING_CORE=0) and WiFi share this core.
+//
+// Everything that crosses between them goes over SPSC queues (spsc_queue.h):
+// write jobs control -> I/O, samples and AC state changes control -> I/O.
+// Write jobs from any other task share one more queue behind a mutex. The
+// rule set is swapped by pointer (rule_program.h).
+
+const int CONTROL_TASK_CORE = 1;
+const int IO_TASK_CORE = 0;
+const uint32_t CONTROL_TASK_STACK = 8192;
+const uint32_t IO_TASK_STACK = 6144;
+const int CONTROL_TASK_PRIORITY = 2;       // Above the Arduino loop task it replaces
+const int IO_TASK_PRIORITY = 1;
+const unsigned long IO_TASK_IDLE_WAKE = 1000;  // ms; drain telemetry at least this often
+const unsigned long SHUTDOWN_FLUSH_TIMEOUT = 3000;  // ms; esp_restart() waits at most this long
+
+void startIoTask();        // Early in setup(), once SPIFFS is mounted
+void startControlTask();   // At the end of setup(); loop() is no longer used
+void wakeIoTask();
+// Run `fn` on the control task, between scheduler passes, and wait for it.
+// Runs it in place when called from the control task or before that task is
+// started. Returns false if it did not finish within `timeoutMs` (it may
+// still run later) or another request is already waiting.
+bool runOnControlTask(void (*fn)(), unsigned long timeoutMs);
+
+#endif
@@ -0,0 +1,114 @@
+// telemetry.cpp
+#include <telemetry.h>
+#include <spsc_queue.h>
+#include <seqlock.h>
+#include <tasks.h>
+#include <atomic>
+
+enum TelemetryEventType : uint8_t {
+    TELEMETRY_SAMPLE,
+    TELEMETRY_AC_STATE
+};
+
+struct TelemetryEvent {
+    uint8_t type;
+    TelemetrySample sample;
+    TelemetryACState ac;
+};
+
+static SpscQueue<TelemetryEvent, TELEMETRY_QUEUE_SIZE> events;
+static std::atomic<uint32_t> dropped(0);
+
+// Written by the I/O task, copied by web handlers (both on core 0)
+static TelemetryStatus status = {};
+#ifdef ESP32
+static portMUX_TYPE statusLock = portMUX_INITIALIZER_UNLOCKED;
+#define LOCK_STATUS() portENTER_CRITICAL(&statusLock)
+#define UNLOCK_STATUS() portEXIT_CRITICAL(&statusLock)
+#else
+#define LOCK_STATUS()
+#define UNLOCK_STATUS()
+#endif
+
+static Seqlock<TemperatureData> liveTemperature;
+static Seqlock<TelemetryACState> liveACState;
+
+struct TimedRollup {
+    uint32_t timestamp;
+    SampleRollup rollup;
+};
+static Seqlock<TimedRollup> liveRollup;
+
+static void copyACState(TelemetryACState& out, uint32_t timestamp, const ACState& state) {
+    out.timestamp = timestamp;
+    out.is_on = state.is_on;
+    out.current_temp = state.current_temp;
+    strncpy(out.mode, state.mode.c_str(), sizeof(out.mode) - 1);
+    out.mode[sizeof(out.mode) - 1] = 0;
+    out.fan_on = state.fan_on;
+}
+
+void publishLiveState(uint32_t timestamp, const TemperatureData& temperature, const ACState& state) {
+    TelemetryACState ac = {};
+    copyACState(ac, timestamp, state);
+    liveTemperature.write(temperature);
+    liveACState.write(ac);
+}
+
+void publishRollup(uint32_t timestamp, const SampleRollup& rollup) {
+    TimedRollup timed = {timestamp, rollup};
+    liveRollup.write(timed);
+}
+
+void getLiveState(LiveState& live) {
+    live.temperature = liveTemperature.read();
+    live.ac = liveACState.read();
+    TimedRollup timed = liveRollup.read();
+    live.rollupTimestamp = timed.timestamp;
+    live.rollup = timed.rollup;
+    live.version = liveTemperature.version() + liveACState.version() + liveRollup.version();
+}
+
+static void publish(const TelemetryEvent& event) {
+    if (!events.push(event)) dropped++;
+}
+
+void publishSample(uint32_t timestamp, float temperature, float humidity, float feelsLike) {
+    TelemetryEvent event = {};
+    event.type = TELEMETRY_SAMPLE;
+    event.sample = {timestamp, temperature, humidity, feelsLike};
+    publish(event);
+}
+
+void publishACState(uint32_t timestamp, const ACState& state) {
+    TelemetryEvent event = {};
+    event.type = TELEMETRY_AC_STATE;
+    copyACState(event.ac, timestamp, state);
+    publish(event);
+    wakeIoTask(); // State changes are worth showing straight away
+}
+
+void serviceTelemetry() {
+    TelemetryEvent event;
+    while (events.pop(event)) {
+        LOCK_STATUS();
+        if (event.type == TELEMETRY_SAMPLE) {
+            status.sample = event.sample;
+        } else {
+            status.ac = event.ac;
+            if (status.changeCount == TELEMETRY_HISTORY) {
+                memmove(status.changes, status.changes + 1, sizeof(status.changes) - sizeof(status.changes[0]));
+                status.changeCount--;
+            }
+            status.changes[status.changeCount++] = event.ac;
+        }
+        UNLOCK_STATUS();
+    }
+}
+
+void getTelemetryStatus(TelemetryStatus& out) {
+    LOCK_STATUS();
+    out = status;
+    UNLOCK_STATUS();
+    out.dropped = dropped.load();
+}
@@ -0,0 +1,61 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <rules.h>
+#include <accumulator.h>
+
+// Samples and AC state changes published by the control task for the web
+// side. The control task pushes events onto an SPSC queue and never waits;
+// the I/O task drains it into a small status record that web handlers copy.
+
+const size_t TELEMETRY_QUEUE_SIZE = 32;   // Must be a power of two
+const size_t TELEMETRY_HISTORY = 16;      // AC state changes kept for the web
+
+struct TelemetrySample {
+  uint32_t timestamp;
+  float temperature;
+  float humidity;
+  float feels_like;
+};
+
+struct TelemetryACState {
+  uint32_t timestamp;
+  bool is_on;
+  float current_temp;
+  char mode[16];
+  bool fan_on;
+};
+
+struct TelemetryStatus {
+  TelemetrySample sample;                          // Latest sample (timestamp 0 if none yet)
+  TelemetryACState ac;                             // State last sent to the AC
+  TelemetryACState changes[TELEMETRY_HISTORY];     // Recent AC state changes, oldest first
+  size_t changeCount;
+  uint32_t dropped;                                // Events lost because the queue was full
+};
+
+// The live temperature_data and ac_state, published by the control task
+// through seqlocks so web handlers can read them without locking
+struct LiveState {
+  TemperatureData temperature;
+  TelemetryACState ac;                             // Desired state (what the rules want)
+  uint32_t rollupTimestamp;                        // Statistics behind the last 5-minute point
+  SampleRollup rollup;
+  uint32_t version;                                // Changes whenever either is republished
+};
+
+// Control task
+void publishLiveState(uint32_t timestamp, const TemperatureData& temperature, const ACState& state);
+void publishRollup(uint32_t timestamp, const SampleRollup& rollup);
+void publishSample(uint32_t timestamp, float temperature, float humidity, float feelsLike);
+void publishACState(uint32_t timestamp, const ACState& state);
+
+// I/O task
+void serviceTelemetry();
+
+// Web handlers
+void getTelemetryStatus(TelemetryStatus& status);
+void getLiveState(LiveState& live);
+
+#endif
@@ -0,0 +1,34 @@
+#include "timezones.h"
+#include "tz_table.h"
+#include <string.h>
+
+const char* findPosixTz(const char* zone) {
+    if (zone == nullptr) return nullptr;
+
+    // TZ_ENTRIES is in strcmp() order
+    size_t low = 0;
+    size_t high = TZ_ZONE_COUNT;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(zone, TZ_NAMES + TZ_ENTRIES[mid].name);
+        if (cmp == 0) return TZ_RULES + TZ_ENTRIES[mid].rule;
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+size_t getTimezoneCount() {
+    return TZ_ZONE_COUNT;
+}
+
+const char* getTimezoneName(size_t index) {
+    return index < TZ_ZONE_COUNT ? TZ_NAMES + TZ_ENTRIES[index].name : nullptr;
+}
+
+const char* getTimezoneRule(size_t index) {
+    return index < TZ_ZONE_COUNT ? TZ_RULES + TZ_ENTRIES[index].rule : nullptr;
+}
@@ -0,0 +1,14 @@
+#ifndef TIMEZONES_H
+#define TIMEZONES_H
+
+#include <stddef.h>
+
+// IANA zone names to POSIX TZ strings, from the table generated out of
+// tools/tz/zones.csv (see tools/tz/gen_tz_table.py). Everything returned
+// points into flash; lookups don't allocate.
+const char* findPosixTz(const char* zone);     // nullptr if the zone is unknown
+size_t getTimezoneCount();
+const char* getTimezoneName(size_t index);     // Sorted; nullptr past the end
+const char* getTimezoneRule(size_t index);
+
+#endif
@@ -0,0 +1,1255 @@
+// tz_table.h - generated by tools/tz/gen_tz_table.py from tools/tz/zones.csv; do not edit
+// tzdata 2025b, 568 zones, 94 distinct rules, 12342 bytes of flash
+#ifndef TZ_TABLE_H
+#define TZ_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct TzEntry {
+    uint16_t name;               // Offset into TZ_NAMES
+    uint16_t rule;               // Offset into TZ_RULES
+};
+
+// Zone names, NUL separated, in strcmp() order
+constexpr char TZ_NAMES[] =
+    "Africa/Abidjan\0"
+    "Africa/Accra\0"
+    "Africa/Addis_Ababa\0"
+    "Africa/Algiers\0"
+    "Africa/Asmara\0"
+    "Africa/Asmera\0"
+    "Africa/Bamako\0"
+    "Africa/Bangui\0"
+    "Africa/Banjul\0"
+    "Africa/Bissau\0"
+    "Africa/Blantyre\0"
+    "Africa/Brazzaville\0"
+    "Africa/Bujumbura\0"
+    "Africa/Cairo\0"
+    "Africa/Casablanca\0"
+    "Africa/Ceuta\0"
+    "Africa/Conakry\0"
+    "Africa/Dakar\0"
+    "Africa/Dar_es_Salaam\0"
+    "Africa/Djibouti\0"
+    "Africa/Douala\0"
+    "Africa/El_Aaiun\0"
+    "Africa/Freetown\0"
+    "Africa/Gaborone\0"
+    "Africa/Harare\0"
+    "Africa/Johannesburg\0"
+    "Africa/Juba\0"
+    "Africa/Kampala\0"
+    "Africa/Khartoum\0"
+    "Africa/Kigali\0"
+    "Africa/Kinshasa\0"
+    "Africa/Lagos\0"
+    "Africa/Libreville\0"
+    "Africa/Lome\0"
+    "Africa/Luanda\0"
+    "Africa/Lubumbashi\0"
+    "Africa/Lusaka\0"
+    "Africa/Malabo\0"
+    "Africa/Maputo\0"
+    "Africa/Maseru\0"
+    "Africa/Mbabane\0"
+    "Africa/Mogadishu\0"
+    "Africa/Monrovia\0"
+    "Africa/Nairobi\0"
+    "Africa/Ndjamena\0"
+    "Africa/Niamey\0"
+    "Africa/Nouakchott\0"
+    "Africa/Ouagadougou\0"
+    "Africa/Porto-Novo\0"
+    "Africa/Sao_Tome\0"
+    "Africa/Timbuktu\0"
+    "Africa/Tripoli\0"
+    "Africa/Tunis\0"
+    "Africa/Windhoek\0"
+    "America/Adak\0"
+    "America/Anchorage\0"
+    "America/Anguilla\0"
+    "America/Antigua\0"
+    "America/Araguaina\0"
+    "America/Argentina/Buenos_Aires\0"
+    "America/Argentina/Catamarca\0"
+    "America/Argentina/ComodRivadavia\0"
+    "America/Argentina/Cordoba\0"
+    "America/Argentina/Jujuy\0"
+    "America/Argentina/La_Rioja\0"
+    "America/Argentina/Mendoza\0"
+    "America/Argentina/Rio_Gallegos\0"
+    "America/Argentina/Salta\0"
+    "America/Argentina/San_Juan\0"
+    "America/Argentina/San_Luis\0"
+    "America/Argentina/Tucuman\0"
+    "America/Argentina/Ushuaia\0"
+    "America/Aruba\0"
+    "America/Asuncion\0"
+    "America/Atikokan\0"
+    "America/Atka\0"
+    "America/Bahia\0"
+    "America/Bahia_Banderas\0"
+    "America/Barbados\0"
+    "America/Belem\0"
+    "America/Belize\0"
+    "America/Blanc-Sablon\0"
+    "America/Boa_Vista\0"
+    "America/Bogota\0"
+    "America/Boise\0"
+    "America/Buenos_Aires\0"
+    "America/Cambridge_Bay\0"
+    "America/Campo_Grande\0"
+    "America/Cancun\0"
+    "America/Caracas\0"
+    "America/Catamarca\0"
+    "America/Cayenne\0"
+    "America/Cayman\0"
+    "America/Chicago\0"
+    "America/Chihuahua\0"
+    "America/Ciudad_Juarez\0"
+    "America/Coral_Harbour\0"
+    "America/Cordoba\0"
+    "America/Costa_Rica\0"
+    "America/Coyhaique\0"
+    "America/Creston\0"
+    "America/Cuiaba\0"
+    "America/Curacao\0"
+    "America/Danmarkshavn\0"
+    "America/Dawson\0"
+    "America/Dawson_Creek\0"
+    "America/Denver\0"
+    "America/Detroit\0"
+    "America/Dominica\0"
+    "America/Edmonton\0"
+    "America/Eirunepe\0"
+    "America/El_Salvador\0"
+    "America/Ensenada\0"
+    "America/Fort_Nelson\0"
+    "America/Fort_Wayne\0"
+    "America/Fortaleza\0"
+    "America/Glace_Bay\0"
+    "America/Godthab\0"
+    "America/Goose_Bay\0"
+    "America/Grand_Turk\0"
+    "America/Grenada\0"
+    "America/Guadeloupe\0"
+    "America/Guatemala\0"
+    "America/Guayaquil\0"
+    "America/Guyana\0"
+    "America/Halifax\0"
+    "America/Havana\0"
+    "America/Hermosillo\0"
+    "America/Indiana/Indianapolis\0"
+    "America/Indiana/Knox\0"
+    "America/Indiana/Marengo\0"
+    "America/Indiana/Petersburg\0"
+    "America/Indiana/Tell_City\0"
+    "America/Indiana/Vevay\0"
+    "America/Indiana/Vincennes\0"
+    "America/Indiana/Winamac\0"
+    "America/Indianapolis\0"
+    "America/Inuvik\0"
+    "America/Iqaluit\0"
+    "America/Jamaica\0"
+    "America/Jujuy\0"
+    "America/Juneau\0"
+    "America/Kentucky/Louisville\0"
+    "America/Kentucky/Monticello\0"
+    "America/Knox_IN\0"
+    "America/Kralendijk\0"
+    "America/La_Paz\0"
+    "America/Lima\0"
+    "America/Los_Angeles\0"
+    "America/Louisville\0"
+    "America/Lower_Princes\0"
+    "America/Maceio\0"
+    "America/Managua\0"
+    "America/Manaus\0"
+    "America/Marigot\0"
+    "America/Martinique\0"
+    "America/Matamoros\0"
+    "America/Mazatlan\0"
+    "America/Mendoza\0"
+    "America/Menominee\0"
+    "America/Merida\0"
+    "America/Metlakatla\0"
+    "America/Mexico_City\0"
+    "America/Miquelon\0"
+    "America/Moncton\0"
+    "America/Monterrey\0"
+    "America/Montevideo\0"
+    "America/Montreal\0"
+    "America/Montserrat\0"
+    "America/Nassau\0"
+    "America/New_York\0"
+    "America/Nipigon\0"
+    "America/Nome\0"
+    "America/Noronha\0"
+    "America/North_Dakota/Beulah\0"
+    "America/North_Dakota/Center\0"
+    "America/North_Dakota/New_Salem\0"
+    "America/Nuuk\0"
+    "America/Ojinaga\0"
+    "America/Panama\0"
+    "America/Pangnirtung\0"
+    "America/Paramaribo\0"
+    "America/Phoenix\0"
+    "America/Port-au-Prince\0"
+    "America/Port_of_Spain\0"
+    "America/Porto_Acre\0"
+    "America/Porto_Velho\0"
+    "America/Puerto_Rico\0"
+    "America/Punta_Arenas\0"
+    "America/Rainy_River\0"
+    "America/Rankin_Inlet\0"
+    "America/Recife\0"
+    "America/Regina\0"
+    "America/Resolute\0"
+    "America/Rio_Branco\0"
+    "America/Rosario\0"
+    "America/Santa_Isabel\0"
+    "America/Santarem\0"
+    "America/Santiago\0"
+    "America/Santo_Domingo\0"
+    "America/Sao_Paulo\0"
+    "America/Scoresbysund\0"
+    "America/Shiprock\0"
+    "America/Sitka\0"
+    "America/St_Barthelemy\0"
+    "America/St_Johns\0"
+    "America/St_Kitts\0"
+    "America/St_Lucia\0"
+    "America/St_Thomas\0"
+    "America/St_Vincent\0"
+    "America/Swift_Current\0"
+    "America/Tegucigalpa\0"
+    "America/Thule\0"
+    "America/Thunder_Bay\0"
+    "America/Tijuana\0"
+    "America/Toronto\0"
+    "America/Tortola\0"
+    "America/Vancouver\0"
+    "America/Virgin\0"
+    "America/Whitehorse\0"
+    "America/Winnipeg\0"
+    "America/Yakutat\0"
+    "America/Yellowknife\0"
+    "Antarctica/Casey\0"
+    "Antarctica/Davis\0"
+    "Antarctica/DumontDUrville\0"
+    "Antarctica/Macquarie\0"
+    "Antarctica/Mawson\0"
+    "Antarctica/McMurdo\0"
+    "Antarctica/Palmer\0"
+    "Antarctica/Rothera\0"
+    "Antarctica/South_Pole\0"
+    "Antarctica/Syowa\0"
+    "Antarctica/Troll\0"
+    "Antarctica/Vostok\0"
+    "Arctic/Longyearbyen\0"
+    "Asia/Aden\0"
+    "Asia/Almaty\0"
+    "Asia/Amman\0"
+    "Asia/Anadyr\0"
+    "Asia/Aqtau\0"
+    "Asia/Aqtobe\0"
+    "Asia/Ashgabat\0"
+    "Asia/Ashkhabad\0"
+    "Asia/Atyrau\0"
+    "Asia/Baghdad\0"
+    "Asia/Bahrain\0"
+    "Asia/Baku\0"
+    "Asia/Bangkok\0"
+    "Asia/Barnaul\0"
+    "Asia/Beirut\0"
+    "Asia/Bishkek\0"
+    "Asia/Brunei\0"
+    "Asia/Calcutta\0"
+    "Asia/Chita\0"
+    "Asia/Choibalsan\0"
+    "Asia/Chongqing\0"
+    "Asia/Chungking\0"
+    "Asia/Colombo\0"
+    "Asia/Dacca\0"
+    "Asia/Damascus\0"
+    "Asia/Dhaka\0"
+    "Asia/Dili\0"
+    "Asia/Dubai\0"
+    "Asia/Dushanbe\0"
+    "Asia/Famagusta\0"
+    "Asia/Gaza\0"
+    "Asia/Harbin\0"
+    "Asia/Hebron\0"
+    "Asia/Ho_Chi_Minh\0"
+    "Asia/Hong_Kong\0"
+    "Asia/Hovd\0"
+    "Asia/Irkutsk\0"
+    "Asia/Istanbul\0"
+    "Asia/Jakarta\0"
+    "Asia/Jayapura\0"
+    "Asia/Jerusalem\0"
+    "Asia/Kabul\0"
+    "Asia/Kamchatka\0"
+    "Asia/Karachi\0"
+    "Asia/Kashgar\0"
+    "Asia/Kathmandu\0"
+    "Asia/Katmandu\0"
+    "Asia/Khandyga\0"
+    "Asia/Kolkata\0"
+    "Asia/Krasnoyarsk\0"
+    "Asia/Kuala_Lumpur\0"
+    "Asia/Kuching\0"
+    "Asia/Kuwait\0"
+    "Asia/Macao\0"
+    "Asia/Macau\0"
+    "Asia/Magadan\0"
+    "Asia/Makassar\0"
+    "Asia/Manila\0"
+    "Asia/Muscat\0"
+    "Asia/Nicosia\0"
+    "Asia/Novokuznetsk\0"
+    "Asia/Novosibirsk\0"
+    "Asia/Omsk\0"
+    "Asia/Oral\0"
+    "Asia/Phnom_Penh\0"
+    "Asia/Pontianak\0"
+    "Asia/Pyongyang\0"
+    "Asia/Qatar\0"
+    "Asia/Qostanay\0"
+    "Asia/Qyzylorda\0"
+    "Asia/Rangoon\0"
+    "Asia/Riyadh\0"
+    "Asia/Saigon\0"
+    "Asia/Sakhalin\0"
+    "Asia/Samarkand\0"
+    "Asia/Seoul\0"
+    "Asia/Shanghai\0"
+    "Asia/Singapore\0"
+    "Asia/Srednekolymsk\0"
+    "Asia/Taipei\0"
+    "Asia/Tashkent\0"
+    "Asia/Tbilisi\0"
+    "Asia/Tehran\0"
+    "Asia/Tel_Aviv\0"
+    "Asia/Thimbu\0"
+    "Asia/Thimphu\0"
+    "Asia/Tokyo\0"
+    "Asia/Tomsk\0"
+    "Asia/Ujung_Pandang\0"
+    "Asia/Ulaanbaatar\0"
+    "Asia/Ulan_Bator\0"
+    "Asia/Urumqi\0"
+    "Asia/Ust-Nera\0"
+    "Asia/Vientiane\0"
+    "Asia/Vladivostok\0"
+    "Asia/Yakutsk\0"
+    "Asia/Yangon\0"
+    "Asia/Yekaterinburg\0"
+    "Asia/Yerevan\0"
+    "Atlantic/Azores\0"
+    "Atlantic/Bermuda\0"
+    "Atlantic/Canary\0"
+    "Atlantic/Cape_Verde\0"
+    "Atlantic/Faeroe\0"
+    "Atlantic/Faroe\0"
+    "Atlantic/Jan_Mayen\0"
+    "Atlantic/Madeira\0"
+    "Atlantic/Reykjavik\0"
+    "Atlantic/South_Georgia\0"
+    "Atlantic/St_Helena\0"
+    "Atlantic/Stanley\0"
+    "Australia/ACT\0"
+    "Australia/Adelaide\0"
+    "Australia/Brisbane\0"
+    "Australia/Broken_Hill\0"
+    "Australia/Canberra\0"
+    "Australia/Currie\0"
+    "Australia/Darwin\0"
+    "Australia/Eucla\0"
+    "Australia/Hobart\0"
+    "Australia/LHI\0"
+    "Australia/Lindeman\0"
+    "Australia/Lord_Howe\0"
+    "Australia/Melbourne\0"
+    "Australia/NSW\0"
+    "Australia/North\0"
+    "Australia/Perth\0"
+    "Australia/Queensland\0"
+    "Australia/South\0"
+    "Australia/Sydney\0"
+    "Australia/Tasmania\0"
+    "Australia/Victoria\0"
+    "Australia/West\0"
+    "Australia/Yancowinna\0"
+    "CET\0"
+    "CST6CDT\0"
+    "Cuba\0"
+    "EET\0"
+    "EST\0"
+    "EST5EDT\0"
+    "Egypt\0"
+    "Eire\0"
+    "Etc/GMT\0"
+    "Etc/GMT+0\0"
+    "Etc/GMT+1\0"
+    "Etc/GMT+10\0"
+    "Etc/GMT+11\0"
+    "Etc/GMT+12\0"
+    "Etc/GMT+2\0"
+    "Etc/GMT+3\0"
+    "Etc/GMT+4\0"
+    "Etc/GMT+5\0"
+    "Etc/GMT+6\0"
+    "Etc/GMT+7\0"
+    "Etc/GMT+8\0"
+    "Etc/GMT+9\0"
+    "Etc/GMT-0\0"
+    "Etc/GMT-1\0"
+    "Etc/GMT-10\0"
+    "Etc/GMT-11\0"
+    "Etc/GMT-12\0"
+    "Etc/GMT-13\0"
+    "Etc/GMT-14\0"
+    "Etc/GMT-2\0"
+    "Etc/GMT-3\0"
+    "Etc/GMT-4\0"
+    "Etc/GMT-5\0"
+    "Etc/GMT-6\0"
+    "Etc/GMT-7\0"
+    "Etc/GMT-8\0"
+    "Etc/GMT-9\0"
+    "Etc/GMT0\0"
+    "Etc/Greenwich\0"
+    "Etc/UCT\0"
+    "Etc/UTC\0"
+    "Etc/Universal\0"
+    "Etc/Zulu\0"
+    "Europe/Amsterdam\0"
+    "Europe/Andorra\0"
+    "Europe/Astrakhan\0"
+    "Europe/Athens\0"
+    "Europe/Belfast\0"
+    "Europe/Belgrade\0"
+    "Europe/Berlin\0"
+    "Europe/Bratislava\0"
+    "Europe/Brussels\0"
+    "Europe/Bucharest\0"
+    "Europe/Budapest\0"
+    "Europe/Busingen\0"
+    "Europe/Chisinau\0"
+    "Europe/Copenhagen\0"
+    "Europe/Dublin\0"
+    "Europe/Gibraltar\0"
+    "Europe/Guernsey\0"
+    "Europe/Helsinki\0"
+    "Europe/Isle_of_Man\0"
+    "Europe/Istanbul\0"
+    "Europe/Jersey\0"
+    "Europe/Kaliningrad\0"
+    "Europe/Kiev\0"
+    "Europe/Kirov\0"
+    "Europe/Kyiv\0"
+    "Europe/Lisbon\0"
+    "Europe/Ljubljana\0"
+    "Europe/London\0"
+    "Europe/Luxembourg\0"
+    "Europe/Madrid\0"
+    "Europe/Malta\0"
+    "Europe/Mariehamn\0"
+    "Europe/Minsk\0"
+    "Europe/Monaco\0"
+    "Europe/Moscow\0"
+    "Europe/Nicosia\0"
+    "Europe/Oslo\0"
+    "Europe/Paris\0"
+    "Europe/Podgorica\0"
+    "Europe/Prague\0"
+    "Europe/Riga\0"
+    "Europe/Rome\0"
+    "Europe/Samara\0"
+    "Europe/San_Marino\0"
+    "Europe/Sarajevo\0"
+    "Europe/Saratov\0"
+    "Europe/Simferopol\0"
+    "Europe/Skopje\0"
+    "Europe/Sofia\0"
+    "Europe/Stockholm\0"
+    "Europe/Tallinn\0"
+    "Europe/Tirane\0"
+    "Europe/Tiraspol\0"
+    "Europe/Ulyanovsk\0"
+    "Europe/Uzhgorod\0"
+    "Europe/Vaduz\0"
+    "Europe/Vatican\0"
+    "Europe/Vienna\0"
+    "Europe/Vilnius\0"
+    "Europe/Volgograd\0"
+    "Europe/Warsaw\0"
+    "Europe/Zagreb\0"
+    "Europe/Zaporozhye\0"
+    "Europe/Zurich\0"
+    "GB\0"
+    "GB-Eire\0"
+    "GMT\0"
+    "GMT+0\0"
+    "GMT-0\0"
+    "GMT0\0"
+    "Greenwich\0"
+    "HST\0"
+    "Hongkong\0"
+    "Iceland\0"
+    "Indian/Antananarivo\0"
+    "Indian/Chagos\0"
+    "Indian/Christmas\0"
+    "Indian/Cocos\0"
+    "Indian/Comoro\0"
+    "Indian/Kerguelen\0"
+    "Indian/Mahe\0"
+    "Indian/Maldives\0"
+    "Indian/Mauritius\0"
+    "Indian/Mayotte\0"
+    "Indian/Reunion\0"
+    "Iran\0"
+    "Israel\0"
+    "Jamaica\0"
+    "Japan\0"
+    "Kwajalein\0"
+    "Libya\0"
+    "MET\0"
+    "MST\0"
+    "MST7MDT\0"
+    "NZ\0"
+    "NZ-CHAT\0"
+    "Navajo\0"
+    "PRC\0"
+    "PST8PDT\0"
+    "Pacific/Apia\0"
+    "Pacific/Auckland\0"
+    "Pacific/Bougainville\0"
+    "Pacific/Chatham\0"
+    "Pacific/Chuuk\0"
+    "Pacific/Easter\0"
+    "Pacific/Efate\0"
+    "Pacific/Enderbury\0"
+    "Pacific/Fakaofo\0"
+    "Pacific/Fiji\0"
+    "Pacific/Funafuti\0"
+    "Pacific/Galapagos\0"
+    "Pacific/Gambier\0"
+    "Pacific/Guadalcanal\0"
+    "Pacific/Guam\0"
+    "Pacific/Honolulu\0"
+    "Pacific/Johnston\0"
+    "Pacific/Kanton\0"
+    "Pacific/Kiritimati\0"
+    "Pacific/Kosrae\0"
+    "Pacific/Kwajalein\0"
+    "Pacific/Majuro\0"
+    "Pacific/Marquesas\0"
+    "Pacific/Midway\0"
+    "Pacific/Nauru\0"
+    "Pacific/Niue\0"
+    "Pacific/Norfolk\0"
+    "Pacific/Noumea\0"
+    "Pacific/Pago_Pago\0"
+    "Pacific/Palau\0"
+    "Pacific/Pitcairn\0"
+    "Pacific/Pohnpei\0"
+    "Pacific/Ponape\0"
+    "Pacific/Port_Moresby\0"
+    "Pacific/Rarotonga\0"
+    "Pacific/Saipan\0"
+    "Pacific/Samoa\0"
+    "Pacific/Tahiti\0"
+    "Pacific/Tarawa\0"
+    "Pacific/Tongatapu\0"
+    "Pacific/Truk\0"
+    "Pacific/Wake\0"
+    "Pacific/Wallis\0"
+    "Pacific/Yap\0"
+    "Poland\0"
+    "Portugal\0"
+    "ROC\0"
+    "ROK\0"
+    "Singapore\0"
+    "Turkey\0"
+    "UCT\0"
+    "UTC\0"
+    "Universal\0"
+    "W-SU\0"
+    "WET\0"
+    "Zulu\0";
+
+// POSIX TZ strings, each stored once
+constexpr char TZ_RULES[] =
+    "<+00>0<+02>-2,M3.5.0/1,M10.5.0/3\0"
+    "<+01>-1\0"
+    "<+02>-2\0"
+    "<+0330>-3:30\0"
+    "<+03>-3\0"
+    "<+0430>-4:30\0"
+    "<+04>-4\0"
+    "<+0530>-5:30\0"
+    "<+0545>-5:45\0"
+    "<+05>-5\0"
+    "<+0630>-6:30\0"
+    "<+06>-6\0"
+    "<+07>-7\0"
+    "<+0845>-8:45\0"
+    "<+08>-8\0"
+    "<+09>-9\0"
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0\0"
+    "<+10>-10\0"
+    "<+11>-11\0"
+    "<+11>-11<+12>,M10.1.0,M4.1.0/3\0"
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45\0"
+    "<+12>-12\0"
+    "<+13>-13\0"
+    "<+14>-14\0"
+    "<-01>1\0"
+    "<-01>1<+00>,M3.5.0/0,M10.5.0/1\0"
+    "<-02>2\0"
+    "<-02>2<-01>,M3.5.0/-1,M10.5.0/0\0"
+    "<-03>3\0"
+    "<-03>3<-02>,M3.2.0,M11.1.0\0"
+    "<-04>4\0"
+    "<-04>4<-03>,M9.1.6/24,M4.1.6/24\0"
+    "<-05>5\0"
+    "<-06>6\0"
+    "<-06>6<-05>,M9.1.6/22,M4.1.6/22\0"
+    "<-07>7\0"
+    "<-08>8\0"
+    "<-0930>9:30\0"
+    "<-09>9\0"
+    "<-10>10\0"
+    "<-11>11\0"
+    "<-12>12\0"
+    "ACST-9:30\0"
+    "ACST-9:30ACDT,M10.1.0,M4.1.0/3\0"
+    "AEST-10\0"
+    "AEST-10AEDT,M10.1.0,M4.1.0/3\0"
+    "AKST9AKDT,M3.2.0,M11.1.0\0"
+    "AST4\0"
+    "AST4ADT,M3.2.0,M11.1.0\0"
+    "AWST-8\0"
+    "CAT-2\0"
+    "CET-1\0"
+    "CET-1CEST,M3.5.0,M10.5.0/3\0"
+    "CST-8\0"
+    "CST5CDT,M3.2.0/0,M11.1.0/1\0"
+    "CST6\0"
+    "CST6CDT,M3.2.0,M11.1.0\0"
+    "ChST-10\0"
+    "EAT-3\0"
+    "EET-2\0"
+    "EET-2EEST,M3.4.4/50,M10.4.4/50\0"
+    "EET-2EEST,M3.5.0,M10.5.0/3\0"
+    "EET-2EEST,M3.5.0/0,M10.5.0/0\0"
+    "EET-2EEST,M3.5.0/3,M10.5.0/4\0"
+    "EET-2EEST,M4.5.5/0,M10.5.4/24\0"
+    "EST5\0"
+    "EST5EDT,M3.2.0,M11.1.0\0"
+    "GMT0\0"
+    "GMT0BST,M3.5.0/1,M10.5.0\0"
+    "HKT-8\0"
+    "HST10\0"
+    "HST10HDT,M3.2.0,M11.1.0\0"
+    "IST-1GMT0,M10.5.0,M3.5.0/1\0"
+    "IST-2IDT,M3.4.4/26,M10.5.0\0"
+    "IST-5:30\0"
+    "JST-9\0"
+    "KST-9\0"
+    "MET-1MEST,M3.5.0,M10.5.0/3\0"
+    "MSK-3\0"
+    "MST7\0"
+    "MST7MDT,M3.2.0,M11.1.0\0"
+    "NST3:30NDT,M3.2.0,M11.1.0\0"
+    "NZST-12NZDT,M9.5.0,M4.1.0/3\0"
+    "PKT-5\0"
+    "PST-8\0"
+    "PST8PDT,M3.2.0,M11.1.0\0"
+    "SAST-2\0"
+    "SST11\0"
+    "UTC0\0"
+    "WAT-1\0"
+    "WET0WEST,M3.5.0/1,M10.5.0\0"
+    "WIB-7\0"
+    "WIT-9\0"
+    "WITA-8\0";
+
+constexpr TzEntry TZ_ENTRIES[] = {
+    {0, 1026},
+    {15, 1026},
+    {28, 840},
+    {47, 738},
+    {62, 840},
+    {76, 840},
+    {90, 1026},
+    {104, 1335},
+    {118, 1026},
+    {132, 1026},
+    {146, 732},
+    {162, 1335},
+    {181, 732},
+    {198, 968},
+    {211, 33},
+    {229, 744},
+    {242, 1026},
+    {257, 1026},
+    {270, 840},
+    {291, 840},
+    {307, 1335},
+    {321, 33},
+    {337, 1026},
+    {353, 732},
+    {369, 732},
+    {383, 1317},
+    {403, 732},
+    {415, 840},
+    {430, 732},
+    {446, 732},
+    {460, 1335},
+    {476, 1335},
+    {489, 1335},
+    {507, 1026},
+    {519, 1335},
+    {533, 732},
+    {551, 732},
+    {565, 1335},
+    {579, 732},
+    {593, 1317},
+    {607, 1317},
+    {622, 840},
+    {639, 1026},
+    {655, 840},
+    {670, 1335},
+    {686, 1335},
+    {700, 1026},
+    {718, 1026},
+    {737, 1335},
+    {755, 1026},
+    {771, 1026},
+    {787, 846},
+    {802, 738},
+    {815, 732},
+    {831, 1068},
+    {844, 672},
+    {862, 697},
+    {879, 697},
+    {895, 418},
+    {913, 418},
+    {944, 418},
+    {972, 418},
+    {1005, 418},
+    {1031, 418},
+    {1055, 418},
+    {1082, 418},
+    {1108, 418},
+    {1139, 418},
+    {1163, 418},
+    {1190, 418},
+    {1217, 418},
+    {1243, 418},
+    {1269, 697},
+    {1283, 418},
+    {1300, 998},
+    {1317, 1068},
+    {1330, 418},
+    {1344, 804},
+    {1367, 697},
+    {1384, 418},
+    {1398, 804},
+    {1413, 697},
+    {1434, 452},
+    {1452, 491},
+    {1467, 1205},
+    {1481, 418},
+    {1502, 1205},
+    {1524, 452},
+    {1545, 998},
+    {1560, 452},
+    {1576, 418},
+    {1594, 418},
+    {1610, 998},
+    {1625, 809},
+    {1641, 804},
+    {1659, 1205},
+    {1681, 998},
+    {1703, 418},
+    {1719, 804},
+    {1738, 418},
+    {1756, 1200},
+    {1772, 452},
+    {1787, 697},
+    {1803, 1026},
+    {1824, 1200},
+    {1839, 1200},
+    {1860, 1205},
+    {1875, 1003},
+    {1891, 697},
+    {1908, 1205},
+    {1925, 491},
+    {1942, 804},
+    {1962, 1294},
+    {1979, 1200},
+    {1999, 1003},
+    {2018, 418},
+    {2036, 702},
+    {2054, 386},
+    {2070, 702},
+    {2088, 1003},
+    {2107, 697},
+    {2123, 697},
+    {2142, 804},
+    {2160, 491},
+    {2178, 452},
+    {2193, 702},
+    {2209, 777},
+    {2224, 1200},
+    {2243, 1003},
+    {2272, 809},
+    {2293, 1003},
+    {2317, 1003},
+    {2344, 809},
+    {2370, 1003},
+    {2392, 1003},
+    {2418, 1003},
+    {2442, 1003},
+    {2463, 1205},
+    {2478, 1003},
+    {2494, 998},
+    {2510, 418},
+    {2524, 672},
+    {2539, 1003},
+    {2567, 1003},
+    {2595, 809},
+    {2611, 697},
+    {2630, 452},
+    {2645, 491},
+    {2658, 1294},
+    {2678, 1003},
+    {2697, 697},
+    {2719, 418},
+    {2734, 804},
+    {2750, 452},
+    {2765, 697},
+    {2781, 697},
+    {2800, 809},
+    {2818, 1200},
+    {2835, 418},
+    {2851, 809},
+    {2869, 804},
+    {2884, 672},
+    {2903, 804},
+    {2923, 425},
+    {2940, 702},
+    {2956, 804},
+    {2974, 418},
+    {2993, 1003},
+    {3010, 697},
+    {3029, 1003},
+    {3044, 1003},
+    {3061, 1003},
+    {3077, 672},
+    {3090, 379},
+    {3106, 809},
+    {3134, 809},
+    {3162, 809},
+    {3193, 386},
+    {3206, 809},
+    {3222, 998},
+    {3237, 1003},
+    {3257, 418},
+    {3276, 1200},
+    {3292, 1003},
+    {3315, 697},
+    {3337, 491},
+    {3356, 452},
+    {3376, 697},
+    {3396, 418},
+    {3417, 809},
+    {3437, 809},
+    {3458, 418},
+    {3473, 804},
+    {3488, 809},
+    {3505, 491},
+    {3524, 418},
+    {3540, 1294},
+    {3561, 418},
+    {3578, 459},
+    {3595, 697},
+    {3617, 418},
+    {3635, 386},
+    {3656, 1205},
+    {3673, 672},
+    {3687, 697},
+    {3709, 1228},
+    {3726, 697},
+    {3743, 697},
+    {3760, 697},
+    {3778, 697},
+    {3797, 804},
+    {3819, 804},
+    {3839, 702},
+    {3853, 1003},
+    {3873, 1294},
+    {3889, 1003},
+    {3905, 697},
+    {3921, 1294},
+    {3939, 697},
+    {3954, 1200},
+    {3973, 809},
+    {3990, 672},
+    {4006, 1205},
+    {4026, 167},
+    {4043, 146},
+    {4060, 220},
+    {4086, 643},
+    {4107, 117},
+    {4125, 1254},
+    {4144, 418},
+    {4162, 418},
+    {4181, 1254},
+    {4203, 62},
+    {4220, 0},
+    {4237, 117},
+    {4255, 744},
+    {4275, 62},
+    {4285, 117},
+    {4297, 62},
+    {4308, 314},
+    {4320, 117},
+    {4331, 117},
+    {4343, 117},
+    {4357, 117},
+    {4372, 117},
+    {4384, 62},
+    {4397, 62},
+    {4410, 83},
+    {4420, 146},
+    {4433, 146},
+    {4446, 910},
+    {4458, 138},
+    {4471, 167},
+    {4483, 1146},
+    {4497, 175},
+    {4508, 167},
+    {4524, 771},
+    {4539, 771},
+    {4554, 91},
+    {4567, 138},
+    {4578, 62},
+    {4592, 138},
+    {4603, 175},
+    {4613, 83},
+    {4624, 117},
+    {4638, 939},
+    {4653, 852},
+    {4663, 771},
+    {4675, 852},
+    {4687, 146},
+    {4704, 1056},
+    {4719, 146},
+    {4729, 167},
+    {4742, 62},
+    {4756, 1367},
+    {4769, 1373},
+    {4783, 1119},
+    {4798, 70},
+    {4809, 314},
+    {4824, 1282},
+    {4837, 138},
+    {4850, 104},
+    {4865, 104},
+    {4879, 175},
+    {4893, 1146},
+    {4906, 146},
+    {4923, 167},
+    {4941, 167},
+    {4954, 62},
+    {4966, 771},
+    {4977, 771},
+    {4988, 229},
+    {5001, 1379},
+    {5015, 1288},
+    {5027, 83},
+    {5039, 939},
+    {5052, 146},
+    {5070, 146},
+    {5087, 138},
+    {5097, 117},
+    {5107, 146},
+    {5123, 1367},
+    {5138, 1161},
+    {5153, 62},
+    {5164, 117},
+    {5178, 117},
+    {5193, 125},
+    {5206, 62},
+    {5218, 146},
+    {5230, 229},
+    {5244, 117},
+    {5259, 1161},
+    {5270, 771},
+    {5284, 167},
+    {5299, 229},
+    {5318, 771},
+    {5330, 117},
+    {5344, 83},
+    {5357, 49},
+    {5369, 1119},
+    {5383, 138},
+    {5395, 138},
+    {5408, 1155},
+    {5419, 146},
+    {5430, 1379},
+    {5449, 167},
+    {5466, 167},
+    {5482, 138},
+    {5494, 220},
+    {5508, 146},
+    {5523, 220},
+    {5540, 175},
+    {5553, 125},
+    {5565, 117},
+    {5584, 83},
+    {5597, 348},
+    {5613, 702},
+    {5630, 1341},
+    {5646, 341},
+    {5666, 1341},
+    {5682, 1341},
+    {5697, 744},
+    {5716, 1341},
+    {5733, 1026},
+    {5752, 379},
+    {5775, 1026},
+    {5794, 418},
+    {5811, 643},
+    {5825, 604},
+    {5844, 635},
+    {5863, 604},
+    {5885, 643},
+    {5904, 643},
+    {5921, 594},
+    {5938, 154},
+    {5954, 643},
+    {5971, 183},
+    {5985, 635},
+    {6004, 183},
+    {6024, 643},
+    {6044, 643},
+    {6058, 594},
+    {6074, 725},
+    {6090, 635},
+    {6111, 604},
+    {6127, 643},
+    {6144, 643},
+    {6163, 643},
+    {6182, 725},
+    {6197, 604},
+    {6218, 744},
+    {6222, 809},
+    {6230, 777},
+    {6235, 939},
+    {6239, 998},
+    {6243, 1003},
+    {6251, 968},
+    {6257, 1092},
+    {6262, 1026},
+    {6270, 1026},
+    {6280, 341},
+    {6290, 570},
+    {6301, 578},
+    {6312, 586},
+    {6323, 379},
+    {6333, 418},
+    {6343, 452},
+    {6353, 491},
+    {6363, 498},
+    {6373, 537},
+    {6383, 544},
+    {6393, 563},
+    {6403, 1026},
+    {6413, 33},
+    {6423, 220},
+    {6434, 229},
+    {6445, 314},
+    {6456, 323},
+    {6467, 332},
+    {6478, 41},
+    {6488, 62},
+    {6498, 83},
+    {6508, 117},
+    {6518, 138},
+    {6528, 146},
+    {6538, 167},
+    {6548, 175},
+    {6558, 1026},
+    {6567, 1026},
+    {6581, 1330},
+    {6589, 1330},
+    {6597, 1330},
+    {6611, 1330},
+    {6620, 744},
+    {6637, 744},
+    {6652, 83},
+    {6669, 939},
+    {6683, 1031},
+    {6698, 744},
+    {6714, 744},
+    {6728, 744},
+    {6746, 744},
+    {6762, 939},
+    {6779, 744},
+    {6795, 744},
+    {6811, 883},
+    {6827, 744},
+    {6845, 1092},
+    {6859, 744},
+    {6876, 1031},
+    {6892, 939},
+    {6908, 1031},
+    {6927, 62},
+    {6943, 1031},
+    {6957, 846},
+    {6976, 939},
+    {6988, 1194},
+    {7001, 939},
+    {7013, 1341},
+    {7027, 744},
+    {7044, 1031},
+    {7058, 744},
+    {7076, 744},
+    {7090, 744},
+    {7103, 939},
+    {7120, 62},
+    {7133, 744},
+    {7147, 1194},
+    {7161, 939},
+    {7176, 744},
+    {7188, 744},
+    {7201, 744},
+    {7218, 744},
+    {7232, 939},
+    {7244, 744},
+    {7256, 83},
+    {7270, 744},
+    {7288, 744},
+    {7304, 83},
+    {7319, 1194},
+    {7337, 744},
+    {7351, 939},
+    {7364, 744},
+    {7381, 939},
+    {7396, 744},
+    {7410, 883},
+    {7426, 83},
+    {7443, 939},
+    {7459, 744},
+    {7472, 744},
+    {7487, 744},
+    {7501, 939},
+    {7516, 1194},
+    {7533, 744},
+    {7547, 744},
+    {7561, 939},
+    {7579, 744},
+    {7593, 1031},
+    {7596, 1031},
+    {7604, 1026},
+    {7608, 1026},
+    {7614, 1026},
+    {7620, 1026},
+    {7625, 1026},
+    {7635, 1062},
+    {7639, 1056},
+    {7648, 1026},
+    {7656, 840},
+    {7676, 138},
+    {7690, 146},
+    {7707, 125},
+    {7720, 840},
+    {7734, 117},
+    {7751, 83},
+    {7763, 117},
+    {7779, 83},
+    {7796, 840},
+    {7811, 83},
+    {7826, 49},
+    {7831, 1119},
+    {7838, 998},
+    {7846, 1155},
+    {7852, 314},
+    {7862, 846},
+    {7868, 1167},
+    {7872, 1200},
+    {7876, 1205},
+    {7884, 1254},
+    {7887, 269},
+    {7895, 1205},
+    {7902, 771},
+    {7906, 1294},
+    {7914, 323},
+    {7927, 1254},
+    {7944, 229},
+    {7965, 269},
+    {7981, 220},
+    {7995, 505},
+    {8010, 229},
+    {8024, 323},
+    {8042, 323},
+    {8058, 314},
+    {8071, 314},
+    {8088, 498},
+    {8106, 563},
+    {8122, 229},
+    {8142, 832},
+    {8155, 1062},
+    {8172, 1062},
+    {8189, 323},
+    {8204, 332},
+    {8223, 229},
+    {8238, 314},
+    {8256, 314},
+    {8271, 551},
+    {8289, 1324},
+    {8304, 314},
+    {8318, 578},
+    {8331, 238},
+    {8347, 229},
+    {8362, 1324},
+    {8380, 175},
+    {8394, 544},
+    {8411, 229},
+    {8427, 229},
+    {8442, 220},
+    {8463, 570},
+    {8481, 832},
+    {8496, 1324},
+    {8510, 570},
+    {8525, 314},
+    {8540, 323},
+    {8558, 220},
+    {8571, 314},
+    {8584, 314},
+    {8599, 220},
+    {8611, 744},
+    {8618, 1341},
+    {8627, 771},
+    {8631, 1161},
+    {8635, 167},
+    {8645, 62},
+    {8652, 1330},
+    {8656, 1330},
+    {8660, 1330},
+    {8670, 1194},
+    {8675, 1341},
+    {8679, 1330}
+};
+
+constexpr size_t TZ_ZONE_COUNT = 568;
+
+#endif
@@ -1,14 +1,23 @@
 #include <ESPAsyncWebServer.h>
 #include <FS.h>
 #include <ArduinoJson.h>
-#include <SPIFFS.h>
+#include <storage.h>
 #include <AsyncTCP.h> // https://randomnerdtutorials.com/esp32-esp8266-web-server-http-authentication/
-#include <base64.h>
 #include <CustomJWT.h>
 #include <data.h>
 #include <config.h>
 #include <web.h>
 #include <rules.h>
+#include <scheduler.h>
+#include <telemetry.h>
+#include <connectivity.h>
+#include <boot_profile.h>
+#include <sensors.h>
+#include <ir_rmt.h>
+#include <persistence.h>
+#include <flash_writer.h>
+#include <timezones.h>
+#include <daily_stats.h>
 
 //Webserver
 AsyncWebServer server(80); // Web server
@@ -49,15 +58,15 @@ bool isValidJWTToken(const String& token) {
   return (result == 0);
 }
 
-// Load HTML file from SPIFFS
+// Load HTML file from flash
 String loadHtmlFile(const char* path) {
-  File file = SPIFFS.open(path, "r");
-  if (!file) {
+  std::vector<uint8_t> contents;
+  if (!storage().read(path, contents)) {
     Serial.printf("Failed to open file %s\n", path);
     return String();
   }
-  String content = file.readString();
-  file.close();
+  String content;
+  content.concat((const char*)contents.data(), contents.size());
   return content;
 }
 
@@ -77,6 +86,25 @@ void servePage(AsyncWebServerRequest *request, const char* pageTitle, const char
   request->send(200, "text/html", html);
 }
 
+// Boot profile as JSON, see boot_profile.h
+void writeBootProfile(const BootProfile& profile, JsonObject out) {
+  out["firmware"] = profile.firmware;
+  out["boot_count"] = profile.bootCount;
+  out["reset_reason"] = profile.resetReason;
+  JsonArray phases = out.createNestedArray("phases");
+  uint32_t start = 0;
+  for (uint32_t i = 0; i < profile.phaseCount; ++i) {
+    const BootPhase& phase = profile.phases[i];
+    JsonObject entry = phases.createNestedObject();
+    entry["name"] = phase.name;
+    entry["at_us"] = phase.endMicros;
+    entry["duration_us"] = phase.endMicros - start;
+    entry["free_heap"] = phase.freeHeap;
+    entry["min_free_heap"] = phase.minFreeHeap;
+    start = phase.endMicros;
+  }
+}
+
 void setupWebServer() {
 
   // Redirect root ("/") to "/dashboard"
@@ -114,46 +142,46 @@ void setupWebServer() {
     servePage(request, "Rules", "/rules_content.html");
   });
 
-  server.serveStatic("/login", SPIFFS, "/login.html");
+  server.serveStatic("/login", storage().filesystem(), "/login.html");
   server.on("/login.html", HTTP_GET, [](AsyncWebServerRequest *request) {
     request->redirect("/login");
   });
 
   /* These must be gzipped due to space */
   server.on("/css/bootstrap.min.css", HTTP_GET, [](AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/css/bootstrap.min.css.gz", "text/css");
+    AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/css/bootstrap.min.css.gz", "text/css");
     response->addHeader("Content-Encoding", "gzip");
     request->send(response);
   }); 
 
   server.on("/css/fontawesome.min.css", HTTP_GET, [](AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/css/fontawesome.min.css.gz", "text/css");
+    AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/css/fontawesome.min.css.gz", "text/css");
     response->addHeader("Content-Encoding", "gzip");
     request->send(response);
   });
 
   server.on("/css/solid.min.css", HTTP_GET, [](AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/css/solid.min.css.gz", "text/css");
+    AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/css/solid.min.css.gz", "text/css");
     response->addHeader("Content-Encoding", "gzip");
     request->send(response);
   });
 
   server.on("/webfonts/fa-solid-900.woff2", HTTP_GET, [](AsyncWebServerRequest* request) {
     Serial.println("Request received for /webfonts/fa-solid-900.woff2");
-    if (SPIFFS.exists("/wf/fa-solid-900.woff2.gz")) {
-        Serial.println("Found file /wf/fa-solid-900.woff2.gz in SPIFFS");
-        AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/wf/fa-solid-900.woff2.gz", "font/woff2");
+    if (storage().exists("/wf/fa-solid-900.woff2.gz")) {
+        Serial.println("Found file /wf/fa-solid-900.woff2.gz");
+        AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/wf/fa-solid-900.woff2.gz", "font/woff2");
         response->addHeader("Content-Encoding", "gzip");
         request->send(response);
     } else {
-        Serial.println("File /wf/fa-solid-900.woff2.gz not found in SPIFFS");
+        Serial.println("File /wf/fa-solid-900.woff2.gz not found");
         request->send(404, "text/plain", "File Not Found");
     }
   });
 
   server.on("/webfonts/fa-solid-900.ttf", HTTP_GET, [](AsyncWebServerRequest* request) {
-    if (SPIFFS.exists("/wf/fa-solid-900.ttf")) {
-        AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/wf/fa-solid-900.ttf", "font/ttf");
+    if (storage().exists("/wf/fa-solid-900.ttf")) {
+        AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/wf/fa-solid-900.ttf", "font/ttf");
         request->send(response);
     } else {
         request->send(404, "text/plain", "File Not Found");
@@ -161,19 +189,19 @@ void setupWebServer() {
   });
 
   server.on("/js/bootstrap.bundle.min.js", HTTP_GET, [](AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/js/bootstrap.bundle.min.js.gz", "application/javascript");
+    AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/js/bootstrap.bundle.min.js.gz", "application/javascript");
     response->addHeader("Content-Encoding", "gzip");
     request->send(response);
   });
 
   server.on("/js/chart.4.4.6.min.js", HTTP_GET, [](AsyncWebServerRequest* request) {
-    AsyncWebServerResponse* response = request->beginResponse(SPIFFS, "/js/chart.4.4.6.min.js.gz", "application/javascript");
+    AsyncWebServerResponse* response = request->beginResponse(storage().filesystem(), "/js/chart.4.4.6.min.js.gz", "application/javascript");
     response->addHeader("Content-Encoding", "gzip");
     request->send(response);
   });
 
-  server.serveStatic("/css", SPIFFS, "/css");
-  server.serveStatic("/js", SPIFFS, "/js");
+  server.serveStatic("/css", storage().filesystem(), "/css");
+  server.serveStatic("/js", storage().filesystem(), "/js");
 
   server.on("/login", HTTP_POST, [](AsyncWebServerRequest *request) {
     if (request->hasParam("username", true) && request->hasParam("password", true)) {
@@ -260,50 +288,45 @@ server.on("/api/auth-check", HTTP_GET, [](AsyncWebServerRequest *request) {
     }
     Serial.printf("[HTTP] GET /api/data - Requested period: %s\n", period.c_str());
 
-    // Select appropriate data vector based on the period
-    std::vector<DataPoint>* selectedData;
+    // Optional "sensor" parameter selects a sensor by id; the primary sensor by default
+    int sensorIndex = PRIMARY_SENSOR;
+    if (request->hasParam("sensor")) {
+        sensorIndex = findSensor(request->getParam("sensor")->value());
+        if (sensorIndex < 0) {
+            request->send(404, "application/json", "{\"error\":\"Unknown sensor\"}");
+            return;
+        }
+    }
+    Sensor& sensor = getSensor(sensorIndex);
+
+    // Select appropriate data series based on the period
+    DataSeries* selectedSeries;
     if (period == "day") {
-        selectedData = &temperatureData5Min; // Use 5-minute data for a day's worth of points
+        selectedSeries = sensor.series5Min; // Use 5-minute data for a day's worth of points
     } else if (period == "week") {
-        selectedData = &temperatureDataHourly; // Use hourly data for a week
+        selectedSeries = sensor.seriesHourly; // Use hourly data for a week
     } else if (period == "month") {
-        selectedData = &temperatureDataHourly; // Use hourly data for a month
+        selectedSeries = sensor.seriesHourly; // Use hourly data for a month
     } else if (period == "year") {
-        selectedData = &temperatureData6Hour; // Use 6-hour data for a year
+        selectedSeries = sensor.series6Hour; // Use 6-hour data for a year
     } else {
         request->send(400, "application/json", "{\"error\":\"Invalid period parameter\"}");
         return;
     }
+
+    // Copy a consistent view of the series; the control task keeps appending on the other core
+    std::vector<DataPoint> points;
+    selectedSeries->readAll(points);
+    std::vector<DataPoint>* selectedData = &points;
     Serial.printf("[HTTP] GET /api/data - Sending %d data points for period %s\n", selectedData->size(), period.c_str());
     // Set up the response stream
     //NOTE: We are streaming the response to avoid memory issues with large data sets
     AsyncResponseStream *response = request->beginResponseStream("application/json");
 
-    // Start JSON object
-    response->print("{\"temperature\":[");
-    for (size_t i = 0; i < selectedData->size(); ++i) {
-        response->print(selectedData->at(i).temperature);
-        if (i < selectedData->size() - 1) {
-            response->print(","); // Add comma between items
-        }
-    }
-    response->print("],\"humidity\":[");
-
-    for (size_t i = 0; i < selectedData->size(); ++i) {
-        response->print(selectedData->at(i).humidity);
-        if (i < selectedData->size() - 1) {
-            response->print(",");
-        }
-    }
-    response->print("],\"timestamps\":[");
-
-    for (size_t i = 0; i < selectedData->size(); ++i) {
-        response->print("\"" + formatTimestamp(selectedData->at(i).timestamp, "+00:00") + "\"");  // UTC offset as an example
-        if (i < selectedData->size() - 1) {
-            response->print(",");
-        }
-    }
-    response->print("],\"message\":\"Thanks for using SmartAC Remote!\"}");
+    // One copy of the zone for the whole series (see civil_time.h)
+    TimeZone zone;
+    getLocalTimeZone(zone);
+    writeSeriesJson(*response, *selectedData, zone);
 
     // Send the response
     request->send(response);
@@ -347,14 +370,14 @@ server.on("/api/auth-check", HTTP_GET, [](AsyncWebServerRequest *request) {
         Serial.printf("[HTTP] GET /download - Requested file: %s\n", filePath.c_str());
 
         // Check if file exists
-        if (!SPIFFS.exists(filePath)) {
+        if (!storage().exists(filePath.c_str())) {
             Serial.printf("[HTTP] GET /download - File not found: %s\n", filePath.c_str());
             request->send(404, "text/plain", "File not found");
             return;
         }
 
         // Send the file to the client
-        request->send(SPIFFS, filePath, "application/octet-stream", true);
+        request->send(storage().filesystem(), filePath, "application/octet-stream", true);
     });
 
     // GET request to retrieve the configuration
@@ -385,12 +408,13 @@ server.on("/api/auth-check", HTTP_GET, [](AsyncWebServerRequest *request) {
         }
 
         // Retrieve the current configuration as JSON
-        DynamicJsonDocument configJson = getConfigJson();
+        DynamicJsonDocument configJson(2048);
+        writeConfigJson(configJson);
 
-        // Serialize and send the JSON response
-        String response;
-        serializeJson(configJson, response);
-        request->send(200, "application/json", response);
+        // Serialize straight into the response
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        serializeJson(configJson, *response);
+        request->send(response);
         Serial.println("[HTTP] GET /api/config - Configuration sent");
     });
 
@@ -414,7 +438,17 @@ server.on("/api/auth-check", HTTP_GET, [](AsyncWebServerRequest *request) {
         if (request->hasParam("config", true)) {
             String newConfig = request->getParam("config", true)->value();
             Serial.printf("[HTTP] POST /api/config - New config: %s\n", newConfig.c_str());
-            updateConfig(newConfig); // Update in-memory and save to SPIFFS
+            String error;
+            if (!updateConfig(newConfig, error)) { // Update in-memory and save to flash
+                // The reason may quote a sensor id, so let ArduinoJson escape it
+                DynamicJsonDocument reply(256 + error.length());
+                reply["error"] = error;
+                String response;
+                serializeJson(reply, response);
+                request->send(400, "application/json", response);
+                return;
+            }
+            updateWifiCredentials(); // Picked up by the next connection attempt
             request->send(200, "application/json", "{\"message\":\"Config updated successfully\"}");
         } else {
             Serial.println("[HTTP] POST /api/config - Missing config parameter");
@@ -435,6 +469,7 @@ server.on("/api/auth-check", HTTP_GET, [](AsyncWebServerRequest *request) {
             return;
         }
 
+        ensureRuleSetsLoaded();
         DynamicJsonDocument rulesJson(4096);
         JsonArray rulesArray = rulesJson.to<JsonArray>();
         saveRulesToJson(rulesArray);
@@ -469,11 +504,324 @@ server.on("/api/auth-check", HTTP_GET, [](AsyncWebServerRequest *request) {
             return;
         }
 
+        // Swapped in immediately; written to flash by the background writer
         loadRulesFromJson(doc.as<JsonArray>());
-        saveRules();
         request->send(200, "application/json", "{\"message\":\"Rules updated successfully\"}");
     });
 
+    // Latest sample and AC state from the control task, plus recent AC changes
+    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasHeader("Authorization")) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        String authHeader = request->header("Authorization");
+        String token = authHeader.startsWith("Bearer ") ? authHeader.substring(7) : "";
+        if (!isValidJWTToken(token)) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        TelemetryStatus status;
+        getTelemetryStatus(status);
+
+        DynamicJsonDocument doc(6144);
+        JsonObject sample = doc.createNestedObject("sample");
+        sample["timestamp"] = status.sample.timestamp;
+        sample["temperature"] = status.sample.temperature;
+        sample["humidity"] = status.sample.humidity;
+        sample["feels_like"] = status.sample.feels_like;
+
+        JsonObject ac = doc.createNestedObject("ac");
+        ac["timestamp"] = status.ac.timestamp;
+        ac["is_on"] = status.ac.is_on;
+        ac["current_temp"] = status.ac.current_temp;
+        ac["mode"] = status.ac.mode;
+        ac["fan_on"] = status.ac.fan_on;
+
+        JsonArray changes = doc.createNestedArray("changes");
+        for (size_t i = 0; i < status.changeCount; ++i) {
+            JsonObject change = changes.createNestedObject();
+            change["timestamp"] = status.changes[i].timestamp;
+            change["is_on"] = status.changes[i].is_on;
+            change["current_temp"] = status.changes[i].current_temp;
+            change["mode"] = status.changes[i].mode;
+            change["fan_on"] = status.changes[i].fan_on;
+        }
+        doc["dropped"] = status.dropped;
+        doc["connectivity"] = connectivityStateName(getConnectivityState());
+        doc["time_synced"] = isTimeSynced();
+
+        LiveState live;
+        getLiveState(live);
+        JsonObject current = doc.createNestedObject("live");
+        current["temperature"] = live.temperature.temperature;
+        current["humidity"] = live.temperature.humidity;
+        current["feels_like"] = live.temperature.feels_like;
+        current["temperature_5min"] = live.temperature.temperature_5min;
+        current["humidity_5min"] = live.temperature.humidity_5min;
+        current["feels_like_5min"] = live.temperature.feels_like_5min;
+        current["temperature_ewma"] = live.temperature.temperature_ewma;
+        current["feels_like_ewma"] = live.temperature.feels_like_ewma;
+        current["temperature_rate"] = live.temperature.temperature_rate;
+        current["temperature_slope"] = live.temperature.temperature_slope;
+        current["minutes_since_ac_change"] = live.temperature.minutes_since_ac_change;
+        JsonObject target = current.createNestedObject("target");
+        target["timestamp"] = live.ac.timestamp;
+        target["is_on"] = live.ac.is_on;
+        target["current_temp"] = live.ac.current_temp;
+        target["mode"] = live.ac.mode;
+        target["fan_on"] = live.ac.fan_on;
+        if (live.rollupTimestamp) {
+            JsonObject rollup = current.createNestedObject("rollup_5min");
+            rollup["timestamp"] = live.rollupTimestamp;
+            rollup["count"] = live.rollup.count;
+            rollup["rejected"] = live.rollup.rejected;
+            rollup["temperature_min"] = live.rollup.temperature.min;
+            rollup["temperature_max"] = live.rollup.temperature.max;
+            rollup["temperature_stddev"] = live.rollup.temperature.stddev;
+            rollup["humidity_min"] = live.rollup.humidity.min;
+            rollup["humidity_max"] = live.rollup.humidity.max;
+            rollup["humidity_stddev"] = live.rollup.humidity.stddev;
+        }
+        current["version"] = live.version;
+
+        JsonArray sensors = doc.createNestedArray("sensors");
+        for (size_t i = 0; i < getSensorCount(); ++i) {
+            Sensor& sensor = getSensor(i);
+            SensorReading reading = sensor.published.read();
+            JsonObject entry = sensors.createNestedObject();
+            entry["id"] = sensor.config.id;
+            entry["driver"] = sensor.config.driver;
+            entry["pin"] = sensor.config.pin;
+            entry["timestamp"] = reading.timestamp;
+            entry["temperature"] = reading.temperature;
+            entry["humidity"] = reading.humidity;
+            entry["feels_like"] = reading.feels_like;
+            entry["ok"] = reading.result == SENSOR_READ_OK;
+        }
+
+        IrFrameCacheStats frames = irFrames.stats();
+        IrTransmitStats transmit = getIrTransmitStats();
+        JsonObject ir = doc.createNestedObject("ir");
+        ir["frames_cached"] = frames.cached;
+        ir["cache_hits"] = frames.hits;
+        ir["cache_misses"] = frames.misses;
+        ir["sent"] = transmit.started;
+        ir["completed"] = transmit.completed;
+        ir["busy"] = transmit.busy;
+        ir["timed_out"] = transmit.timedOut;
+        ir["last_frame_us"] = transmit.lastFrameMicros;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Control task statistics, for diagnosing slow or late tasks
+    server.on("/api/scheduler", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasHeader("Authorization")) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        String authHeader = request->header("Authorization");
+        String token = authHeader.startsWith("Bearer ") ? authHeader.substring(7) : "";
+        if (!isValidJWTToken(token)) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        DynamicJsonDocument doc(2048);
+        JsonArray tasks = doc.createNestedArray("tasks");
+        for (int i = 0; i < getTaskCount(); ++i) {
+            TaskStats stats;
+            if (!getTaskStats(i, stats)) break;
+            JsonObject task = tasks.createNestedObject();
+            task["name"] = stats.name;
+            task["period_ms"] = stats.period;
+            task["budget_ms"] = stats.budget;
+            task["calls"] = stats.calls;
+            task["overruns"] = stats.overruns;
+            task["skipped"] = stats.skipped;
+            task["total_us"] = stats.totalMicros;
+            task["avg_us"] = stats.calls ? (uint32_t)(stats.totalMicros / stats.calls) : 0;
+            task["max_us"] = stats.maxMicros;
+            task["max_late_ms"] = stats.maxLateMillis;
+        }
+
+        if (request->hasParam("reset")) resetSchedulerStats(); // Applied by the control task
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Where boot time went, for this boot and the one before a reset
+    server.on("/api/boot-profile", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasHeader("Authorization")) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        String authHeader = request->header("Authorization");
+        String token = authHeader.startsWith("Bearer ") ? authHeader.substring(7) : "";
+        if (!isValidJWTToken(token)) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        BootProfile profile;
+        DynamicJsonDocument doc(6144);
+        getBootProfile(profile);
+        writeBootProfile(profile, doc.createNestedObject("current"));
+        if (getPreviousBootProfile(profile)) writeBootProfile(profile, doc.createNestedObject("previous"));
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Flash write budget: what the data files cost in writes and erase blocks,
+    // for tuning the durability window (config "durability_window")
+    server.on("/api/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasHeader("Authorization")) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        String authHeader = request->header("Authorization");
+        String token = authHeader.startsWith("Bearer ") ? authHeader.substring(7) : "";
+        if (!isValidJWTToken(token)) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        PersistenceStats persistence = getPersistenceStats();
+        DynamicJsonDocument doc(4096);
+        JsonObject staging = doc.createNestedObject("staging");
+        staging["durability_window_min"] = persistence.windowMinutes;
+        staging["staged"] = persistence.staged;
+        staging["unwritten"] = persistence.unwritten;
+        staging["capacity"] = PERSIST_STAGING_CAPACITY;
+        staging["recovered"] = persistence.recovered;
+        staging["dropped"] = persistence.dropped;
+        JsonObject flushes = staging.createNestedObject("flushes");
+        flushes["window"] = persistence.flushes[PERSIST_FLUSH_WINDOW];
+        flushes["pressure"] = persistence.flushes[PERSIST_FLUSH_PRESSURE];
+        flushes["shutdown"] = persistence.flushes[PERSIST_FLUSH_SHUTDOWN];
+        flushes["forced"] = persistence.flushes[PERSIST_FLUSH_FORCED];
+
+        uint32_t totalBytes = 0;
+        uint32_t totalBlocks = 0;
+        JsonArray files = doc.createNestedArray("files");
+        for (size_t i = 0; i < getPersistentFileCount(); ++i) {
+            PersistentFileStats stats = getPersistentFileStats(i);
+            JsonObject file = files.createNestedObject();
+            file["path"] = getPersistentFilePath(i);
+            file["writes"] = stats.writes;
+            file["bytes"] = stats.bytesWritten;
+            file["erase_blocks"] = stats.eraseBlocks;
+            file["failed"] = stats.failed;
+            file["staged"] = getPersistentFileStaged(i);
+            totalBytes += stats.bytesWritten;
+            totalBlocks += stats.eraseBlocks;
+        }
+
+        // Wear levelling spreads erases over the whole partition, so the
+        // budget is blocks in the partition times the endurance of each
+        FlashWriterStats writer = getFlashWriterStats();
+        float days = millis() / 86400000.0f;
+        float blocksPerDay = days > 0 ? totalBlocks / days : 0;
+        uint32_t partitionBlocks = storage().totalBytes() / FLASH_ERASE_BLOCK_SIZE;
+        JsonObject budget = doc.createNestedObject("budget");
+        budget["data_bytes"] = totalBytes;
+        budget["data_erase_blocks"] = totalBlocks;
+        budget["all_bytes"] = writer.bytesWritten;
+        budget["all_writes"] = writer.written;
+        budget["uptime_days"] = days;
+        budget["erase_blocks_per_day"] = blocksPerDay;
+        budget["partition_blocks"] = partitionBlocks;
+        budget["erase_cycles"] = FLASH_ERASE_CYCLES;
+        if (blocksPerDay > 0) budget["lifetime_years"] = (float)partitionBlocks * FLASH_ERASE_CYCLES / blocksPerDay / 365.0f;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Daily statistics (see daily_stats.h) for local dates ?from=YYYY-MM-DD&to=YYYY-MM-DD,
+    // both optional: `to` defaults to today and `from` to six days before `to`. At most
+    // a year is kept, so a longer range is cut to the year up to `to`
+    server.on("/api/stats", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasHeader("Authorization")) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        String authHeader = request->header("Authorization");
+        String token = authHeader.startsWith("Bearer ") ? authHeader.substring(7) : "";
+        if (!isValidJWTToken(token)) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        // Before the clock is set, "today" is the newest day with data
+        DailyStats today;
+        uint32_t now = getCurrentEpoch();
+        int32_t to = now >= MIN_VALID_EPOCH ? getLocalDay(now) : getTodayStats(today) ? today.day : 0;
+        if (request->hasParam("to") && !parseDate(request->getParam("to")->value().c_str(), to)) {
+            request->send(400, "application/json", "{\"error\":\"Invalid to date, expected YYYY-MM-DD\"}");
+            return;
+        }
+        int32_t from = to - 6;
+        if (request->hasParam("from") && !parseDate(request->getParam("from")->value().c_str(), from)) {
+            request->send(400, "application/json", "{\"error\":\"Invalid from date, expected YYYY-MM-DD\"}");
+            return;
+        }
+        if (from > to) {
+            request->send(400, "application/json", "{\"error\":\"Invalid range\"}");
+            return;
+        }
+        if (to - from >= (int32_t)DAILY_STATS_DAYS) from = to - (DAILY_STATS_DAYS - 1);
+
+        // Records hold the day as a uint16_t; a range wholly outside that is empty
+        std::vector<DailyStats> days;
+        if (to >= 0 && from <= (int32_t)UINT16_MAX) {
+            readDailyStats(from < 0 ? 0 : (uint16_t)from, to > (int32_t)UINT16_MAX ? UINT16_MAX : (uint16_t)to, days);
+        }
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        writeDailyStatsJson(*response, days);
+        request->send(response);
+    });
+
+    // Zone names the settings page can offer, straight from the table in flash
+    server.on("/api/timezones", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasHeader("Authorization")) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        String authHeader = request->header("Authorization");
+        String token = authHeader.startsWith("Bearer ") ? authHeader.substring(7) : "";
+        if (!isValidJWTToken(token)) {
+            request->send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+            return;
+        }
+
+        // Streamed: the full list is around 8KB. Zone names need no JSON escaping
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        response->print("[");
+        for (size_t i = 0; i < getTimezoneCount(); ++i) {
+            if (i > 0) response->print(",");
+            response->print("\"");
+            response->print(getTimezoneName(i));
+            response->print("\"");
+        }
+        response->print("]");
+        request->send(response);
+    });
 
   server.onNotFound([](AsyncWebServerRequest *request){
     request->send(404, "text/plain", "404: Not Found");
@@ -0,0 +1,249 @@
+// bench.cpp - micro-benchmarks for the device code, built for Linux
+//
+// [env:native] compiles data.cpp, rules.cpp, rule_program.cpp, config.cpp
+// and their dependencies against the lib/ArduinoHost shims, so the hot paths
+// can be measured on a workstation with Google Benchmark:
+//   - calculateCRC32 over a header, a flash block and a full 5-minute file
+//   - saveDataPoints/loadDataPoints on the POSIX storage backend
+//   - loading data/rules.json (parse, compile, publish) and evaluateRules()
+//   - getFeelsLikeTemperature
+//   - the /api/data body (writeSeriesJson) for a day, a week and a year
+//   - encoding and decoding the config record
+// Host numbers are not device numbers; they are a repeatable baseline for
+// comparing a change against the code before it.
+//
+// Needs Google Benchmark installed (libbenchmark-dev, or built from source).
+// Build and run from the project directory:
+//   pio run -e native
+//   .pio/build/native/program [--rules data/rules.json] [--benchmark_filter=CRC]
+//       [--benchmark_format=json]
+#include <benchmark/benchmark.h>
+#include <Arduino.h>
+#include <HostClock.h>
+#include <ArduinoJson.h>
+#include <storage.h>
+#include <data.h>
+#include <rules.h>
+#include <rule_program.h>
+#include <config.h>
+#include <config_store.h>
+#include <civil_time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+static std::string rulesPath = "data/rules.json";
+
+static std::vector<DataPoint> makePoints(size_t count, uint32_t step) {
+  std::mt19937 random(7);
+  std::normal_distribution<float> noise(0, 0.3f);
+  std::vector<DataPoint> points(count);
+  uint32_t start = 1735689600 - count * step;
+  for (size_t i = 0; i < count; ++i) {
+    float daily = sinf(i * step * 2 * (float)M_PI / 86400);
+    points[i].temperature = 24 + 4 * daily + noise(random);
+    points[i].humidity = 55 - 10 * daily + noise(random);
+    points[i].timestamp = start + i * step;
+  }
+  return points;
+}
+
+// Counts what would go out over the socket
+class NullPrint : public Print {
+public:
+  size_t written = 0;
+  size_t write(uint8_t) override { written++; return 1; }
+  size_t write(const uint8_t*, size_t size) override { written += size; return size; }
+};
+
+// ---- CRC ----
+
+static void BM_CalculateCRC32(benchmark::State& state) {
+  std::vector<uint8_t> bytes(state.range(0));
+  for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = (uint8_t)(i * 31);
+  for (auto _ : state) benchmark::DoNotOptimize(calculateCRC32(bytes.data(), bytes.size()));
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_CalculateCRC32)->Arg(sizeof(DataPointHeader))->Arg(4096)->Arg(MAX_5MIN_POINTS * sizeof(DataPoint));
+
+// ---- Data files ----
+
+static void BM_SaveDataPoints(benchmark::State& state) {
+  std::vector<DataPoint> points = makePoints(state.range(0), 300);
+  for (auto _ : state) saveDataPoints("/bench.bin", points);
+  state.SetBytesProcessed(state.iterations() * (sizeof(DataPointHeader) + points.size() * sizeof(DataPoint)));
+}
+BENCHMARK(BM_SaveDataPoints)->Arg(288)->Arg(MAX_5MIN_POINTS)->Unit(benchmark::kMicrosecond);
+
+static void BM_LoadDataPoints(benchmark::State& state) {
+  saveDataPoints("/bench.bin", makePoints(state.range(0), 300));
+  DataPointHeader header;
+  std::vector<DataPoint> points;
+  for (auto _ : state) {
+    points.clear();
+    if (loadDataPoints("/bench.bin", header, points) != 1 || points.size() != (size_t)state.range(0)) {
+      state.SkipWithError("load failed");
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * (sizeof(DataPointHeader) + state.range(0) * sizeof(DataPoint)));
+}
+BENCHMARK(BM_LoadDataPoints)->Arg(288)->Arg(MAX_5MIN_POINTS)->Unit(benchmark::kMicrosecond);
+
+// ---- Rules ----
+
+static std::string readRulesFile() {
+  FILE* file = fopen(rulesPath.c_str(), "rb");
+  if (!file) return std::string();
+  std::string contents;
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) contents.append(buffer, n);
+  fclose(file);
+  return contents;
+}
+
+// Parse, compile and publish, as loadRules() does without a snapshot
+static bool loadRulesText(const std::string& text, std::vector<RuleSet>& parsed) {
+  DynamicJsonDocument doc(16384);
+  if (deserializeJson(doc, text.data(), text.size())) return false;
+  JsonArray rulesArray = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["rules"].as<JsonArray>();
+  parsed.clear();
+  if (!parseRuleSets(rulesArray, parsed)) return false;
+  publishRuleProgram(buildRuleProgram(parsed, 0, 0));
+  return true;
+}
+
+static void BM_LoadRules(benchmark::State& state) {
+  std::string text = readRulesFile();
+  std::vector<RuleSet> parsed;
+  if (text.empty()) {
+    state.SkipWithError("rules file not found (--rules)");
+    return;
+  }
+  for (auto _ : state) {
+    if (!loadRulesText(text, parsed)) {
+      state.SkipWithError("rules failed to load");
+      break;
+    }
+  }
+  state.counters["rules"] = parsed.size();
+}
+BENCHMARK(BM_LoadRules)->Unit(benchmark::kMicrosecond);
+
+static void BM_EvaluateRules(benchmark::State& state) {
+  std::vector<RuleSet> parsed;
+  if (!loadRulesText(readRulesFile(), parsed)) {
+    state.SkipWithError("rules failed to load");
+    return;
+  }
+  std::vector<DataPoint> points = makePoints(MAX_5MIN_POINTS, 300);
+  const ACState initial = ac_state;
+  size_t i = 0;
+  for (auto _ : state) {
+    // A new reading and a new minute each pass, so the local time is redone too
+    const DataPoint& point = points[i++ % points.size()];
+    hostClockSetEpoch(point.timestamp);
+    temperature_data.temperature = point.temperature;
+    temperature_data.humidity = point.humidity;
+    temperature_data.feels_like = getFeelsLikeTemperature(point.temperature, point.humidity);
+    evaluateRules();
+  }
+  ac_state = initial;
+  hostClockUseRealTime();
+  state.counters["rules"] = parsed.size();
+}
+BENCHMARK(BM_EvaluateRules);
+
+static void BM_GetFeelsLikeTemperature(benchmark::State& state) {
+  std::vector<DataPoint> points = makePoints(1024, 300);
+  size_t i = 0;
+  for (auto _ : state) {
+    const DataPoint& point = points[i++ & 1023];
+    benchmark::DoNotOptimize(getFeelsLikeTemperature(point.temperature, point.humidity));
+  }
+}
+BENCHMARK(BM_GetFeelsLikeTemperature);
+
+// ---- /api/data ----
+
+static void BM_SeriesJson(benchmark::State& state) {
+  std::vector<DataPoint> points = makePoints(state.range(0), 300);
+  setLocalTimeZone("AEST-10AEDT,M10.1.0,M4.1.0/3");
+  NullPrint out;
+  for (auto _ : state) {
+    TimeZone zone;
+    getLocalTimeZone(zone);
+    writeSeriesJson(out, points, zone);
+  }
+  state.SetBytesProcessed(out.written);
+  state.counters["points"] = points.size();
+}
+BENCHMARK(BM_SeriesJson)->Arg(288)->Arg(MAX_5MIN_POINTS)->Arg(MAX_6HOUR_POINTS)->Unit(benchmark::kMicrosecond);
+
+// ---- Config ----
+
+static Config benchConfig() {
+  Config c = config;
+  c.wifi_ssid = "home-network";
+  c.wifi_password = "correct horse battery staple";
+  c.timezone = "Australia/Sydney";
+  for (int i = 0; i < 4; ++i) {
+    SensorConfig sensor = defaultSensorConfig();
+    sensor.id = String("sensor") + i;
+    sensor.pin = 4 + i;
+    c.sensors.push_back(sensor);
+  }
+  return c;
+}
+
+static void BM_EncodeConfig(benchmark::State& state) {
+  Config c = benchConfig();
+  for (auto _ : state) benchmark::DoNotOptimize(encodeConfig(c));
+}
+BENCHMARK(BM_EncodeConfig);
+
+static void BM_DecodeConfig(benchmark::State& state) {
+  std::vector<uint8_t> record = encodeConfig(benchConfig());
+  for (auto _ : state) {
+    Config c = config;
+    if (decodeConfig(record.data(), record.size(), c) != CONFIG_RECORD_OK) {
+      state.SkipWithError("decode failed");
+      break;
+    }
+    benchmark::DoNotOptimize(c);
+  }
+}
+BENCHMARK(BM_DecodeConfig);
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--rules") && i + 1 < argc) {
+      rulesPath = argv[++i];
+    } else {
+      fprintf(stderr, "usage: bench [--rules file] [benchmark options, see --help]\n");
+      return 2;
+    }
+  }
+
+  // Data files go to a scratch directory, not the project
+  char dir[] = "/tmp/smartac-bench-XXXXXX";
+  if (!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  setStorageRoot(dir);
+  storage().begin();
+  Serial.setQuiet(true);
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  storage().remove("/bench.bin");
+  rmdir(dir);
+  return 0;
+}
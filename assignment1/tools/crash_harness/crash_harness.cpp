@@ -0,0 +1,642 @@
+// crash_harness.cpp - power-cut and write-cost checks for the storage path
+//
+// Runs the firmware's ArduinoStorage (src/arduino_storage.h) on SimFlash, a
+// stand-in for the flash file system that records every page program,
+// create, rename and remove, and can cut the power before any of them. For
+// each file format below it saves a few successive versions and, for every
+// save, cuts the power at every step of it; then "reboots" (storage begin()
+// and the device's own loader) and checks that
+//   - what loads is the previous version or the new one, never less,
+//   - no .tmp/.new files are left behind, and
+//   - the next save succeeds.
+// Each cut is also followed by cuts at every step of the recovery itself.
+// Without an atomic rename, each save is also swept starting from the state
+// a failed last rename leaves: the previous version only in <path>.new.
+//
+// Sensor ids of the longest valid length must give data files whose
+// temporary names still fit SPIFFS, so they are saved through the harness's
+// flash, which refuses longer names as SPIFFS does. Then the flash writer is run with more distinct files pending than its
+// job table holds (a persistence flush of every tier of MAX_SENSORS sensors
+// plus the statistics, rules and config files), and every file must still be
+// written once with its newest contents.
+//
+// Formats: the 5-minute series file (loaded with loadHistoricalData(), which
+// must also still load the other two tiers) and the config record (loaded
+// with loadConfig()). A new format only needs a Scenario.
+//
+// It then reports what one save costs: bytes handed to write(), pages
+// programmed (data and metadata), erase blocks consumed in the long run, and
+// the write amplification against the bytes that actually changed. The cost
+// model is SPIFFS's (256-byte pages with 252 bytes of data, a metadata page
+// per create/close/rename/remove, 4 KB erase blocks, as estimateEraseBlocks()
+// in persistence.cpp assumes); the LittleFS rows differ only in rename
+// replacing the target atomically.
+//
+// Build and run:
+//   pio run -e crash_harness
+//   .pio/build/crash_harness/program [--trace]
+#include <Arduino.h>
+#include <arduino_storage.h>
+#include <storage.h>
+#include <flash_writer.h>
+#include <data.h>
+#include <config.h>
+#include <config_store.h>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+const size_t SIM_PAGE_SIZE = 256;
+const size_t SIM_PAGE_DATA = 252;           // Less the page header
+const size_t SIM_BLOCK_SIZE = 4096;
+const size_t SIM_CAPACITY = 1408 * 1024;    // SPIFFS partition of huge_app.csv
+
+struct PowerCut {};
+
+struct FlashCounters {
+  uint32_t steps;              // Operations the power can be cut before
+  size_t bytesWritten;         // As handed to write()
+  uint32_t dataPages;
+  uint32_t metadataPages;      // Object headers: create, size on close, rename, remove
+  uint32_t creates;
+  uint32_t renames;
+  uint32_t removes;
+
+  uint32_t pages() const { return dataPages + metadataPages; }
+  // Every programmed page is erased again once it is obsolete
+  double eraseBlocks() const { return (double)pages() * SIM_PAGE_SIZE / SIM_BLOCK_SIZE; }
+};
+
+class SimFlash;
+
+class SimFile {
+public:
+  operator bool() const { return flash != nullptr; }
+  size_t write(const uint8_t* data, size_t length);
+  size_t read(uint8_t* buffer, size_t length);
+  bool seek(size_t offset);
+  size_t size() const;
+  bool isDirectory() const { return directory; }
+  const char* name() const { return path.c_str(); }
+  SimFile openNextFile();
+  void close();
+
+private:
+  friend class SimFlash;
+  SimFlash* flash = nullptr;
+  std::string path;
+  bool directory = false;
+  bool writing = false;
+  size_t position = 0;
+  std::vector<uint8_t> pending;      // Written but not yet in a programmed page
+  std::vector<std::string> listing;  // Directory: file paths, SPIFFS style
+  size_t next = 0;
+};
+
+// Files live in `files`; a file being written only holds the pages that have
+// been programmed, so a cut mid-write leaves a short file, as on SPIFFS.
+// Derived from fs::FS only for Storage::filesystem(); the calls below hide it.
+class SimFlash : public fs::FS {
+public:
+  explicit SimFlash(bool atomicRename) : atomicRename(atomicRename) {}
+
+  bool begin(bool formatOnFail = false) { return true; }
+  bool renamesAtomically() const { return atomicRename; }
+
+  SimFile open(const char* path, const char* mode = FILE_READ) {
+    SimFile file;
+    if (!atomicRename && strlen(path) > SPIFFS_MAX_PATH_LENGTH) return file;   // SPIFFS can't name it
+    if (!strcmp(path, "/")) {
+      file.flash = this;
+      file.path = path;
+      file.directory = true;
+      for (const auto& entry : files) file.listing.push_back(entry.first);
+      return file;
+    }
+    bool create = !strcmp(mode, FILE_WRITE) || (!strcmp(mode, FILE_APPEND) && !files.count(path));
+    if (create) {
+      step(std::string("create ") + path);
+      counters.creates++;
+      counters.metadataPages++;
+      files[path].clear();
+    } else if (!files.count(path)) {
+      return file;
+    }
+    file.flash = this;
+    file.path = path;
+    file.writing = strcmp(mode, FILE_READ) != 0;
+    file.position = file.writing ? files[path].size() : 0;
+    return file;
+  }
+
+  bool exists(const char* path) { return files.count(path) != 0; }
+
+  bool remove(const char* path) {
+    if (!files.count(path)) return false;
+    step(std::string("remove ") + path);
+    counters.removes++;
+    counters.metadataPages++;
+    files.erase(path);
+    return true;
+  }
+
+  bool rename(const char* from, const char* to) {
+    if (!files.count(from) || (files.count(to) && !atomicRename)) return false;
+    step(std::string("rename ") + from + " -> " + to);
+    counters.renames++;
+    counters.metadataPages++;
+    files[to] = std::move(files[from]);
+    files.erase(from);
+    return true;
+  }
+
+  size_t totalBytes() { return SIM_CAPACITY; }
+  size_t usedBytes() {
+    size_t pages = 0;
+    for (const auto& entry : files) pages += 1 + (entry.second.size() + SIM_PAGE_DATA - 1) / SIM_PAGE_DATA;
+    return pages * SIM_PAGE_SIZE;
+  }
+
+  // Harness side
+  void cutPowerAfter(long steps) { budget = steps; }   // -1: never
+  void reset(const std::map<std::string, std::vector<uint8_t>>& state) {
+    files = state;
+    counters = FlashCounters();
+    trace.clear();
+    budget = -1;
+  }
+
+  std::map<std::string, std::vector<uint8_t>> files;
+  FlashCounters counters = FlashCounters();
+  std::vector<std::string> trace;    // One line per step
+
+private:
+  friend class SimFile;
+  bool atomicRename;
+  long budget = -1;
+
+  void step(const std::string& what) {
+    if (budget == 0) throw PowerCut();
+    if (budget > 0) budget--;
+    counters.steps++;
+    trace.push_back(what);
+  }
+
+  void programPage(const std::string& path, const uint8_t* data, size_t length) {
+    step("program " + path + " page " + std::to_string(files[path].size() / SIM_PAGE_DATA));
+    counters.dataPages++;
+    files[path].insert(files[path].end(), data, data + length);
+  }
+};
+
+size_t SimFile::write(const uint8_t* data, size_t length) {
+  if (!writing) return 0;
+  flash->counters.bytesWritten += length;
+  pending.insert(pending.end(), data, data + length);
+  size_t programmed = 0;
+  size_t partial = flash->files[path].size() % SIM_PAGE_DATA;   // Appending fills the last page first
+  while (pending.size() - programmed >= SIM_PAGE_DATA - partial) {
+    flash->programPage(path, pending.data() + programmed, SIM_PAGE_DATA - partial);
+    programmed += SIM_PAGE_DATA - partial;
+    partial = 0;
+  }
+  pending.erase(pending.begin(), pending.begin() + programmed);
+  position += length;
+  return length;
+}
+
+size_t SimFile::read(uint8_t* buffer, size_t length) {
+  const std::vector<uint8_t>& contents = flash->files[path];
+  size_t n = position < contents.size() ? std::min(length, contents.size() - position) : 0;
+  memcpy(buffer, contents.data() + position, n);
+  position += n;
+  return n;
+}
+
+bool SimFile::seek(size_t offset) {
+  if (offset > size()) return false;
+  position = offset;
+  return true;
+}
+
+size_t SimFile::size() const {
+  if (directory) return 0;
+  auto entry = flash->files.find(path);
+  return (entry == flash->files.end() ? 0 : entry->second.size()) + pending.size();
+}
+
+SimFile SimFile::openNextFile() {
+  return next < listing.size() ? flash->open(listing[next++].c_str()) : SimFile();
+}
+
+void SimFile::close() {
+  if (flash && writing) {
+    if (!pending.empty()) flash->programPage(path, pending.data(), pending.size());
+    flash->step("close " + path);        // Size into the object header
+    flash->counters.metadataPages++;
+  }
+  flash = nullptr;
+}
+
+// ---- Scenarios ----
+
+// Successive contents of one file, and how the device reads it back
+struct Scenario {
+  const char* name;
+  const char* path;
+  size_t changedBytes;                                  // Logical change per save
+  std::map<std::string, std::vector<uint8_t>> others;   // Files that must survive untouched
+  std::vector<std::vector<uint8_t>> versions;
+  std::function<int()> load;                            // Version the device loaded, -1 none, -2 wrong
+};
+
+inline bool operator==(const DataPoint& a, const DataPoint& b) {
+  return !memcmp(&a, &b, sizeof(DataPoint));
+}
+
+static std::vector<DataPoint> makePoints(size_t count, uint32_t step, uint32_t start) {
+  std::vector<DataPoint> points(count);
+  for (size_t i = 0; i < count; ++i) {
+    points[i].temperature = 22 + (i % 50) * 0.1f;
+    points[i].humidity = 50 + (i % 30) * 0.5f;
+    points[i].timestamp = start + i * step;
+  }
+  return points;
+}
+
+// RAM after a reboot: an empty series (DataSeries only grows)
+static void rebootSeries(DataSeries& series) {
+  size_t capacity = series.capacity();
+  series.~DataSeries();
+  new (&series) DataSeries(capacity);
+}
+
+static Scenario seriesScenario() {
+  static std::vector<std::vector<DataPoint>> saved;
+  static std::vector<DataPoint> hourly, sixHour;
+  saved.clear();
+  hourly = makePoints(MAX_HOURLY_POINTS, 3600, 1733000000);
+  sixHour = makePoints(400, 6 * 3600, 1725000000);
+
+  Scenario scenario;
+  scenario.name = "5-minute series";
+  scenario.path = "/data_5min.bin";
+  scenario.changedBytes = sizeof(DataPoint);
+  scenario.others["/data_hourly.bin"] = serializeDataPoints(hourly);
+  scenario.others["/data_6hour.bin"] = serializeDataPoints(sixHour);
+
+  // The series as it fills: a new point per save, the oldest dropping out
+  DataSeries series(MAX_5MIN_POINTS);
+  series.assign(makePoints(MAX_5MIN_POINTS - 2, 300, 1735000000));
+  for (int i = 0; i < 5; ++i) {
+    saved.push_back(series.toVector());
+    scenario.versions.push_back(serializeDataPoints(saved.back()));
+    series.push_back(makePoints(1, 300, series.back().timestamp + 300)[0]);
+  }
+
+  scenario.load = [] {
+    rebootSeries(temperatureData5Min);
+    rebootSeries(temperatureDataHourly);
+    rebootSeries(temperatureData6Hour);
+    loadHistoricalData();
+    if (temperatureDataHourly.toVector() != hourly || temperatureData6Hour.toVector() != sixHour) return -2;
+    std::vector<DataPoint> loaded = temperatureData5Min.toVector();
+    if (loaded.empty()) return -1;
+    for (size_t i = 0; i < saved.size(); ++i) {
+      if (loaded == saved[i]) return (int)i;
+    }
+    return -2;
+  };
+  return scenario;
+}
+
+static Scenario configScenario() {
+  static const Config defaults = config;
+  Scenario scenario;
+  scenario.name = "config record";
+  scenario.path = CONFIG_PATH;
+  for (int i = 0; i < 4; ++i) {
+    Config c = defaults;
+    c.wifi_ssid = String("network-") + i;
+    c.timezone = i % 2 ? "Europe/Berlin" : "Australia/Sydney";
+    for (int n = 0; n <= i; ++n) {
+      SensorConfig sensor = defaultSensorConfig();
+      sensor.id = String("sensor") + n;
+      sensor.pin = 4 + n;
+      c.sensors.push_back(sensor);
+    }
+    scenario.versions.push_back(encodeConfig(c));
+  }
+  scenario.changedBytes = scenario.versions.back().size();   // Rewritten whole
+
+  static std::vector<std::vector<uint8_t>> versions;
+  versions = scenario.versions;
+  scenario.load = [] {
+    config = defaults;
+    loadConfig();
+    std::vector<uint8_t> loaded = encodeConfig(config);
+    if (loaded == encodeConfig(defaults)) return -1;
+    for (size_t i = 0; i < versions.size(); ++i) {
+      if (loaded == versions[i]) return (int)i;
+    }
+    return -2;
+  };
+  return scenario;
+}
+
+// ---- Sweep ----
+
+struct SweepResult {
+  uint32_t saves = 0;
+  uint32_t cuts = 0;           // Power cuts during saves
+  uint32_t recoveryCuts = 0;   // Power cuts during recovery after one of those
+  uint32_t keptOld = 0;        // Reboots that loaded the previous version
+  uint32_t strandedSaves = 0;  // Saves also swept from a failed rename's .new
+  uint32_t failures = 0;
+  FlashCounters perSave = FlashCounters();
+};
+
+static SimFlash* flash;
+static Storage* simStorage;
+static bool traceSaves = false;
+
+static void reportFailure(SweepResult& result, const Scenario& scenario, size_t save, uint32_t cut,
+                          const std::vector<std::string>& steps, const char* what) {
+  if (result.failures++ < 5) {
+    printf("    FAILED: %s, save %zu, cut before step %u (%s): %s\n", scenario.name, save, cut,
+           cut < steps.size() ? steps[cut].c_str() : "-", what);
+  }
+}
+
+// Reboot and check: storage recovery, then the device's loader
+static void checkAfterCut(SweepResult& result, const Scenario& scenario, size_t save, uint32_t cut,
+                          const std::vector<std::string>& steps) {
+  flash->cutPowerAfter(-1);
+  if (!simStorage->begin()) return reportFailure(result, scenario, save, cut, steps, "storage did not mount");
+  for (const auto& entry : flash->files) {
+    if (entry.first.size() > 4 && (entry.first.compare(entry.first.size() - 4, 4, ".tmp") == 0 ||
+                                   entry.first.compare(entry.first.size() - 4, 4, ".new") == 0)) {
+      return reportFailure(result, scenario, save, cut, steps, ("left behind " + entry.first).c_str());
+    }
+  }
+  for (const auto& other : scenario.others) {
+    if (flash->files[other.first] != other.second) return reportFailure(result, scenario, save, cut, steps, "other file changed");
+  }
+
+  int loaded = scenario.load();
+  if (loaded == (int)save - 1) result.keptOld++;
+  else if (loaded != (int)save) {
+    char what[64];
+    snprintf(what, sizeof(what), loaded == -1 ? "no file loaded" : "loaded version %d", loaded);
+    return reportFailure(result, scenario, save, cut, steps, what);
+  }
+
+  // And the device can carry on
+  const std::vector<uint8_t>& next = scenario.versions[save];
+  if (!writeFileAtomic(scenario.path, next.data(), next.size()) || scenario.load() != (int)save) {
+    reportFailure(result, scenario, save, cut, steps, "next save failed");
+  }
+}
+
+// Cut the power before each of `steps`, the steps of an uninterrupted save
+// from `start`, and before each step of the recovery after every cut
+static void cutEveryStep(SweepResult& result, const Scenario& scenario, size_t save,
+                         const std::map<std::string, std::vector<uint8_t>>& start,
+                         const std::vector<std::string>& steps) {
+  const std::vector<uint8_t>& contents = scenario.versions[save];
+  for (uint32_t cut = 0; cut < steps.size(); ++cut) {
+    flash->reset(start);
+    flash->cutPowerAfter(cut);
+    try {
+      writeFileAtomic(scenario.path, contents.data(), contents.size());
+      reportFailure(result, scenario, save, cut, steps, "power was not cut");
+      continue;
+    } catch (const PowerCut&) {
+    }
+    result.cuts++;
+    std::map<std::string, std::vector<uint8_t>> crashed = flash->files;
+    checkAfterCut(result, scenario, save, cut, steps);
+
+    // Power cut again while recovering
+    for (long recoveryCut = 0;; ++recoveryCut) {
+      flash->reset(crashed);
+      flash->cutPowerAfter(recoveryCut);
+      try {
+        simStorage->begin();
+        break;             // Recovery finished before the cut
+      } catch (const PowerCut&) {
+      }
+      result.recoveryCuts++;
+      checkAfterCut(result, scenario, save, cut, steps);
+    }
+  }
+}
+
+static SweepResult sweep(const Scenario& scenario) {
+  SweepResult result;
+  std::map<std::string, std::vector<uint8_t>> base = scenario.others;
+
+  for (size_t save = 0; save < scenario.versions.size(); ++save) {
+    const std::vector<uint8_t>& contents = scenario.versions[save];
+
+    // An uninterrupted save: its steps, its cost, and the state it leaves
+    flash->reset(base);
+    if (!writeFileAtomic(scenario.path, contents.data(), contents.size()) || scenario.load() != (int)save) {
+      reportFailure(result, scenario, save, 0, {}, "save without a power cut failed");
+      continue;
+    }
+    FlashCounters cost = flash->counters;
+    std::vector<std::string> steps = flash->trace;
+    std::map<std::string, std::vector<uint8_t>> after = flash->files;
+    if (save > 0) {   // The first save creates the file; count the steady state
+      result.saves++;
+      result.perSave.steps += cost.steps;
+      result.perSave.bytesWritten += cost.bytesWritten;
+      result.perSave.dataPages += cost.dataPages;
+      result.perSave.metadataPages += cost.metadataPages;
+      result.perSave.creates += cost.creates;
+      result.perSave.renames += cost.renames;
+      result.perSave.removes += cost.removes;
+    }
+    if (traceSaves && save == 1) {
+      for (size_t i = 0; i < steps.size(); ++i) printf("      %3zu  %s\n", i, steps[i].c_str());
+    }
+
+    cutEveryStep(result, scenario, save, base, steps);
+
+    // The previous save removed the old file but its rename of .new failed
+    if (save > 0 && !flash->renamesAtomically()) {
+      std::map<std::string, std::vector<uint8_t>> stranded = base;
+      stranded[std::string(scenario.path) + ".new"] = stranded[scenario.path];
+      stranded.erase(scenario.path);
+      flash->reset(stranded);
+      if (!writeFileAtomic(scenario.path, contents.data(), contents.size()) || scenario.load() != (int)save) {
+        reportFailure(result, scenario, save, 0, {}, "save after a failed rename failed");
+      } else {
+        result.strandedSaves++;
+        std::vector<std::string> strandedSteps = flash->trace;   // reset() clears the trace
+        cutEveryStep(result, scenario, save, stranded, strandedSteps);
+      }
+    }
+    base = after;
+  }
+  return result;
+}
+
+static void printCost(const char* mode, const Scenario& scenario, const SweepResult& result) {
+  double saves = result.saves ? result.saves : 1;
+  const FlashCounters& total = result.perSave;
+  double programmed = total.pages() * SIM_PAGE_SIZE / saves;
+  double fileBytes = scenario.versions.back().size();
+  printf("  %-9s %6.0f B written  %5.1f pages (%4.1f metadata)  %5.2f erase blocks  "
+         "%3.0f ops   amplification %6.1fx of the change, %4.2fx of the file\n",
+         mode, total.bytesWritten / saves, total.pages() / saves, total.metadataPages / saves,
+         total.eraseBlocks() / saves, total.steps / saves,
+         programmed / scenario.changedBytes, programmed / fileBytes);
+}
+
+// ---- Sensor file names ----
+
+static int checkSensorPathLengths() {
+  int failures = 0;
+  SensorConfig longest = defaultSensorConfig();
+  longest.id = String();
+  for (size_t i = 0; i < SENSOR_ID_LENGTH; ++i) longest.id += (char)('a' + i % 26);
+  SensorConfig tooLong = longest;
+  tooLong.id += "x";
+
+  String error;
+  if (!validateSensorConfigs(std::vector<SensorConfig>(1, longest), error)) {
+    printf("    FAILED: a %u-character id is refused: %s\n", (unsigned)SENSOR_ID_LENGTH, error.c_str());
+    failures++;
+  }
+  if (validateSensorConfigs(std::vector<SensorConfig>(1, tooLong), error)) {
+    printf("    FAILED: a %u-character id is accepted\n", (unsigned)tooLong.id.length());
+    failures++;
+  }
+
+  // Not the registry's primary sensor, so its files carry the id
+  SimFlash sim(false);
+  ArduinoStorage<SimFlash> backend(sim, "SPIFFS", false);
+  setStorage(&backend);
+  Sensor sensor{};
+  sensor.config = longest;
+  size_t longestPath = 0;
+  const char* tiers[] = {"5min", "hourly", "6hour"};
+  for (const char* tier : tiers) {
+    String path = sensorDataPath(sensor, tier);
+    size_t length = path.length() + REPLACE_SUFFIX_LENGTH;
+    if (length > longestPath) longestPath = length;
+    const uint8_t contents[] = {1, 2, 3};
+    if (length > SPIFFS_MAX_PATH_LENGTH || !writeFileAtomic(path.c_str(), contents, sizeof(contents))) {
+      printf("    FAILED: %s.tmp (%u characters) can't be saved on SPIFFS\n", path.c_str(), (unsigned)length);
+      failures++;
+    }
+  }
+  setStorage(nullptr);
+  printf("Sensor ids of %u characters: %s (longest temporary name %u of %u characters)\n",
+         (unsigned)SENSOR_ID_LENGTH, failures ? "FAILED" : "every tier saves", (unsigned)longestPath,
+         (unsigned)SPIFFS_MAX_PATH_LENGTH);
+  return failures;
+}
+
+// ---- Flash writer ----
+
+static void noWake() {}   // The harness runs the I/O side itself
+
+static int checkManyPendingFiles() {
+  const int fileCount = 24;               // More than FLASH_WRITE_QUEUE_SIZE for each lane
+  SimFlash sim(false);
+  ArduinoStorage<SimFlash> backend(sim, "SPIFFS", false);
+  setStorage(&backend);
+  startFlashWriter(noWake);
+
+  // Queue until the lane is full, then let the writer take one job, so files
+  // pile up in its table faster than they are written
+  int failures = 0;
+  uint32_t fullQueue = 0;
+  for (int i = 0; i < fileCount; ++i) {
+    String path = String("/pending_") + String(i) + ".bin";
+    std::vector<uint8_t> contents(100 + i, (uint8_t)i);
+    while (!queueFileWrite(path.c_str(), std::vector<uint8_t>(contents))) {
+      fullQueue++;
+      serviceFlashWrites();
+    }
+  }
+  while (serviceFlashWrites()) {}
+
+  for (int i = 0; i < fileCount; ++i) {
+    String path = String("/pending_") + String(i) + ".bin";
+    std::vector<uint8_t> contents;
+    if (!backend.read(path.c_str(), contents) || contents != std::vector<uint8_t>(100 + i, (uint8_t)i)) {
+      printf("    FAILED: %s not written\n", path.c_str());
+      failures++;
+    }
+  }
+  if (pendingFileWrites() != 0) {
+    printf("    FAILED: %u writes still pending\n", (unsigned)pendingFileWrites());
+    failures++;
+  }
+  FlashWriterStats stats = getFlashWriterStats();
+  printf("Flash writer, %d distinct files pending: %s (at most %u waiting in the table, queue full %u times)\n",
+         fileCount, failures ? "FAILED" : "all written", stats.maxDepth, fullQueue);
+
+  startFlashWriter(nullptr);
+  setStorage(nullptr);
+  return failures;
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--trace")) {
+      traceSaves = true;
+    } else {
+      fprintf(stderr, "usage: crash_harness [--trace]\n");
+      return 2;
+    }
+  }
+  Serial.setQuiet(true);
+
+  std::vector<Scenario> scenarios = {seriesScenario(), configScenario()};
+  struct Mode {
+    const char* name;
+    bool atomicRename;
+  } modes[] = {{"SPIFFS", false}, {"LittleFS", true}};
+
+  int failures = 0;
+  for (const Scenario& scenario : scenarios) {
+    printf("%s (%s, %zu bytes, %zu changed per save)\n", scenario.name, scenario.path,
+           scenario.versions.back().size(), scenario.changedBytes);
+    std::vector<std::pair<const char*, SweepResult>> results;
+    for (const Mode& mode : modes) {
+      SimFlash sim(mode.atomicRename);
+      ArduinoStorage<SimFlash> backend(sim, mode.name, mode.atomicRename);
+      flash = &sim;
+      simStorage = &backend;
+      setStorage(&backend);
+
+      SweepResult result = sweep(scenario);
+      printf("  %-9s %u power cuts in %zu saves (%u more after a failed rename), %u more during recovery: %s "
+             "(previous version kept %u times)\n",
+             mode.name, result.cuts, scenario.versions.size(), result.strandedSaves, result.recoveryCuts,
+             result.failures ? "FAILED" : "always recovered", result.keptOld);
+      results.push_back({mode.name, result});
+      failures += result.failures;
+      setStorage(nullptr);
+    }
+    printf("  Cost of one save:\n");
+    for (const auto& entry : results) printCost(entry.first, scenario, entry.second);
+  }
+
+  failures += checkSensorPathLengths();
+  failures += checkManyPendingFiles();
+
+  if (failures) {
+    printf("%d checks FAILED\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
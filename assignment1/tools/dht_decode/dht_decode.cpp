@@ -0,0 +1,261 @@
+// dht_decode.cpp - Linux checks and benchmark for src/dht_decoder.cpp
+//
+// Synthesises DHT11 and DHT22 captures the way the RMT receiver records
+// them (start signal tail, response, 40 bits, end pulse), with timing jitter
+// and split pulses, and checks that every one decodes to the frame it was
+// built from. Also checks truncated, corrupted and silent captures fail with
+// the right status, then times the decoder.
+//
+// Recorded captures (a logic analyser export, or pulses logged from the
+// device) can be decoded with --file. The format is one pulse per line,
+// "<level> <microseconds>", '#' for comments, and a blank line between
+// captures. --dump prints a synthesised capture in the same format.
+//
+// Build and run:
+//   pio run -e dht_decode
+//   .pio/build/dht_decode/program [--frames n] [--jitter us] [--file capture.txt --model dht11|dht22] [--dump]
+#include <dht_decoder.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+struct Options {
+  unsigned frames = 100000;
+  int jitter = 8;
+  const char* file = nullptr;
+  DhtModel model = DHT_MODEL_DHT22;
+  bool dump = false;
+};
+
+static std::mt19937 rng(12345);
+
+static uint16_t jittered(int micros, int jitter) {
+  int value = micros + (jitter ? (int)(rng() % (2 * jitter + 1)) - jitter : 0);
+  return (uint16_t)(value < 1 ? 1 : value);
+}
+
+static void makeFrame(DhtModel model, float temperature, float humidity, uint8_t frame[DHT_FRAME_BYTES]) {
+  if (model == DHT_MODEL_DHT11) {
+    int t = (int)(fabsf(temperature) * 10 + 0.5f);
+    int h = (int)(humidity * 10 + 0.5f);
+    frame[0] = h / 10;
+    frame[1] = h % 10;
+    frame[2] = t / 10;
+    frame[3] = (t % 10) | (temperature < 0 ? 0x80 : 0);
+  } else {
+    int t = (int)(fabsf(temperature) * 10 + 0.5f);
+    int h = (int)(humidity * 10 + 0.5f);
+    frame[0] = h >> 8;
+    frame[1] = h & 0xFF;
+    frame[2] = ((t >> 8) & 0x7F) | (temperature < 0 ? 0x80 : 0);
+    frame[3] = t & 0xFF;
+  }
+  frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+}
+
+// Pulses as the RMT records them from the release of the start signal
+static std::vector<DhtPulse> makeCapture(const uint8_t frame[DHT_FRAME_BYTES], int jitter, bool splitPulses) {
+  std::vector<DhtPulse> pulses;
+  auto add = [&](uint8_t level, int micros) {
+    uint16_t length = jittered(micros, jitter);
+    if (splitPulses && length > 20 && rng() % 8 == 0) {
+      // A glitch the RMT filter let through, splitting one pulse in two
+      uint16_t first = length / 3;
+      pulses.push_back({level, first});
+      pulses.push_back({level, (uint16_t)(length - first)});
+    } else {
+      pulses.push_back({level, length});
+    }
+  };
+  add(1, 30);                                 // Line released, pull-up
+  add(0, 80);                                 // Response
+  add(1, 80);
+  for (size_t bit = 0; bit < DHT_FRAME_BITS; ++bit) {
+    bool one = frame[bit / 8] & (0x80 >> (bit % 8));
+    add(0, 50);
+    add(1, one ? 70 : 27);
+  }
+  add(0, 50);                                 // End of frame, then idle high
+  return pulses;
+}
+
+static bool sameFrame(const uint8_t a[DHT_FRAME_BYTES], const uint8_t b[DHT_FRAME_BYTES]) {
+  return memcmp(a, b, DHT_FRAME_BYTES) == 0;
+}
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+  printf("  %-48s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok) failures++;
+}
+
+static void checkRoundTrips(DhtModel model, const char* name, int jitter) {
+  std::uniform_real_distribution<float> temperatures(model == DHT_MODEL_DHT11 ? 0 : -40, 50);
+  std::uniform_real_distribution<float> humidities(5, 95);
+  unsigned bad = 0;
+  for (int i = 0; i < 10000; ++i) {
+    float temperature = roundf(temperatures(rng) * 10) / 10;
+    float humidity = roundf(humidities(rng) * 10) / 10;
+    uint8_t frame[DHT_FRAME_BYTES], decoded[DHT_FRAME_BYTES];
+    makeFrame(model, temperature, humidity, frame);
+    std::vector<DhtPulse> pulses = makeCapture(frame, jitter, i % 2);
+
+    float outTemperature, outHumidity;
+    if (decodeDhtPulses(pulses.data(), pulses.size(), decoded) != DHT_DECODE_OK || !sameFrame(frame, decoded)) {
+      bad++;
+      continue;
+    }
+    dhtFrameToReading(model, decoded, outTemperature, outHumidity);
+    if (fabsf(outTemperature - temperature) > 0.051f || fabsf(outHumidity - humidity) > 0.051f) bad++;
+  }
+  char what[64];
+  snprintf(what, sizeof(what), "%s: 10000 frames, jitter +-%d us", name, jitter);
+  expect(bad == 0, what);
+}
+
+static void checkFailures() {
+  uint8_t frame[DHT_FRAME_BYTES], decoded[DHT_FRAME_BYTES];
+  makeFrame(DHT_MODEL_DHT22, 21.5f, 48.2f, frame);
+  std::vector<DhtPulse> pulses = makeCapture(frame, 0, false);
+
+  std::vector<DhtPulse> truncated(pulses.begin(), pulses.begin() + 40);
+  expect(decodeDhtPulses(truncated.data(), truncated.size(), decoded) == DHT_DECODE_TRUNCATED, "truncated capture");
+
+  std::vector<DhtPulse> flipped = pulses;
+  flipped[3 + 2 * 20 + 1].micros = flipped[3 + 2 * 20 + 1].micros > 48 ? 27 : 70;  // Flip bit 20
+  expect(decodeDhtPulses(flipped.data(), flipped.size(), decoded) == DHT_DECODE_BAD_CHECKSUM, "flipped bit");
+
+  std::vector<DhtPulse> stretched = pulses;
+  stretched[3 + 2 * 10].micros = 400;
+  expect(decodeDhtPulses(stretched.data(), stretched.size(), decoded) == DHT_DECODE_BAD_TIMING, "stretched low pulse");
+
+  DhtPulse idle[] = {{1, 30}, {0, 5000}};
+  expect(decodeDhtPulses(idle, 2, decoded) == DHT_DECODE_NO_RESPONSE, "no response");
+
+  // A leading start-signal low from a receiver armed early
+  std::vector<DhtPulse> early = pulses;
+  early.insert(early.begin(), DhtPulse{0, 18000});
+  expect(decodeDhtPulses(early.data(), early.size(), decoded) == DHT_DECODE_OK && sameFrame(frame, decoded),
+         "start signal tail before the response");
+
+  float temperature, humidity;
+  uint8_t negative[DHT_FRAME_BYTES];
+  makeFrame(DHT_MODEL_DHT22, -12.3f, 60.0f, negative);
+  dhtFrameToReading(DHT_MODEL_DHT22, negative, temperature, humidity);
+  expect(fabsf(temperature + 12.3f) < 0.01f && fabsf(humidity - 60.0f) < 0.01f, "DHT22 negative temperature");
+}
+
+static void benchmark(unsigned frames, int jitter) {
+  std::vector<std::vector<DhtPulse>> captures;
+  for (int i = 0; i < 64; ++i) {
+    uint8_t frame[DHT_FRAME_BYTES];
+    makeFrame(DHT_MODEL_DHT22, 15 + i * 0.3f, 40 + i * 0.5f, frame);
+    captures.push_back(makeCapture(frame, jitter, false));
+  }
+
+  uint8_t decoded[DHT_FRAME_BYTES];
+  unsigned ok = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < frames; ++i) {
+    const std::vector<DhtPulse>& capture = captures[i % captures.size()];
+    ok += decodeDhtPulses(capture.data(), capture.size(), decoded) == DHT_DECODE_OK;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("Decoded %u frames (%u ok) in %.3f s, %.0f ns/frame\n", frames, ok, seconds, seconds * 1e9 / frames);
+}
+
+static bool decodeFile(const char* path, DhtModel model) {
+  FILE* file = fopen(path, "r");
+  if (!file) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+
+  std::vector<DhtPulse> pulses;
+  int captures = 0;
+  auto flush = [&]() {
+    if (pulses.empty()) return;
+    uint8_t frame[DHT_FRAME_BYTES];
+    DhtDecodeStatus status = decodeDhtPulses(pulses.data(), pulses.size(), frame);
+    printf("capture %d: %zu pulses, %s", ++captures, pulses.size(), dhtDecodeStatusName(status));
+    if (status == DHT_DECODE_OK || status == DHT_DECODE_BAD_CHECKSUM) {
+      printf(", frame %02x %02x %02x %02x %02x", frame[0], frame[1], frame[2], frame[3], frame[4]);
+    }
+    if (status == DHT_DECODE_OK) {
+      float temperature, humidity;
+      dhtFrameToReading(model, frame, temperature, humidity);
+      printf(", %.1f C %.1f %%RH", temperature, humidity);
+    }
+    printf("\n");
+    pulses.clear();
+  };
+
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    char* text = line;
+    while (*text == ' ' || *text == '\t') text++;
+    if (*text == '#') continue;
+    if (*text == '\n' || *text == '\r' || *text == 0) {
+      flush();
+      continue;
+    }
+    unsigned level, micros;
+    if (sscanf(text, "%u %u", &level, &micros) == 2) {
+      pulses.push_back({(uint8_t)(level ? 1 : 0), (uint16_t)(micros > 0xFFFF ? 0xFFFF : micros)});
+    }
+  }
+  flush();
+  fclose(file);
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: dht_decode [--frames n] [--jitter us] [--file capture.txt] [--model dht11|dht22] [--dump]\n");
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--frames") && hasValue) options.frames = strtoul(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--jitter") && hasValue) options.jitter = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--file") && hasValue) options.file = argv[++i];
+    else if (!strcmp(argv[i], "--model") && hasValue) {
+      const char* model = argv[++i];
+      options.model = !strcmp(model, "dht11") ? DHT_MODEL_DHT11 : DHT_MODEL_DHT22;
+    }
+    else if (!strcmp(argv[i], "--dump")) options.dump = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+
+  if (options.file) return decodeFile(options.file, options.model) ? 0 : 1;
+
+  if (options.dump) {
+    uint8_t frame[DHT_FRAME_BYTES];
+    makeFrame(options.model, 22.4f, 51.0f, frame);
+    printf("# %s capture of 22.4 C, 51.0 %%RH, jitter +-%d us\n", options.model == DHT_MODEL_DHT11 ? "DHT11" : "DHT22", options.jitter);
+    for (const DhtPulse& pulse : makeCapture(frame, options.jitter, false)) printf("%u %u\n", pulse.level, pulse.micros);
+    return 0;
+  }
+
+  printf("Decoder checks\n");
+  checkRoundTrips(DHT_MODEL_DHT11, "DHT11", options.jitter);
+  checkRoundTrips(DHT_MODEL_DHT22, "DHT22", options.jitter);
+  checkFailures();
+  benchmark(options.frames, options.jitter);
+
+  if (failures) {
+    printf("%d checks FAILED\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
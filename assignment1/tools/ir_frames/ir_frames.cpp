@@ -0,0 +1,244 @@
+// ir_frames.cpp - Linux checks and benchmark for src/ir_frame.cpp
+//
+// Compares the RMT item buffers built by encodeDaikinFrame() against a
+// plain mark/space list laid out the way IRremoteESP8266's sendDaikin()
+// emits it, then checks the frame cache: repeat states hit, states that
+// differ only below the transmitted resolution share a frame, the least
+// recently used frame is the one evicted, and a frame's buffer is not
+// moved while it is cached. Finally times encoding against a cache hit.
+//
+// The Daikin bytes come from a stand-in for IRDaikinESP (the library does
+// not build on Linux), laid out like the real state with its checksums.
+// --dump prints a state's timings as a rawData array, the format
+// IRrecvDumpV2 prints, for comparison with a capture of the real remote.
+//
+// Build and run:
+//   pio run -e ir_frames
+//   .pio/build/ir_frames/program [--frames n] [--dump]
+#include <ir_frame.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static uint8_t sectionSum(const uint8_t* bytes, size_t length) {
+  uint8_t sum = 0;
+  for (size_t i = 0; i < length; ++i) sum += bytes[i];
+  return sum;
+}
+
+// Stand-in for IRDaikinESP::getRaw(): same sections and checksum bytes
+static unsigned encoderCalls = 0;
+static size_t encodeTestState(const ACState& state, uint8_t* bytes, size_t capacity) {
+  if (capacity < DAIKIN_STATE_LENGTH) return 0;
+  encoderCalls++;
+  static const uint8_t prefix[] = {0x11, 0xDA, 0x27, 0x00};
+  memset(bytes, 0, DAIKIN_STATE_LENGTH);
+  memcpy(bytes, prefix, 4);
+  bytes[4] = 0xC5;
+  bytes[7] = sectionSum(bytes, 7);
+  memcpy(bytes + 8, prefix, 4);
+  bytes[12] = 0x42;
+  bytes[15] = sectionSum(bytes + 8, 7);
+  memcpy(bytes + 16, prefix, 4);
+  uint8_t mode = irStateKey(state) >> 2 & 0x3F;
+  bytes[21] = (uint8_t)(mode << 4 | 0x08 | state.is_on);
+  bytes[22] = (uint8_t)(roundf(state.current_temp) * 2);
+  bytes[24] = state.fan_on ? 0xA0 : 0xB0;
+  bytes[34] = sectionSum(bytes + 16, 18);
+  return DAIKIN_STATE_LENGTH;
+}
+
+static size_t failingEncoder(const ACState&, uint8_t*, size_t) {
+  return 0;
+}
+
+// Reference: the mark/space sequence of sendDaikin(), written out longhand
+static std::vector<uint16_t> referenceTimings(const uint8_t* state, size_t length) {
+  std::vector<uint16_t> timings;
+  auto bits = [&timings](uint8_t value, int count) {
+    for (int bit = 0; bit < count; ++bit) {
+      timings.push_back(DAIKIN_BIT_MARK);
+      timings.push_back(value & (1 << bit) ? DAIKIN_ONE_SPACE : DAIKIN_ZERO_SPACE);
+    }
+  };
+  auto footer = [&timings]() {
+    timings.push_back(DAIKIN_BIT_MARK);
+    timings.push_back(DAIKIN_ZERO_SPACE + DAIKIN_GAP);
+  };
+
+  bits(0, DAIKIN_LEADER_BITS);
+  footer();
+  size_t sections[] = {0, DAIKIN_SECTION1_LENGTH, DAIKIN_SECTION1_LENGTH + DAIKIN_SECTION2_LENGTH, length};
+  for (int s = 0; s < 3; ++s) {
+    timings.push_back(DAIKIN_HDR_MARK);
+    timings.push_back(DAIKIN_HDR_SPACE);
+    for (size_t i = sections[s]; i < sections[s + 1]; ++i) bits(state[i], 8);
+    footer();
+  }
+  return timings;
+}
+
+// Back from RMT items to alternating mark/space durations, checking levels
+static bool unpack(const IrFrame& frame, std::vector<uint16_t>& timings) {
+  timings.clear();
+  for (uint32_t item : frame.items) {
+    if (!(item >> 15 & 1) || (item >> 31 & 1)) return false;   // Must be mark then space
+    timings.push_back(item & 0x7FFF);
+    timings.push_back(item >> 16 & 0x7FFF);
+  }
+  return true;
+}
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+  printf("  %-52s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok) failures++;
+}
+
+static ACState makeState(bool on, float temperature, const char* mode, bool fan) {
+  ACState state;
+  state.is_on = on;
+  state.current_temp = temperature;
+  state.mode = mode;
+  state.fan_on = fan;
+  return state;
+}
+
+static const char* modes[] = {"cool", "heat", "dry", "fan", "auto", "energy_saver"};
+
+static void checkEncoder() {
+  unsigned mismatches = 0;
+  size_t items = 0;
+  uint32_t duration = 0;
+  for (const char* mode : modes) {
+    for (int temperature = 10; temperature <= 32; ++temperature) {
+      for (int flags = 0; flags < 4; ++flags) {
+        uint8_t bytes[DAIKIN_STATE_LENGTH];
+        encodeTestState(makeState(flags & 1, temperature, mode, flags & 2), bytes, sizeof(bytes));
+        IrFrame frame;
+        encodeDaikinFrame(bytes, sizeof(bytes), frame);
+
+        std::vector<uint16_t> timings;
+        uint32_t sum = 0;
+        bool ok = unpack(frame, timings) && timings == referenceTimings(bytes, sizeof(bytes));
+        for (uint16_t t : timings) sum += t;
+        if (!ok || sum != frame.durationMicros) mismatches++;
+        items = frame.items.size();
+        duration = frame.durationMicros;
+      }
+    }
+  }
+  char what[96];
+  snprintf(what, sizeof(what), "timings match sendDaikin() (%zu items, %.1f ms)", items, duration / 1000.0);
+  expect(mismatches == 0, what);
+
+  IrFrame frame;
+  uint8_t shortState[4] = {};
+  encodeDaikinFrame(shortState, sizeof(shortState), frame);
+  expect(frame.items.empty(), "too short a state encodes nothing");
+}
+
+static void checkCache() {
+  encoderCalls = 0;
+  IrFrameCache cache(encodeTestState);
+  const IrFrame* cool22 = cache.get(makeState(true, 22, "cool", true));
+  const IrFrame* again = cache.get(makeState(true, 22, "cool", true));
+  expect(cool22 && cool22 == again && encoderCalls == 1, "repeat state is a hit, encoded once");
+
+  const IrFrame* rounded = cache.get(makeState(true, 22.3f, "cool", true));
+  expect(rounded == cool22, "22.3 C shares the 22 C frame");
+
+  const IrFrame* heat = cache.get(makeState(true, 22, "heat", true));
+  const IrFrame* saver = cache.get(makeState(true, 22, "energy_saver", true));
+  expect(heat != cool22 && saver != cool22 && saver != heat && encoderCalls == 3, "mode changes are distinct frames");
+
+  // Fill the cache, keeping the 22 C cool frame in use; the heat frame is oldest
+  cache.get(makeState(true, 22, "cool", true));
+  for (int t = 16; cache.size() < IR_FRAME_CACHE_SIZE; ++t) cache.get(makeState(true, t, "cool", false));
+  const uint32_t* buffer = cool22->items.data();
+  unsigned before = encoderCalls;
+  cache.get(makeState(false, 30, "auto", false));
+  expect(cache.stats().evictions == 1, "a full cache evicts one frame");
+  cache.get(makeState(true, 22, "cool", true));
+  expect(encoderCalls == before + 1 && cool22->items.data() == buffer, "recently used frame kept in place");
+  cache.get(makeState(true, 22, "heat", true));
+  expect(encoderCalls == before + 2, "least recently used frame was the one evicted");
+
+  IrFrameCache failing(failingEncoder);
+  expect(failing.get(makeState(true, 22, "cool", true)) == nullptr && failing.size() == 0, "encoder failure is not cached");
+}
+
+static void benchmark(unsigned frames) {
+  std::vector<ACState> states;
+  for (int t = 18; t < 18 + (int)IR_FRAME_CACHE_SIZE; ++t) states.push_back(makeState(true, t, "cool", true));
+
+  IrFrame frame;
+  uint8_t bytes[DAIKIN_STATE_LENGTH];
+  size_t items = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < frames; ++i) {
+    encodeTestState(states[i % states.size()], bytes, sizeof(bytes));
+    encodeDaikinFrame(bytes, sizeof(bytes), frame);
+    items += frame.items.size();
+  }
+  double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  IrFrameCache cache(encodeTestState);
+  start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < frames; ++i) items += cache.get(states[i % states.size()])->items.size();
+  double cachedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("Encode %.0f ns/frame, cache lookup %.0f ns/frame (%u frames, %zu items)\n",
+         encodeSeconds * 1e9 / frames, cachedSeconds * 1e9 / frames, frames, items);
+}
+
+static void dump() {
+  uint8_t bytes[DAIKIN_STATE_LENGTH];
+  encodeTestState(makeState(true, 22, "cool", true), bytes, sizeof(bytes));
+  IrFrame frame;
+  encodeDaikinFrame(bytes, sizeof(bytes), frame);
+  std::vector<uint16_t> timings;
+  unpack(frame, timings);
+  timings.pop_back();   // IRrecvDumpV2 ends on the last mark
+
+  printf("// Daikin, on, cool, 22 C, fan auto (test state bytes)\n");
+  printf("uint16_t rawData[%zu] = {", timings.size());
+  for (size_t i = 0; i < timings.size(); ++i) printf("%s%u", i ? (i % 16 ? ", " : ",\n    ") : "", timings[i]);
+  printf("};\n");
+}
+
+int main(int argc, char** argv) {
+  unsigned frames = 200000;
+  bool dumpFrame = false;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+      frames = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--dump")) {
+      dumpFrame = true;
+    } else {
+      fprintf(stderr, "usage: ir_frames [--frames n] [--dump]\n");
+      return 2;
+    }
+  }
+
+  if (dumpFrame) {
+    dump();
+    return 0;
+  }
+
+  printf("Encoder\n");
+  checkEncoder();
+  printf("Cache\n");
+  checkCache();
+  benchmark(frames);
+
+  if (failures) {
+    printf("%d checks FAILED\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
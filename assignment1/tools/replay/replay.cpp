@@ -0,0 +1,264 @@
+// replay.cpp - Host-side rule replay simulator and evaluation benchmark
+//
+// Runs the firmware's rule loader, compiler and evaluator (src/rules.cpp,
+// src/rule_program.cpp) on Linux against a data file exported from the
+// device via /download, using a simulated clock and timezone. Prints a
+// timeline of rules starting and stopping, of the resulting ACState changes
+// and of the IR frames the actuator would send, followed by evaluation
+// throughput so evaluator changes can be benchmarked.
+//
+// Build and run:
+//   pio run -e replay
+//   .pio/build/replay/program --rules data/rules.json --data data/data_5min.bin
+//       --tz "AEST-10AEDT,M10.1.0,M4.1.0/3" --step 15
+//
+// Options:
+//   --rules <file>   Rules JSON, either {"rules":[...]} or a bare array (default data/rules.json)
+//   --data <file>    data_5min.bin / data_hourly.bin / data_6hour.bin (default data/data_5min.bin)
+//   --tz <posix>     POSIX TZ string used for rule timeframes (default UTC0)
+//   --step <sec>     Evaluation interval between data points (default 15, the collection interval)
+//   --max-gap <sec>  Gaps longer than this are treated as downtime: one evaluation only (default 3600)
+//   --repeat <n>     Replay the data n times for a steadier throughput figure (default 1)
+//   --verbose        Keep the firmware's own Serial output
+#include <Arduino.h>
+#include <storage.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include <algorithm>
+#include <data.h>
+#include <rules.h>
+#include <actuator.h>
+#include <rule_program.h>
+#include <signals.h>
+#include <boot_profile.h>
+#include <civil_time.h>
+
+struct ReplayOptions {
+  String rulesPath = "data/rules.json";
+  String dataPath = "data/data_5min.bin";
+  String tz = "UTC0";
+  uint32_t step = 15;
+  uint32_t maxGap = 3600;
+  int repeat = 1;
+  bool verbose = false;
+};
+
+static std::vector<size_t> firedThisTick;
+
+static void onRuleFired(size_t ruleIndex, const char* ruleName) {
+  (void)ruleName;
+  firedThisTick.push_back(ruleIndex);
+}
+
+static uint32_t framesTransmitted = 0;
+
+static bool countFrame(const ACState& state) {
+  (void)state;
+  framesTransmitted++;
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: replay [--rules file] [--data file] [--tz posix] [--step sec] [--max-gap sec] [--repeat n] [--verbose]\n");
+}
+
+static bool parseArgs(int argc, char** argv, ReplayOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    String arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--verbose") options.verbose = true;
+    else if (arg == "--rules" && hasValue) options.rulesPath = argv[++i];
+    else if (arg == "--data" && hasValue) options.dataPath = argv[++i];
+    else if (arg == "--tz" && hasValue) options.tz = argv[++i];
+    else if (arg == "--step" && hasValue) options.step = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--max-gap" && hasValue) options.maxGap = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--repeat" && hasValue) options.repeat = atoi(argv[++i]);
+    else return false;
+  }
+  if (options.step == 0) options.step = 15;
+  if (options.repeat < 1) options.repeat = 1;
+  return true;
+}
+
+// Point the storage root at the file's directory and return its device path
+static String mountHostFile(const String& hostPath) {
+  int slash = hostPath.lastIndexOf('/');
+  setStorageRoot(slash < 0 ? String(".") : hostPath.substring(0, slash));
+  return "/" + (slash < 0 ? hostPath : hostPath.substring(slash + 1));
+}
+
+static bool loadReplayRules(const String& path) {
+  std::vector<uint8_t> contents;
+  if (!storage().read(mountHostFile(path).c_str(), contents)) {
+    fprintf(stderr, "Failed to open rules file %s\n", path.c_str());
+    return false;
+  }
+
+  DynamicJsonDocument doc(16384);
+  DeserializationError error = deserializeJson(doc, (const char*)contents.data(), contents.size());
+  if (error) {
+    fprintf(stderr, "Failed to parse rules file %s: %s\n", path.c_str(), error.c_str());
+    return false;
+  }
+
+  // The device stores {"rules":[...]}; /api/rules returns a bare array
+  JsonArray rulesArray = doc.is<JsonArray>() ? doc.as<JsonArray>() : doc["rules"].as<JsonArray>();
+
+  // Compile and publish directly; loadRulesFromJson() would also save the rules back to disk
+  if (!parseRuleSets(rulesArray, rules)) return false;
+  publishRuleProgram(buildRuleProgram(rules, 0, 0));
+  return true;
+}
+
+static String formatLocal(uint32_t epoch) {
+  time_t rawTime = epoch;
+  struct tm* timeInfo = localtime(&rawTime);
+  char buffer[32];
+  strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M %Z", timeInfo);
+  return String(buffer);
+}
+
+static void printStateChange(const ACState& before, const ACState& after) {
+  printf("    ac:");
+  if (before.is_on != after.is_on) printf(" power %s->%s", before.is_on ? "on" : "off", after.is_on ? "on" : "off");
+  if (before.current_temp != after.current_temp) printf(" temp %.1f->%.1f", before.current_temp, after.current_temp);
+  if (before.mode != after.mode) printf(" mode %s->%s", before.mode.c_str(), after.mode.c_str());
+  if (before.fan_on != after.fan_on) printf(" fan %s->%s", before.fan_on ? "on" : "off", after.fan_on ? "on" : "off");
+  printf("\n");
+}
+
+struct ReplayStats {
+  uint64_t ticks = 0;
+  uint64_t rulesFired = 0;
+  uint64_t stateChanges = 0;
+  uint64_t irFrames = 0;
+  uint64_t simulatedSeconds = 0;
+  double evalSeconds = 0;
+};
+
+static void replayOnce(const std::vector<DataPoint>& points, const ReplayOptions& options, bool printTimeline, ReplayStats& stats) {
+  const ACState initialState = ac_state;
+  std::vector<size_t> firedLastTick;
+  uint32_t lastNow = points.front().timestamp;
+  setupActuator(countFrame);
+  resetSignals();
+  framesTransmitted = 0;
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    const DataPoint& point = points[i];
+    temperature_data.temperature = point.temperature;
+    temperature_data.humidity = point.humidity;
+    temperature_data.feels_like = getFeelsLikeTemperature(point.temperature, point.humidity);
+    temperature_data.temperature_5min = point.temperature;
+    temperature_data.humidity_5min = point.humidity;
+    temperature_data.feels_like_5min = temperature_data.feels_like;
+    updateTrendSignals(point.temperature);
+
+    // Evaluate every `step` seconds until the next point, like the device would
+    uint32_t span = (i + 1 < points.size()) ? points[i + 1].timestamp - point.timestamp : options.step;
+    if (span > options.maxGap) span = options.step;
+    stats.simulatedSeconds += span;
+
+    for (uint32_t offset = 0; offset < span; offset += options.step) {
+      uint32_t now = point.timestamp + offset;
+      hostClockAdvanceMillis((unsigned long)(now - lastNow) * 1000);
+      hostClockSetEpoch(now);
+      lastNow = now;
+      updateSampleSignals(temperature_data.temperature, temperature_data.feels_like, millis(), hasACChanged(), getLastACChangeTime());
+
+      ACState before = ac_state;
+      firedThisTick.clear();
+      auto start = std::chrono::steady_clock::now();
+      evaluateRules();
+      stats.evalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      stats.ticks++;
+      stats.rulesFired += firedThisTick.size();
+
+      bool changed = !isSameACState(before, ac_state);
+      if (changed) stats.stateChanges++;
+      uint32_t resyncsBefore = getActuatorStats().resyncs;
+      bool sent = actuatorService(ac_state, millis());
+      bool resync = getActuatorStats().resyncs != resyncsBefore;
+
+      if (printTimeline && (changed || (sent && !resync) || firedThisTick != firedLastTick)) {
+        printf("%s  temp=%.1f hum=%.1f feels=%.1f\n", formatLocal(now).c_str(),
+               temperature_data.temperature, temperature_data.humidity, temperature_data.feels_like);
+        for (size_t rule : firedThisTick) {
+          if (std::find(firedLastTick.begin(), firedLastTick.end(), rule) == firedLastTick.end()) {
+            printf("    + %s\n", getRuleProgram()->ruleName(rule));
+          }
+        }
+        for (size_t rule : firedLastTick) {
+          if (std::find(firedThisTick.begin(), firedThisTick.end(), rule) == firedThisTick.end()) {
+            printf("    - %s\n", getRuleProgram()->ruleName(rule));
+          }
+        }
+        if (changed) printStateChange(before, ac_state);
+        if (sent && !resync) printf("    ir: frame sent\n");
+      }
+      firedLastTick = firedThisTick;
+    }
+  }
+
+  stats.irFrames += framesTransmitted;
+  ac_state = initialState;
+}
+
+int main(int argc, char** argv) {
+  ReplayOptions options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return 2;
+  }
+
+  beginBootProfile();
+  Serial.setQuiet(!options.verbose);
+  setLocalTimeZone(options.tz.c_str());
+
+  if (!loadReplayRules(options.rulesPath)) return 1;
+  markBootPhase("rules");
+
+  DataPointHeader header;
+  std::vector<DataPoint> points;
+  if (!loadDataPoints(mountHostFile(options.dataPath).c_str(), header, points) || points.empty()) {
+    fprintf(stderr, "No usable data points in %s\n", options.dataPath.c_str());
+    return 1;
+  }
+  std::stable_sort(points.begin(), points.end(), [](const DataPoint& a, const DataPoint& b) {
+    return a.timestamp < b.timestamp;
+  });
+  markBootPhase("data");
+
+  printf("Replaying %zu points (%s .. %s) against %zu rules, step %us, TZ %s\n",
+         points.size(), formatLocal(points.front().timestamp).c_str(), formatLocal(points.back().timestamp).c_str(),
+         getRuleProgram()->rules.size(), options.step, options.tz.c_str());
+
+  // Same phase hooks as the firmware's setup()
+  BootProfile profile;
+  getBootProfile(profile);
+  printf("Startup:");
+  for (uint32_t i = 0; i < profile.phaseCount; ++i) {
+    uint32_t start = i ? profile.phases[i - 1].endMicros : 0;
+    printf(" %s %.2f ms", profile.phases[i].name, (profile.phases[i].endMicros - start) / 1000.0);
+  }
+  printf("\n");
+
+  setRuleFiredCallback(onRuleFired);
+  ReplayStats stats;
+  auto wallStart = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < options.repeat; ++pass) {
+    replayOnce(points, options, pass == 0, stats);
+  }
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+  double ruleTicks = (double)stats.ticks * getRuleProgram()->rules.size();
+  printf("\n%llu ticks x %zu rules, %llu rule firings, %llu AC state changes, %llu IR frames (%u resyncs)\n",
+         (unsigned long long)stats.ticks, getRuleProgram()->rules.size(), (unsigned long long)stats.rulesFired,
+         (unsigned long long)stats.stateChanges, (unsigned long long)stats.irFrames, getActuatorStats().resyncs);
+  printf("Evaluation: %.3f s, %.0f rule-ticks/s, %.2f us/tick\n", stats.evalSeconds,
+         stats.evalSeconds > 0 ? ruleTicks / stats.evalSeconds : 0.0,
+         stats.ticks ? stats.evalSeconds * 1e6 / stats.ticks : 0.0);
+  printf("Simulated %.1f days in %.3f s (%.0fx real time)\n", stats.simulatedSeconds / 86400.0, wallSeconds,
+         wallSeconds > 0 ? stats.simulatedSeconds / wallSeconds : 0.0);
+  return 0;
+}
@@ -0,0 +1,129 @@
+// spsc_stress.cpp - Linux stress test for src/spsc_queue.h
+//
+// Runs a producer and a consumer thread against SpscQueue with no pacing,
+// so the queue spends most of its time either full or empty, and checks
+// that every item arrives exactly once, in order and intact. Covers a plain
+// integer payload at several capacities and a heap-owning payload that moves
+// through the queue the way flash write jobs do.
+//
+// Build and run:
+//   pio run -e spsc_stress
+//   .pio/build/spsc_stress/program [--items n]
+#include <spsc_queue.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+struct BufferItem {
+  uint32_t sequence = 0;
+  std::vector<uint8_t> bytes;
+};
+
+static uint8_t patternByte(uint32_t sequence, size_t index) {
+  return (uint8_t)(sequence * 31 + index * 7);
+}
+
+template <size_t Capacity>
+static bool stressSequence(uint64_t items) {
+  static SpscQueue<uint64_t, Capacity> queue;
+  std::atomic<bool> failed(false);
+  uint64_t fullSpins = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    for (uint64_t i = 0; i < items; ++i) {
+      while (!queue.push(i)) {
+        fullSpins++;
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::thread consumer([&] {
+    uint64_t value;
+    for (uint64_t expected = 0; expected < items && !failed; ) {
+      if (!queue.pop(value)) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (value != expected) {
+        fprintf(stderr, "capacity %zu: expected %llu, got %llu\n", Capacity,
+                (unsigned long long)expected, (unsigned long long)value);
+        failed = true;
+      }
+      expected++;
+    }
+  });
+  producer.join();
+  consumer.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool ok = !failed && queue.empty();
+  printf("%-6s u64     capacity %5zu: %llu items, %.1f M items/s, producer found it full %llu times\n",
+         ok ? "ok" : "FAILED", Capacity, (unsigned long long)items, items / seconds / 1e6, (unsigned long long)fullSpins);
+  return ok;
+}
+
+template <size_t Capacity>
+static bool stressBuffers(uint64_t items) {
+  static SpscQueue<BufferItem, Capacity> queue;
+  std::atomic<bool> failed(false);
+
+  auto start = std::chrono::steady_clock::now();
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < items; ++i) {
+      BufferItem item;
+      item.sequence = i;
+      item.bytes.resize(i % 97);
+      for (size_t b = 0; b < item.bytes.size(); ++b) item.bytes[b] = patternByte(i, b);
+      while (!queue.push(std::move(item))) std::this_thread::yield();
+    }
+  });
+  std::thread consumer([&] {
+    BufferItem item;
+    for (uint32_t expected = 0; expected < items && !failed; ) {
+      if (!queue.pop(item)) {
+        std::this_thread::yield();
+        continue;
+      }
+      bool intact = item.sequence == expected && item.bytes.size() == expected % 97;
+      for (size_t b = 0; intact && b < item.bytes.size(); ++b) intact = item.bytes[b] == patternByte(expected, b);
+      if (!intact) {
+        fprintf(stderr, "buffer %u arrived damaged or out of order (got sequence %u)\n", expected, item.sequence);
+        failed = true;
+      }
+      expected++;
+    }
+  });
+  producer.join();
+  consumer.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  bool ok = !failed && queue.empty();
+  printf("%-6s buffers capacity %5zu: %llu items, %.1f M items/s\n",
+         ok ? "ok" : "FAILED", Capacity, (unsigned long long)items, items / seconds / 1e6);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  uint64_t items = 10000000;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--items") && i + 1 < argc) {
+      items = strtoull(argv[++i], nullptr, 10);
+    } else {
+      fprintf(stderr, "usage: spsc_stress [--items n]\n");
+      return 2;
+    }
+  }
+
+  bool ok = true;
+  ok &= stressSequence<2>(items / 10);
+  ok &= stressSequence<8>(items);
+  ok &= stressSequence<1024>(items);
+  ok &= stressBuffers<8>(items / 10);
+  ok &= stressBuffers<32>(items / 10);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+// storage_bench.cpp - data file save/load latency on the POSIX storage backend
+//
+// Runs runStorageBenchmark() (src/storage_bench.cpp) against a host
+// directory, the same table the firmware prints at boot when built with
+// -D STORAGE_BENCHMARK for SPIFFS or LittleFS. Saves fsync() before the
+// rename, so the numbers depend on the disk under --root.
+//
+// Build and run:
+//   pio run -e storage_bench
+//   .pio/build/storage_bench/program [--root dir] [--iterations n]
+#include <storage.h>
+#include <storage_bench.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+  String root;
+  int iterations = 50;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--root") && i + 1 < argc) {
+      root = argv[++i];
+    } else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: storage_bench [--root dir] [--iterations n]\n");
+      return 2;
+    }
+  }
+
+  bool temporary = root.length() == 0;
+  if (temporary) {
+    char pattern[] = "/tmp/storage_bench.XXXXXX";
+    if (!mkdtemp(pattern)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    root = pattern;
+  }
+
+  setStorageRoot(root);
+  if (!storage().begin()) {
+    fprintf(stderr, "Cannot use %s as the storage root\n", root.c_str());
+    return 1;
+  }
+  printf("Root: %s\n", root.c_str());
+  runStorageBenchmark(iterations < 1 ? 1 : iterations);
+
+  if (temporary) rmdir(root.c_str());
+  return 0;
+}
@@ -0,0 +1,255 @@
+// time_bench.cpp - Linux checks and benchmark for src/civil_time.cpp
+//
+// Checks the integer calendar against every day from 1900 to 2200, then
+// checks the POSIX TZ handling against glibc for every zone in the firmware's
+// table (src/tz_table.h): each zone's rule goes to both, and the local time,
+// weekday, DST flag and UTC offset must agree at hourly samples around each
+// DST transition and at random instants from 1970 to 2100. LocalClock is
+// checked across a minute boundary and a zone change on the host's virtual
+// clock.
+//
+// Finally times the /api/data timestamp path: the old formatTimestamp()
+// (localtime() + strftime() + String) against the allocation-free form,
+// for one "year" request's worth of points.
+//
+// Build and run:
+//   pio run -e time_bench
+//   .pio/build/time_bench/program [--points n] [--rounds n]
+#include <Arduino.h>
+#include <HostClock.h>
+#include <civil_time.h>
+#include <timezones.h>
+#include <data.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+  printf("  %-60s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok) failures++;
+}
+
+static void checkCalendar() {
+  unsigned bad = 0;
+  int32_t days = daysFromCivil(1900, 1, 1);
+  for (int32_t year = 1900; year < 2200; ++year) {
+    for (uint32_t month = 1; month <= 12; ++month) {
+      for (uint32_t day = 1; day <= daysInMonth(year, month); ++day, ++days) {
+        int32_t y;
+        uint32_t m, d;
+        civilFromDays(days, y, m, d);
+        if (daysFromCivil(year, month, day) != days || y != year || m != month || d != day) bad++;
+      }
+    }
+  }
+  expect(bad == 0 && daysFromCivil(1970, 1, 1) == 0, "days <-> civil, 1900-2199");
+
+  CivilTime t;
+  utcToCivil(951782400, t);    // 2000-02-29 00:00 UTC, a Tuesday
+  expect(t.year == 2000 && t.month == 2 && t.day == 29 && t.weekday == 2, "leap day and weekday");
+  utcToCivil(-1, t);
+  expect(t.year == 1969 && t.month == 12 && t.day == 31 && t.hour == 23 && t.second == 59, "before the epoch");
+}
+
+// Compare one instant against glibc (TZ already set to the same rule)
+static bool matchesLibc(const TimeZone& zone, int64_t epoch) {
+  CivilTime ours;
+  toLocalTime(zone, epoch, ours);
+  time_t raw = (time_t)epoch;
+  struct tm theirs;
+  localtime_r(&raw, &theirs);
+  return ours.year == theirs.tm_year + 1900 && ours.month == theirs.tm_mon + 1 && ours.day == theirs.tm_mday &&
+         ours.hour == theirs.tm_hour && ours.minute == theirs.tm_min && ours.second == theirs.tm_sec &&
+         ours.weekday == theirs.tm_wday && ours.dst == (theirs.tm_isdst > 0) && ours.utcOffset == theirs.tm_gmtoff;
+}
+
+static void checkZones() {
+  std::mt19937_64 random(42);
+  std::uniform_int_distribution<int64_t> instant(0, 4102444800LL);   // 1970-2100
+  unsigned zonesBad = 0, samples = 0, parseFailures = 0;
+  const char* firstBad = nullptr;
+
+  for (size_t i = 0; i < getTimezoneCount(); ++i) {
+    const char* rule = getTimezoneRule(i);
+    TimeZone zone;
+    if (!parsePosixTz(rule, zone)) {
+      parseFailures++;
+      if (!firstBad) firstBad = getTimezoneName(i);
+      continue;
+    }
+    setenv("TZ", rule, 1);
+    tzset();
+
+    bool ok = true;
+    // Either side of each transition in the table
+    for (size_t year = 0; zone.hasDst && year < TZ_TABLE_YEARS; ++year) {
+      for (int64_t around : {zone.dstStart[year], zone.dstEnd[year]}) {
+        for (int64_t delta = -7200; delta <= 7200; delta += 1800, ++samples) ok &= matchesLibc(zone, around + delta);
+        ok &= matchesLibc(zone, around - 1) && matchesLibc(zone, around);
+      }
+    }
+    for (int n = 0; n < 2000; ++n, ++samples) ok &= matchesLibc(zone, instant(random));
+    if (!ok) {
+      zonesBad++;
+      if (!firstBad) firstBad = getTimezoneName(i);
+    }
+  }
+
+  char what[128];
+  snprintf(what, sizeof(what), "%zu zones parse", getTimezoneCount());
+  expect(parseFailures == 0, what);
+  snprintf(what, sizeof(what), "local time matches glibc (%u samples)", samples);
+  expect(zonesBad == 0, what);
+  if (firstBad) printf("    first mismatch: %s (%s)\n", firstBad, findPosixTz(firstBad));
+
+  TimeZone zone;
+  parsePosixTz(findPosixTz("Australia/Sydney"), zone);
+  expect(isSouthernDst(zone), "Sydney is southern");
+  parsePosixTz(findPosixTz("Europe/Berlin"), zone);
+  expect(zone.hasDst && !isSouthernDst(zone), "Berlin is northern");
+  expect(!parsePosixTz("not a zone", zone) && zone.stdOffset == 0, "garbage is UTC");
+}
+
+static void checkFormatting() {
+  TimeZone zone;
+  parsePosixTz("AEST-10AEDT,M10.1.0,M4.1.0/3", zone);
+  CivilTime t;
+  toLocalTime(zone, 1735689600, t);   // 2025-01-01 00:00 UTC
+  char buffer[48];
+  formatDateTime(buffer, t);
+  expect(!strcmp(buffer, "2025-01-01 11:00:00"), "formatDateTime (Sydney, DST)");
+  formatDateMinute(buffer, t);
+  expect(!strcmp(buffer, "2025-01-01 11:00"), "formatDateMinute");
+  formatHourMinute(buffer, t);
+  expect(!strcmp(buffer, "11:00") && !strcmp(weekdayName(t.weekday), "Wednesday"), "formatHourMinute, weekdayName");
+  formatTimestamp(buffer, sizeof(buffer), zone, 1735689600, "+00:00");
+  expect(!strcmp(buffer, "2025-01-01 11:00:00 +00:00"), "formatTimestamp with suffix");
+
+  // The String form still matches what strftime() gave
+  setLocalTimeZone("AEST-10AEDT,M10.1.0,M4.1.0/3");
+  time_t raw = 1735689600;
+  char expected[32];
+  strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", localtime(&raw));
+  expect(formatTimestamp(1735689600, "+00:00") == String(expected) + " +00:00", "String formatTimestamp unchanged");
+}
+
+static void checkLocalClock() {
+  setLocalTimeZone("JST-9");
+  hostClockSetEpoch(1735689600 + 58);   // 09:00:58 in Tokyo
+  LocalClock clock;
+  CivilTime t;
+  clock.now(t);
+  bool ok = t.hour == 9 && t.minute == 0 && t.second == 58;
+  hostClockAdvanceMillis(3000);
+  clock.now(t);
+  ok &= t.hour == 9 && t.minute == 1 && t.second == 1;
+  expect(ok, "LocalClock crosses a minute");
+
+  setLocalTimeZone("CET-1CEST,M3.5.0,M10.5.0/3");
+  clock.now(t);
+  expect(t.hour == 1 && t.minute == 1, "LocalClock follows a zone change");
+  hostClockUseRealTime();
+}
+
+template <typename F>
+static double nanosPer(unsigned count, F body) {
+  auto start = std::chrono::steady_clock::now();
+  body();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / count;
+}
+
+static void benchmark(unsigned points, unsigned rounds) {
+  setLocalTimeZone("AEST-10AEDT,M10.1.0,M4.1.0/3");
+  std::vector<uint32_t> stamps(points);
+  for (unsigned i = 0; i < points; ++i) stamps[i] = 1735689600 - (points - i) * 6 * 3600;   // 6-hour tier
+
+  // Before: what /api/data did for each point
+  size_t bytes = 0;
+  double before = nanosPer(points * rounds, [&] {
+    for (unsigned r = 0; r < rounds; ++r) {
+      for (uint32_t stamp : stamps) {
+        time_t rawTime = stamp;
+        struct tm* timeInfo = localtime(&rawTime);
+        char buffer[25];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeInfo);
+        String formattedTime(buffer);
+        formattedTime += String(" ") + "+00:00";
+        String quoted = "\"" + formattedTime + "\"";
+        bytes += quoted.length();
+      }
+    }
+  });
+
+  double after = nanosPer(points * rounds, [&] {
+    for (unsigned r = 0; r < rounds; ++r) {
+      TimeZone zone;
+      getLocalTimeZone(zone);
+      char stamp[40];
+      for (uint32_t epoch : stamps) {
+        stamp[0] = '"';
+        size_t length = 1 + formatTimestamp(stamp + 1, sizeof(stamp) - 2, zone, epoch, "+00:00");
+        stamp[length++] = '"';
+        bytes += length;
+      }
+    }
+  });
+
+  LocalClock clock;
+  CivilTime t;
+  double clockNanos = nanosPer(points * rounds, [&] {
+    for (unsigned i = 0; i < points * rounds; ++i) {
+      clock.now(t);
+      bytes += t.minute;
+    }
+  });
+  double libcNanos = nanosPer(points * rounds, [&] {
+    for (unsigned i = 0; i < points * rounds; ++i) {
+      time_t now = time(nullptr);
+      struct tm timeInfo;
+      localtime_r(&now, &timeInfo);
+      bytes += timeInfo.tm_min;
+    }
+  });
+
+  printf("Timestamps (%u points x %u): localtime+strftime+String %.0f ns, civil_time %.0f ns (%.1fx)\n",
+         points, rounds, before, after, before / after);
+  printf("Current local time: localtime_r %.0f ns, LocalClock %.0f ns (%.1fx)   [%zu]\n",
+         libcNanos, clockNanos, libcNanos / clockNanos, bytes % 10);
+}
+
+int main(int argc, char** argv) {
+  unsigned points = MAX_6HOUR_POINTS;
+  unsigned rounds = 200;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--points") && i + 1 < argc) {
+      points = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+      rounds = strtoul(argv[++i], nullptr, 10);
+    } else {
+      fprintf(stderr, "usage: time_bench [--points n] [--rounds n]\n");
+      return 2;
+    }
+  }
+
+  printf("Calendar\n");
+  checkCalendar();
+  printf("Time zones\n");
+  checkZones();
+  printf("Formatting\n");
+  checkFormatting();
+  printf("Local clock\n");
+  checkLocalClock();
+  benchmark(points, rounds);
+
+  if (failures) {
+    printf("%d checks FAILED\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""Timezone table for the firmware (src/tz_table.h).
+
+tools/tz/zones.csv maps each IANA zone name to its POSIX TZ string, in the
+format of https://github.com/nayarsystems/posix_tz_db/blob/master/zones.csv.
+This script turns it into constexpr tables that live in flash: the zone
+names sorted (for binary search) and packed into one string, the distinct
+rules packed into another, and an index of offsets into both.
+
+  gen_tz_table.py zoneinfo [/usr/share/zoneinfo] > tools/tz/zones.csv
+      Rebuild zones.csv from a compiled tz database. The POSIX rule is the
+      footer of each TZif file (version 2 and later).
+  gen_tz_table.py header [tools/tz/zones.csv] [src/tz_table.h]
+      Regenerate the header.
+
+Listed in platformio.ini as a pre: script, it regenerates the header before
+a build whenever zones.csv is newer.
+"""
+import csv
+import os
+import sys
+
+AREAS = ["Africa", "America", "Antarctica", "Arctic", "Asia", "Atlantic",
+         "Australia", "Europe", "Indian", "Pacific", "Etc"]
+SKIP = {"Factory", "localtime", "posixrules"}
+
+
+def read_footer(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(b"TZif") or data[4:5] not in (b"2", b"3", b"4"):
+        return None
+    # The footer is the last line: "\n<POSIX TZ>\n"
+    end = data.rstrip(b"\n")
+    start = end.rfind(b"\n")
+    return end[start + 1:].decode("ascii") if start >= 0 else None
+
+
+def zones_from_zoneinfo(root):
+    version = ""
+    tzdata = os.path.join(root, "tzdata.zi")
+    if os.path.exists(tzdata):
+        with open(tzdata) as f:
+            first = f.readline().split()
+            version = first[-1] if first[:2] == ["#", "version"] else ""
+
+    zones = {}
+    # Top-level names such as UTC and CET, which older configs use
+    for name in os.listdir(root):
+        path = os.path.join(root, name)
+        if os.path.isfile(path) and name not in SKIP and not name.startswith("."):
+            rule = read_footer(path)
+            if rule:
+                zones[name] = rule
+    for area in AREAS:
+        for directory, _, files in os.walk(os.path.join(root, area)):
+            for name in files:
+                path = os.path.join(directory, name)
+                rule = read_footer(path)
+                if rule:
+                    zones[os.path.relpath(path, root)] = rule
+    return version, zones
+
+
+def write_csv(version, zones, out):
+    if version:
+        out.write("# tzdata %s\n" % version)
+    writer = csv.writer(out, quoting=csv.QUOTE_ALL, lineterminator="\n")
+    for name in sorted(zones):
+        writer.writerow([name, zones[name]])
+
+
+def read_csv(path):
+    version = ""
+    zones = {}
+    with open(path, newline="") as f:
+        lines = []
+        for line in f:
+            if line.startswith("#"):
+                if "tzdata" in line:
+                    version = line.split()[-1]
+                continue
+            lines.append(line)
+    for row in csv.reader(lines):
+        if len(row) >= 2 and row[0]:
+            zones.setdefault(row[0], row[1])     # First entry wins on duplicates
+    return version, zones
+
+
+def c_string(strings):
+    # Adjacent literals split per entry so the header stays readable
+    return "\n".join('    "%s\\0"' % s.replace("\\", "\\\\").replace('"', '\\"') for s in strings)
+
+
+def render_header(version, zones):
+    names = sorted(zones, key=lambda name: name.encode())   # strcmp() order
+    rules = sorted(set(zones.values()))
+
+    name_offsets = []
+    offset = 0
+    for name in names:
+        name_offsets.append(offset)
+        offset += len(name) + 1
+    names_size = offset
+
+    rule_offsets = {}
+    offset = 0
+    for rule in rules:
+        rule_offsets[rule] = offset
+        offset += len(rule) + 1
+    rules_size = offset
+    if max(names_size, rules_size) > 0xFFFF:
+        raise SystemExit("timezone table too large for 16-bit offsets")
+
+    entries = ",\n".join("    {%d, %d}" % (name_offsets[i], rule_offsets[zones[name]])
+                         for i, name in enumerate(names))
+    return """// tz_table.h - generated by tools/tz/gen_tz_table.py from tools/tz/zones.csv; do not edit
+// %s%d zones, %d distinct rules, %d bytes of flash
+#ifndef TZ_TABLE_H
+#define TZ_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct TzEntry {
+    uint16_t name;               // Offset into TZ_NAMES
+    uint16_t rule;               // Offset into TZ_RULES
+};
+
+// Zone names, NUL separated, in strcmp() order
+constexpr char TZ_NAMES[] =
+%s;
+
+// POSIX TZ strings, each stored once
+constexpr char TZ_RULES[] =
+%s;
+
+constexpr TzEntry TZ_ENTRIES[] = {
+%s
+};
+
+constexpr size_t TZ_ZONE_COUNT = %d;
+
+#endif
+""" % ("tzdata %s, " % version if version else "", len(names), len(rules),
+       names_size + rules_size + 4 * len(names), c_string(names), c_string(rules), entries, len(names))
+
+
+def generate_header(csv_path, header_path):
+    version, zones = read_csv(csv_path)
+    header = render_header(version, zones)
+    if os.path.exists(header_path):
+        with open(header_path) as f:
+            if f.read() == header:
+                return False
+    with open(header_path, "w") as f:
+        f.write(header)
+    return True
+
+
+def main(argv):
+    here = os.path.dirname(os.path.abspath(__file__))
+    project = os.path.dirname(os.path.dirname(here))
+    if len(argv) >= 2 and argv[1] == "zoneinfo":
+        version, zones = zones_from_zoneinfo(argv[2] if len(argv) > 2 else "/usr/share/zoneinfo")
+        write_csv(version, zones, sys.stdout)
+    elif len(argv) >= 2 and argv[1] == "header":
+        csv_path = argv[2] if len(argv) > 2 else os.path.join(here, "zones.csv")
+        header_path = argv[3] if len(argv) > 3 else os.path.join(project, "src", "tz_table.h")
+        print("%s %s" % ("Wrote" if generate_header(csv_path, header_path) else "Unchanged", header_path))
+    else:
+        print(__doc__)
+        return 2
+    return 0
+
+
+try:
+    Import("env")    # Running as a PlatformIO extra script
+except NameError:
+    if __name__ == "__main__":
+        sys.exit(main(sys.argv))
+else:
+    _project = env["PROJECT_DIR"]
+    _csv = os.path.join(_project, "tools", "tz", "zones.csv")
+    _header = os.path.join(_project, "src", "tz_table.h")
+    if not os.path.exists(_header) or os.path.getmtime(_csv) > os.path.getmtime(_header):
+        if generate_header(_csv, _header):
+            print("Regenerated %s from %s" % (_header, _csv))
@@ -0,0 +1,410 @@
+// web_host.cpp - the firmware's web server on Linux, with a load generator
+//
+// setupWebServer() from src/web.cpp runs unchanged behind the POSIX socket
+// AsyncWebServer in lib/ArduinoHost, with the same JWT, data, config and
+// rules code as the device. Boot is the part of setup() the routes need:
+// config, time zone, the data series and sensors, rules. Files come from
+// --root (default data/, the file system image), so the pages, rules.json
+// and the three series files there are what gets served. POSTs write there.
+//
+// By default it then load-tests the server over loopback: for each route,
+// 1 to 16 keep-alive clients send requests back to back for --seconds, and
+// it prints requests/second, latency percentiles, response size and heap per
+// request. Heap is measured on the server thread around each handler (every
+// malloc/new while it runs): the peak above what was live when it started,
+// and the total allocated. The server thread runs handlers one at a time,
+// as the AsyncTCP task does on the device, so more clients show queueing.
+// Host numbers are not device numbers; compare a change against the code
+// before it.
+//
+// Build and run:
+//   pio run -e web_host
+//   .pio/build/web_host/program [--root data] [--seconds 2] [--clients 1,2,4,8,16]
+//       [--route /api/data?period=day ...]
+//   .pio/build/web_host/program --serve [--port 8080]   (then browse to it)
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <storage.h>
+#include <config.h>
+#include <data.h>
+#include <sensors.h>
+#include <rules.h>
+#include <daily_stats.h>
+#include <connectivity.h>
+#include <civil_time.h>
+#include <web.h>
+#include <ir_frame.h>
+#include <tasks.h>
+#include <arpa/inet.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---- Heap per request ----
+// The malloc family is wrapped at link time (-Wl,--wrap=malloc,...) and
+// operator new goes through malloc, so every allocation is seen. Only the
+// thread with `measuring` set is counted.
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t count, size_t size);
+extern "C" void* __real_realloc(void* pointer, size_t size);
+extern "C" void __real_free(void* pointer);
+
+static thread_local bool measuring = false;
+static thread_local int64_t liveBytes = 0;
+static thread_local int64_t peakBytes = 0;
+static thread_local uint64_t allocatedBytes = 0;
+
+static inline void noteAllocation(void* pointer) {
+  if (!measuring || !pointer) return;
+  size_t size = malloc_usable_size(pointer);
+  allocatedBytes += size;
+  liveBytes += size;
+  if (liveBytes > peakBytes) peakBytes = liveBytes;
+}
+
+static inline void noteFree(void* pointer) {
+  if (measuring && pointer) liveBytes -= malloc_usable_size(pointer);
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+  void* pointer = __real_malloc(size);
+  noteAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+  void* pointer = __real_calloc(count, size);
+  noteAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* __wrap_realloc(void* pointer, size_t size) {
+  noteFree(pointer);
+  void* moved = __real_realloc(pointer, size);
+  noteAllocation(moved);
+  return moved;
+}
+
+extern "C" void __wrap_free(void* pointer) {
+  noteFree(pointer);
+  __real_free(pointer);
+}
+
+void* operator new(size_t size) {
+  void* pointer = malloc(size ? size : 1);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
+
+static void beforeRequest(AsyncWebServerRequest&) {
+  liveBytes = peakBytes = 0;
+  allocatedBytes = 0;
+  measuring = true;
+}
+
+static void afterRequest(AsyncWebServerRequest&, AsyncWebServerResponse& response) {
+  measuring = false;
+  response.addHeader("X-Heap-Peak", String((unsigned long)peakBytes));
+  response.addHeader("X-Heap-Allocated", String((unsigned long)allocatedBytes));
+}
+
+// ---- Connectivity ----
+// connectivity.cpp drives the WiFi radio; on the host the network is up and
+// the clock is the system's
+
+void startConnectivity(TimeSyncCallback onTimeSynced) {}
+void serviceConnectivity() {}
+void updateWifiCredentials() {}
+ConnectivityState getConnectivityState() { return CONNECTIVITY_ONLINE; }
+bool isTimeSynced() { return true; }
+
+const char* connectivityStateName(ConnectivityState state) {
+  switch (state) {
+    case CONNECTIVITY_NO_CREDENTIALS: return "no_credentials";
+    case CONNECTIVITY_CONNECTING: return "connecting";
+    case CONNECTIVITY_BACKOFF: return "backoff";
+    case CONNECTIVITY_WAITING_FOR_TIME: return "waiting_for_time";
+    case CONNECTIVITY_ONLINE: return "online";
+  }
+  return "unknown";
+}
+
+// ---- What main.cpp and tasks.cpp provide on the device ----
+// There is no IR transmitter (the cache stays empty) and no I/O task:
+// telemetry is never serviced, and flash writes happen in the handler
+
+static size_t encodeNothing(const ACState& state, uint8_t* bytes, size_t capacity) { return 0; }
+IrFrameCache irFrames(encodeNothing);
+
+void wakeIoTask() {}
+
+// ---- Client ----
+
+struct Reply {
+  int status = 0;
+  size_t bytes = 0;
+  uint64_t heapPeak = 0;
+  uint64_t heapAllocated = 0;
+  std::string body;
+};
+
+static int connectTo(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  return fd;
+}
+
+static uint64_t headerNumber(const std::string& head, const char* name) {
+  size_t at = head.find(name);
+  return at == std::string::npos ? 0 : strtoull(head.c_str() + at + strlen(name), nullptr, 10);
+}
+
+// One request on an open keep-alive connection
+static bool exchange(int fd, const std::string& request, Reply& reply, bool keepBody) {
+  for (size_t sent = 0; sent < request.size();) {
+    ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    sent += n;
+  }
+
+  std::string input;
+  char buffer[65536];
+  size_t headEnd = std::string::npos;
+  size_t total = 0;
+  while (true) {
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0) return false;
+    input.append(buffer, n);
+    if (headEnd == std::string::npos && (headEnd = input.find("\r\n\r\n")) != std::string::npos) {
+      std::string head = input.substr(0, headEnd);
+      reply.status = atoi(head.c_str() + 9);
+      reply.heapPeak = headerNumber(head, "X-Heap-Peak: ");
+      reply.heapAllocated = headerNumber(head, "X-Heap-Allocated: ");
+      total = headEnd + 4 + headerNumber(head, "Content-Length: ");
+    }
+    if (headEnd != std::string::npos && input.size() >= total) break;
+  }
+  reply.bytes = total - headEnd - 4;
+  if (keepBody) reply.body = input.substr(headEnd + 4, reply.bytes);
+  return true;
+}
+
+static std::string getRequest(const std::string& route, const std::string& token) {
+  return "GET " + route + " HTTP/1.1\r\nHost: localhost\r\nAuthorization: Bearer " + token + "\r\n\r\n";
+}
+
+static std::string login(uint16_t port) {
+  std::string body = std::string("username=") + config.web_username.c_str() + "&password=" + config.web_userpass.c_str();
+  std::string request = "POST /login HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+  Reply reply;
+  int fd = connectTo(port);
+  bool ok = fd >= 0 && exchange(fd, request, reply, true) && reply.status == 200;
+  if (fd >= 0) close(fd);
+  size_t at = reply.body.find("\"token\":\"");
+  if (!ok || at == std::string::npos) return std::string();
+  at += 9;
+  return reply.body.substr(at, reply.body.find('"', at) - at);
+}
+
+struct LoadResult {
+  std::vector<uint32_t> latencies;   // Microseconds
+  uint64_t bytes = 0;
+  uint64_t heapPeak = 0;
+  uint64_t heapPeakMax = 0;
+  uint64_t heapAllocated = 0;
+  uint32_t errors = 0;
+  double seconds = 0;
+};
+
+static LoadResult runLoad(uint16_t port, const std::string& route, const std::string& token, int clients, double seconds) {
+  std::vector<LoadResult> perClient(clients);
+  std::vector<std::thread> threads;
+  std::atomic<bool> go(false);
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+  std::string request = getRequest(route, token);
+
+  for (int c = 0; c < clients; ++c) {
+    threads.emplace_back([&, c] {
+      LoadResult& result = perClient[c];
+      int fd = connectTo(port);
+      while (!go) std::this_thread::yield();
+      while (std::chrono::steady_clock::now() < deadline) {
+        if (fd < 0 && (fd = connectTo(port)) < 0) {
+          result.errors++;
+          continue;
+        }
+        Reply reply;
+        auto sent = std::chrono::steady_clock::now();
+        bool ok = exchange(fd, request, reply, false);
+        auto received = std::chrono::steady_clock::now();
+        if (!ok || reply.status != 200) {
+          result.errors++;
+          if (!ok) {
+            close(fd);
+            fd = -1;
+          }
+          continue;
+        }
+        result.latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(received - sent).count());
+        result.bytes += reply.bytes;
+        result.heapPeak += reply.heapPeak;
+        result.heapPeakMax = std::max(result.heapPeakMax, reply.heapPeak);
+        result.heapAllocated += reply.heapAllocated;
+      }
+      if (fd >= 0) close(fd);
+    });
+  }
+  start = std::chrono::steady_clock::now();
+  go = true;
+  for (std::thread& t : threads) t.join();
+
+  LoadResult total;
+  total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (const LoadResult& r : perClient) {
+    total.latencies.insert(total.latencies.end(), r.latencies.begin(), r.latencies.end());
+    total.bytes += r.bytes;
+    total.heapPeak += r.heapPeak;
+    total.heapPeakMax = std::max(total.heapPeakMax, r.heapPeakMax);
+    total.heapAllocated += r.heapAllocated;
+    total.errors += r.errors;
+  }
+  std::sort(total.latencies.begin(), total.latencies.end());
+  return total;
+}
+
+static double percentileMillis(const std::vector<uint32_t>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t index = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+  return sorted[index] / 1000.0;
+}
+
+static std::vector<int> parseClients(const char* text) {
+  std::vector<int> clients;
+  for (const char* at = text; *at;) {
+    char* end;
+    long n = strtol(at, &end, 10);
+    if (end == at || n < 1) return std::vector<int>();
+    clients.push_back(n);
+    at = *end == ',' ? end + 1 : end;
+  }
+  return clients;
+}
+
+static void usage() {
+  fprintf(stderr, "usage: web_host [--root dir] [--serve] [--port n] [--seconds s] [--clients 1,2,4,8,16] [--route path]...\n");
+}
+
+int main(int argc, char** argv) {
+  String root = "data";
+  bool serve = false;
+  int port = -1;
+  double seconds = 2;
+  std::vector<int> clients = {1, 2, 4, 8, 16};
+  std::vector<std::string> routes;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--root") && i + 1 < argc) {
+      root = argv[++i];
+    } else if (!strcmp(argv[i], "--serve")) {
+      serve = true;
+    } else if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+      port = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--clients") && i + 1 < argc) {
+      clients = parseClients(argv[++i]);
+      if (clients.empty()) {
+        usage();
+        return 2;
+      }
+    } else if (!strcmp(argv[i], "--route") && i + 1 < argc) {
+      routes.push_back(argv[++i]);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (routes.empty()) {
+    routes = {"/api/data?period=day", "/api/data?period=week", "/api/data?period=year",
+              "/api/stats?from=2000-01-01", "/api/rules", "/api/config", "/dashboard", "/settings"};
+  }
+
+  // What setup() does before the web server, minus the hardware
+  Serial.setQuiet(!serve);
+  setStorageRoot(root);
+  if (!storage().begin()) {
+    fprintf(stderr, "%s is not a directory\n", root.c_str());
+    return 1;
+  }
+  loadConfig();
+  setLocalTimeZone(config.posix_tz.c_str());
+  loadHistoricalData();
+  if (config.sensors.empty()) config.sensors.push_back(defaultSensorConfig());
+  setupSensors(config.sensors);
+  loadDailyStats(temperatureData5Min);
+  loadRules();
+
+  setWebServerPort(port >= 0 ? port : serve ? 8080 : 0);
+  setWebRequestHooks(beforeRequest, afterRequest);
+  setupWebServer();
+  if (!webServerPort()) return 1;
+
+  if (serve) {
+    printf("Serving %s on http://localhost:%u/ (user %s)\n", root.c_str(), webServerPort(), config.web_username.c_str());
+    fflush(stdout);
+    while (true) sleep(60);
+  }
+
+  std::string token = login(webServerPort());
+  if (token.empty()) {
+    fprintf(stderr, "POST /login failed\n");
+    return 1;
+  }
+  printf("%u 5-minute, %u hourly and %u 6-hour points from %s; %.1f s per run\n\n",
+         (unsigned)temperatureData5Min.size(), (unsigned)temperatureDataHourly.size(),
+         (unsigned)temperatureData6Hour.size(), root.c_str(), seconds);
+  printf("%-24s %7s %9s %8s %8s %8s %8s %9s %10s %10s %6s\n", "Route", "Clients", "Req/s", "p50 ms", "p90 ms",
+         "p99 ms", "max ms", "KB/resp", "Heap peak", "Allocated", "Errors");
+
+  int failures = 0;
+  for (const std::string& route : routes) {
+    runLoad(webServerPort(), route, token, 1, 0.05);    // Warm up (rules are loaded on first use)
+    for (int n : clients) {
+      LoadResult result = runLoad(webServerPort(), route, token, n, seconds);
+      size_t count = result.latencies.size();
+      double perRequest = count ? 1.0 / count : 0;
+      printf("%-24s %7d %9.0f %8.2f %8.2f %8.2f %8.2f %9.1f %9.1fK %9.1fK %6u\n", route.c_str(), n,
+             count / result.seconds, percentileMillis(result.latencies, 0.5), percentileMillis(result.latencies, 0.9),
+             percentileMillis(result.latencies, 0.99), count ? result.latencies.back() / 1000.0 : 0,
+             result.bytes * perRequest / 1024, result.heapPeak * perRequest / 1024,
+             result.heapAllocated * perRequest / 1024, result.errors);
+      if (!count || result.errors) failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,635 @@
+// year_sim.cpp - a year of the control task on Linux against a virtual clock
+//
+// Boots the firmware's control side the way setup() does (config, series,
+// sensors, staging, rules, actuator) into a scratch directory and then runs
+// the real scheduler tasks from src/control.cpp - sampling, rule passes, the
+// actuator, the 5-minute/hourly/6-hour rollups and the durability window
+// flushes - with HostClock jumping straight to each next deadline. The DHTs
+// are a simulated room behind the host pulse source in dht_rmt.h: a daily and
+// a seasonal cycle plus slowly wandering weather and a little noise, encoded
+// as DHT frames and decoded by the real decoder, with a few failed captures
+// so the retries run too. A year takes seconds.
+//
+// It reports, per month and in total:
+//   CPU     process CPU time per simulated day (scheduler, tasks, flash I/O)
+//   heap    peak and live bytes (malloc/new wrapped at link time), so a slow
+//           leak shows as live heap still growing once the tiers are full
+//   flash   bytes written per file and the erase blocks that takes
+//           (estimateEraseBlocks()), spread over the partition for a
+//           wear figure
+//   tiers   the final contents of every tier, checked against its capacity
+//           and against the files after a shutdown flush
+//   stats   the daily statistics (daily_stats.h), checked against the
+//           5-minute tier for the days it still holds and against /stats.bin
+// Exits non-zero if a check fails. Compare runs before and after a change.
+//
+// Build and run:
+//   pio run -e year_sim
+//   .pio/build/year_sim/program [--days 400] [--sensors 1] [--window minutes]
+//       [--start epoch] [--tz posix] [--rules data/rules.json] [--failures percent]
+//       [--root dir] [--partition KB] [--seed n] [--verbose]
+#include <Arduino.h>
+#include <storage.h>
+#include <config.h>
+#include <data.h>
+#include <sensors.h>
+#include <rules.h>
+#include <rule_program.h>
+#include <actuator.h>
+#include <signals.h>
+#include <persistence.h>
+#include <scheduler.h>
+#include <telemetry.h>
+#include <connectivity.h>
+#include <control.h>
+#include <daily_stats.h>
+#include <civil_time.h>
+#include <dht_rmt.h>
+#include <ir_frame.h>
+#include <tasks.h>
+#include <HostClock.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---- Heap ----
+// The malloc family is wrapped at link time (-Wl,--wrap=malloc,...) and
+// operator new goes through malloc. Everything runs on this thread.
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t count, size_t size);
+extern "C" void* __real_realloc(void* pointer, size_t size);
+extern "C" void __real_free(void* pointer);
+
+static bool measuring = false;
+static int64_t liveBytes = 0;
+static int64_t peakBytes = 0;
+
+static inline void noteAllocation(void* pointer) {
+  if (!measuring || !pointer) return;
+  liveBytes += malloc_usable_size(pointer);
+  if (liveBytes > peakBytes) peakBytes = liveBytes;
+}
+
+static inline void noteFree(void* pointer) {
+  if (measuring && pointer) liveBytes -= malloc_usable_size(pointer);
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+  void* pointer = __real_malloc(size);
+  noteAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t size) {
+  void* pointer = __real_calloc(count, size);
+  noteAllocation(pointer);
+  return pointer;
+}
+
+extern "C" void* __wrap_realloc(void* pointer, size_t size) {
+  noteFree(pointer);
+  void* moved = __real_realloc(pointer, size);
+  noteAllocation(moved);
+  return moved;
+}
+
+extern "C" void __wrap_free(void* pointer) {
+  noteFree(pointer);
+  __real_free(pointer);
+}
+
+void* operator new(size_t size) {
+  void* pointer = malloc(size ? size : 1);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
+
+// ---- Flash ----
+// Every write the firmware makes, per file, on top of the POSIX backend
+
+struct FileWrites {
+  uint32_t writes = 0;
+  uint64_t bytes = 0;
+  uint64_t eraseBlocks = 0;
+};
+
+class CountingStorage : public Storage {
+public:
+  std::map<std::string, FileWrites> files;
+  uint64_t bytes = 0;
+
+  explicit CountingStorage(Storage& inner) : inner(inner) {}
+
+  const char* name() const override { return inner.name(); }
+  bool begin(bool formatOnFail) override { return inner.begin(formatOnFail); }
+  bool exists(const char* path) override { return inner.exists(path); }
+  bool stat(const char* path, StorageStat& info) override { return inner.stat(path, info); }
+  bool read(const char* path, std::vector<uint8_t>& contents) override { return inner.read(path, contents); }
+  size_t readAt(const char* path, size_t offset, uint8_t* buffer, size_t length) override {
+    return inner.readAt(path, offset, buffer, length);
+  }
+  bool append(const char* path, const uint8_t* data, size_t length) override {
+    count(path, length);
+    return inner.append(path, data, length);
+  }
+  bool replace(const char* path, const uint8_t* data, size_t length) override {
+    count(path, length);
+    return inner.replace(path, data, length);
+  }
+  bool remove(const char* path) override { return inner.remove(path); }
+  bool list(const char* directory, std::vector<StorageEntry>& entries) override { return inner.list(directory, entries); }
+  size_t totalBytes() override { return inner.totalBytes(); }
+  size_t usedBytes() override { return inner.usedBytes(); }
+  fs::FS& filesystem() override { return inner.filesystem(); }
+
+private:
+  Storage& inner;
+
+  void count(const char* path, size_t length) {
+    FileWrites& file = files[path];
+    file.writes++;
+    file.bytes += length;
+    file.eraseBlocks += estimateEraseBlocks(length);
+    bytes += length;
+  }
+};
+
+// ---- The room ----
+
+struct SimOptions {
+  uint32_t days = 400;                 // Past a year, so the 6-hour tier fills and rotates
+  uint32_t start = 1735689600;         // 2025-01-01 00:00 UTC
+  size_t sensors = 1;
+  int32_t window = -1;                 // Durability window; -1 keeps the config's
+  String tz;                           // Empty keeps the config's
+  String rules = "data/rules.json";
+  String root;                         // Empty: a scratch directory, removed afterwards
+  double failures = 1.0;               // Percent of captures that fail
+  uint32_t partitionKB = 896;          // SPIFFS in huge_app.csv
+  uint32_t seed = 1;
+  bool verbose = false;
+};
+
+static SimOptions options;
+static std::mt19937 rng;
+static TimeZone zone;
+
+struct Weather {
+  uint32_t epoch = 0;
+  float temperature = 0;               // Offsets from the cycles, wandering over days
+  float humidity = 0;
+};
+static Weather weather[MAX_SENSORS];
+
+// Indoor temperature and humidity for sensor `index` at `epoch`
+static void roomAt(size_t index, uint32_t epoch, float& temperature, float& humidity) {
+  const double tau = 3 * 86400.0;      // Weather changes over a few days
+  Weather& w = weather[index];
+  std::normal_distribution<float> normal(0, 1);
+  if (w.epoch && epoch > w.epoch) {
+    double decay = exp(-(double)(epoch - w.epoch) / tau);
+    float spread = (float)sqrt(1 - decay * decay);
+    w.temperature = w.temperature * decay + 2.0f * spread * normal(rng);
+    w.humidity = w.humidity * decay + 8.0f * spread * normal(rng);
+  }
+  w.epoch = epoch;
+
+  CivilTime local;
+  toLocalTime(zone, epoch, local);
+  int32_t dayOfYear = daysFromCivil(local.year, local.month, local.day) - daysFromCivil(local.year, 1, 1);
+  double hour = local.hour + local.minute / 60.0 + local.second / 3600.0;
+  double warmestDay = isSouthernDst(zone) ? 25 : 205;   // Late January or late July
+  double season = cos(2 * M_PI * (dayOfYear - warmestDay) / 365.25);
+  double day = cos(2 * M_PI * (hour - 15) / 24);        // Warmest mid-afternoon
+
+  temperature = (float)(21 + 5 * season + 3 * day) + w.temperature + 0.5f * index + 0.15f * normal(rng);
+  humidity = (float)(55 + 10 * season - 8 * day) + w.humidity + 0.5f * normal(rng);
+  humidity = std::min(95.0f, std::max(10.0f, humidity));
+}
+
+static void makeFrame(DhtModel model, float temperature, float humidity, uint8_t frame[DHT_FRAME_BYTES]) {
+  int t = (int)(fabsf(temperature) * 10 + 0.5f);
+  int h = (int)(humidity * 10 + 0.5f);
+  if (model == DHT_MODEL_DHT11) {
+    frame[0] = h / 10;
+    frame[1] = h % 10;
+    frame[2] = t / 10;
+    frame[3] = (t % 10) | (temperature < 0 ? 0x80 : 0);
+  } else {
+    frame[0] = h >> 8;
+    frame[1] = h & 0xFF;
+    frame[2] = ((t >> 8) & 0x7F) | (temperature < 0 ? 0x80 : 0);
+    frame[3] = t & 0xFF;
+  }
+  frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+}
+
+// The capture as the RMT records it, from the release of the start signal
+static size_t roomPulses(uint8_t pin, DhtModel model, DhtPulse* pulses, size_t capacity) {
+  size_t index = 0;
+  while (index < config.sensors.size() && config.sensors[index].pin != pin) index++;
+  if (index == config.sensors.size()) return 0;
+
+  std::uniform_real_distribution<double> chance(0, 100);
+  if (chance(rng) < options.failures) return 0;        // No response
+
+  float temperature, humidity;
+  roomAt(index, getCurrentEpoch(), temperature, humidity);
+  uint8_t frame[DHT_FRAME_BYTES];
+  makeFrame(model, temperature, humidity, frame);
+
+  std::uniform_int_distribution<int> jitter(-4, 4);
+  size_t count = 0;
+  auto add = [&](uint8_t level, int micros) {
+    if (count < capacity) pulses[count++] = {level, (uint16_t)(micros + jitter(rng))};
+  };
+  add(1, 30);                                         // Line released, pull-up
+  add(0, 80);                                         // Response
+  add(1, 80);
+  for (size_t bit = 0; bit < DHT_FRAME_BITS; ++bit) {
+    add(0, 50);
+    add(1, frame[bit / 8] & (0x80 >> (bit % 8)) ? 70 : 27);
+  }
+  add(0, 50);
+  return count;
+}
+
+// ---- What main.cpp, tasks.cpp and connectivity.cpp provide on the device ----
+// The clock is set from the start, so the network is up and synced
+
+static uint32_t framesSent = 0;
+
+static bool countFrame(const ACState& state) {
+  (void)state;
+  framesSent++;
+  return true;
+}
+
+static size_t encodeNothing(const ACState& state, uint8_t* bytes, size_t capacity) { return 0; }
+IrFrameCache irFrames(encodeNothing);
+
+void wakeIoTask() {}
+
+void startConnectivity(TimeSyncCallback onTimeSynced) {}
+void serviceConnectivity() {}
+ConnectivityState getConnectivityState() { return CONNECTIVITY_ONLINE; }
+bool isTimeSynced() { return true; }
+const char* connectivityStateName(ConnectivityState state) { return "online"; }
+
+// ---- Run ----
+
+static double cpuSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static String formatDate(uint32_t epoch) {
+  CivilTime local;
+  toLocalTime(zone, epoch, local);
+  char buffer[20];
+  formatDateTime(buffer, local);
+  buffer[10] = '\0';
+  return String(buffer);
+}
+
+static bool copyFile(const String& from, const String& to) {
+  FILE* in = fopen(from.c_str(), "rb");
+  if (!in) return false;
+  std::vector<uint8_t> contents;
+  uint8_t buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) contents.insert(contents.end(), buffer, buffer + n);
+  fclose(in);
+  return storage().replace(to.c_str(), contents.data(), contents.size());
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* format, const String& what) {
+  if (ok) return;
+  printf("FAIL: ");
+  printf(format, what.c_str());
+  printf("\n");
+  failures++;
+}
+
+// One tier: contents, capacity, order, and whether the file matches after the flush
+static uint32_t statsDaysAtBoot = 0;
+
+// Daily statistics: as many days as the run finished (up to a year), each
+// agreeing with the 5-minute points it was built from, and the same on flash
+static void reportDailyStats() {
+  std::vector<DailyStats> days;
+  readDailyStats(0, UINT16_MAX, days);
+  DailyStats today;
+  bool haveToday = getTodayStats(today);
+  size_t finished = days.size() - (haveToday ? 1 : 0);
+  printf("\nDaily statistics: %u finished days, %u points today\n", (unsigned)finished, haveToday ? today.points : 0);
+  for (size_t i = days.size() > 3 ? days.size() - 3 : 0; i < days.size(); ++i) {
+    const DailyStats& day = days[i];
+    int32_t year;
+    uint32_t month, date;
+    civilFromDays(day.day, year, month, date);
+    printf("  %04d-%02u-%02u  %3u points  %5.1f / %5.1f / %5.1f °C  %4.1f h above %.1f, %4.1f h below %.1f, AC on %4.1f h\n",
+           (int)year, (unsigned)month, (unsigned)date, day.points, day.minTemperature / 10.0,
+           day.temperatureSum / 10.0 / day.points, day.maxTemperature / 10.0, day.pointsAbove / 12.0, day.high / 10.0,
+           day.pointsBelow / 12.0, day.low / 10.0, day.acOnPoints / 12.0);
+  }
+  // The first and last day of the run are partial, and fall in one local day or
+  // two; a resumed run also finishes the day it was stopped in
+  size_t added = finished - statsDaysAtBoot;
+  check(finished == DAILY_STATS_DAYS || (added + 1 >= options.days && added <= options.days + 1),
+        "%sdaily statistics are missing days", "");
+
+  // Recompute the finished days the 5-minute tier still covers completely
+  std::map<uint16_t, std::vector<float>> byDay;
+  for (size_t i = 0; i < temperatureData5Min.size(); ++i) {
+    byDay[getLocalDay(temperatureData5Min[i].timestamp)].push_back(temperatureData5Min[i].temperature);
+  }
+  size_t compared = 0;
+  for (const DailyStats& day : days) {
+    auto points = byDay.find(day.day);
+    if (points == byDay.end() || points == byDay.begin() || (haveToday && day.day == today.day)) continue;
+    float minimum = INFINITY, maximum = -INFINITY;
+    double sum = 0;
+    for (float t : points->second) {
+      minimum = std::min(minimum, t);
+      maximum = std::max(maximum, t);
+      sum += t;
+    }
+    bool same = points->second.size() == day.points && fabs(minimum - day.minTemperature / 10.0) < 0.051 &&
+                fabs(maximum - day.maxTemperature / 10.0) < 0.051 &&
+                fabs(sum / day.points - day.temperatureSum / 10.0 / day.points) < 0.051;
+    check(same, "%sdaily statistics differ from the 5-minute points", "");
+    compared++;
+  }
+  printf("  %u days checked against the 5-minute tier\n", (unsigned)compared);
+
+  std::vector<uint8_t> contents;
+  DailyStatsFileHeader header;
+  bool stored = storage().read(DAILY_STATS_PATH, contents) && contents.size() >= sizeof(header);
+  if (stored) memcpy(&header, contents.data(), sizeof(header));
+  check(stored && header.count == finished &&
+        !memcmp(contents.data() + sizeof(header), days.data(), finished * sizeof(DailyStats)),
+        "%s differs from memory", DAILY_STATS_PATH);
+}
+
+static void reportTier(const Sensor& sensor, const char* tier, const DataSeries& series, uint32_t spacing) {
+  String path = sensorDataPath(sensor, tier);
+  String label = sensor.config.id + " " + tier;
+  size_t expected = std::min((size_t)((uint64_t)options.days * 86400 / spacing), series.capacity());
+
+  float minimum = INFINITY, maximum = -INFINITY;
+  double sum = 0;
+  bool ordered = true;
+  for (size_t i = 0; i < series.size(); ++i) {
+    minimum = std::min(minimum, series[i].temperature);
+    maximum = std::max(maximum, series[i].temperature);
+    sum += series[i].temperature;
+    if (i && series[i].timestamp <= series[i - 1].timestamp) ordered = false;
+  }
+  printf("  %-14s %5u/%-5u", label.c_str(), (unsigned)series.size(), (unsigned)series.capacity());
+  if (!series.empty()) {
+    printf("  %s .. %s  %5.1f / %5.1f / %5.1f °C", formatDate(series[0].timestamp).c_str(),
+           formatDate(series.back().timestamp).c_str(), minimum, sum / series.size(), maximum);
+  }
+  printf("\n");
+
+  // A point or two either way for where the first rollup of each period lands
+  check(series.size() + 2 >= expected && series.size() <= series.capacity(), "%s holds fewer points than a run this long should", label);
+  check(ordered, "%s timestamps are out of order", label);
+  check(series.size() < series.capacity() || series.back().timestamp - series[0].timestamp < series.capacity() * spacing + spacing,
+        "%s keeps points older than its capacity covers", label);
+
+  DataSeries stored(series.capacity());
+  check(loadSeries(path.c_str(), stored, tier) && stored.size() == series.size(), "%s file differs from memory", label);
+  for (size_t i = 0; i < stored.size() && i < series.size(); ++i) {
+    if (stored[i].timestamp != series[i].timestamp || stored[i].temperature != series[i].temperature) {
+      check(false, "%s file differs from memory", label);
+      break;
+    }
+  }
+}
+
+static void usage() {
+  fprintf(stderr, "usage: year_sim [--days n] [--sensors n] [--window minutes] [--start epoch] [--tz posix] [--rules file]\n"
+                  "                [--failures percent] [--root dir] [--partition KB] [--seed n] [--verbose]\n");
+}
+
+static bool parseArgs(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    String arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--verbose") options.verbose = true;
+    else if (arg == "--days" && hasValue) options.days = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--sensors" && hasValue) options.sensors = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--window" && hasValue) options.window = atoi(argv[++i]);
+    else if (arg == "--start" && hasValue) options.start = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--tz" && hasValue) options.tz = argv[++i];
+    else if (arg == "--rules" && hasValue) options.rules = argv[++i];
+    else if (arg == "--failures" && hasValue) options.failures = atof(argv[++i]);
+    else if (arg == "--root" && hasValue) options.root = argv[++i];
+    else if (arg == "--partition" && hasValue) options.partitionKB = strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--seed" && hasValue) options.seed = strtoul(argv[++i], nullptr, 10);
+    else return false;
+  }
+  return options.days > 0 && options.sensors >= 1 && options.sensors <= MAX_SENSORS && options.start >= MIN_VALID_EPOCH;
+}
+
+int main(int argc, char** argv) {
+  if (!parseArgs(argc, argv)) {
+    usage();
+    return 2;
+  }
+  rng.seed(options.seed);
+  Serial.setQuiet(!options.verbose);
+
+  // A fresh file system unless told otherwise; the rules come from the data image
+  bool scratch = options.root.isEmpty();
+  if (scratch) {
+    char dir[] = "/tmp/year_sim.XXXXXX";
+    if (!mkdtemp(dir)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    options.root = dir;
+  }
+  setStorageRoot(options.root);
+  static CountingStorage counting(storage());
+  setStorage(&counting);
+  if (!storage().begin()) {
+    fprintf(stderr, "%s is not a directory\n", options.root.c_str());
+    return 1;
+  }
+  if (!storage().exists("/rules.json") && !copyFile(options.rules, "/rules.json")) {
+    fprintf(stderr, "Failed to copy %s\n", options.rules.c_str());
+    return 1;
+  }
+
+  std::vector<double> dayCpu;
+  dayCpu.reserve(options.days);        // Before measuring, so only the firmware's heap shows
+  hostClockSetEpoch(options.start);
+  measuring = true;
+
+  // setup(), minus the radio and the web server
+  loadConfig();
+  if (options.tz.length()) config.posix_tz = options.tz;
+  if (options.window >= 0) config.durability_window = options.window;
+  setLocalTimeZone(config.posix_tz.c_str());
+  getLocalTimeZone(zone);
+  loadHistoricalData();
+  resumeAggregation();
+  seedTrendSignals(temperatureData5Min);
+
+  setDhtPulseSource(roomPulses);
+  if (config.sensors.empty()) config.sensors.push_back(defaultSensorConfig());
+  config.sensors.resize(std::min(config.sensors.size(), options.sensors));
+  while (config.sensors.size() < options.sensors) {
+    SensorConfig extra = defaultSensorConfig();
+    extra.id = "room" + String((unsigned)config.sensors.size() + 1);
+    extra.driver = "dht22";
+    extra.pin = 16 + config.sensors.size();
+    config.sensors.push_back(extra);
+  }
+  setupSensors(config.sensors);
+  for (size_t i = 0; i < getSensorCount(); ++i) {
+    Sensor& sensor = getSensor(i);
+    registerPersistentSeries(sensorDataPath(sensor, "5min").c_str(), sensor.series5Min);
+    registerPersistentSeries(sensorDataPath(sensor, "hourly").c_str(), sensor.seriesHourly);
+    registerPersistentSeries(sensorDataPath(sensor, "6hour").c_str(), sensor.series6Hour);
+  }
+  setDurabilityWindow(config.durability_window);
+  recoverStagedPoints();
+  loadDailyStats(temperatureData5Min);
+  statsDaysAtBoot = getDailyStatsStatus().finishedDays;
+  loadRules();
+  setupActuator(countFrame);
+  startConnectivity(nullptr);
+  setupTasks();
+
+  printf("%u days from %s, TZ %s, %u sensors, %u rules, durability window %u min, %.1f%% failed captures, files in %s\n\n",
+         options.days, formatDate(options.start).c_str(), config.posix_tz.c_str(), (unsigned)getSensorCount(),
+         (unsigned)getRuleProgram()->rules.size(), config.durability_window, options.failures, options.root.c_str());
+  printf("%6s %-10s %12s %12s %10s %10s %12s %6s %6s %6s\n", "Day", "Date", "CPU ms/day", "max ms/day",
+         "Live heap", "Peak heap", "Flash/day", "5min", "Hourly", "6hour");
+
+  int64_t liveAfterWeek = 0;
+  uint64_t periodBytes = 0;
+  uint64_t lastBytes = counting.bytes;
+  double periodCpu = 0, periodMax = 0;
+  uint32_t periodDays = 0;
+  double cpuStart = cpuSeconds();
+
+  for (uint32_t day = 1; day <= options.days; ++day) {
+    double dayStart = cpuSeconds();
+    unsigned long end = millis() + 86400000UL;
+    while (millis() < end) {
+      unsigned long idle = runScheduler(millis());
+      serviceTelemetry();
+      if (idle) hostClockAdvanceMillis(idle);
+    }
+    double spent = cpuSeconds() - dayStart;
+    dayCpu.push_back(spent);
+    if (day == 7) liveAfterWeek = liveBytes;
+
+    periodCpu += spent;
+    periodMax = std::max(periodMax, spent);
+    periodDays++;
+    periodBytes += counting.bytes - lastBytes;
+    lastBytes = counting.bytes;
+    if (day % 30 == 0 || day == options.days) {
+      printf("%6u %-10s %12.2f %12.2f %9.1fK %9.1fK %11.1fK %6u %6u %6u\n", day, formatDate(getCurrentEpoch() - 1).c_str(),
+             periodCpu * 1000 / periodDays, periodMax * 1000, liveBytes / 1024.0, peakBytes / 1024.0,
+             periodBytes / 1024.0 / periodDays, (unsigned)temperatureData5Min.size(),
+             (unsigned)temperatureDataHourly.size(), (unsigned)temperatureData6Hour.size());
+      periodCpu = periodMax = 0;
+      periodDays = 0;
+      periodBytes = 0;
+    }
+  }
+  double totalCpu = cpuSeconds() - cpuStart;
+
+  // What a restart would leave on flash
+  flushPersistence(PERSIST_FLUSH_SHUTDOWN);
+  measuring = false;
+
+  std::vector<double> sorted = dayCpu;
+  std::sort(sorted.begin(), sorted.end());
+  size_t month = std::min<size_t>(30, dayCpu.size());
+  double firstMonth = 0, lastMonth = 0;
+  for (size_t i = 0; i < month; ++i) {
+    firstMonth += dayCpu[i];
+    lastMonth += dayCpu[dayCpu.size() - 1 - i];
+  }
+  printf("\nCPU: %.2f s for %u days; per day %.2f ms median, %.2f ms max; first 30 days %.2f ms/day, last 30 %.2f ms/day\n",
+         totalCpu, options.days, sorted[sorted.size() / 2] * 1000, sorted.back() * 1000, firstMonth * 1000 / month,
+         lastMonth * 1000 / month);
+
+  printf("Heap: peak %.1f KB, live %.1f KB at the end", peakBytes / 1024.0, liveBytes / 1024.0);
+  if (options.days > 7) printf(", %+.1f KB since day 7", (liveBytes - liveAfterWeek) / 1024.0);
+  printf("\n");
+
+  uint64_t eraseBlocks = 0;
+  for (const auto& file : counting.files) eraseBlocks += file.second.eraseBlocks;
+  uint32_t partitionBlocks = options.partitionKB * 1024 / FLASH_ERASE_BLOCK_SIZE;
+  double cyclesPerYear = (double)eraseBlocks / partitionBlocks * 365 / options.days;
+  printf("\nFlash: %.1f KB written, %.1f KB/day, %llu erase blocks; spread over %u KB that is %.1f erase cycles per block per year"
+         " (%.0f years to %u)\n", counting.bytes / 1024.0, counting.bytes / 1024.0 / options.days,
+         (unsigned long long)eraseBlocks, options.partitionKB, cyclesPerYear,
+         cyclesPerYear > 0 ? FLASH_ERASE_CYCLES / cyclesPerYear : INFINITY, FLASH_ERASE_CYCLES);
+  printf("  %-24s %8s %12s %10s %12s\n", "File", "Writes", "KB", "KB/day", "Erase blocks");
+  std::vector<std::pair<std::string, FileWrites>> byBytes(counting.files.begin(), counting.files.end());
+  std::sort(byBytes.begin(), byBytes.end(), [](const std::pair<std::string, FileWrites>& a, const std::pair<std::string, FileWrites>& b) {
+    return a.second.bytes > b.second.bytes;
+  });
+  for (const auto& file : byBytes) {
+    printf("  %-24s %8u %12.1f %10.1f %12llu\n", file.first.c_str(), file.second.writes, file.second.bytes / 1024.0,
+           file.second.bytes / 1024.0 / options.days, (unsigned long long)file.second.eraseBlocks);
+  }
+
+  PersistenceStats persistence = getPersistenceStats();
+  printf("Flushes: %u window, %u pressure, %u shutdown, %u forced; %u staged points dropped\n",
+         persistence.flushes[PERSIST_FLUSH_WINDOW], persistence.flushes[PERSIST_FLUSH_PRESSURE],
+         persistence.flushes[PERSIST_FLUSH_SHUTDOWN], persistence.flushes[PERSIST_FLUSH_FORCED], persistence.dropped);
+  check(persistence.dropped == 0, "%sstaged points were dropped", "");
+
+  printf("\nTiers (points/capacity, oldest .. newest, min / mean / max):\n");
+  for (size_t i = 0; i < getSensorCount(); ++i) {
+    const Sensor& sensor = getSensor(i);
+    reportTier(sensor, "5min", *sensor.series5Min, 300);
+    reportTier(sensor, "hourly", *sensor.seriesHourly, 3600);
+    reportTier(sensor, "6hour", *sensor.series6Hour, 21600);
+  }
+  reportDailyStats();
+
+  printf("\nSensors:");
+  for (size_t i = 0; i < getSensorCount(); ++i) {
+    const Sensor& sensor = getSensor(i);
+    printf(" %s %u failed, %u rejected;", sensor.config.id.c_str(), sensor.failures, sensor.rejected);
+  }
+  printf(" %u IR frames (%u resyncs)\n", framesSent, getActuatorStats().resyncs);
+
+  if (scratch) {
+    std::vector<StorageEntry> entries;
+    storage().list("/", entries);
+    for (const StorageEntry& entry : entries) storage().remove(entry.path.c_str());
+    rmdir(options.root.c_str());
+  }
+
+  printf("\n%s\n", failures ? "Checks failed" : "All checks passed");
+  return failures ? 1 : 0;
+}